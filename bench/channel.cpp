@@ -0,0 +1,40 @@
+#include <asyncpp/channel.h>
+#include <asyncpp/fire_and_forget.h>
+#include <benchmark/benchmark.h>
+
+using namespace asyncpp;
+
+// Round trip between two coroutines over two unbuffered channels, every hand-off resumes the other side inline
+static void BM_ChannelPingPong(benchmark::State& state) {
+	channel<int> ping;
+	channel<int> pong;
+	[](channel<int>& ping, channel<int>& pong) -> eager_fire_and_forget_task<> {
+		while (auto val = co_await ping.read())
+			co_await pong.write(*val);
+	}(ping, pong);
+	[](benchmark::State& state, channel<int>& ping, channel<int>& pong) -> eager_fire_and_forget_task<> {
+		for (auto _ : state) {
+			co_await ping.write(1);
+			benchmark::DoNotOptimize(co_await pong.read());
+		}
+		ping.close();
+	}(state, ping, pong);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChannelPingPong);
+
+// Buffered channel used as a queue, measures the cost of a write and read that never suspend
+static void BM_ChannelBuffered(benchmark::State& state) {
+	channel<int> chan{static_cast<size_t>(state.range(0))};
+	[](benchmark::State& state, channel<int>& chan) -> eager_fire_and_forget_task<> {
+		const auto count = state.range(0);
+		for (auto _ : state) {
+			for (int64_t i = 0; i < count; i++)
+				co_await chan.write(1);
+			for (int64_t i = 0; i < count; i++)
+				benchmark::DoNotOptimize(co_await chan.read());
+		}
+	}(state, chan);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ChannelBuffered)->Arg(1)->Arg(64);
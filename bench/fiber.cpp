@@ -0,0 +1,31 @@
+#include <asyncpp/fiber.h>
+#include <benchmark/benchmark.h>
+
+using namespace asyncpp::detail;
+
+namespace {
+	fiber_context main_ctx{};
+	fiber_context fiber_ctx{};
+} // namespace
+
+// Switch into a fiber and back, which is one full round trip through fiber_swapcontext
+static void BM_FiberSwitch(benchmark::State& state) {
+	stack_context stack;
+	if (!fiber_allocate_stack(stack, 64 * 1024)) {
+		state.SkipWithError("failed to allocate stack");
+		return;
+	}
+	fiber_makecontext(
+		&fiber_ctx, stack,
+		[](void*) {
+			while (true)
+				fiber_swapcontext(&fiber_ctx, &main_ctx);
+		},
+		nullptr);
+	for (auto _ : state)
+		fiber_swapcontext(&main_ctx, &fiber_ctx);
+	state.SetItemsProcessed(state.iterations());
+	fiber_destroy_context(&fiber_ctx);
+	fiber_deallocate_stack(stack);
+}
+BENCHMARK(BM_FiberSwitch);
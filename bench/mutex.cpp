@@ -0,0 +1,52 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/mutex.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <benchmark/benchmark.h>
+
+#include <future>
+#include <vector>
+
+using namespace asyncpp;
+
+namespace {
+	constexpr int locks_per_task = 1000;
+} // namespace
+
+// Coroutines on a thread pool taking the same mutex, so most locks are handed over to a waiter
+static void BM_MutexContended(benchmark::State& state) {
+	const auto threads = static_cast<size_t>(state.range(0));
+	thread_pool pool{threads};
+	mutex mtx;
+	size_t counter = 0;
+	for (auto _ : state) {
+		std::vector<std::future<void>> results;
+		for (size_t i = 0; i < threads * 2; i++) {
+			results.push_back(as_promise([](thread_pool& pool, mutex& mtx, size_t& counter) -> task<> {
+				co_await defer{pool};
+				for (int n = 0; n < locks_per_task; n++) {
+					co_await mtx.lock();
+					counter++;
+					mtx.unlock();
+				}
+			}(pool, mtx, counter)));
+		}
+		for (auto& e : results)
+			e.get();
+	}
+	benchmark::DoNotOptimize(counter);
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(threads) * 2 * locks_per_task);
+}
+BENCHMARK(BM_MutexContended)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// Lock and unlock without any contention
+static void BM_MutexUncontended(benchmark::State& state) {
+	mutex mtx;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(mtx.try_lock());
+		mtx.unlock();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexUncontended);
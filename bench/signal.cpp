@@ -0,0 +1,51 @@
+#include <asyncpp/signal.h>
+#include <benchmark/benchmark.h>
+
+#include <type_traits>
+#include <vector>
+
+using namespace asyncpp;
+
+// Emit a signal with N connected slots
+template<typename TTraits>
+static void BM_SignalEmit(benchmark::State& state) {
+	signal<void(int), TTraits> sig;
+	int sum = 0;
+	std::vector<typename signal<void(int), TTraits>::handle> handles;
+	for (int64_t i = 0; i < state.range(0); i++)
+		handles.push_back(sig.append([&sum](int val) { sum += val; }));
+	for (auto _ : state)
+		benchmark::DoNotOptimize(sig(1));
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SignalEmit<signal_traits_mt>)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_SignalEmit<signal_traits_st>)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_SignalEmit<signal_traits_rcu>)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_SignalEmit<signal_traits_flat>)->RangeMultiplier(8)->Range(1, 512);
+
+namespace {
+	enum class bench_event { first, second, third, fourth };
+} // namespace
+template<>
+inline constexpr size_t asyncpp::signal_event_count<bench_event> = 4;
+
+// Emit the events of a signal_manager with one slot each from multiple threads, which mostly measures the lookup
+template<typename TEventType, typename TMap>
+static void BM_SignalManagerEmit(benchmark::State& state) {
+	constexpr int events = std::is_enum_v<TEventType> ? 4 : 1024;
+	static signal_manager<TEventType, void(int), signal_traits_rcu, TMap> mgr;
+	static const bool populated = []() {
+		for (int i = 0; i < events; i++)
+			(void)mgr.append(static_cast<TEventType>(i), [](int val) { benchmark::DoNotOptimize(val); });
+		return true;
+	}();
+	benchmark::DoNotOptimize(populated);
+	int i = 0;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(mgr(static_cast<TEventType>(i++ % events), 1));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SignalManagerEmit<int, signal_map_locked>)->ThreadRange(1, 8);
+BENCHMARK(BM_SignalManagerEmit<int, signal_map_concurrent>)->ThreadRange(1, 8);
+BENCHMARK(BM_SignalManagerEmit<bench_event, signal_map_locked>)->ThreadRange(1, 8);
@@ -0,0 +1,43 @@
+#include <asyncpp/thread_pool.h>
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+
+using namespace asyncpp;
+
+namespace {
+	constexpr int batch_size = 10000;
+
+	void wait_for(const std::atomic<int>& counter, int value) {
+		while (counter.load(std::memory_order::acquire) != value)
+			std::this_thread::yield();
+	}
+} // namespace
+
+// Callbacks pushed from outside the pool, distributed to the workers
+static void BM_ThreadPoolPushExternal(benchmark::State& state) {
+	thread_pool pool{static_cast<size_t>(state.range(0))};
+	for (auto _ : state) {
+		std::atomic<int> done{0};
+		for (int i = 0; i < batch_size; i++)
+			pool.push([&done]() { done.fetch_add(1, std::memory_order::release); });
+		wait_for(done, batch_size);
+	}
+	state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_ThreadPoolPushExternal)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// One callback pushed from outside fans out into the local queue of a worker, the others have to steal
+static void BM_ThreadPoolPushSteal(benchmark::State& state) {
+	thread_pool pool{static_cast<size_t>(state.range(0))};
+	for (auto _ : state) {
+		std::atomic<int> done{0};
+		pool.push([&]() {
+			for (int i = 0; i < batch_size; i++)
+				pool.push([&done]() { done.fetch_add(1, std::memory_order::release); });
+		});
+		wait_for(done, batch_size);
+	}
+	state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_ThreadPoolPushSteal)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
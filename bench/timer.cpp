@@ -0,0 +1,44 @@
+#include <asyncpp/stop_token.h>
+#include <asyncpp/timer.h>
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace asyncpp;
+
+// Arm a timeout and cancel it right away, like a request that completes long before its deadline
+static void BM_TimerArmCancel(benchmark::State& state) {
+	timer tmr;
+	std::atomic<int64_t> done{0};
+	int64_t armed = 0;
+	for (auto _ : state) {
+		stop_source source;
+		tmr.schedule([&done](bool) { done.fetch_add(1, std::memory_order::relaxed); }, std::chrono::seconds(10),
+					 source.get_token());
+		source.request_stop();
+		armed++;
+	}
+	// Cancelled callbacks still get invoked, the timer needs to be idle before it is destroyed
+	while (done.load(std::memory_order::relaxed) != armed)
+		std::this_thread::yield();
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerArmCancel);
+
+// Arm timeouts that are never cancelled, they all expire at the end of the run
+static void BM_TimerArm(benchmark::State& state) {
+	timer tmr;
+	std::atomic<int64_t> done{0};
+	int64_t armed = 0;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+	for (auto _ : state) {
+		tmr.schedule([&done](bool) { done.fetch_add(1, std::memory_order::relaxed); }, deadline);
+		armed++;
+	}
+	while (done.load(std::memory_order::relaxed) != armed)
+		std::this_thread::yield();
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerArm);
@@ -6,6 +6,7 @@
 #include <exception>
 #include <iterator>
 #include <memory>
+#include <span>
 
 namespace asyncpp {
 	template<typename T, ByteAllocator Allocator = default_allocator_type>
@@ -17,8 +18,9 @@ namespace asyncpp {
 
 		class async_generator_yield_operation final {
 		public:
+			// A null consumer continues the producer right away, which is used for empty chunks
 			explicit async_generator_yield_operation(coroutine_handle<> consumer) noexcept : m_consumer(consumer) {}
-			[[nodiscard]] bool await_ready() const noexcept { return false; }
+			[[nodiscard]] bool await_ready() const noexcept { return !m_consumer; }
 			[[nodiscard]] coroutine_handle<> await_suspend([[maybe_unused]] coroutine_handle<> producer) noexcept {
 				return m_consumer;
 			}
@@ -46,6 +48,7 @@ namespace asyncpp {
 				if (m_exception) { std::rethrow_exception(std::move(m_exception)); }
 			}
 			[[nodiscard]] T* value() const noexcept { return m_value; }
+			[[nodiscard]] T* value_end() const noexcept { return m_end; }
 
 		protected:
 			[[nodiscard]] async_generator_yield_operation internal_yield_value() noexcept {
@@ -63,6 +66,7 @@ namespace asyncpp {
 
 		protected:
 			T* m_value;
+			T* m_end;
 		};
 
 		template<typename T, ByteAllocator Allocator>
@@ -77,11 +81,24 @@ namespace asyncpp {
 			}
 			[[nodiscard]] async_generator_yield_operation yield_value(value_type& value) noexcept {
 				this->m_value = std::addressof(value);
+				this->m_end = this->m_value + 1;
 				return this->internal_yield_value();
 			}
 			[[nodiscard]] async_generator_yield_operation yield_value(value_type&& value) noexcept {
 				return yield_value(value);
 			}
+			/**
+			 * \brief Yield a whole chunk of values at once.
+			 *
+			 * The consumer walks the chunk in place and the generator is only resumed once it moved past its end.
+			 * The memory needs to stay valid until then. Empty chunks are skipped without suspending.
+			 */
+			[[nodiscard]] async_generator_yield_operation yield_value(std::span<value_type> chunk) noexcept {
+				if (chunk.empty()) return async_generator_yield_operation{nullptr};
+				this->m_value = chunk.data();
+				this->m_end = chunk.data() + chunk.size();
+				return this->internal_yield_value();
+			}
 		};
 
 		template<typename T, ByteAllocator Allocator>
@@ -94,6 +111,7 @@ namespace asyncpp {
 			}
 			[[nodiscard]] async_generator_yield_operation yield_value(T&& value) noexcept {
 				this->m_value = std::addressof(value);
+				this->m_end = this->m_value + 1;
 				return this->internal_yield_value();
 			}
 		};
@@ -113,14 +131,15 @@ namespace asyncpp {
 			[[nodiscard]] auto operator++() noexcept {
 				class increment_op final {
 				public:
-					explicit increment_op(async_generator_iterator<T>& iterator) noexcept : m_iterator(iterator) {}
-					[[nodiscard]] bool await_ready() const noexcept { return false; }
+					explicit increment_op(async_generator_iterator<T>& iterator, bool in_chunk) noexcept
+						: m_iterator(iterator), m_in_chunk(in_chunk) {}
+					[[nodiscard]] bool await_ready() const noexcept { return m_in_chunk; }
 					[[nodiscard]] coroutine_handle<> await_suspend(coroutine_handle<> consumer) noexcept {
 						m_iterator.m_promise->m_consumer = consumer;
 						return m_iterator.m_coro;
 					}
 					async_generator_iterator<T>& await_resume() {
-						if (m_iterator.m_promise->finished()) {
+						if (!m_in_chunk && m_iterator.m_promise->finished()) {
 							// Update iterator to end()
 							auto promise = m_iterator.m_promise;
 							m_iterator = async_generator_iterator<T>{nullptr};
@@ -132,8 +151,24 @@ namespace asyncpp {
 
 				private:
 					async_generator_iterator<T>& m_iterator;
+					bool m_in_chunk;
 				};
-				return increment_op{*this};
+				// Values left in the current chunk are consumed without resuming the generator
+				auto& promise = *m_promise;
+				return increment_op{*this, ++promise.m_value != promise.m_end};
+			}
+			/// \brief Skip the rest of the current chunk and resume the generator, see operator++().
+			[[nodiscard]] auto next_chunk() noexcept {
+				m_promise->m_value = m_promise->m_end - 1;
+				return ++*this;
+			}
+			/**
+			 * \brief Get the remaining values of the current chunk, starting with the current one.
+			 *
+			 * Values yielded on their own form a chunk of size one.
+			 */
+			[[nodiscard]] std::span<value_type> chunk() const noexcept {
+				return {static_cast<T*>(m_promise->value()), static_cast<T*>(m_promise->value_end())};
 			}
 			[[nodiscard]] reference operator*() const noexcept { return *static_cast<T*>(m_promise->value()); }
 			[[nodiscard]] bool operator==(const async_generator_iterator& other) const noexcept {
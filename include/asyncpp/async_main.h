@@ -13,7 +13,8 @@ asyncpp::task<int> async_main(int argc, const char** argv);
 int main(int argc, const char** argv) {
 	using asyncpp::eager_fire_and_forget_task;
 	using asyncpp::simple_dispatcher;
-	simple_dispatcher disp;
+	using asyncpp::simple_dispatcher_mode;
+	simple_dispatcher disp{simple_dispatcher_mode::inline_fast_path};
 	std::pair<int, std::exception_ptr> result{-1, nullptr};
 	disp.push([&]() {
 		[](simple_dispatcher* disp, std::pair<int, std::exception_ptr>& result, int argc,
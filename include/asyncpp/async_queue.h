@@ -0,0 +1,155 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/trampoline.h>
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace asyncpp {
+	/**
+	 * \brief Unbounded queue with an asynchronous pop() operation.
+	 *
+	 * Pushing never suspends. If a coroutine is waiting in pop() the value is moved directly into it and the
+	 * coroutine is resumed, otherwise the value is appended to the queue. Popping takes the first value if there
+	 * is one and suspends otherwise. Waiting coroutines are kept in an intrusive list and served in the order
+	 * they started to wait, they are resumed on the dispatcher passed to pop(), or inline in push() if none was
+	 * provided.
+	 *
+	 * \note Destroying a queue that is currently being awaited can cause resource leaks as the waiting coroutines
+	 *      can never resume. (This asserts in debug mode)
+	 * \tparam T Type of the contained elements
+	 */
+	template<typename T>
+	class async_queue {
+		struct awaiter;
+
+		std::mutex m_mtx;
+		std::deque<T> m_queue;
+		// Waiters in order of arrival, there are only waiters while m_queue is empty
+		awaiter* m_awaiters{nullptr};
+		awaiter* m_awaiters_tail{nullptr};
+
+	public:
+		async_queue() = default;
+#ifndef NDEBUG
+		~async_queue() noexcept { assert(m_awaiters == nullptr); }
+#endif
+		async_queue(const async_queue&) = delete;
+		async_queue& operator=(const async_queue&) = delete;
+
+		/**
+		 * \brief Push an element to the queue
+		 * \note A waiting coroutine without a dispatcher is resumed inside this call.
+		 * \param val The element to push
+		 */
+		void push(T val) { emplace(std::move(val)); }
+
+		/**
+		 * \brief Emplace a new element to the queue
+		 * \note A waiting coroutine without a dispatcher is resumed inside this call.
+		 * \param args Arguments to forward to the element constructor
+		 */
+		template<typename... Args>
+		void emplace(Args&&... args) {
+			std::unique_lock lck{m_mtx};
+			if (m_awaiters == nullptr) {
+				m_queue.emplace_back(std::forward<Args>(args)...);
+				return;
+			}
+			auto await = m_awaiters;
+			m_awaiters = await->m_next;
+			if (m_awaiters == nullptr) m_awaiters_tail = nullptr;
+			try {
+				await->m_result.emplace(std::forward<Args>(args)...);
+			} catch (...) {
+				// Put the waiter back in front, so it keeps its place
+				await->m_next = m_awaiters;
+				m_awaiters = await;
+				if (m_awaiters_tail == nullptr) m_awaiters_tail = await;
+				throw;
+			}
+			lck.unlock();
+			if (await->m_dispatcher != nullptr)
+				await->m_dispatcher->push_resume(await->m_handle);
+			else
+				resume_trampoline::resume(await->m_handle);
+		}
+
+		/**
+		 * \brief Pop the first element without suspending.
+		 * \return The first element of the queue or std::nullopt if the queue is empty.
+		 */
+		std::optional<T> try_pop() {
+			std::unique_lock lck{m_mtx};
+			if (m_queue.empty()) return std::nullopt;
+			std::optional<T> res{std::move(m_queue.front())};
+			m_queue.pop_front();
+			return res;
+		}
+
+		/**
+		 * \brief Pop the first element, suspending until one is pushed if the queue is empty.
+		 *
+		 * The coroutine will resume on the current dispatcher if the thread belongs to a dispatcher or inside
+		 * push() if not.
+		 * \return Awaitable resolving to the element
+		 */
+		[[nodiscard]] auto pop() noexcept { return awaiter{this, dispatcher::current()}; }
+
+		/**
+		 * \brief Pop the first element, suspending until one is pushed if the queue is empty.
+		 * \param resume_dispatcher The dispatcher to resume on or nullptr to resume inside push()
+		 * \return Awaitable resolving to the element
+		 */
+		[[nodiscard]] auto pop(dispatcher* resume_dispatcher) noexcept { return awaiter{this, resume_dispatcher}; }
+
+		/**
+		 * \brief Query the number of elements in the queue
+		 * \note Do not base decisions on this value, as it might change at any time
+		 */
+		[[nodiscard]] size_t size() {
+			std::unique_lock lck{m_mtx};
+			return m_queue.size();
+		}
+
+	private:
+		struct [[nodiscard]] awaiter {
+			awaiter(async_queue* parent, dispatcher* dispatcher) noexcept
+				: m_parent(parent), m_dispatcher(dispatcher) {}
+			awaiter(const awaiter& other) noexcept : m_parent(other.m_parent), m_dispatcher(other.m_dispatcher) {}
+			awaiter& operator=(const awaiter&) = delete;
+
+			[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) {
+				m_handle = hdl;
+				std::unique_lock lck{m_parent->m_mtx};
+				if (!m_parent->m_queue.empty()) {
+					m_result.emplace(std::move(m_parent->m_queue.front()));
+					m_parent->m_queue.pop_front();
+					return false;
+				}
+				if (m_parent->m_awaiters_tail != nullptr)
+					m_parent->m_awaiters_tail->m_next = this;
+				else
+					m_parent->m_awaiters = this;
+				m_parent->m_awaiters_tail = this;
+				return true;
+			}
+			T await_resume() {
+				assert(m_result.has_value());
+				return std::move(*m_result);
+			}
+
+			async_queue* m_parent;
+			dispatcher* m_dispatcher;
+			awaiter* m_next{nullptr};
+			coroutine_handle<> m_handle{};
+			std::optional<T> m_result{};
+		};
+	};
+} // namespace asyncpp
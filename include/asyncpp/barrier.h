@@ -0,0 +1,122 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/trampoline.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace asyncpp {
+	namespace detail {
+		struct barrier_noop_completion {
+			constexpr void operator()() const noexcept {}
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Reusable barrier to synchronize a fixed number of coroutines in phases.
+	 *
+	 * Every phase completes once the expected number of participants arrived. The last one to arrive invokes the
+	 * completion function and resumes all others, after which the next phase starts with the same number of
+	 * participants (minus those that called arrive_and_drop()). Unlike latch the barrier can be reused for an
+	 * arbitrary number of phases, it does not allocate and the implementation is lock-free.
+	 *
+	 * \tparam CompletionFn Function invoked by the last coroutine arriving in a phase, before any other gets resumed
+	 */
+	template<typename CompletionFn = detail::barrier_noop_completion>
+	class async_barrier {
+		static_assert(std::is_nothrow_invocable_v<CompletionFn&>, "completion function needs to be noexcept");
+		struct awaiter;
+
+	public:
+		/**
+		 * \brief Construct a new barrier
+		 * \param expected The number of participants in every phase
+		 * \param completion Function invoked at the end of every phase
+		 */
+		explicit async_barrier(std::size_t expected, CompletionFn completion = CompletionFn{}) noexcept(
+			std::is_nothrow_move_constructible_v<CompletionFn>)
+			: m_completion{std::move(completion)}, m_expected{expected}, m_remaining{expected} {}
+#ifndef NDEBUG
+		~async_barrier() noexcept { assert(m_awaiters.load(std::memory_order::relaxed) == nullptr); }
+#endif
+		async_barrier(const async_barrier&) = delete;
+		async_barrier& operator=(const async_barrier&) = delete;
+
+		/**
+		 * \brief Arrive at the barrier and wait for the current phase to complete
+		 *
+		 * The coroutine will resume on the current dispatcher if the thread belongs to a dispatcher or inside
+		 * the arrival that completed the phase if not. The last coroutine to arrive continues right away.
+		 * \return Awaitable
+		 */
+		[[nodiscard]] auto arrive_and_wait() noexcept { return awaiter{this, dispatcher::current()}; }
+
+		/**
+		 * \brief Arrive at the barrier and wait for the current phase to complete
+		 * \param resume_dispatcher The dispatcher to resume on or nullptr to resume inside the completing arrival
+		 * \return Awaitable
+		 */
+		[[nodiscard]] constexpr auto arrive_and_wait(dispatcher* resume_dispatcher) noexcept {
+			return awaiter{this, resume_dispatcher};
+		}
+
+		/**
+		 * \brief Arrive at the barrier and remove the caller from all following phases
+		 * \note If this completes the phase, waiting coroutines without a dispatcher are resumed inside this call.
+		 */
+		void arrive_and_drop() noexcept {
+			m_expected.fetch_sub(1, std::memory_order::relaxed);
+			if (m_remaining.fetch_sub(1, std::memory_order::acq_rel) == 1) complete_phase(nullptr);
+		}
+
+	private:
+		[[no_unique_address]] CompletionFn m_completion;
+		std::atomic<std::size_t> m_expected;
+		std::atomic<std::size_t> m_remaining;
+		std::atomic<awaiter*> m_awaiters{nullptr};
+
+		struct [[nodiscard]] awaiter {
+			constexpr awaiter(async_barrier* parent, dispatcher* dispatcher) noexcept
+				: m_parent(parent), m_dispatcher(dispatcher) {}
+			[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
+				m_handle = hdl;
+				// Register before arriving, so the last one to arrive sees all waiters of this phase
+				m_next = m_parent->m_awaiters.load(std::memory_order::relaxed);
+				while (!m_parent->m_awaiters.compare_exchange_weak(m_next, this, std::memory_order::release,
+																   std::memory_order::relaxed)) {}
+				if (m_parent->m_remaining.fetch_sub(1, std::memory_order::acq_rel) != 1) return true;
+				m_parent->complete_phase(this);
+				return false;
+			}
+			constexpr void await_resume() const noexcept {}
+
+			async_barrier* m_parent;
+			dispatcher* m_dispatcher;
+			awaiter* m_next{nullptr};
+			coroutine_handle<> m_handle{};
+		};
+
+		void complete_phase(awaiter* self) noexcept {
+			m_completion();
+			// Nobody can arrive for the next phase before we resumed them, so it is fine to reset the counter first
+			m_remaining.store(m_expected.load(std::memory_order::relaxed), std::memory_order::relaxed);
+			auto await = m_awaiters.exchange(nullptr, std::memory_order::acq_rel);
+			while (await != nullptr) {
+				auto next = await->m_next;
+				// The coroutine completing the phase continues without suspending
+				if (await != self) {
+					if (await->m_dispatcher != nullptr)
+						await->m_dispatcher->push_resume(await->m_handle);
+					else
+						resume_trampoline::resume(await->m_handle);
+				}
+				await = next;
+			}
+		}
+	};
+} // namespace asyncpp
@@ -0,0 +1,168 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/stop_token.h>
+#include <asyncpp/task.h>
+
+#include <cassert>
+#include <exception>
+#include <utility>
+
+namespace asyncpp {
+	/**
+	 * \brief Exception thrown by cancellable_task if it reaches a co_await after a stop was requested.
+	 */
+	class operation_cancelled : public std::exception {
+	public:
+		[[nodiscard]] const char* what() const noexcept override { return "operation cancelled"; }
+	};
+
+	/**
+	 * \brief Tag to query the stop_token of the current cancellable_task using `co_await current_stop_token`.
+	 */
+	constexpr inline struct current_stop_token_t {
+	} current_stop_token{};
+
+	/**
+	 * \brief Check if an awaitable can pick up a stop_token, which cancellable_task does automatically.
+	 *
+	 * The awaitable needs to provide a with_stop_token(asyncpp::stop_token) method returning a cancellable version
+	 * of it, like the ones returned by timer::wait() and channel::read().
+	 */
+	template<typename T>
+	concept StopTokenAwaitable = requires(T&& awaitable, asyncpp::stop_token stoken) {
+		std::forward<T>(awaitable).with_stop_token(std::move(stoken));
+	};
+
+	template<class T, ByteAllocator Allocator>
+	class cancellable_task;
+
+	namespace detail {
+		template<class T, ByteAllocator Allocator>
+		class cancellable_task_promise : public task_promise<T, Allocator, cancellable_task_promise<T, Allocator>> {
+		public:
+#if ASYNCPP_TRACK_FRAMES
+			template<typename Awaitable>
+			decltype(auto) await_transform(Awaitable&& awaitable,
+										   std::source_location loc = std::source_location::current()) {
+				this->m_frame.suspended_at(loc);
+#else
+			template<typename Awaitable>
+			decltype(auto) await_transform(Awaitable&& awaitable) {
+#endif
+				// Every co_await is a cancellation point
+				if (m_stop_token.stop_requested()) throw operation_cancelled{};
+				if constexpr (StopTokenAwaitable<Awaitable>)
+					return std::forward<Awaitable>(awaitable).with_stop_token(m_stop_token);
+				else
+					return std::forward<Awaitable>(awaitable);
+			}
+			auto await_transform(current_stop_token_t) noexcept {
+				struct awaiter {
+					asyncpp::stop_token m_stop_token;
+					constexpr bool await_ready() const noexcept { return true; }
+					constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+					asyncpp::stop_token await_resume() noexcept { return std::move(m_stop_token); }
+				};
+				return awaiter{m_stop_token};
+			}
+
+			asyncpp::stop_token m_stop_token{};
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Task carrying a stop_token that is passed on to everything it awaits.
+	 *
+	 * The task works like task<T>, but its promise holds a stop_token. It is either set explicitly using
+	 * with_stop_token() or inherited from the cancellable_task awaiting it, so a whole tree of calls can be
+	 * cancelled using a single stop_source. Awaiting library awaitables that support cancellation (timer::wait(),
+	 * channel::read() and other cancellable_tasks) passes the token on to them automatically. Every co_await
+	 * throws operation_cancelled if a stop has been requested before, so cancelled work stops at the next
+	 * suspension point. An awaiter that is already waiting resumes as if cancelled by its own stop_token, e.g.
+	 * timer::wait() with false and channel::read() with std::nullopt. Awaitables without stop_token support
+	 * (like mutex::lock()) are only cancelled before they start waiting.
+	 *
+	 * `co_await current_stop_token` gives access to the token from inside the task.
+	 * \tparam T Return type of the task
+	 */
+	template<class T = void, ByteAllocator Allocator = default_allocator_type>
+	class [[nodiscard]] cancellable_task {
+	public:
+		/// \brief Promise type
+		using promise_type = detail::cancellable_task_promise<T, Allocator>;
+		/// \brief Handle type
+		using handle_t = coroutine_handle<promise_type>;
+
+		/// \brief Construct from handle
+		//NOLINTNEXTLINE(google-explicit-constructor)
+		cancellable_task(handle_t hndl) noexcept : m_coro(hndl) {
+			assert(this->m_coro);
+			assert(!this->m_coro.done());
+		}
+
+		/// \brief Construct from nullptr. The resulting task is invalid.
+		explicit cancellable_task(std::nullptr_t) noexcept : m_coro{} {}
+
+		/// \brief Move constructor
+		cancellable_task(cancellable_task&& other) noexcept : m_coro{std::exchange(other.m_coro, {})} {}
+		/// \brief Move assignment
+		cancellable_task& operator=(cancellable_task&& other) noexcept {
+			m_coro = std::exchange(other.m_coro, m_coro);
+			return *this;
+		}
+		cancellable_task(const cancellable_task&) = delete;
+		cancellable_task& operator=(const cancellable_task&) = delete;
+
+		/// \brief Destructor
+		~cancellable_task() {
+			if (m_coro) m_coro.destroy();
+			m_coro = nullptr;
+		}
+
+		/// \brief Check if the task holds a valid coroutine.
+		explicit operator bool() const noexcept { return m_coro != nullptr; }
+		/// \brief Check if the task does not hold a valid coroutine.
+		bool operator!() const noexcept { return m_coro == nullptr; }
+
+		/**
+		 * \brief Set the stop_token of the task, unless it already has one.
+		 * \note This needs to be called before the task is awaited.
+		 */
+		cancellable_task& with_stop_token(asyncpp::stop_token stoken) & noexcept {
+			assert(this->m_coro);
+			auto& token = m_coro.promise().m_stop_token;
+			if (!token.stop_possible()) token = std::move(stoken);
+			return *this;
+		}
+		/// \copydoc with_stop_token
+		cancellable_task&& with_stop_token(asyncpp::stop_token stoken) && noexcept {
+			return std::move(with_stop_token(std::move(stoken)));
+		}
+
+		/// \brief Operator co_await
+		auto operator co_await() noexcept {
+			struct awaiter {
+				constexpr explicit awaiter(handle_t coro) : m_coro(coro) {}
+				constexpr bool await_ready() noexcept { return false; }
+				auto await_suspend(coroutine_handle<void> hndl) noexcept {
+					assert(this->m_coro);
+					assert(hndl);
+					m_coro.promise().m_continuation = hndl;
+					return m_coro;
+				}
+				T await_resume() {
+					assert(this->m_coro);
+					return this->m_coro.promise().get();
+				}
+
+			private:
+				handle_t m_coro;
+			};
+			assert(this->m_coro);
+			return awaiter{m_coro};
+		}
+
+	private:
+		handle_t m_coro;
+	};
+} // namespace asyncpp
@@ -1,65 +1,266 @@
 #pragma once
 #include <asyncpp/detail/concepts.h>
+#include <asyncpp/detail/select_state.h>
 #include <asyncpp/detail/std_import.h>
 #include <asyncpp/dispatcher.h>
+#include <asyncpp/stop_token.h>
+#include <asyncpp/trampoline.h>
+#if ASYNCPP_ENABLE_METRICS
+#include <asyncpp/metrics.h>
+#endif
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <iterator>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace asyncpp {
 
 	/**
 	 * \brief Channel for communication between coroutines
-	 * \note Channels are not a queue. Writing to a channel that has no active reader will suspend until one
-	 * 		calls read (or the channel is closed).
+	 * \note By default channels are not a queue. Writing to a channel that has no active reader will suspend until
+	 * 		one calls read (or the channel is closed).
 	 * This class allows passing values between multiple coroutines in a thread safe and convenient way.
 	 * They work similar to a pipe/loopback socket.
+	 *
+	 * A channel can optionally be constructed with a capacity, in which case it uses a ring buffer of that size.
+	 * Writes complete without suspending as long as there is space in the buffer and reads complete without
+	 * suspending as long as there are buffered values. Values buffered at the time of close() can still be read.
 	 * \tparam T Type of the payload
 	 */
 	template<typename T>
 	class channel {
 		struct read_awaiter;
+		struct cancellable_read_awaiter;
 		struct write_awaiter;
+		template<std::output_iterator<T> OutputIt>
+		struct read_many_awaiter;
+		struct write_many_awaiter;
 
 		std::atomic<bool> m_closed{false};
 		std::mutex m_mtx;
 		read_awaiter* m_reader_list{};
 		write_awaiter* m_writer_list{};
+		// Ring buffer for buffered channels, empty for unbuffered ones.
+		// Readers only wait if it is empty and writers only wait if it is full.
+		std::vector<std::optional<T>> m_buffer{};
+		size_t m_buffer_head{0};
+		size_t m_buffer_size{0};
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_read_contention{};
+		detail::contention_counters m_write_contention{};
+
+		static detail::contention_counters& contention_of(read_awaiter* awaiter) noexcept {
+			return awaiter->m_parent->m_read_contention;
+		}
+		static detail::contention_counters& contention_of(write_awaiter* awaiter) noexcept {
+			return awaiter->m_parent->m_write_contention;
+		}
+#endif
+
+		bool buffer_full() const noexcept { return m_buffer_size == m_buffer.size(); }
+		void buffer_push(T&& value) {
+			m_buffer[(m_buffer_head + m_buffer_size) % m_buffer.size()].emplace(std::move(value));
+			m_buffer_size++;
+		}
+		T buffer_pop() {
+			auto& slot = m_buffer[m_buffer_head];
+			T res = std::move(*slot);
+			slot.reset();
+			m_buffer_head = (m_buffer_head + 1) % m_buffer.size();
+			m_buffer_size--;
+			return res;
+		}
+		// Take a value out of the buffer and refill it from a waiting writer. Needs to be called with m_mtx held,
+		// the writer that needs to be resumed (if any) is returned in writer.
+		T buffer_take_locked(write_awaiter*& writer);
+		// Same as buffer_take_locked, but unlocks lck and resumes the writer
+		std::optional<T> buffer_take(std::unique_lock<std::mutex>& lck);
+
+		// Awaiters that belong to a select() might have been completed by another channel already,
+		// the following helpers take care of skipping them. All of them need to be called with m_mtx held.
+		template<typename Awaiter>
+		static bool claim(Awaiter* awaiter) noexcept {
+			return awaiter->m_select == nullptr || awaiter->m_select->try_claim(awaiter->m_select_index);
+		}
+		template<typename Awaiter>
+		static Awaiter* pop_front(Awaiter*& list) noexcept {
+			while (auto res = list) {
+				list = res->m_next;
+				res->m_next = nullptr;
+				if (claim(res)) {
+#if ASYNCPP_ENABLE_METRICS
+					res->m_park.finish(contention_of(res));
+#endif
+					return res;
+				}
+			}
+			return nullptr;
+		}
+		template<typename Awaiter>
+		static void push_back(Awaiter*& list, Awaiter* awaiter) noexcept {
+			awaiter->m_next = nullptr;
+			auto last = list;
+			[[maybe_unused]] size_t waiters = 1;
+			while (last && last->m_next) {
+				last = last->m_next;
+				waiters++;
+			}
+			if (last == nullptr)
+				list = awaiter;
+			else {
+				last->m_next = awaiter;
+				waiters++;
+			}
+#if ASYNCPP_ENABLE_METRICS
+			awaiter->m_park.start();
+			contention_of(awaiter).count_waiters(waiters);
+#endif
+		}
+		template<typename Awaiter>
+		static void remove(Awaiter*& list, Awaiter* awaiter) noexcept {
+			for (auto it = &list; *it != nullptr; it = &(*it)->m_next) {
+				if (*it == awaiter) {
+					*it = awaiter->m_next;
+					return;
+				}
+			}
+		}
+		// Chain of awaiters to resume once the lock is released, linked by m_next
+		template<typename Awaiter>
+		struct awaiter_chain {
+			Awaiter* head{};
+			Awaiter* tail{};
+			void append(Awaiter* awaiter) noexcept {
+				awaiter->m_next = nullptr;
+				if (tail != nullptr)
+					tail->m_next = awaiter;
+				else
+					head = awaiter;
+				tail = awaiter;
+			}
+		};
+
+		// Move as many values as possible into waiting readers and the buffer. Needs to be called with m_mtx held,
+		// readers that need to be resumed are returned as a chain linked by m_next.
+		size_t write_locked(std::span<T> values, read_awaiter*& readers);
+		// Take up to max values out of the buffer and waiting writers. Needs to be called with m_mtx held,
+		// writers that need to be resumed are returned as a chain linked by m_next.
+		template<typename OutputIt>
+		size_t read_locked(OutputIt& out, size_t max, write_awaiter*& writers);
+
+		template<typename Awaiter>
+		static void resume(Awaiter* awaiter) {
+			if (awaiter->m_dispatcher != nullptr)
+				awaiter->m_dispatcher->push_resume(awaiter->m_handle);
+			else
+				resume_trampoline::resume(awaiter->m_handle);
+		}
+		template<typename Awaiter>
+		static void resume_chain(Awaiter* awaiter) {
+			while (awaiter != nullptr)
+				resume(std::exchange(awaiter, awaiter->m_next));
+		}
 
 	public:
+		/**
+		 * \brief Construct an unbuffered channel, where every write waits for a matching read.
+		 */
+		channel() = default;
+		/**
+		 * \brief Construct a buffered channel.
+		 * \param capacity Number of values that can be buffered without a reader, 0 creates an unbuffered channel.
+		 */
+		explicit channel(size_t capacity) : m_buffer(capacity) {}
 #ifndef NDEBUG
 		~channel() {
 			assert(m_reader_list == nullptr && m_writer_list == nullptr && "channel destroyed with waiting coroutines");
 		}
 #endif
 
+		/**
+		 * \brief Get the number of values the channel can buffer.
+		 */
+		[[nodiscard]] size_t capacity() const noexcept { return m_buffer.size(); }
+
 		/**
 		 * \brief Read from the channel.
 		 * 
 		 * Suspends until write/try_write is called on a different coroutine or the channel is closed.
+		 * If the channel is buffered and contains values, this does not suspend.
 		 * \return Awaiter for reading (resumes with std::optional<T>).
 		 */
 		[[nodiscard]] read_awaiter read();
+		/**
+		 * \brief Read from the channel, allows cancellation.
+		 *
+		 * Same as read(), but resumes with std::nullopt once a stop is requested on stoken.
+		 * \param stoken A stop_token that allows cancellation of the read
+		 * \return Awaiter for reading (resumes with std::optional<T>).
+		 */
+		[[nodiscard]] cancellable_read_awaiter read(asyncpp::stop_token stoken);
 		/**
 		 * \brief Attempt to read a value without suspending.
-		 * If the channel is closed or no writer is suspended this returns std::nullopt.
+		 * If the channel is closed or no writer is suspended (and no value is buffered) this returns std::nullopt.
 		 */
 		[[nodiscard]] std::optional<T> try_read();
 
 		/**
 		 * \brief Write to the channel.
 		 * \note This will suspend until a reader is available to receive the value or the channel is closed.
+		 * 		Buffered channels only suspend if the buffer is full.
 		 * \return Awaiter for reading (resumes with true if the value was received and false if the channel was closed).
 		 */
 		[[nodiscard]] write_awaiter write(T value);
 		/**
 		 * \brief Attempt to write a value without suspending.
-		 * If the channel is closed or no reader is suspended this returns false.
+		 * If the channel is closed or no reader is suspended (and the buffer is full) this returns false.
 		 */
 		[[nodiscard]] bool try_write(T value);
 
+		/**
+		 * \brief Read multiple values from the channel.
+		 *
+		 * Takes all values that are available right now (up to max) using a single lock acquisition.
+		 * If no value is available it suspends until one is written or the channel is closed.
+		 * \param out Output iterator the read values are written to
+		 * \param max The maximum number of values to read
+		 * \return Awaiter for reading (resumes with the number of values read, 0 if the channel was closed).
+		 */
+		template<std::output_iterator<T> OutputIt>
+		[[nodiscard]] read_many_awaiter<OutputIt> read_many(OutputIt out, size_t max);
+		/**
+		 * \brief Attempt to read multiple values without suspending.
+		 * \param out Output iterator the read values are written to
+		 * \param max The maximum number of values to read
+		 * \return The number of values read
+		 */
+		template<std::output_iterator<T> OutputIt>
+		[[nodiscard]] size_t try_read_many(OutputIt out, size_t max);
+
+		/**
+		 * \brief Write multiple values to the channel.
+		 *
+		 * Hands as many values as possible to waiting readers and the buffer using a single lock acquisition.
+		 * If no value can be written it suspends until a reader takes the first one or the channel is closed.
+		 * \note Written values are moved out of the span, the remaining ones are left untouched.
+		 * \param values The values to write
+		 * \return Awaiter for writing (resumes with the number of values written, 0 if the channel was closed).
+		 */
+		[[nodiscard]] write_many_awaiter write_many(std::span<T> values);
+		/**
+		 * \brief Attempt to write multiple values without suspending.
+		 * \note Written values are moved out of the span, the remaining ones are left untouched.
+		 * \param values The values to write
+		 * \return The number of values written
+		 */
+		[[nodiscard]] size_t try_write_many(std::span<T> values);
+
 		/**
 		 * \brief Close the channel.
 		 * 
@@ -76,6 +277,19 @@ namespace asyncpp {
 		 * \return true if the channel is closed, false if not
 		 */
 		[[nodiscard]] bool is_closed() const noexcept { return m_closed.load(std::memory_order::relaxed); }
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of the readers.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. Waits ended by a stop request or another branch of select()
+		 * are not counted as suspensions.
+		 */
+		[[nodiscard]] contention_metrics read_metrics() const noexcept { return m_read_contention.collect(); }
+		/**
+		 * \brief Get the contention counters of the writers, see read_metrics().
+		 */
+		[[nodiscard]] contention_metrics write_metrics() const noexcept { return m_write_contention.collect(); }
+#endif
 	};
 
 	template<typename T>
@@ -86,6 +300,13 @@ namespace asyncpp {
 		coroutine_handle<> m_handle;
 		dispatcher* m_dispatcher = dispatcher::current();
 		std::optional<T> m_result{std::nullopt};
+		// Only set if this awaiter is a branch of select()
+		detail::select_state* m_select{};
+		size_t m_select_index{};
+		write_awaiter* m_select_peer{};
+#if ASYNCPP_ENABLE_METRICS
+		detail::park_timer m_park{};
+#endif
 
 		/**
 		 * \brief Specify a dispatcher to resume after on after reading.
@@ -103,8 +324,92 @@ namespace asyncpp {
 		[[nodiscard]] constexpr bool await_ready() const noexcept;
 		bool await_suspend(coroutine_handle<> hndl);
 		std::optional<T> await_resume();
+
+		/// \brief Turn this into a cancellable read, used by cancellable_task.
+		[[nodiscard]] cancellable_read_awaiter with_stop_token(asyncpp::stop_token stoken) && noexcept;
+
+		/// \brief Get the mutex that needs to be held for select_try_complete() and select_enqueue()
+		std::mutex& select_mutex() const noexcept { return m_parent->m_mtx; }
+		/// \brief Complete the read if possible without waiting, used by select().
+		bool select_try_complete();
+		/// \brief Register as a waiting branch of a select().
+		void select_enqueue(coroutine_handle<> hndl, detail::select_state* state, size_t index, dispatcher* dsp);
+		/// \brief Resume the writer released by select_try_complete(), needs to be called without holding the lock.
+		void select_finish();
+		/// \brief Remove this awaiter from the channel if it is still registered.
+		void select_cancel();
 	};
 
+	/**
+	 * \brief Read awaiter that can be cancelled using a stop_token.
+	 *
+	 * Waiting works like a select() with the read as one branch and the stop request as the other, whichever
+	 * claims the shared state first completes the read.
+	 */
+	template<typename T>
+	struct channel<T>::cancellable_read_awaiter {
+		struct cancel_callback {
+			cancellable_read_awaiter* m_parent;
+			void operator()() const noexcept { m_parent->cancel(); }
+		};
+		read_awaiter m_read;
+		asyncpp::stop_token m_stoptoken;
+		detail::select_state m_state{};
+		std::optional<asyncpp::stop_callback<cancel_callback>> m_callback{};
+		// Protected by the channel mutex
+		bool m_enqueued{false};
+
+		cancellable_read_awaiter(read_awaiter read, asyncpp::stop_token stoken) noexcept
+			: m_read{std::move(read)}, m_stoptoken{std::move(stoken)} {}
+
+		/// \brief Specify a dispatcher to resume on, see read_awaiter::resume_on()
+		cancellable_read_awaiter& resume_on(dispatcher* dsp) noexcept {
+			m_read.resume_on(dsp);
+			return *this;
+		}
+
+		[[nodiscard]] bool await_ready() const noexcept { return m_stoptoken.stop_requested() || m_read.await_ready(); }
+		bool await_suspend(coroutine_handle<> hndl) {
+#if ASYNCPP_ENABLE_METRICS
+			m_read.m_parent->m_read_contention.count_wait();
+#endif
+			// Register first, if the stop happens before we are enqueued the callback only claims the state
+			m_callback.emplace(m_stoptoken, cancel_callback{this});
+			std::unique_lock lck{m_read.m_parent->m_mtx};
+			if (m_state.m_winner.load(std::memory_order::relaxed) != detail::select_state::npos) return false;
+			if (m_read.select_try_complete()) {
+				lck.unlock();
+				m_read.select_finish();
+				return false;
+			}
+			m_read.select_enqueue(hndl, &m_state, 0, m_read.m_dispatcher);
+			m_enqueued = true;
+			return true;
+		}
+		std::optional<T> await_resume() {
+			// Waits for a concurrently running callback that lost the claim
+			m_callback.reset();
+			return std::move(m_read.m_result);
+		}
+
+	private:
+		void cancel() noexcept {
+			if (!m_state.try_claim(1)) return;
+			std::unique_lock lck{m_read.m_parent->m_mtx};
+			if (!m_enqueued) return;
+			remove(m_read.m_parent->m_reader_list, &m_read);
+			lck.unlock();
+			m_read.m_result.reset();
+			resume(&m_read);
+		}
+	};
+
+	template<typename T>
+	inline typename channel<T>::cancellable_read_awaiter
+	channel<T>::read_awaiter::with_stop_token(asyncpp::stop_token stoken) && noexcept {
+		return cancellable_read_awaiter{std::move(*this), std::move(stoken)};
+	}
+
 	template<typename T>
 	struct channel<T>::write_awaiter {
 		channel* m_parent;
@@ -114,6 +419,13 @@ namespace asyncpp {
 		coroutine_handle<> m_handle;
 		dispatcher* m_dispatcher = dispatcher::current();
 		bool m_result{false};
+		// Only set if this awaiter is a branch of select()
+		detail::select_state* m_select{};
+		size_t m_select_index{};
+		read_awaiter* m_select_peer{};
+#if ASYNCPP_ENABLE_METRICS
+		detail::park_timer m_park{};
+#endif
 
 		/**
 		 * \brief Specify a dispatcher to resume after on after writing.
@@ -131,30 +443,246 @@ namespace asyncpp {
 		[[nodiscard]] constexpr bool await_ready() const noexcept;
 		bool await_suspend(coroutine_handle<> hndl);
 		bool await_resume();
+
+		/// \brief Get the mutex that needs to be held for select_try_complete() and select_enqueue()
+		std::mutex& select_mutex() const noexcept { return m_parent->m_mtx; }
+		/// \brief Complete the write if possible without waiting, used by select().
+		bool select_try_complete();
+		/// \brief Register as a waiting branch of a select().
+		void select_enqueue(coroutine_handle<> hndl, detail::select_state* state, size_t index, dispatcher* dsp);
+		/// \brief Resume the reader released by select_try_complete(), needs to be called without holding the lock.
+		void select_finish();
+		/// \brief Remove this awaiter from the channel if it is still registered.
+		void select_cancel();
+	};
+
+	template<typename T>
+	template<std::output_iterator<T> OutputIt>
+	struct channel<T>::read_many_awaiter {
+		channel* m_parent;
+		OutputIt m_out;
+		size_t m_max;
+
+		dispatcher* m_dispatcher = dispatcher::current();
+		size_t m_result{0};
+		// Used to wait on the reader list if nothing is available
+		std::optional<read_awaiter> m_single{};
+
+		/**
+		 * \brief Specify a dispatcher to resume after on after reading.
+		 * \param dsp The dispatcher to resume on or nullptr to resume inside the write call.
+		 */
+		read_many_awaiter& resume_on(dispatcher* dsp) noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept {
+			return m_max == 0 || (m_parent->m_buffer.empty() && m_parent->m_closed.load(std::memory_order::relaxed));
+		}
+		bool await_suspend(coroutine_handle<> hndl) {
+#if ASYNCPP_ENABLE_METRICS
+			m_parent->m_read_contention.count_wait();
+#endif
+			std::unique_lock lck{m_parent->m_mtx};
+			write_awaiter* writers = nullptr;
+			m_result = m_parent->read_locked(m_out, m_max, writers);
+			if (m_result != 0 || m_parent->m_closed.load(std::memory_order::relaxed)) {
+				lck.unlock();
+				resume_chain(writers);
+				return false;
+			}
+			// Nothing available, wait for a single value
+			auto& rdr = m_single.emplace(read_awaiter{m_parent});
+			rdr.m_handle = hndl;
+			rdr.m_dispatcher = m_dispatcher;
+			push_back(m_parent->m_reader_list, &rdr);
+			return true;
+		}
+		size_t await_resume() {
+			if (m_single && m_single->m_result) {
+				*m_out++ = std::move(*m_single->m_result);
+				m_result = 1;
+			}
+			return m_result;
+		}
+	};
+
+	template<typename T>
+	struct channel<T>::write_many_awaiter {
+		channel* m_parent;
+		std::span<T> m_values;
+
+		dispatcher* m_dispatcher = dispatcher::current();
+		size_t m_result{0};
+		// Used to wait on the writer list if nothing can be written
+		std::optional<write_awaiter> m_single{};
+
+		/**
+		 * \brief Specify a dispatcher to resume after on after writing.
+		 * \param dsp The dispatcher to resume on or nullptr to resume inside the read call.
+		 */
+		write_many_awaiter& resume_on(dispatcher* dsp) noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept {
+			return m_values.empty() || m_parent->m_closed.load(std::memory_order::relaxed);
+		}
+		bool await_suspend(coroutine_handle<> hndl) {
+#if ASYNCPP_ENABLE_METRICS
+			m_parent->m_write_contention.count_wait();
+#endif
+			std::unique_lock lck{m_parent->m_mtx};
+			if (m_parent->m_closed.load(std::memory_order::relaxed)) return false;
+			read_awaiter* readers = nullptr;
+			m_result = m_parent->write_locked(m_values, readers);
+			if (m_result != 0) {
+				lck.unlock();
+				resume_chain(readers);
+				return false;
+			}
+			// Nothing could be written, wait for a reader to take the first value
+			auto& wrt = m_single.emplace(write_awaiter{m_parent, std::move(m_values.front())});
+			wrt.m_handle = hndl;
+			wrt.m_dispatcher = m_dispatcher;
+			push_back(m_parent->m_writer_list, &wrt);
+			return true;
+		}
+		size_t await_resume() {
+			if (!m_single) return m_result;
+			if (m_single->m_result) return 1;
+			// The channel was closed while waiting, give the value back so the span stays untouched
+			m_values.front() = std::move(m_single->m_value);
+			return 0;
+		}
 	};
 
+	template<typename T>
+	inline size_t channel<T>::write_locked(std::span<T> values, read_awaiter*& readers) {
+		size_t n = 0;
+		// Readers only wait if the buffer is empty, so they come first
+		awaiter_chain<read_awaiter> chain;
+		while (n < values.size()) {
+			auto rdr = pop_front(m_reader_list);
+			if (rdr == nullptr) break;
+			rdr->m_result = std::move(values[n++]);
+			chain.append(rdr);
+		}
+		readers = chain.head;
+		while (n < values.size() && !buffer_full())
+			buffer_push(std::move(values[n++]));
+		return n;
+	}
+
+	template<typename T>
+	template<typename OutputIt>
+	inline size_t channel<T>::read_locked(OutputIt& out, size_t max, write_awaiter*& writers) {
+		size_t n = 0;
+		while (n < max && m_buffer_size != 0) {
+			*out++ = buffer_pop();
+			n++;
+		}
+		// Writers only wait if the buffer is full. Once the buffer is drained we take their values directly,
+		// after that we use them to refill the buffer.
+		awaiter_chain<write_awaiter> chain;
+		while (n < max || !buffer_full()) {
+			auto wrt = pop_front(m_writer_list);
+			if (wrt == nullptr) break;
+			wrt->m_result = true;
+			if (n < max) {
+				*out++ = std::move(wrt->m_value);
+				n++;
+			} else
+				buffer_push(std::move(wrt->m_value));
+			chain.append(wrt);
+		}
+		writers = chain.head;
+		return n;
+	}
+
+	template<typename T>
+	template<std::output_iterator<T> OutputIt>
+	inline typename channel<T>::template read_many_awaiter<OutputIt> channel<T>::read_many(OutputIt out, size_t max) {
+		return read_many_awaiter<OutputIt>{this, std::move(out), max};
+	}
+
+	template<typename T>
+	template<std::output_iterator<T> OutputIt>
+	inline size_t channel<T>::try_read_many(OutputIt out, size_t max) {
+		if (max == 0 || (m_buffer.empty() && m_closed.load(std::memory_order::relaxed))) return 0;
+		std::unique_lock lck{m_mtx};
+		if (m_buffer.empty() && m_closed.load(std::memory_order::relaxed)) return 0;
+		write_awaiter* writers = nullptr;
+		auto res = read_locked(out, max, writers);
+		lck.unlock();
+		resume_chain(writers);
+		return res;
+	}
+
+	template<typename T>
+	inline typename channel<T>::write_many_awaiter channel<T>::write_many(std::span<T> values) {
+		return write_many_awaiter{this, values};
+	}
+
+	template<typename T>
+	inline size_t channel<T>::try_write_many(std::span<T> values) {
+		if (values.empty() || m_closed.load(std::memory_order::relaxed)) return 0;
+		std::unique_lock lck{m_mtx};
+		if (m_closed.load(std::memory_order::relaxed)) return 0;
+		read_awaiter* readers = nullptr;
+		auto res = write_locked(values, readers);
+		lck.unlock();
+		resume_chain(readers);
+		return res;
+	}
+
+	template<typename T>
+	inline typename channel<T>::cancellable_read_awaiter channel<T>::read(asyncpp::stop_token stoken) {
+		return cancellable_read_awaiter{read(), std::move(stoken)};
+	}
+
 	template<typename T>
 	inline typename channel<T>::read_awaiter channel<T>::read() {
 		return read_awaiter{this};
 	}
 
+	template<typename T>
+	inline T channel<T>::buffer_take_locked(write_awaiter*& writer) {
+		T res = buffer_pop();
+		// A writer waiting means the buffer was full, so move its value into the slot we just freed
+		writer = pop_front(m_writer_list);
+		if (writer != nullptr) {
+			buffer_push(std::move(writer->m_value));
+			writer->m_result = true;
+		}
+		return res;
+	}
+
+	template<typename T>
+	inline std::optional<T> channel<T>::buffer_take(std::unique_lock<std::mutex>& lck) {
+		write_awaiter* wrt = nullptr;
+		std::optional<T> res = buffer_take_locked(wrt);
+		lck.unlock();
+		if (wrt != nullptr) resume(wrt);
+		return res;
+	}
+
 	template<typename T>
 	inline std::optional<T> channel<T>::try_read() {
-		if (m_closed.load(std::memory_order::relaxed)) return std::nullopt;
+		if (m_buffer.empty() && m_closed.load(std::memory_order::relaxed)) return std::nullopt;
 		std::unique_lock lck{m_mtx};
+		if (m_buffer_size != 0) return buffer_take(lck);
 		// Check if there is a writer waiting
-		if (auto wrt = m_writer_list; wrt != nullptr && !m_closed.load(std::memory_order::relaxed)) {
-			// Unhook writer
-			m_writer_list = wrt->m_next;
+		if (m_closed.load(std::memory_order::relaxed)) return std::nullopt;
+		if (auto wrt = pop_front(m_writer_list); wrt != nullptr) {
 			lck.unlock();
 			// Take the value out
 			std::optional<T> res = std::move(wrt->m_value);
 			wrt->m_result = true;
 			// Resume writer
-			if (wrt->m_dispatcher != nullptr)
-				wrt->m_dispatcher->push([wrt]() { wrt->m_handle.resume(); });
-			else
-				wrt->m_handle.resume();
+			resume(wrt);
 			return res;
 		}
 		return std::nullopt;
@@ -169,18 +697,18 @@ namespace asyncpp {
 	inline bool channel<T>::try_write(T value) {
 		if (m_closed.load(std::memory_order::relaxed)) return false;
 		std::unique_lock lck{m_mtx};
+		if (m_closed.load(std::memory_order::relaxed)) return false;
 		// Check if there is a reader waiting
-		if (auto rdr = m_reader_list; rdr != nullptr && !m_closed.load(std::memory_order::relaxed)) {
-			// Unhook reader
-			m_reader_list = rdr->m_next;
+		if (auto rdr = pop_front(m_reader_list); rdr != nullptr) {
 			lck.unlock();
 			// Take the value out
 			rdr->m_result = std::move(value);
 			// Resume writer
-			if (rdr->m_dispatcher != nullptr)
-				rdr->m_dispatcher->push([rdr]() { rdr->m_handle.resume(); });
-			else
-				rdr->m_handle.resume();
+			resume(rdr);
+			return true;
+		}
+		if (!buffer_full()) {
+			buffer_push(std::move(value));
 			return true;
 		}
 		return false;
@@ -192,68 +720,57 @@ namespace asyncpp {
 		std::unique_lock lck{m_mtx};
 		if (!m_closed.exchange(true)) {
 			// This is the first close, so cancel all waiting awaiters
-			while (m_reader_list != nullptr) {
-				auto rdr = m_reader_list;
-				m_reader_list = rdr->m_next;
-				// We do not need to unlock, because all further attempts to access this
-				// cannel will get refused.
+			awaiter_chain<read_awaiter> readers;
+			while (auto rdr = pop_front(m_reader_list)) {
 				rdr->m_result.reset();
-				// Resume reader
-				if (rdr->m_dispatcher != nullptr)
-					rdr->m_dispatcher->push([rdr]() { rdr->m_handle.resume(); });
-				else
-					rdr->m_handle.resume();
+				readers.append(rdr);
 			}
-			while (m_writer_list != nullptr) {
-				auto wrt = m_writer_list;
-				m_writer_list = wrt->m_next;
-				// We do not need to unlock, because all further attempts to access this
-				// cannel will get refused.
+			awaiter_chain<write_awaiter> writers;
+			while (auto wrt = pop_front(m_writer_list)) {
 				wrt->m_result = false;
-				// Resume reader
-				if (wrt->m_dispatcher != nullptr)
-					wrt->m_dispatcher->push([wrt]() { wrt->m_handle.resume(); });
-				else
-					wrt->m_handle.resume();
+				writers.append(wrt);
 			}
+			// Resume after unlocking, a resumed coroutine might access the channel again
+			lck.unlock();
+			resume_chain(readers.head);
+			resume_chain(writers.head);
 		}
 	}
 
 	template<typename T>
 	inline constexpr bool channel<T>::read_awaiter::await_ready() const noexcept {
-		return m_parent->m_closed.load(std::memory_order::relaxed);
+		// Buffered channels might still contain values after close
+		return m_parent->m_buffer.empty() && m_parent->m_closed.load(std::memory_order::relaxed);
 	}
 
 	template<typename T>
 	inline bool channel<T>::read_awaiter::await_suspend(coroutine_handle<> hndl) {
 		m_handle = hndl;
 		m_next = nullptr;
+#if ASYNCPP_ENABLE_METRICS
+		m_parent->m_read_contention.count_wait();
+#endif
 		std::unique_lock lck{m_parent->m_mtx};
+		if (m_parent->m_buffer_size != 0) {
+			m_result = m_parent->buffer_take(lck);
+			return false;
+		}
+		// Closed while we were waiting for the lock
+		if (m_parent->m_closed.load(std::memory_order::relaxed)) return false;
 		// Check if there is a writer waiting
-		if (auto wrt = m_parent->m_writer_list; wrt != nullptr) {
-			// Unhook writer
-			m_parent->m_writer_list = wrt->m_next;
+		if (auto wrt = pop_front(m_parent->m_writer_list); wrt != nullptr) {
 			lck.unlock();
 			// Take the value out
 			m_result = std::move(wrt->m_value);
 			wrt->m_result = true;
 			// Resume writer
-			if (wrt->m_dispatcher != nullptr)
-				wrt->m_dispatcher->push([wrt]() { wrt->m_handle.resume(); });
-			else
-				wrt->m_handle.resume();
+			resume(wrt);
 			// Do not suspend ourself
 			return false;
 		}
 
 		// No writer available, we have to wait...
-		auto last = m_parent->m_reader_list;
-		while (last && last->m_next)
-			last = last->m_next;
-		if (last == nullptr)
-			m_parent->m_reader_list = this;
-		else
-			last->m_next = this;
+		push_back(m_parent->m_reader_list, this);
 		return true;
 	}
 
@@ -271,33 +788,31 @@ namespace asyncpp {
 	inline bool channel<T>::write_awaiter::await_suspend(coroutine_handle<> hndl) {
 		m_handle = hndl;
 		m_next = nullptr;
+#if ASYNCPP_ENABLE_METRICS
+		m_parent->m_write_contention.count_wait();
+#endif
 		if (m_parent->m_closed.load(std::memory_order::relaxed)) return false;
 		std::unique_lock lck{m_parent->m_mtx};
 		if (m_parent->m_closed.load(std::memory_order::relaxed)) return false;
 		// Check if there is a reader waiting
-		if (auto rdr = m_parent->m_reader_list; rdr != nullptr) {
-			// Unhook reader
-			m_parent->m_reader_list = rdr->m_next;
+		if (auto rdr = pop_front(m_parent->m_reader_list); rdr != nullptr) {
 			lck.unlock();
 			// Copy the value over
 			rdr->m_result = std::move(m_value);
 			// Resume reader
-			if (rdr->m_dispatcher != nullptr)
-				rdr->m_dispatcher->push([rdr]() { rdr->m_handle.resume(); });
-			else
-				rdr->m_handle.resume();
+			resume(rdr);
 			// Do not suspend ourself
+			m_result = true;
+			return false;
+		}
+		if (!m_parent->buffer_full()) {
+			m_parent->buffer_push(std::move(m_value));
+			m_result = true;
 			return false;
 		}
 
 		// No reader available, we have to wait...
-		auto last = m_parent->m_writer_list;
-		while (last && last->m_next)
-			last = last->m_next;
-		if (last == nullptr)
-			m_parent->m_writer_list = this;
-		else
-			last->m_next = this;
+		push_back(m_parent->m_writer_list, this);
 		return true;
 	}
 
@@ -305,4 +820,85 @@ namespace asyncpp {
 	inline bool channel<T>::write_awaiter::await_resume() {
 		return m_result;
 	}
+
+	template<typename T>
+	inline bool channel<T>::read_awaiter::select_try_complete() {
+		if (m_parent->m_buffer_size != 0) {
+			m_result = m_parent->buffer_take_locked(m_select_peer);
+			return true;
+		}
+		if (m_parent->m_closed.load(std::memory_order::relaxed)) {
+			m_result.reset();
+			return true;
+		}
+		if (auto wrt = pop_front(m_parent->m_writer_list); wrt != nullptr) {
+			m_result = std::move(wrt->m_value);
+			wrt->m_result = true;
+			m_select_peer = wrt;
+			return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	inline void channel<T>::read_awaiter::select_enqueue(coroutine_handle<> hndl, detail::select_state* state,
+														 size_t index, dispatcher* dsp) {
+		m_handle = hndl;
+		m_select = state;
+		m_select_index = index;
+		m_dispatcher = dsp;
+		push_back(m_parent->m_reader_list, this);
+	}
+
+	template<typename T>
+	inline void channel<T>::read_awaiter::select_finish() {
+		if (m_select_peer != nullptr) resume(std::exchange(m_select_peer, nullptr));
+	}
+
+	template<typename T>
+	inline void channel<T>::read_awaiter::select_cancel() {
+		std::unique_lock lck{m_parent->m_mtx};
+		remove(m_parent->m_reader_list, this);
+	}
+
+	template<typename T>
+	inline bool channel<T>::write_awaiter::select_try_complete() {
+		if (m_parent->m_closed.load(std::memory_order::relaxed)) {
+			m_result = false;
+			return true;
+		}
+		if (auto rdr = pop_front(m_parent->m_reader_list); rdr != nullptr) {
+			rdr->m_result = std::move(m_value);
+			m_result = true;
+			m_select_peer = rdr;
+			return true;
+		}
+		if (!m_parent->buffer_full()) {
+			m_parent->buffer_push(std::move(m_value));
+			m_result = true;
+			return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	inline void channel<T>::write_awaiter::select_enqueue(coroutine_handle<> hndl, detail::select_state* state,
+														  size_t index, dispatcher* dsp) {
+		m_handle = hndl;
+		m_select = state;
+		m_select_index = index;
+		m_dispatcher = dsp;
+		push_back(m_parent->m_writer_list, this);
+	}
+
+	template<typename T>
+	inline void channel<T>::write_awaiter::select_finish() {
+		if (m_select_peer != nullptr) resume(std::exchange(m_select_peer, nullptr));
+	}
+
+	template<typename T>
+	inline void channel<T>::write_awaiter::select_cancel() {
+		std::unique_lock lck{m_parent->m_mtx};
+		remove(m_parent->m_writer_list, this);
+	}
 } // namespace asyncpp
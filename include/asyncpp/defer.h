@@ -1,6 +1,7 @@
 #pragma once
 #include <asyncpp/detail/concepts.h>
 #include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
 #include <utility>
 
 namespace asyncpp {
@@ -11,11 +12,16 @@ namespace asyncpp {
 	 * This stops executions on the current dispatcher and reschedules the function on the provided dispatcher.
 	 * It can be used if a function needs to run within a certain thread (e.g. libuv I/O) or to give a different task
 	 * the chance to get work done. Does nothing if the dispatcher is nullptr.
+	 *
+	 * A priority other than task_priority::normal is passed to push_resume_prioritized() if the dispatcher
+	 * provides it, and ignored otherwise.
 	 */
 	template<Dispatcher TDispatcher>
 	struct defer {
 		/// \brief The new dispatcher to resume execution on.
 		TDispatcher* target_dispatcher;
+		/// \brief The priority to resume with.
+		task_priority priority{task_priority::normal};
 
 		/**
 		 * \brief Construct with a pointer to a dispatcher.
@@ -30,6 +36,23 @@ namespace asyncpp {
 		 */
 		explicit constexpr defer(TDispatcher& target) noexcept : target_dispatcher(&target) {}
 
+		/**
+		 * \brief Construct with a pointer to a dispatcher and the priority to resume with.
+		 * \param target The dispatcher to resume on.
+		 * \param prio The priority to resume with.
+		 * \note If target is nullptr the defer is a noop and does not suspend.
+		 */
+		constexpr defer(TDispatcher* target, task_priority prio) noexcept
+			: target_dispatcher(target), priority(prio) {}
+
+		/**
+		 * \brief Construct with a reference to a dispatcher and the priority to resume with.
+		 * \param target The dispatcher to resume on.
+		 * \param prio The priority to resume with.
+		 */
+		constexpr defer(TDispatcher& target, task_priority prio) noexcept
+			: target_dispatcher(&target), priority(prio) {}
+
 		/**
 		 * \brief Check if await should suspend
 		 * \return true if a dispatcher was set.
@@ -39,11 +62,32 @@ namespace asyncpp {
 		 * \brief Suspend the current coroutine and schedule resumption on the specified dispatcher.
 		 * \param h The current coroutine
 		 */
-		void await_suspend(coroutine_handle<> hndl) const
-			noexcept(noexcept(target_dispatcher->push(std::declval<std::function<void()>>()))) {
-			target_dispatcher->push([hndl]() mutable { hndl.resume(); });
+		void await_suspend(coroutine_handle<> hndl) const noexcept(is_suspend_noexcept()) {
+			if constexpr (requires { target_dispatcher->push_resume_prioritized(hndl, priority); }) {
+				if (priority != task_priority::normal) {
+					target_dispatcher->push_resume_prioritized(hndl, priority);
+					return;
+				}
+			}
+			if constexpr (requires { target_dispatcher->push_resume(hndl); })
+				target_dispatcher->push_resume(hndl);
+			else
+				target_dispatcher->push([hndl]() mutable { hndl.resume(); });
 		}
 		/// \brief Called on resumption
 		constexpr void await_resume() const noexcept {}
+
+	private:
+		// Derived from the functions await_suspend() actually calls
+		static constexpr bool is_suspend_noexcept() noexcept {
+			constexpr coroutine_handle<> hndl{};
+			bool res = true;
+			if constexpr (requires(TDispatcher& d) { d.push_resume_prioritized(hndl, task_priority::normal); })
+				res = noexcept(std::declval<TDispatcher&>().push_resume_prioritized(hndl, task_priority::normal));
+			if constexpr (requires(TDispatcher& d) { d.push_resume(hndl); })
+				return res && noexcept(std::declval<TDispatcher&>().push_resume(hndl));
+			else
+				return res && noexcept(std::declval<TDispatcher&>().push([hndl]() mutable { hndl.resume(); }));
+		}
 	};
 } // namespace asyncpp
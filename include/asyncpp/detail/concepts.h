@@ -68,4 +68,14 @@ namespace asyncpp {
 		{ std::allocator_traits<Allocator>::allocate(alloc, 0) } -> std::convertible_to<std::byte*>;
 		{ std::allocator_traits<Allocator>::deallocate(alloc, std::declval<std::byte*>(), 0) };
 	};
+
+	/**
+	 * \brief Check if a ByteAllocator can recover an allocator suitable for freeing a pointer from the pointer itself.
+	 *
+	 * Coroutine frames allocated with such an allocator do not store a copy of it in front of the frame.
+	 */
+	template<class Allocator>
+	concept ArenaBoundAllocator = ByteAllocator<Allocator> && requires(std::byte* ptr) {
+		{ Allocator::owner_of(ptr) } -> std::convertible_to<Allocator>;
+	};
 } // namespace asyncpp
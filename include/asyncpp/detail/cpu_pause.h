@@ -0,0 +1,28 @@
+#pragma once
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace asyncpp::detail {
+	/**
+	 * \brief Pause the current cpu. This is effectively an optimized nop
+	 * 	      that reduces congestion in hyperthreading and improves power usage.
+	 */
+	inline void cpu_pause() noexcept {
+#if defined(__i386) || defined(_M_IX86) || defined(_X86_) || defined(__amd64) || defined(_M_AMD64)
+#ifdef _MSC_VER
+		_mm_pause();
+#else
+		__builtin_ia32_pause();
+#endif
+#elif defined(__arm__) || defined(_ARM) || defined(_M_ARM) || defined(__arm)
+#ifdef _MSC_VER
+		__yield();
+#else
+		asm volatile("yield");
+#endif
+#elif defined(__riscv)
+		asm volatile("pause");
+#endif
+	}
+} // namespace asyncpp::detail
@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace asyncpp::detail {
+	/**
+	 * \brief A cpu the process may run on and the NUMA node it belongs to.
+	 */
+	struct cpu_slot {
+		int cpu;
+		int node;
+	};
+
+	/**
+	 * \brief Parse a kernel cpu list like "0-3,8,10-11".
+	 * \return The cpus in the list, invalid parts are ignored
+	 */
+	inline std::vector<int> parse_cpu_list(const std::string& list) {
+		std::vector<int> res;
+		size_t pos = 0;
+		while (pos < list.size()) {
+			auto end = list.find(',', pos);
+			if (end == std::string::npos) end = list.size();
+			const auto part = list.substr(pos, end - pos);
+			pos = end + 1;
+			try {
+				const auto dash = part.find('-');
+				const int first = std::stoi(part.substr(0, dash));
+				const int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+				for (int cpu = first; cpu <= last; cpu++)
+					res.push_back(cpu);
+			} catch (const std::exception&) { continue; }
+		}
+		return res;
+	}
+
+	/**
+	 * \brief Get the cpus the calling thread is allowed to run on, grouped by NUMA node.
+	 *
+	 * The node of every cpu is read from /sys/devices/system/node. If the topology is not available every cpu is
+	 * reported as part of node 0. On platforms other than Linux the result is empty.
+	 * \return The cpus sorted by node and cpu number
+	 */
+	inline std::vector<cpu_slot> get_cpu_topology() {
+		std::vector<cpu_slot> res;
+#ifdef __linux__
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return res;
+		std::vector<int> node_of(CPU_SETSIZE, 0);
+		std::ifstream online{"/sys/devices/system/node/online"};
+		std::string nodes;
+		if (online && std::getline(online, nodes)) {
+			for (auto node : parse_cpu_list(nodes)) {
+				std::ifstream cpulist{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+				std::string cpus;
+				if (!cpulist || !std::getline(cpulist, cpus)) continue;
+				for (auto cpu : parse_cpu_list(cpus)) {
+					if (cpu >= 0 && cpu < CPU_SETSIZE) node_of[cpu] = node;
+				}
+			}
+		}
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &allowed)) res.push_back(cpu_slot{cpu, node_of[cpu]});
+		}
+		std::stable_sort(res.begin(), res.end(),
+						 [](const cpu_slot& lhs, const cpu_slot& rhs) { return lhs.node < rhs.node; });
+#endif
+		return res;
+	}
+
+	/**
+	 * \brief Pin the calling thread to a single cpu.
+	 * \return true on success, false if pinning failed or is not supported
+	 */
+	inline bool pin_current_thread(int cpu) noexcept {
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		static_cast<void>(cpu);
+		return false;
+#endif
+	}
+
+	/**
+	 * \brief Get the cpu the calling thread is currently running on.
+	 * \return The cpu number or -1 if it is not known
+	 */
+	inline int current_cpu() noexcept {
+#ifdef __linux__
+		return sched_getcpu();
+#else
+		return -1;
+#endif
+	}
+} // namespace asyncpp::detail
@@ -2,6 +2,8 @@
 #include <asyncpp/detail/concepts.h>
 #include <asyncpp/detail/parameter_pack.h>
 #include <asyncpp/detail/std_import.h>
+#include <asyncpp/frame_pool.h>
+#include <asyncpp/frame_registry.h>
 #include <type_traits>
 
 namespace asyncpp {
@@ -20,6 +22,9 @@ namespace asyncpp::detail {
 
 		template<typename... Args>
 		void* operator new(size_t size, Args&&... args) {
+#if ASYNCPP_TRACK_FRAMES
+			g_last_frame_size = size;
+#endif
 			if constexpr (std::allocator_traits<allocator_type>::is_always_equal::value) {
 				allocator_type alloc{};
 				return std::allocator_traits<allocator_type>::allocate(alloc, size);
@@ -29,9 +34,14 @@ namespace asyncpp::detail {
 				static_assert(std::is_convertible_v<std::remove_cvref_t<decltype(alloc)>&, allocator_type> ||
 								  std::is_constructible_v<allocator_type, decltype(alloc)>,
 							  "last argument is not of allocator type");
-				auto ptr = std::allocator_traits<allocator_type>::allocate(alloc, size + sizeof(allocator_type));
-				auto aptr = new (ptr) allocator_type{std::move(alloc)};
-				return aptr + 1;
+				// The allocator can be recovered from the frame address, no need to store it
+				if constexpr (ArenaBoundAllocator<allocator_type>) {
+					return std::allocator_traits<allocator_type>::allocate(alloc, size);
+				} else {
+					auto ptr = std::allocator_traits<allocator_type>::allocate(alloc, size + sizeof(allocator_type));
+					auto aptr = new (ptr) allocator_type{std::move(alloc)};
+					return aptr + 1;
+				}
 			}
 		}
 		void operator delete(void* ptr, size_t size) {
@@ -39,6 +49,9 @@ namespace asyncpp::detail {
 			if constexpr (std::allocator_traits<allocator_type>::is_always_equal::value) {
 				allocator_type alloc{};
 				std::allocator_traits<allocator_type>::deallocate(alloc, static_cast<std::byte*>(ptr), size);
+			} else if constexpr (ArenaBoundAllocator<allocator_type>) {
+				allocator_type alloc = allocator_type::owner_of(static_cast<std::byte*>(ptr));
+				std::allocator_traits<allocator_type>::deallocate(alloc, static_cast<std::byte*>(ptr), size);
 			} else {
 				allocator_type* info = static_cast<allocator_type*>(ptr) - 1;
 				auto alloc = std::move(*info);
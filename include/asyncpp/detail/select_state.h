@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace asyncpp::detail {
+	/**
+	 * \brief Shared state of a select() operation waiting on multiple channels.
+	 *
+	 * Every branch of the select registers an awaiter on its channel, all pointing to the same state. The first
+	 * channel operation that wants to complete one of them has to claim the state, all other branches are
+	 * considered cancelled afterwards and get skipped.
+	 */
+	struct select_state {
+		/// \brief Value of m_winner while no branch has completed yet
+		static constexpr size_t npos = SIZE_MAX;
+		/// \brief Index of the branch that completed the select
+		std::atomic<size_t> m_winner{npos};
+
+		select_state() noexcept = default;
+		/// \brief Move the state, this is only valid before any branch got registered
+		select_state(select_state&& other) noexcept : m_winner{other.m_winner.load(std::memory_order::relaxed)} {}
+		select_state& operator=(select_state&&) = delete;
+
+		/**
+		 * \brief Try to complete the select with the given branch.
+		 * \return true if the branch won, false if another branch already completed
+		 */
+		bool try_claim(size_t index) noexcept {
+			size_t expected = npos;
+			return m_winner.compare_exchange_strong(expected, index, std::memory_order::acq_rel,
+													std::memory_order::acquire);
+		}
+	};
+} // namespace asyncpp::detail
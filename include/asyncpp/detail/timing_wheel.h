@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace asyncpp::detail {
+	/**
+	 * \brief Node stored inside a timing_wheel.
+	 *
+	 * This is declared outside of timing_wheel so pointers to it can be used while T is still incomplete.
+	 */
+	template<typename T>
+	struct timing_wheel_node {
+		timing_wheel_node* prev{};
+		timing_wheel_node* next{};
+		/// \brief Absolute tick at which this node expires
+		std::uint64_t expiry{};
+		/// \brief Index of the slot this node is linked into
+		std::uint32_t slot{};
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T& value() noexcept { return *std::launder(reinterpret_cast<T*>(storage)); }
+		const T& value() const noexcept { return *std::launder(reinterpret_cast<const T*>(storage)); }
+	};
+
+	/**
+	 * \brief Hierarchical timing wheel with O(1) insert and removal.
+	 *
+	 * Nodes are kept in intrusive doubly linked lists, one per slot. Level 0 has one slot per tick, every higher level
+	 * covers 64 times the range of the one below. Nodes on higher levels are cascaded down once the lower level wraps
+	 * around. Released nodes are kept in a free list and reused, so steady state operation does not allocate.
+	 *
+	 * \note This class is not thread safe, it is expected to be protected by an external lock.
+	 * \tparam T Type of the value stored in every node
+	 */
+	template<typename T>
+	class timing_wheel {
+	public:
+		using node = timing_wheel_node<T>;
+
+		/**
+		 * \brief Construct a new timing wheel
+		 * \param start_tick The current tick
+		 */
+		explicit timing_wheel(std::uint64_t start_tick = 0) noexcept : m_current{start_tick} {}
+		~timing_wheel() {
+			assert(m_size == 0);
+			while (m_free != nullptr)
+				delete std::exchange(m_free, m_free->next);
+		}
+		timing_wheel(const timing_wheel&) = delete;
+		timing_wheel& operator=(const timing_wheel&) = delete;
+
+		/**
+		 * \brief Construct a new value and insert it into the wheel.
+		 * \param expiry The absolute tick at which the node expires, nodes in the past expire on the next advance
+		 * \param args Arguments to forward to the value constructor
+		 * \return The inserted node, which stays valid until it is passed to release()
+		 */
+		template<typename... Args>
+		node* emplace(std::uint64_t expiry, Args&&... args) {
+			node* res = m_free;
+			if (res != nullptr) {
+				m_free = res->next;
+				m_free_size--;
+			} else
+				res = new node;
+			try {
+				new (res->storage) T(std::forward<Args>(args)...);
+			} catch (...) {
+				delete res;
+				throw;
+			}
+			res->expiry = expiry;
+			adopt(res);
+			return res;
+		}
+
+		/**
+		 * \brief Allocate and construct a node without inserting it.
+		 *
+		 * This does not access the wheel, so it can be used without holding the lock protecting the wheel.
+		 * The node can later be inserted using adopt() or destroyed using destroy_node().
+		 * \param expiry The absolute tick at which the node expires
+		 * \param args Arguments to forward to the value constructor
+		 */
+		template<typename... Args>
+		static node* make_node(std::uint64_t expiry, Args&&... args) {
+			auto res = std::make_unique<node>();
+			new (res->storage) T(std::forward<Args>(args)...);
+			res->expiry = expiry;
+			return res.release();
+		}
+
+		/**
+		 * \brief Destroy a node that is not part of any wheel.
+		 */
+		static void destroy_node(node* n) noexcept {
+			n->value().~T();
+			delete n;
+		}
+
+		/**
+		 * \brief Insert a node previously created using make_node().
+		 */
+		void adopt(node* n) noexcept {
+			insert(n);
+			m_size++;
+		}
+
+		/**
+		 * \brief Remove a node from the wheel without releasing it.
+		 * \note The node needs to be currently linked into the wheel.
+		 */
+		void unlink(node* n) noexcept {
+			remove(n);
+			m_size--;
+		}
+
+		/**
+		 * \brief Destroy the value of a node that is no longer linked into the wheel and recycle it.
+		 */
+		void release(node* n) noexcept {
+			n->value().~T();
+			// Adopted nodes are allocated outside, so we need to bound the free list
+			if (m_free_size >= max_free_nodes) {
+				delete n;
+				return;
+			}
+			n->next = m_free;
+			m_free = n;
+			m_free_size++;
+		}
+
+		/**
+		 * \brief Advance the wheel up to (and including) the given tick.
+		 * \param target The tick to advance to
+		 * \return A singly linked list (using node::next) of all nodes that expired, they are no longer in the wheel
+		 */
+		node* advance(std::uint64_t target) noexcept {
+			node* expired = nullptr;
+			take_slot(due_slot, expired);
+			while (m_current < target) {
+				if (m_size == 0) {
+					m_current = target;
+					break;
+				}
+				// Skip directly to the next occupied slot on level 0, or the next wrap around if there is none
+				const auto idx = m_current & slot_mask;
+				const auto ahead = idx == slot_mask ? 0 : m_occupied[0] & (~std::uint64_t{0} << (idx + 1));
+				const auto next = m_current - idx + (ahead != 0 ? std::countr_zero(ahead) : slots_per_level);
+				if (next > target) {
+					m_current = target;
+					break;
+				}
+				m_current = next;
+				if ((m_current & slot_mask) == 0) cascade();
+				take_slot(m_current & slot_mask, expired);
+				take_slot(due_slot, expired);
+			}
+			return expired;
+		}
+
+		/**
+		 * \brief Remove all nodes from the wheel.
+		 * \return A singly linked list (using node::next) of all nodes that were in the wheel
+		 */
+		node* take_all() noexcept {
+			node* res = nullptr;
+			for (std::uint32_t i = 0; i < m_slots.size(); i++)
+				take_slot(i, res);
+			return res;
+		}
+
+		/**
+		 * \brief Get the next tick at which advance() might return nodes.
+		 * \note This is a lower bound, the tick might not expire any nodes if higher levels need to be cascaded.
+		 * \return The tick or UINT64_MAX if the wheel is empty
+		 */
+		[[nodiscard]] std::uint64_t next_tick() const noexcept {
+			if (m_size == 0) return UINT64_MAX;
+			if (m_slots[due_slot] != nullptr) return m_current;
+			const auto idx = m_current & slot_mask;
+			const auto ahead = idx == slot_mask ? 0 : m_occupied[0] & (~std::uint64_t{0} << (idx + 1));
+			return m_current - idx + (ahead != 0 ? std::countr_zero(ahead) : slots_per_level);
+		}
+
+		/// \brief Get the current tick
+		[[nodiscard]] std::uint64_t current_tick() const noexcept { return m_current; }
+		/// \brief Get the number of nodes inside the wheel
+		[[nodiscard]] size_t size() const noexcept { return m_size; }
+		/// \brief Check if the wheel is empty
+		[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+	private:
+		static constexpr std::uint32_t slot_bits = 6;
+		static constexpr std::uint32_t slots_per_level = 1u << slot_bits;
+		static constexpr std::uint64_t slot_mask = slots_per_level - 1;
+		static constexpr std::uint32_t levels = 6;
+		static constexpr std::uint64_t max_delta = (std::uint64_t{1} << (slot_bits * levels)) - 1;
+		// Extra slot for nodes that are already expired on insertion
+		static constexpr std::uint32_t due_slot = levels * slots_per_level;
+		static constexpr size_t max_free_nodes = 4096;
+
+		std::uint64_t m_current;
+		size_t m_size{0};
+		std::array<node*, levels * slots_per_level + 1> m_slots{};
+		std::array<std::uint64_t, levels> m_occupied{};
+		node* m_free{nullptr};
+		size_t m_free_size{0};
+
+		void insert(node* n) noexcept {
+			if (n->expiry <= m_current) {
+				link(n, due_slot);
+				return;
+			}
+			// Nodes too far in the future are put on the last level and will be reinserted when cascaded
+			const auto delta = (std::min)(n->expiry - m_current, max_delta);
+			const auto level = static_cast<std::uint32_t>(std::bit_width(delta) - 1) / slot_bits;
+			const auto slot = static_cast<std::uint32_t>(((m_current + delta) >> (level * slot_bits)) & slot_mask);
+			link(n, level * slots_per_level + slot);
+		}
+
+		void link(node* n, std::uint32_t slot) noexcept {
+			n->slot = slot;
+			n->prev = nullptr;
+			n->next = m_slots[slot];
+			if (n->next != nullptr) n->next->prev = n;
+			m_slots[slot] = n;
+			if (slot != due_slot) m_occupied[slot / slots_per_level] |= std::uint64_t{1} << (slot & slot_mask);
+		}
+
+		void remove(node* n) noexcept {
+			if (n->prev != nullptr)
+				n->prev->next = n->next;
+			else
+				m_slots[n->slot] = n->next;
+			if (n->next != nullptr) n->next->prev = n->prev;
+			if (m_slots[n->slot] == nullptr && n->slot != due_slot)
+				m_occupied[n->slot / slots_per_level] &= ~(std::uint64_t{1} << (n->slot & slot_mask));
+		}
+
+		void take_slot(std::uint32_t slot, node*& list) noexcept {
+			auto n = m_slots[slot];
+			if (n == nullptr) return;
+			m_slots[slot] = nullptr;
+			if (slot != due_slot) m_occupied[slot / slots_per_level] &= ~(std::uint64_t{1} << (slot & slot_mask));
+			while (n != nullptr) {
+				auto next = n->next;
+				n->next = list;
+				list = n;
+				m_size--;
+				n = next;
+			}
+		}
+
+		void cascade() noexcept {
+			for (std::uint32_t level = 1; level < levels; level++) {
+				const auto idx = static_cast<std::uint32_t>((m_current >> (level * slot_bits)) & slot_mask);
+				const auto slot = level * slots_per_level + idx;
+				auto n = m_slots[slot];
+				m_slots[slot] = nullptr;
+				m_occupied[level] &= ~(std::uint64_t{1} << idx);
+				while (n != nullptr) {
+					auto next = n->next;
+					insert(n);
+					n = next;
+				}
+				// Only continue with the next level if this one wrapped around as well
+				if (idx != 0) break;
+			}
+		}
+	};
+} // namespace asyncpp::detail
@@ -0,0 +1,146 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace asyncpp::detail {
+	/**
+	 * \brief Lock-free single producer, multi consumer work stealing deque.
+	 *
+	 * This is an implementation of the dynamic circular work stealing deque described by Chase and Lev,
+	 * using the memory orderings from "Correct and Efficient Work-Stealing for Weak Memory Models"
+	 * (Lê, Pop, Cohen, Nardelli). The owning thread pushes and pops at the bottom end (LIFO), while
+	 * other threads can steal elements from the top end (FIFO). Neither operation takes a lock.
+	 *
+	 * \note push() and pop() may only be called by the owning thread, steal() can be called by any thread.
+	 * \tparam T Type of the stored elements. Needs to be trivially copyable and lock-free as an atomic (e.g. pointers).
+	 */
+	template<typename T>
+	class work_stealing_deque {
+		static_assert(std::is_trivially_copyable_v<T>, "work_stealing_deque requires trivially copyable elements");
+		static_assert(std::atomic<T>::is_always_lock_free, "work_stealing_deque requires lock free atomic elements");
+
+		struct ring_buffer {
+			const std::int64_t m_capacity;
+			const std::int64_t m_mask;
+			std::unique_ptr<std::atomic<T>[]> m_data;
+
+			explicit ring_buffer(std::int64_t capacity)
+				: m_capacity{capacity}, m_mask{capacity - 1}, m_data{std::make_unique<std::atomic<T>[]>(capacity)} {
+				assert((capacity & m_mask) == 0 && "capacity needs to be a power of two");
+			}
+
+			void store(std::int64_t idx, T value) noexcept {
+				m_data[idx & m_mask].store(value, std::memory_order::relaxed);
+			}
+			T load(std::int64_t idx) const noexcept { return m_data[idx & m_mask].load(std::memory_order::relaxed); }
+
+			std::unique_ptr<ring_buffer> grow(std::int64_t bottom, std::int64_t top) const {
+				auto res = std::make_unique<ring_buffer>(m_capacity * 2);
+				for (auto i = top; i != bottom; i++)
+					res->store(i, load(i));
+				return res;
+			}
+		};
+
+		alignas(64) std::atomic<std::int64_t> m_top{0};
+		alignas(64) std::atomic<std::int64_t> m_bottom{0};
+		alignas(64) std::atomic<ring_buffer*> m_buffer;
+		// Old buffers might still get read by concurrent thieves, so we keep them until destruction.
+		// This is only ever accessed by the owning thread.
+		std::vector<std::unique_ptr<ring_buffer>> m_buffers;
+
+	public:
+		/**
+		 * \brief Construct a new deque
+		 * \param initial_capacity The initial capacity, needs to be a power of two. The deque grows automatically.
+		 */
+		explicit work_stealing_deque(size_t initial_capacity = 64) {
+			m_buffers.emplace_back(std::make_unique<ring_buffer>(static_cast<std::int64_t>(initial_capacity)));
+			m_buffer.store(m_buffers.back().get(), std::memory_order::relaxed);
+		}
+		work_stealing_deque(const work_stealing_deque&) = delete;
+		work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+		/**
+		 * \brief Push a new element at the bottom of the deque.
+		 * \note May only be called by the owning thread.
+		 * \param value The value to push
+		 */
+		void push(T value) {
+			const auto bottom = m_bottom.load(std::memory_order::relaxed);
+			const auto top = m_top.load(std::memory_order::acquire);
+			auto buffer = m_buffer.load(std::memory_order::relaxed);
+			if (bottom - top > buffer->m_capacity - 1) {
+				m_buffers.emplace_back(buffer->grow(bottom, top));
+				buffer = m_buffers.back().get();
+				m_buffer.store(buffer, std::memory_order::release);
+			}
+			buffer->store(bottom, value);
+			m_bottom.store(bottom + 1, std::memory_order::release);
+		}
+
+		/**
+		 * \brief Pop the most recently pushed element from the bottom of the deque.
+		 * \note May only be called by the owning thread.
+		 * \return The element or std::nullopt if the deque is empty.
+		 */
+		std::optional<T> pop() noexcept {
+			const auto bottom = m_bottom.load(std::memory_order::relaxed) - 1;
+			auto buffer = m_buffer.load(std::memory_order::relaxed);
+			m_bottom.store(bottom, std::memory_order::seq_cst);
+			auto top = m_top.load(std::memory_order::seq_cst);
+			if (top > bottom) {
+				// Deque was empty
+				m_bottom.store(bottom + 1, std::memory_order::relaxed);
+				return std::nullopt;
+			}
+			std::optional<T> res = buffer->load(bottom);
+			if (top == bottom) {
+				// This is the last element, we need to race against thieves for it
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst,
+												   std::memory_order::relaxed))
+					res.reset();
+				m_bottom.store(bottom + 1, std::memory_order::relaxed);
+			}
+			return res;
+		}
+
+		/**
+		 * \brief Steal the oldest element from the top of the deque.
+		 * \note Can be called by any thread.
+		 * \return The element or std::nullopt if the deque was empty or another thread won the race for the element.
+		 */
+		std::optional<T> steal() noexcept {
+			auto top = m_top.load(std::memory_order::seq_cst);
+			const auto bottom = m_bottom.load(std::memory_order::seq_cst);
+			if (top >= bottom) return std::nullopt;
+			auto buffer = m_buffer.load(std::memory_order::acquire);
+			T res = buffer->load(top);
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed))
+				return std::nullopt;
+			return res;
+		}
+
+		/**
+		 * \brief Get the approximate number of elements inside the deque.
+		 * \note This is a snapshot and might be outdated by the time it returns if other threads access the deque.
+		 */
+		[[nodiscard]] size_t size() const noexcept {
+			const auto bottom = m_bottom.load(std::memory_order::relaxed);
+			const auto top = m_top.load(std::memory_order::relaxed);
+			return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+		}
+
+		/**
+		 * \brief Check if the deque is empty.
+		 * \note This is a snapshot and might be outdated by the time it returns if other threads access the deque.
+		 */
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+	};
+} // namespace asyncpp::detail
@@ -1,8 +1,69 @@
 #pragma once
+#include <asyncpp/detail/std_import.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
 #include <functional>
+#include <span>
+#include <utility>
+
+// Enables the instrumentation hooks of the dispatchers, see dispatch_observer. This changes the layout of all
+// dispatchers, so it needs to be set the same way in every translation unit.
+#ifndef ASYNCPP_ENABLE_METRICS
+#define ASYNCPP_ENABLE_METRICS 0
+#endif
 
 namespace asyncpp {
 	/**
+	 * \brief Priority of work pushed to a dispatcher, see dispatcher::push_prioritized()
+	 */
+	enum class task_priority {
+		/// \brief Latency critical work, run before any other
+		high,
+		/// \brief The priority used by push() and push_resume()
+		normal,
+		/// \brief Background work, only run if nothing else is waiting
+		low,
+	};
+
+	/**
+	 * \brief Scheduling events reported to a dispatch_observer
+	 */
+	enum class dispatch_event {
+		/// \brief Work was pushed to the dispatcher
+		push,
+		/// \brief A callback or coroutine is about to run
+		start,
+		/// \brief The callback or coroutine returned or suspended
+		end,
+		/// \brief An idle worker took work queued for another worker
+		steal,
+	};
+
+	class dispatcher;
+
+	/**
+	 * \brief Receives the scheduling events of a dispatcher, see dispatcher::observer().
+	 *
+	 * Events are reported synchronously by the thread causing them, so implementations have to be thread safe and
+	 * should return quickly. Dispatchers only report events if ASYNCPP_ENABLE_METRICS is set.
+	 */
+	class dispatch_observer {
+	public:
+		virtual ~dispatch_observer() = default;
+		/**
+		 * \brief Called for every event
+		 * \param disp The dispatcher reporting the event
+		 * \param event The event
+		 * \param worker Index of the worker thread the event belongs to, always 0 for single threaded dispatchers.
+		 *               For pushes from outside the dispatcher this is the worker receiving the work.
+		 */
+		virtual void on_event(const dispatcher& disp, dispatch_event event, std::size_t worker) noexcept = 0;
+	};
+
+	/**
      * \brief Basic dispatcher interface class
      */
 	class dispatcher {
@@ -11,10 +72,27 @@ namespace asyncpp {
 #else
 		static thread_local inline dispatcher* g_current_dispatcher = nullptr;
 #endif
+#if ASYNCPP_ENABLE_METRICS
+		std::atomic<dispatch_observer*> m_observer{nullptr};
+#endif
 
 	protected:
 		~dispatcher() = default;
 
+		/**
+		 * \brief Report an event to the observer, if there is one.
+		 *
+		 * Compiles to nothing unless ASYNCPP_ENABLE_METRICS is set, so implementers can call it unconditionally.
+		 * \param event The event
+		 * \param worker Index of the worker thread the event belongs to
+		 */
+		void trace([[maybe_unused]] dispatch_event event, [[maybe_unused]] std::size_t worker = 0) const noexcept {
+#if ASYNCPP_ENABLE_METRICS
+			if (auto obs = m_observer.load(std::memory_order::acquire); obs != nullptr)
+				obs->on_event(*this, event, worker);
+#endif
+		}
+
 		/**
 		 * \brief Set the current dispatcher for this thread and reurns the current one.
 		 * Implementers of dispatchers can use this to give convenient access to the current dispatcher, for example for yielding.
@@ -40,15 +118,114 @@ namespace asyncpp {
          */
 		virtual void push(std::function<void()> cbfn) = 0;
 		/**
+         * Push a coroutine to be resumed on the dispatcher.
+         *
+         * This is a fast path for the most common use of push(), resuming a suspended coroutine. Dispatchers
+         * can override it to store the handle directly instead of wrapping it inside a std::function, which
+         * allows resuming coroutines without any allocation. The default implementation forwards to push().
+         * \param hndl The coroutine to resume
+         */
+		virtual void push_resume(coroutine_handle<> hndl) { push(std::function<void()>{hndl}); }
+		/**
+         * Push multiple coroutines to be resumed on the dispatcher.
+         *
+         * Used when a lot of coroutines become ready at once, for example when an event is set. Dispatchers can
+         * override it to enqueue all of them at once, taking their locks only once and waking multiple workers.
+         * The default implementation calls push_resume() for every handle.
+         * \param hndls The coroutines to resume, the span is only valid for the duration of the call
+         */
+		virtual void push_resume_batch(std::span<const coroutine_handle<>> hndls) {
+			for (auto hndl : hndls)
+				push_resume(hndl);
+		}
+		/**
+         * Push a function to be executed on the dispatcher with a given priority.
+         *
+         * Dispatchers supporting priorities run higher priority work first, while making sure lower priorities
+         * still make progress. The default implementation ignores the priority and forwards to push().
+         * \param cbfn Callback
+         * \param prio The priority
+         */
+		virtual void push_prioritized(std::function<void()> cbfn, [[maybe_unused]] task_priority prio) {
+			push(std::move(cbfn));
+		}
+		/**
+         * Push a coroutine to be resumed on the dispatcher with a given priority, see push_prioritized().
+         *
+         * The default implementation ignores the priority and forwards to push_resume().
+         * \param hndl The coroutine to resume
+         * \param prio The priority
+         */
+		virtual void push_resume_prioritized(coroutine_handle<> hndl, [[maybe_unused]] task_priority prio) {
+			push_resume(hndl);
+		}
+		/**
          * Get the dispatcher associated with the current thread.
          * This can be used to shedule more tasks on the current dispatcher.
          * Returns the current dispatcher, or nullptr if the current thread is
          * not associated with a dispatcher.
          */
 		static dispatcher* current() noexcept { return g_current_dispatcher; }
+
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Set the observer receiving the scheduling events of this dispatcher.
+		 *
+		 * The observer has to stay alive until the dispatcher is destroyed, even after replacing it, because events
+		 * might be reported concurrently. Only available if ASYNCPP_ENABLE_METRICS is set.
+		 * \param obs The new observer, nullptr to disable reporting
+		 */
+		void observer(dispatch_observer* obs) noexcept { m_observer.store(obs, std::memory_order::release); }
+		/**
+		 * \brief Get the observer set using observer(dispatch_observer*)
+		 */
+		[[nodiscard]] dispatch_observer* observer() const noexcept {
+			return m_observer.load(std::memory_order::acquire);
+		}
+#endif
 	};
 
 #if defined(ASYNCPP_SO_COMPAT_IMPL)
 	thread_local dispatcher* dispatcher::g_current_dispatcher = nullptr;
 #endif
+
+	namespace detail {
+		/**
+		 * \brief Collects coroutines to resume and hands them to their dispatchers using push_resume_batch().
+		 *
+		 * Consecutive handles for the same dispatcher are grouped into one batch, the buffer lives on the stack so
+		 * no allocation is needed. flush() has to be called once all coroutines are added.
+		 */
+		class resume_batch {
+		public:
+			static constexpr size_t capacity = 64;
+
+			resume_batch() noexcept = default;
+			resume_batch(const resume_batch&) = delete;
+			resume_batch& operator=(const resume_batch&) = delete;
+			~resume_batch() { assert(m_size == 0); }
+
+			/// \brief Add a coroutine to resume on the given dispatcher
+			void add(dispatcher* dsp, coroutine_handle<> hndl) {
+				if (dsp != m_dispatcher || m_size == capacity) flush();
+				m_dispatcher = dsp;
+				m_handles[m_size++] = hndl;
+			}
+
+			/// \brief Push all the collected coroutines
+			void flush() {
+				if (m_size == 0) return;
+				const auto size = std::exchange(m_size, 0);
+				if (size == 1)
+					m_dispatcher->push_resume(m_handles[0]);
+				else
+					m_dispatcher->push_resume_batch(std::span<const coroutine_handle<>>{m_handles.data(), size});
+			}
+
+		private:
+			std::array<coroutine_handle<>, capacity> m_handles;
+			dispatcher* m_dispatcher{nullptr};
+			size_t m_size{0};
+		};
+	} // namespace detail
 } // namespace asyncpp
@@ -1,8 +1,13 @@
 #pragma once
 #include <asyncpp/detail/std_import.h>
 #include <asyncpp/dispatcher.h>
+#include <asyncpp/trampoline.h>
 #include <atomic>
 #include <cassert>
+#include <cstddef>
+#if ASYNCPP_ENABLE_METRICS
+#include <asyncpp/metrics.h>
+#endif
 
 namespace asyncpp {
 	/**
@@ -65,12 +70,16 @@ namespace asyncpp {
 				auto await = static_cast<awaiter*>(state);
 				assert(await->m_parent == this);
 				assert(await->m_handle);
+#if ASYNCPP_ENABLE_METRICS
+				m_contention.count_waiters(1);
+				await->m_park.finish(m_contention);
+#endif
 				if (await->m_dispatcher != nullptr) {
-					await->m_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					await->m_dispatcher->push_resume(await->m_handle);
 				} else if (resume_dispatcher != nullptr) {
-					resume_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					resume_dispatcher->push_resume(await->m_handle);
 				} else {
-					await->m_handle.resume();
+					resume_trampoline::resume(await->m_handle);
 				}
 				return true;
 			}
@@ -109,19 +118,39 @@ namespace asyncpp {
 			return awaiter{this, resume_dispatcher};
 		}
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of this event.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. The waiter count is taken by set().
+		 */
+		[[nodiscard]] contention_metrics metrics() const noexcept { return m_contention.collect(); }
+#endif
+
 	private:
 		/* nullptr => unset
 		 * this => set
 		 * x => awaiter*
 		 */
 		std::atomic<void*> m_state;
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_contention{};
+#endif
 
 		struct [[nodiscard]] awaiter {
 			explicit constexpr awaiter(single_consumer_event* parent, dispatcher* dispatcher) noexcept
 				: m_parent(parent), m_dispatcher(dispatcher) {}
-			[[nodiscard]] bool await_ready() const noexcept { return m_parent->is_set(); }
+			[[nodiscard]] bool await_ready() const noexcept {
+#if ASYNCPP_ENABLE_METRICS
+				m_parent->m_contention.count_wait();
+#endif
+				return m_parent->is_set();
+			}
 			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
 				m_handle = hdl;
+#if ASYNCPP_ENABLE_METRICS
+				m_park.start();
+#endif
 				void* old_state = nullptr;
 				// If the current state is unset set it to this
 				bool was_equal = m_parent->m_state.compare_exchange_strong(old_state, this, std::memory_order::release,
@@ -129,6 +158,9 @@ namespace asyncpp {
 				// If the state was not unset it has to be set,
 				// otherwise we have a concurrent await, which is not supported
 				assert(was_equal || old_state == m_parent);
+#if ASYNCPP_ENABLE_METRICS
+				if (!was_equal) m_park.cancel();
+#endif
 				return was_equal;
 			}
 			constexpr void await_resume() const noexcept {}
@@ -136,6 +168,9 @@ namespace asyncpp {
 			single_consumer_event* m_parent;
 			dispatcher* m_dispatcher;
 			coroutine_handle<> m_handle{};
+#if ASYNCPP_ENABLE_METRICS
+			detail::park_timer m_park{};
+#endif
 		};
 	};
 
@@ -206,12 +241,16 @@ namespace asyncpp {
 
 				assert(await->m_parent == this);
 				assert(await->m_handle);
+#if ASYNCPP_ENABLE_METRICS
+				m_contention.count_waiters(1);
+				await->m_park.finish(m_contention);
+#endif
 				if (await->m_dispatcher != nullptr) {
-					await->m_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					await->m_dispatcher->push_resume(await->m_handle);
 				} else if (resume_dispatcher != nullptr) {
-					resume_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					resume_dispatcher->push_resume(await->m_handle);
 				} else {
-					await->m_handle.resume();
+					resume_trampoline::resume(await->m_handle);
 				}
 				return true;
 			}
@@ -250,25 +289,50 @@ namespace asyncpp {
 			return awaiter{this, resume_dispatcher};
 		}
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of this event.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. The waiter count is taken by set().
+		 */
+		[[nodiscard]] contention_metrics metrics() const noexcept { return m_contention.collect(); }
+#endif
+
 	private:
 		/* nullptr => unset
 		 * this => set
 		 * x => awaiter*
 		 */
 		std::atomic<void*> m_state;
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_contention{};
+#endif
 
 		struct [[nodiscard]] awaiter {
 			explicit constexpr awaiter(single_consumer_auto_reset_event* parent, dispatcher* dispatcher) noexcept
 				: m_parent(parent), m_dispatcher(dispatcher) {}
+#if ASYNCPP_ENABLE_METRICS
+			[[nodiscard]] bool await_ready() const noexcept {
+				m_parent->m_contention.count_wait();
+				return false;
+			}
+#else
 			[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+#endif
 			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
 				m_handle = hdl;
+#if ASYNCPP_ENABLE_METRICS
+				m_park.start();
+#endif
 				void* old_state = nullptr;
 				if (!m_parent->m_state.compare_exchange_strong(old_state, this, std::memory_order::release,
 															   std::memory_order::relaxed)) {
 					// No duplicate awaiters allowed, so the only valid values are m_parent and nullptr
 					assert(m_parent == old_state);
 					m_parent->m_state.exchange(nullptr, std::memory_order::acquire);
+#if ASYNCPP_ENABLE_METRICS
+					m_park.cancel();
+#endif
 					return false;
 				}
 				return true;
@@ -278,6 +342,9 @@ namespace asyncpp {
 			single_consumer_auto_reset_event* m_parent;
 			dispatcher* m_dispatcher;
 			coroutine_handle<> m_handle{};
+#if ASYNCPP_ENABLE_METRICS
+			detail::park_timer m_park{};
+#endif
 		};
 	};
 
@@ -340,19 +407,31 @@ namespace asyncpp {
 			auto state = m_state.exchange(this, std::memory_order::acq_rel);
 			if (state == this) return false;
 			auto await = static_cast<awaiter*>(state);
+			// Waiters usually share a dispatcher, so we hand them over in batches instead of one by one
+#if ASYNCPP_ENABLE_METRICS
+			// Counted upfront, resuming inline might destroy the event
+			std::size_t waiters = 0;
+			for (auto it = await; it != nullptr; it = it->m_next) {
+				it->m_park.finish(m_contention);
+				waiters++;
+			}
+			m_contention.count_waiters(waiters);
+#endif
+			detail::resume_batch batch;
 			while (await != nullptr) {
 				auto next = await->m_next;
 				assert(await->m_parent == this);
 				assert(await->m_handle);
 				if (await->m_dispatcher != nullptr) {
-					await->m_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					batch.add(await->m_dispatcher, await->m_handle);
 				} else if (resume_dispatcher != nullptr) {
-					resume_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					batch.add(resume_dispatcher, await->m_handle);
 				} else {
-					await->m_handle.resume();
+					resume_trampoline::resume(await->m_handle);
 				}
 				await = next;
 			}
+			batch.flush();
 			return true;
 		}
 
@@ -388,23 +467,48 @@ namespace asyncpp {
 			return awaiter{this, resume_dispatcher};
 		}
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of this event.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. The waiter count is taken by set().
+		 */
+		[[nodiscard]] contention_metrics metrics() const noexcept { return m_contention.collect(); }
+#endif
+
 	private:
 		/* nullptr => unset
 		 * this => set
 		 * x => head of awaiter* list
 		 */
 		std::atomic<void*> m_state;
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_contention{};
+#endif
 
 		struct [[nodiscard]] awaiter {
 			explicit constexpr awaiter(multi_consumer_event* parent, dispatcher* dispatcher) noexcept
 				: m_parent(parent), m_dispatcher(dispatcher) {}
-			[[nodiscard]] bool await_ready() const noexcept { return m_parent->is_set(); }
+			[[nodiscard]] bool await_ready() const noexcept {
+#if ASYNCPP_ENABLE_METRICS
+				m_parent->m_contention.count_wait();
+#endif
+				return m_parent->is_set();
+			}
 			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
 				m_handle = hdl;
+#if ASYNCPP_ENABLE_METRICS
+				m_park.start();
+#endif
 				void* old_state = m_parent->m_state.load(std::memory_order::acquire);
 				do {
 					// event became set
-					if (old_state == m_parent) return false;
+					if (old_state == m_parent) {
+#if ASYNCPP_ENABLE_METRICS
+						m_park.cancel();
+#endif
+						return false;
+					}
 					m_next = static_cast<awaiter*>(old_state);
 				} while (!m_parent->m_state.compare_exchange_weak( //
 					old_state, this, std::memory_order::release, std::memory_order::acquire));
@@ -416,6 +520,9 @@ namespace asyncpp {
 			dispatcher* m_dispatcher;
 			awaiter* m_next{nullptr};
 			coroutine_handle<> m_handle{};
+#if ASYNCPP_ENABLE_METRICS
+			detail::park_timer m_park{};
+#endif
 		};
 	};
 
@@ -484,19 +591,31 @@ namespace asyncpp {
 			state = this;
 			m_state.compare_exchange_strong(state, nullptr, std::memory_order::acq_rel);
 
+			// Waiters usually share a dispatcher, so we hand them over in batches instead of one by one
+#if ASYNCPP_ENABLE_METRICS
+			// Counted upfront, resuming inline might destroy the event
+			std::size_t waiters = 0;
+			for (auto it = await; it != nullptr; it = it->m_next) {
+				it->m_park.finish(m_contention);
+				waiters++;
+			}
+			m_contention.count_waiters(waiters);
+#endif
+			detail::resume_batch batch;
 			while (await != nullptr) {
 				auto next = await->m_next;
 				assert(await->m_parent == this);
 				assert(await->m_handle);
 				if (await->m_dispatcher != nullptr) {
-					await->m_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					batch.add(await->m_dispatcher, await->m_handle);
 				} else if (resume_dispatcher != nullptr) {
-					resume_dispatcher->push([hdl = await->m_handle]() mutable { hdl.resume(); });
+					batch.add(resume_dispatcher, await->m_handle);
 				} else {
-					await->m_handle.resume();
+					resume_trampoline::resume(await->m_handle);
 				}
 				await = next;
 			}
+			batch.flush();
 			return true;
 		}
 
@@ -532,23 +651,48 @@ namespace asyncpp {
 			return awaiter{this, resume_dispatcher};
 		}
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of this event.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. The waiter count is taken by set().
+		 */
+		[[nodiscard]] contention_metrics metrics() const noexcept { return m_contention.collect(); }
+#endif
+
 	private:
 		/* nullptr => unset
 		 * this => set
 		 * x => head of awaiter* list
 		 */
 		std::atomic<void*> m_state;
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_contention{};
+#endif
 
 		struct [[nodiscard]] awaiter {
 			explicit constexpr awaiter(multi_consumer_auto_reset_event* parent, dispatcher* dispatcher) noexcept
 				: m_parent(parent), m_dispatcher(dispatcher) {}
-			[[nodiscard]] bool await_ready() const noexcept { return m_parent->is_set(); }
+			[[nodiscard]] bool await_ready() const noexcept {
+#if ASYNCPP_ENABLE_METRICS
+				m_parent->m_contention.count_wait();
+#endif
+				return m_parent->is_set();
+			}
 			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
 				m_handle = hdl;
+#if ASYNCPP_ENABLE_METRICS
+				m_park.start();
+#endif
 				void* old_state = m_parent->m_state.load(std::memory_order::acquire);
 				do {
 					// event became set
-					if (old_state == m_parent) return false;
+					if (old_state == m_parent) {
+#if ASYNCPP_ENABLE_METRICS
+						m_park.cancel();
+#endif
+						return false;
+					}
 					m_next = static_cast<awaiter*>(old_state);
 				} while (!m_parent->m_state.compare_exchange_weak( //
 					old_state, this, std::memory_order::release, std::memory_order::acquire));
@@ -560,6 +704,9 @@ namespace asyncpp {
 			dispatcher* m_dispatcher{};
 			awaiter* m_next{nullptr};
 			coroutine_handle<> m_handle{};
+#if ASYNCPP_ENABLE_METRICS
+			detail::park_timer m_park{};
+#endif
 		};
 	};
 } // namespace asyncpp
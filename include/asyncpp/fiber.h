@@ -1,13 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <exception>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include <asyncpp/detail/sanitizers.h>
 #include <asyncpp/detail/std_import.h>
@@ -25,6 +31,10 @@
 #define ASYNCPP_FIBER_USE_UCONTEXT 0
 #endif
 
+#ifndef ASYNCPP_FIBER_STACK_POOL
+#define ASYNCPP_FIBER_STACK_POOL 1
+#endif
+
 #if ASYNCPP_FIBER_USE_UCONTEXT
 #include <ucontext.h>
 #endif
@@ -41,21 +51,28 @@ namespace asyncpp::detail {
 		size_t mmap_size;
 	};
 
-	inline bool fiber_allocate_stack(stack_context& ctx, size_t size) noexcept {
-		static size_t pagesize = sysconf(_SC_PAGESIZE);
+	inline size_t fiber_page_size() noexcept {
+		static const size_t pagesize = sysconf(_SC_PAGESIZE);
+		return pagesize;
+	}
 
-		// Round the stacksize to the next multiple of pages
-		const auto page_count = (size + pagesize - 1) / pagesize;
-		size = page_count * pagesize;
+	/**
+	 * \brief Map a new stack with a guard page at both ends.
+	 * \param ctx The context to fill
+	 * \param size The usable size of the stack, needs to be a multiple of the page size
+	 */
+	inline bool fiber_map_stack(stack_context& ctx, size_t size) noexcept {
+		const auto pagesize = fiber_page_size();
 		const auto alloc_size = size + pagesize * 2;
-#if defined(MAP_STACK)
-		void* const stack =
-			::mmap(nullptr, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_STACK, -1, 0);
-#elif defined(MAP_ANON)
-		void* const stack = ::mmap(nullptr, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+#if defined(MAP_ANON)
+		int flags = MAP_PRIVATE | MAP_ANON;
 #else
-		void* const stack = ::mmap(nullptr, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+#if defined(MAP_STACK)
+		flags |= MAP_STACK;
 #endif
+		void* const stack = ::mmap(nullptr, alloc_size, PROT_READ | PROT_WRITE, flags, -1, 0);
 		if (stack == MAP_FAILED) return false;
 
 		// Protect a page at the bottom and top to cause fault on stack over/underflow
@@ -71,13 +88,226 @@ namespace asyncpp::detail {
 		return true;
 	}
 
-	inline bool fiber_deallocate_stack(stack_context& ctx) {
+	inline bool fiber_unmap_stack(stack_context& ctx) noexcept {
 		if (ctx.mmap_base == nullptr) return true;
 
 		auto res = ::munmap(ctx.mmap_base, ctx.mmap_size);
+		ctx.mmap_base = nullptr;
 		return res == 0;
 	}
 
+	/**
+	 * \brief Pool of guarded fiber stacks.
+	 *
+	 * Stacks are grouped into power of two size classes. Released stacks keep their mapping and guard pages,
+	 * their memory is handed back to the kernel using madvise() instead. Every thread keeps a small cache per
+	 * size class, overflowing stacks go to a global pool shared by all threads and are only unmapped once that
+	 * is full as well.
+	 * \note If the library is used from multiple shared objects every one of them might end up with its own pool.
+	 */
+	class fiber_stack_pool {
+	public:
+		/// \brief Number of size classes, class 0 holds stacks of 4 pages
+		static constexpr size_t num_classes = 16;
+		/// \brief Maximum number of stacks cached per thread and class
+		static constexpr size_t max_local = 16;
+		/// \brief Maximum number of stacks kept in the global pool per class
+		static constexpr size_t max_global = 256;
+
+		/**
+		 * \brief Get the size class for a stack size
+		 * \return The class index or num_classes if the size is too large to be pooled
+		 */
+		static size_t size_class(size_t size) noexcept {
+			const auto pages = (std::max)((size + fiber_page_size() - 1) / fiber_page_size(), min_pages);
+			const auto cls = static_cast<size_t>(std::bit_width(std::bit_ceil(pages) / min_pages) - 1);
+			return (std::min)(cls, num_classes);
+		}
+
+		/// \brief Get the usable stack size of a size class
+		static size_t class_size(size_t cls) noexcept { return (min_pages << cls) * fiber_page_size(); }
+
+		/**
+		 * \brief Get a stack of at least the given size.
+		 * \return false if mapping a new stack failed
+		 */
+		static bool acquire(stack_context& ctx, size_t size) noexcept {
+			const auto cls = size_class(size);
+			if (cls >= num_classes) {
+				const auto pagesize = fiber_page_size();
+				return fiber_map_stack(ctx, (size + pagesize - 1) / pagesize * pagesize);
+			}
+			const auto idx = cls;
+			if (auto cache = local(); cache != nullptr && !cache->m_free[idx].empty()) {
+				ctx = cache->m_free[idx].back();
+				cache->m_free[idx].pop_back();
+				return true;
+			}
+			{
+				auto& pool = global();
+				std::unique_lock lck{pool.m_mtx};
+				if (!pool.m_free[idx].empty()) {
+					ctx = pool.m_free[idx].back();
+					pool.m_free[idx].pop_back();
+					return true;
+				}
+			}
+			return fiber_map_stack(ctx, class_size(cls));
+		}
+
+		/**
+		 * \brief Return a stack to the pool.
+		 */
+		static bool release(stack_context& ctx) noexcept {
+			if (ctx.mmap_base == nullptr) return true;
+			const auto cls = size_class(ctx.stack_size);
+			if (cls >= num_classes || class_size(cls) != ctx.stack_size) return fiber_unmap_stack(ctx);
+			discard_pages(ctx);
+			const auto idx = cls;
+			try {
+				if (auto cache = local(); cache != nullptr && cache->m_free[idx].size() < max_local) {
+					cache->m_free[idx].push_back(ctx);
+					ctx.mmap_base = nullptr;
+					return true;
+				}
+				auto& pool = global();
+				std::unique_lock lck{pool.m_mtx};
+				if (pool.m_free[idx].size() < max_global) {
+					pool.m_free[idx].push_back(ctx);
+					ctx.mmap_base = nullptr;
+					return true;
+				}
+			} catch (const std::bad_alloc&) {} // NOLINT(bugprone-empty-catch)
+			return fiber_unmap_stack(ctx);
+		}
+
+		/**
+		 * \brief Unmap all stacks cached by the calling thread and the global pool.
+		 */
+		static void trim() noexcept {
+			if (auto cache = local(); cache != nullptr) cache->clear();
+			auto& pool = global();
+			std::unique_lock lck{pool.m_mtx};
+			pool.clear();
+		}
+
+	private:
+		static constexpr size_t min_pages = 4;
+
+		struct free_lists {
+			std::array<std::vector<stack_context>, num_classes> m_free{};
+			void clear() noexcept {
+				for (auto& list : m_free) {
+					for (auto& e : list)
+						fiber_unmap_stack(e);
+					list.clear();
+				}
+			}
+		};
+		struct global_pool : free_lists {
+			std::mutex m_mtx{};
+		};
+		struct local_cache : free_lists {
+			local_cache() noexcept { alive() = true; }
+			~local_cache() {
+				alive() = false;
+				// Hand cached stacks over to other threads
+				for (auto& list : m_free) {
+					for (auto& e : list)
+						release_global(e);
+					list.clear();
+				}
+			}
+			local_cache(const local_cache&) = delete;
+			local_cache& operator=(const local_cache&) = delete;
+			static bool& alive() noexcept {
+				static thread_local bool value = false;
+				return value;
+			}
+		};
+
+		static global_pool& global() noexcept {
+			// Intentionally leaked, fibers might still get destroyed during static destruction
+			static auto* const pool = new global_pool();
+			return *pool;
+		}
+
+		static local_cache* local() noexcept {
+			static thread_local local_cache cache{};
+			// The cache is gone if a fiber is destroyed by a thread_local destructor running after it
+			return local_cache::alive() ? &cache : nullptr;
+		}
+
+		static void release_global(stack_context& ctx) noexcept {
+			const auto idx = size_class(ctx.stack_size);
+			auto& pool = global();
+			std::unique_lock lck{pool.m_mtx};
+			try {
+				if (pool.m_free[idx].size() < max_global) {
+					pool.m_free[idx].push_back(ctx);
+					return;
+				}
+			} catch (const std::bad_alloc&) {} // NOLINT(bugprone-empty-catch)
+			fiber_unmap_stack(ctx);
+		}
+
+		static void discard_pages(stack_context& ctx) noexcept {
+			auto base = static_cast<std::byte*>(ctx.stack) - ctx.stack_size;
+#if ASYNCPP_HAS_ASAN
+			// Frames of the previous fiber might still be poisoned
+			ASAN_UNPOISON_MEMORY_REGION(base, ctx.stack_size);
+#endif
+			// MADV_FREE would be cheaper, but lazily freed pages stay resident and would show up in the high water
+			// mark of the next fiber using this stack.
+#if defined(MADV_DONTNEED)
+			::madvise(base, ctx.stack_size, MADV_DONTNEED);
+#endif
+		}
+	};
+
+	inline bool fiber_allocate_stack(stack_context& ctx, size_t size) noexcept {
+#if ASYNCPP_FIBER_STACK_POOL
+		return fiber_stack_pool::acquire(ctx, size);
+#else
+		// Round the stacksize to the next multiple of pages
+		const auto pagesize = fiber_page_size();
+		return fiber_map_stack(ctx, (size + pagesize - 1) / pagesize * pagesize);
+#endif
+	}
+
+	inline bool fiber_deallocate_stack(stack_context& ctx) {
+#if ASYNCPP_FIBER_STACK_POOL
+		return fiber_stack_pool::release(ctx);
+#else
+		return fiber_unmap_stack(ctx);
+#endif
+	}
+
+	/**
+	 * \brief Get the number of bytes of a stack that were touched so far.
+	 *
+	 * This checks which pages of the stack are resident. Pooled stacks drop their pages on release, so the result
+	 * only covers the current user of the stack.
+	 */
+	inline size_t fiber_stack_high_water(const stack_context& ctx) noexcept {
+		if (ctx.mmap_base == nullptr) return 0;
+		const auto pagesize = fiber_page_size();
+		const auto pages = ctx.stack_size / pagesize;
+#if defined(__linux__)
+		using vec_type = unsigned char;
+#else
+		using vec_type = char;
+#endif
+		std::unique_ptr<vec_type[]> vec{new (std::nothrow) vec_type[pages]};
+		if (!vec || ::mincore(static_cast<std::byte*>(ctx.stack) - ctx.stack_size, ctx.stack_size, vec.get()) != 0)
+			return 0;
+		// The stack grows down, so the lowest resident page is the deepest point reached so far
+		for (size_t i = 0; i < pages; i++) {
+			if ((vec[i] & 1) != 0) return (pages - i) * pagesize;
+		}
+		return 0;
+	}
+
 #if ASYNCPP_FIBER_USE_UCONTEXT
 	struct fiber_context {
 		ucontext_t context;
@@ -623,6 +853,9 @@ namespace asyncpp::detail {
 
 	inline bool fiber_deallocate_stack(stack_context& ctx) noexcept { return true; }
 
+	/// \brief Get the number of bytes of a stack that were touched so far, this is not supported on windows.
+	inline size_t fiber_stack_high_water(const stack_context&) noexcept { return 0; }
+
 	struct fiber_context {
 		LPVOID fiber_handle;
 		void (*start_fn)(void* arg);
@@ -688,6 +921,8 @@ namespace asyncpp::detail {
 		std::exception_ptr suspend_exception = nullptr;
 
 		coroutine_handle<> continuation{};
+		// Handle passed to awaiters instead of the fiber itself, used by schedulers to redirect resumption
+		coroutine_handle<> resume_handle{};
 
 		bool want_destroy = false;
 		bool was_started = false;
@@ -708,7 +943,8 @@ namespace asyncpp::detail {
 #if defined(ASYNCPP_SO_COMPAT)
 	extern thread_local fiber_handle_base* g_current_fiber;
 #else
-	inline static thread_local fiber_handle_base* g_current_fiber = nullptr;
+	// Not static, fib_await_helper has external linkage and needs to see the same variable in every TU
+	inline thread_local fiber_handle_base* g_current_fiber = nullptr;
 #endif
 
 #if defined(ASYNCPP_SO_COMPAT_IMPL)
@@ -748,8 +984,14 @@ namespace asyncpp::detail {
 				if (hndl->suspend_handler) {
 					auto handler = std::exchange(hndl->suspend_handler, nullptr);
 					auto ptr = std::exchange(hndl->suspend_handler_ptr, nullptr);
+					auto resume_hndl = hndl->resume_handle ? hndl->resume_handle
+														   : coroutine_handle<>::from_address(static_cast<void*>(hndl));
 					try {
-						if (handler(ptr, coroutine_handle<>::from_address(static_cast<void*>(hndl)))) break;
+						if (handler(ptr, resume_hndl)) {
+							// The fiber might already be running on a different thread, so hndl must not be touched
+							g_current_fiber = old;
+							return;
+						}
 					} catch (...) { hndl->suspend_exception = std::current_exception(); }
 				}
 			}
@@ -970,6 +1212,19 @@ namespace asyncpp {
 		 * \return auto An awaiter that is resumed once the fiber finishes
 		 */
 		auto operator co_await() { return await(); }
+
+		/**
+		 * \brief Get the amount of stack used by this fiber so far.
+		 *
+		 * Use this to right-size the stack_size of fibers. Only pages touched by this fiber are counted, even if
+		 * its stack was reused from the pool.
+		 * \return The high water mark in bytes, rounded to pages, or 0 if not supported on this platform
+		 */
+		[[nodiscard]] size_t stack_high_water_mark() const noexcept {
+			if (!m_handle) return 0;
+			const auto hndl = static_cast<detail::fiber_handle_base*>(m_handle.address());
+			return detail::fiber_stack_high_water(hndl->fiber_stack);
+		}
 	};
 
 	/**
@@ -1078,6 +1333,11 @@ namespace asyncpp {
 		 * \return auto An awaiter that is resumed once the fiber finishes
 		 */
 		auto operator co_await() && { return await(); }
+
+		/**
+		 * \brief Get the amount of stack used by this fiber so far, see fiber<void>::stack_high_water_mark().
+		 */
+		[[nodiscard]] size_t stack_high_water_mark() const noexcept { return m_base.stack_high_water_mark(); }
 	};
 
 	template<typename FN>
@@ -0,0 +1,155 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/fiber.h>
+#include <asyncpp/promise.h>
+
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace asyncpp {
+	namespace detail {
+		/**
+		 * \brief Fake coroutine frame used as a stand-in for a scheduled fiber.
+		 *
+		 * This follows the same ABI as fiber handles, so it can be passed to awaiters as a regular coroutine_handle.
+		 */
+		struct fiber_proxy_frame {
+			// C++20 coroutine ABI dictates those
+			void (*resume_cb)(fiber_proxy_frame*) = nullptr;
+			void (*destroy_cb)(fiber_proxy_frame*) = [](fiber_proxy_frame*) {};
+
+			fiber_handle_base* fiber{};
+			void* owner{};
+
+			[[nodiscard]] coroutine_handle<> handle() noexcept {
+				return coroutine_handle<>::from_address(static_cast<void*>(this));
+			}
+			[[nodiscard]] coroutine_handle<> fiber_handle() const noexcept {
+				return coroutine_handle<>::from_address(static_cast<void*>(fiber));
+			}
+		};
+		static_assert(offsetof(fiber_proxy_frame, resume_cb) == 0);
+
+		/**
+		 * \brief Entry function of a fiber started by a fiber_scheduler.
+		 *
+		 * Awaiters get a proxy that pushes the fiber back onto the dispatcher once resumed, so the fiber always
+		 * continues on a worker no matter which thread completed the awaited operation. Once the fiber exits a second
+		 * proxy, resumed on the worker stack, destroys the fiber and settles the promise.
+		 */
+		template<typename FN, typename TResult>
+		struct scheduled_fiber_entry {
+			using value_type = std::conditional_t<std::is_void_v<TResult>, std::monostate, TResult>;
+
+			dispatcher* m_dispatcher;
+			FN m_function;
+			promise<TResult> m_promise;
+			std::variant<std::monostate, value_type, std::exception_ptr> m_result{};
+			fiber_proxy_frame m_reschedule{};
+			fiber_proxy_frame m_cleanup{};
+
+			scheduled_fiber_entry(dispatcher* dsp, FN&& function, promise<TResult> prom)
+				: m_dispatcher{dsp}, m_function{std::forward<FN>(function)}, m_promise{std::move(prom)} {}
+			scheduled_fiber_entry(scheduled_fiber_entry&& other) noexcept(std::is_nothrow_move_constructible_v<FN>)
+				: m_dispatcher{other.m_dispatcher}, m_function{std::move(other.m_function)},
+				  m_promise{std::move(other.m_promise)} {}
+
+			void operator()() {
+				auto base = g_current_fiber;
+				m_reschedule.fiber = m_cleanup.fiber = base;
+				m_reschedule.owner = m_cleanup.owner = this;
+				m_reschedule.resume_cb = [](fiber_proxy_frame* frame) {
+					auto self = static_cast<scheduled_fiber_entry*>(frame->owner);
+					self->m_dispatcher->push_resume(frame->fiber_handle());
+				};
+				m_cleanup.resume_cb = [](fiber_proxy_frame* frame) {
+					auto self = static_cast<scheduled_fiber_entry*>(frame->owner);
+					auto prom = std::move(self->m_promise);
+					auto result = std::move(self->m_result);
+					// This destroys self as well
+					frame->fiber_handle().destroy();
+					if (result.index() == 2)
+						prom.reject(std::get<2>(std::move(result)));
+					else if constexpr (std::is_void_v<TResult>)
+						prom.fulfill();
+					else
+						prom.fulfill(std::get<1>(std::move(result)));
+				};
+				base->resume_handle = m_reschedule.handle();
+				base->continuation = m_cleanup.handle();
+				try {
+					if constexpr (std::is_void_v<TResult>) {
+						m_function();
+						m_result.template emplace<1>();
+					} else
+						m_result.template emplace<1>(m_function());
+				} catch (const fiber_destroy_requested_exception&) { throw; } catch (...) {
+					m_result.template emplace<2>(std::current_exception());
+				}
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Runs fibers on top of a dispatcher, usually a thread_pool.
+	 *
+	 * Fibers spawned by the scheduler start on the dispatcher. Whenever they fib_await something that is not ready,
+	 * for example locking a mutex, reading a channel or waiting on a timer, the worker is released and can run other
+	 * fibers and coroutines. Once the awaited operation completes the fiber is pushed back onto the dispatcher
+	 * and continues on whatever worker picks it up. This allows running blocking style code at coroutine density.
+	 */
+	class fiber_scheduler {
+	public:
+		/**
+		 * \brief Construct a new scheduler.
+		 * \param dsp The dispatcher to run fibers on, it needs to outlive all fibers spawned
+		 * \param stack_size The stack size of spawned fibers
+		 */
+		explicit fiber_scheduler(dispatcher& dsp, size_t stack_size = 262144) noexcept
+			: m_dispatcher{&dsp}, m_stack_size{stack_size} {}
+
+		/**
+		 * \brief Start a new fiber on the dispatcher.
+		 * \param function The function to run inside the fiber
+		 * \return A promise that is settled with the result of the function once the fiber exits
+		 */
+		template<typename FN>
+		promise<std::invoke_result_t<std::decay_t<FN>&>> spawn(FN&& function) {
+			using result_type = std::invoke_result_t<std::decay_t<FN>&>;
+			promise<result_type> res;
+			using entry_type = detail::scheduled_fiber_entry<std::decay_t<FN>, result_type>;
+			auto hndl = detail::make_fiber_handle(
+				m_stack_size, entry_type{m_dispatcher, std::decay_t<FN>{std::forward<FN>(function)}, res});
+			m_dispatcher->push_resume(hndl);
+			return res;
+		}
+
+		/**
+		 * \brief Suspend the current fiber and reschedule it at the end of the dispatchers queue.
+		 * \throw std::logic_error if the calling code is not running inside a fiber spawned by a fiber_scheduler
+		 */
+		static void yield() {
+			auto cur = detail::g_current_fiber;
+			if (cur == nullptr || !cur->resume_handle) throw std::logic_error("not running on a scheduled fiber");
+			struct awaiter {
+				constexpr bool await_ready() const noexcept { return false; }
+				void await_suspend(coroutine_handle<> hndl) const { hndl.resume(); }
+				constexpr void await_resume() const noexcept {}
+			};
+			detail::fiber_await(awaiter{});
+		}
+
+		/// \brief Get the dispatcher fibers are run on
+		[[nodiscard]] dispatcher& get_dispatcher() const noexcept { return *m_dispatcher; }
+
+	private:
+		dispatcher* m_dispatcher;
+		size_t m_stack_size;
+	};
+} // namespace asyncpp
@@ -4,6 +4,9 @@
 #include <asyncpp/detail/std_import.h>
 #include <asyncpp/policy.h>
 #include <atomic>
+#include <exception>
+#include <functional>
+#include <type_traits>
 #include <utility>
 
 namespace asyncpp {
@@ -17,13 +20,27 @@ namespace asyncpp {
 		* \note Since the coroutine might outlive its caller, care must be taken if pointers or references are passed.
 		* \note If it is used as the return value of a lambda this applies to captures by value as well.
 		* \tparam Eager Flag to indicate if execution should start immediately or only after calling start.
+		* \tparam ExceptionPolicy exception_policy_dynamic to store the handler set by awaiting an exception_policy, or a
+		* StaticExceptionPolicy, which removes the std::function from the frame.
 		*/
-		template<bool Eager = false, ByteAllocator Allocator = default_allocator_type>
+		template<bool Eager = false, ByteAllocator Allocator = default_allocator_type,
+				 typename ExceptionPolicy = exception_policy_dynamic>
 		struct fire_and_forget_task_impl {
+			static_assert(std::is_same_v<ExceptionPolicy, exception_policy_dynamic> ||
+							  StaticExceptionPolicy<ExceptionPolicy>,
+						  "invalid exception policy");
+			static constexpr bool dynamic_policy = std::is_same_v<ExceptionPolicy, exception_policy_dynamic>;
+			struct no_exception_handler {};
+
 			// Promise type of this task
 			class promise_type : public promise_allocator_base<Allocator> {
 				std::atomic<size_t> m_ref_count{1};
-				std::function<void()> m_exception_handler{};
+				[[no_unique_address]] std::conditional_t<dynamic_policy, std::function<void()>, no_exception_handler>
+					m_exception_handler{};
+#if ASYNCPP_TRACK_FRAMES
+				frame_entry m_frame{Eager ? "eager_fire_and_forget_task" : "fire_and_forget_task",
+									coroutine_handle<promise_type>::from_promise(*this).address()};
+#endif
 
 			public:
 				constexpr promise_type() noexcept = default;
@@ -54,20 +71,35 @@ namespace asyncpp {
 				}
 				constexpr void return_void() noexcept {}
 				void unhandled_exception() noexcept {
-					if (m_exception_handler)
-						m_exception_handler();
-					else
-						std::terminate();
+					if constexpr (dynamic_policy) {
+						if (m_exception_handler)
+							m_exception_handler();
+						else
+							std::terminate();
+					} else {
+						ExceptionPolicy::on_exception();
+					}
 				}
 
-				auto await_transform(exception_policy policy) {
+				auto await_transform(exception_policy policy)
+					requires(dynamic_policy)
+				{
 					m_exception_handler = std::move(policy.handler);
 					return suspend_never{};
 				}
+#if ASYNCPP_TRACK_FRAMES
+				template<typename U>
+				decltype(auto) await_transform(U&& awaitable,
+											   std::source_location loc = std::source_location::current()) noexcept {
+					m_frame.suspended_at(loc);
+					return forward_awaitable(std::forward<U>(awaitable));
+				}
+#else
 				template<typename U>
 				constexpr U&& await_transform(U&& awaitable) noexcept {
 					return static_cast<U&&>(awaitable);
 				}
+#endif
 
 				void unref() noexcept {
 					if (m_ref_count.fetch_sub(1) == 1) coroutine_handle<promise_type>::from_promise(*this).destroy();
@@ -121,12 +153,45 @@ namespace asyncpp {
 		private:
 			coroutine_handle<promise_type> m_coro;
 		};
+
+		/**
+		* \brief Eager fire and forget task without reference counting.
+		*
+		* The frame is owned by the coroutine alone and destroyed once it finishes, the returned object is empty.
+		* Since it can not be started later or kept alive by its return value, no reference count is needed.
+		* \tparam ExceptionPolicy A StaticExceptionPolicy invoked if an exception leaves the coroutine.
+		*/
+		template<ByteAllocator Allocator = default_allocator_type,
+				 StaticExceptionPolicy ExceptionPolicy = exception_policy_terminate>
+		struct detached_task_impl {
+			// Promise type of this task
+			struct promise_type : promise_allocator_base<Allocator> {
+				constexpr detached_task_impl get_return_object() noexcept { return {}; }
+				constexpr suspend_never initial_suspend() noexcept { return {}; }
+				constexpr suspend_never final_suspend() noexcept { return {}; }
+				constexpr void return_void() noexcept {}
+				void unhandled_exception() noexcept { ExceptionPolicy::on_exception(); }
+#if ASYNCPP_TRACK_FRAMES
+				template<class U>
+				decltype(auto) await_transform(U&& awaitable,
+											   std::source_location loc = std::source_location::current()) noexcept {
+					m_frame.suspended_at(loc);
+					return forward_awaitable(std::forward<U>(awaitable));
+				}
+
+				frame_entry m_frame{"detached_task", coroutine_handle<promise_type>::from_promise(*this).address()};
+#endif
+			};
+		};
 	} // namespace detail
 
 	/// \brief Eager task, that immediately starts execution once called.
-	template<class Allocator = default_allocator_type>
-	using eager_fire_and_forget_task = detail::fire_and_forget_task_impl<true, Allocator>;
+	template<class Allocator = default_allocator_type, class ExceptionPolicy = exception_policy_dynamic>
+	using eager_fire_and_forget_task = detail::fire_and_forget_task_impl<true, Allocator, ExceptionPolicy>;
 	/// \brief Lazy task, that only starts after calling start().
-	template<class Allocator = default_allocator_type>
-	using fire_and_forget_task = detail::fire_and_forget_task_impl<false, Allocator>;
+	template<class Allocator = default_allocator_type, class ExceptionPolicy = exception_policy_dynamic>
+	using fire_and_forget_task = detail::fire_and_forget_task_impl<false, Allocator, ExceptionPolicy>;
+	/// \brief Eager task without reference counting and with a compile time exception policy.
+	template<class Allocator = default_allocator_type, class ExceptionPolicy = exception_policy_terminate>
+	using detached_task = detail::detached_task_impl<Allocator, ExceptionPolicy>;
 } // namespace asyncpp
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace asyncpp {
+	/**
+	 * \brief Monotonic arena handing out coroutine frames from large aligned chunks.
+	 *
+	 * Frames are bump allocated from chunks of chunk_size bytes, which are aligned to their size. The header at the
+	 * start of every chunk can therefore be found by masking a frame's address, so frames neither need to know
+	 * their arena nor carry an allocator copy and freeing one is O(1). Each chunk counts its live frames and is
+	 * released as soon as the last one is gone and the arena moved on to a new chunk. If all frames of the current
+	 * chunk are freed, the arena starts over at its beginning, so an arena used for a repeating workload stops
+	 * allocating once it is warmed up.
+	 *
+	 * Allocations have to be made by one thread at a time, frames can be freed from any thread. The arena can be
+	 * destroyed while frames are still alive, their chunks are released once those are freed.
+	 */
+	class frame_arena {
+		struct chunk {
+			std::atomic<size_t> live;
+		};
+
+	public:
+		/// \brief Size and alignment of the chunks, bigger frames get a chunk of their own
+		static constexpr size_t chunk_size = 64 * 1024;
+
+		constexpr frame_arena() noexcept = default;
+		~frame_arena() noexcept {
+			if (m_current != nullptr) release(m_current);
+		}
+		frame_arena(const frame_arena&) = delete;
+		frame_arena& operator=(const frame_arena&) = delete;
+
+		/**
+		 * \brief Allocate memory from the arena
+		 * \param size The size of the memory block
+		 * \return Memory aligned for any type with fundamental alignment
+		 */
+		[[nodiscard]] void* allocate(size_t size) {
+			size = (size + alignment - 1) & ~(alignment - 1);
+			if (size > chunk_size - header_size) {
+				auto res = new_chunk(header_size + size);
+				return reinterpret_cast<std::byte*>(res) + header_size;
+			}
+			// Everything allocated from the current chunk got freed, so its memory can be reused
+			if (m_current != nullptr && m_current->live.load(std::memory_order::acquire) == 1) m_offset = header_size;
+			if (m_current == nullptr || m_offset + size > chunk_size) {
+				auto next = new_chunk(chunk_size);
+				if (m_current != nullptr) release(m_current);
+				m_current = next;
+				m_offset = header_size;
+			}
+			m_current->live.fetch_add(1, std::memory_order::relaxed);
+			auto res = reinterpret_cast<std::byte*>(m_current) + m_offset;
+			m_offset += size;
+			return res;
+		}
+
+		/**
+		 * \brief Free memory allocated from any frame_arena
+		 * \param ptr The pointer returned by allocate()
+		 */
+		static void deallocate(void* ptr) noexcept {
+			if (ptr != nullptr) release(chunk_of(ptr));
+		}
+
+	private:
+		static constexpr size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+		static constexpr size_t header_size = (sizeof(chunk) + alignment - 1) & ~(alignment - 1);
+		static_assert((chunk_size & (chunk_size - 1)) == 0, "chunk size needs to be a power of two");
+
+		// The arena holds a reference to its current chunk, so it can not get released while allocating from it
+		chunk* m_current{nullptr};
+		size_t m_offset{0};
+
+		static chunk* new_chunk(size_t size) {
+			size = (size + chunk_size - 1) & ~(chunk_size - 1);
+			return new (::operator new(size, std::align_val_t{chunk_size})) chunk{1};
+		}
+		static void release(chunk* chk) noexcept {
+			if (chk->live.fetch_sub(1, std::memory_order::acq_rel) != 1) return;
+			chk->~chunk();
+			::operator delete(chk, std::align_val_t{chunk_size});
+		}
+		static chunk* chunk_of(void* ptr) noexcept {
+			// Frames in chunks of their own start within the first chunk_size bytes as well
+			return reinterpret_cast<chunk*>(reinterpret_cast<std::uintptr_t>(ptr) & ~(chunk_size - 1));
+		}
+	};
+
+	/**
+	 * \brief ByteAllocator allocating from a frame_arena.
+	 *
+	 * This satisfies ArenaBoundAllocator, so coroutine frames allocated with it do not store a copy of the allocator.
+	 * Pass the arena (or the allocator) as the last argument of the coroutine.
+	 */
+	class frame_arena_allocator {
+	public:
+		using value_type = std::byte;
+
+		constexpr frame_arena_allocator(frame_arena& arena) noexcept : m_arena{&arena} {}
+
+		[[nodiscard]] std::byte* allocate(size_t size) { return static_cast<std::byte*>(m_arena->allocate(size)); }
+		void deallocate(std::byte* ptr, size_t) noexcept { frame_arena::deallocate(ptr); }
+
+		/// \brief Get an allocator able to free ptr. Freeing does not need the arena, so it might be gone already.
+		[[nodiscard]] static frame_arena_allocator owner_of(std::byte*) noexcept { return frame_arena_allocator{}; }
+
+		friend constexpr bool operator==(const frame_arena_allocator& lhs, const frame_arena_allocator& rhs) noexcept {
+			return lhs.m_arena == rhs.m_arena;
+		}
+
+	private:
+		constexpr frame_arena_allocator() noexcept = default;
+
+		frame_arena* m_arena{nullptr};
+	};
+} // namespace asyncpp
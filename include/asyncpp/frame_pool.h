@@ -0,0 +1,177 @@
+#pragma once
+#include <asyncpp/detail/sanitizers.h>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace asyncpp {
+	/**
+	 * \brief Stateless allocator keeping freed coroutine frames in per thread size class pools.
+	 *
+	 * Allocations are rounded up to a power of two between 64 bytes and 4KiB, bigger ones are passed on to
+	 * operator new. Every thread caches freed blocks of each size class in a plain list, so the common case of
+	 * allocating and freeing frames on the same thread does not need any synchronization. Blocks are returned to the
+	 * calling thread, no matter which thread allocated them. Once a thread caches too many blocks of a class, half
+	 * of them move to a lock-free global pool, from which threads running out of blocks take them. This way frames of
+	 * coroutines allocated on one thread and destroyed on another are reused instead of piling up. Blocks cached by
+	 * a thread move to the global pool when it exits. Memory in the pools is kept for reuse and never given back.
+	 *
+	 * The allocator can be passed to task, launch, fire_and_forget_task, generator and async_generator, or be made
+	 * the default for all of them by defining ASYNCPP_DEFAULT_ALLOCATOR as asyncpp::frame_pool_allocator
+	 * (ASYNCPP_FRAME_POOL_DEFAULT in cmake).
+	 */
+	class frame_pool_allocator {
+	public:
+		using value_type = std::byte;
+		using is_always_equal = std::true_type;
+
+		/// \brief Number of size classes
+		static constexpr size_t num_classes = 7;
+		/// \brief Smallest block size
+		static constexpr size_t min_block_size = 64;
+		/// \brief Largest block size, larger requests go to operator new
+		static constexpr size_t max_block_size = min_block_size << (num_classes - 1);
+		/// \brief Blocks per size class a thread caches before it moves half of them to the global pool
+		static constexpr size_t thread_cache_limit = 64;
+
+		[[nodiscard]] std::byte* allocate(size_t size) {
+			if (size > max_block_size) return static_cast<std::byte*>(::operator new(size));
+			const auto index = size_class(size);
+			block* res = nullptr;
+			if (!g_cache_destroyed) {
+				auto& list = g_cache.lists[index];
+				if (list.head == nullptr) list.refill(g_global[index]);
+				if (list.head != nullptr) {
+					res = list.head;
+					list.head = res->next;
+					list.count--;
+				}
+			}
+			if (res == nullptr) return static_cast<std::byte*>(::operator new(min_block_size << index));
+			unpoison(res, index);
+			return reinterpret_cast<std::byte*>(res);
+		}
+
+		void deallocate(std::byte* ptr, size_t size) noexcept {
+			if (ptr == nullptr) return;
+			if (size > max_block_size) return ::operator delete(ptr);
+			const auto index = size_class(size);
+			auto blk = new (ptr) block{};
+			poison(blk, index);
+			if (g_cache_destroyed) {
+				// The thread is shutting down, hand it to the global pool directly
+				push_global(g_global[index], blk, blk);
+				return;
+			}
+			auto& list = g_cache.lists[index];
+			blk->next = list.head;
+			list.head = blk;
+			if (++list.count > thread_cache_limit) list.spill(g_global[index]);
+		}
+
+		/// \brief Move all blocks cached by the calling thread to the global pool
+		static void flush_thread_cache() noexcept {
+			if (!g_cache_destroyed) g_cache.flush();
+		}
+
+		friend constexpr bool operator==(const frame_pool_allocator&, const frame_pool_allocator&) noexcept {
+			return true;
+		}
+
+	private:
+		struct block {
+			block* next{nullptr};
+		};
+
+		struct thread_list {
+			// No default member initializers, the enclosing class is not complete yet. g_cache is value initialized.
+			block* head;
+			size_t count;
+
+			void refill(std::atomic<block*>& global) noexcept {
+				// Taking the whole list avoids the ABA problem of popping single blocks
+				head = global.exchange(nullptr, std::memory_order::acquire);
+				for (auto it = head; it != nullptr; it = it->next)
+					count++;
+			}
+			void spill(std::atomic<block*>& global) noexcept {
+				auto first = head;
+				auto last = head;
+				for (size_t i = 1; i < count / 2; i++)
+					last = last->next;
+				head = last->next;
+				count -= count / 2;
+				push_global(global, first, last);
+			}
+		};
+
+		struct thread_cache {
+			std::array<thread_list, num_classes> lists;
+
+			thread_cache() noexcept = default;
+			thread_cache(const thread_cache&) = delete;
+			thread_cache& operator=(const thread_cache&) = delete;
+			~thread_cache() noexcept {
+				flush();
+				g_cache_destroyed = true;
+			}
+
+			void flush() noexcept {
+				for (size_t i = 0; i < num_classes; i++) {
+					auto& list = lists[i];
+					if (list.head == nullptr) continue;
+					auto last = list.head;
+					while (last->next != nullptr)
+						last = last->next;
+					push_global(g_global[i], list.head, last);
+					list.head = nullptr;
+					list.count = 0;
+				}
+			}
+		};
+
+#if defined(ASYNCPP_SO_COMPAT)
+		static thread_local thread_cache g_cache;
+		static thread_local bool g_cache_destroyed;
+		static std::array<std::atomic<block*>, num_classes> g_global;
+#else
+		static thread_local inline thread_cache g_cache{};
+		// Frames freed by thread_local destructors running after g_cache was destroyed bypass the thread cache
+		static thread_local inline bool g_cache_destroyed = false;
+		static inline std::array<std::atomic<block*>, num_classes> g_global{};
+#endif
+
+		static constexpr size_t size_class(size_t size) noexcept {
+			return size <= min_block_size ? 0 : std::bit_width(size - 1) - std::bit_width(min_block_size - 1);
+		}
+
+		static void push_global(std::atomic<block*>& global, block* first, block* last) noexcept {
+			last->next = global.load(std::memory_order::relaxed);
+			while (!global.compare_exchange_weak(last->next, first, std::memory_order::release,
+												 std::memory_order::relaxed)) {}
+		}
+
+		// Keep the sanitizer able to detect use after free of pooled frames, except the list pointer
+		static void poison([[maybe_unused]] block* blk, [[maybe_unused]] size_t index) noexcept {
+#if ASYNCPP_HAS_ASAN
+			ASAN_POISON_MEMORY_REGION(blk + 1, (min_block_size << index) - sizeof(block));
+#endif
+		}
+		static void unpoison([[maybe_unused]] block* blk, [[maybe_unused]] size_t index) noexcept {
+#if ASYNCPP_HAS_ASAN
+			ASAN_UNPOISON_MEMORY_REGION(blk + 1, (min_block_size << index) - sizeof(block));
+#endif
+		}
+	};
+
+#if defined(ASYNCPP_SO_COMPAT_IMPL)
+	thread_local frame_pool_allocator::thread_cache frame_pool_allocator::g_cache{};
+	thread_local bool frame_pool_allocator::g_cache_destroyed = false;
+	std::array<std::atomic<frame_pool_allocator::block*>, frame_pool_allocator::num_classes>
+		frame_pool_allocator::g_global{};
+#endif
+} // namespace asyncpp
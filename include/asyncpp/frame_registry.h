@@ -0,0 +1,306 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+
+// Enables the registry of live coroutine frames, see frame_registry. This changes the layout of the promise types,
+// so it needs to be set the same way in every translation unit.
+#ifndef ASYNCPP_TRACK_FRAMES
+#define ASYNCPP_TRACK_FRAMES 0
+#endif
+
+#if ASYNCPP_TRACK_FRAMES
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace asyncpp {
+	class frame_registry;
+
+	/**
+	 * \brief State of a live coroutine frame, see frame_registry::snapshot().
+	 */
+	struct frame_snapshot {
+		/// \brief Address of the frame, as returned by coroutine_handle<>::address()
+		const void* address;
+		/// \brief Kind of the coroutine, e.g. "task"
+		const char* kind;
+		/// \brief Size of the frame allocation, 0 if it is not known
+		std::size_t size;
+		/// \brief Time since the coroutine was created
+		std::chrono::nanoseconds age;
+		/// \brief File of the last co_await, nullptr if the coroutine did not await anything yet
+		const char* file;
+		/// \brief Function containing the last co_await
+		const char* function;
+		/// \brief Line of the last co_await
+		std::uint_least32_t line;
+		/// \brief Frame of the coroutine awaiting this one, nullptr if there is none or it is not known
+		const void* continuation;
+	};
+
+	namespace detail {
+		/**
+		 * \brief Size passed to the last coroutine frame allocation of this thread.
+		 *
+		 * Set by promise_allocator_base and taken by the frame_entry of the promise constructed right after.
+		 */
+		inline thread_local std::size_t g_last_frame_size{0};
+
+		/**
+		 * \brief Refers to an awaiter passed to await_transform of a tracked promise.
+		 *
+		 * gcc copies awaiters returned by reference from await_transform, which fails for non copyable ones and
+		 * breaks awaiters relying on their address. Returning this wrapper by value keeps using the original object,
+		 * which lives until the end of the full expression containing the co_await.
+		 */
+		template<typename T>
+		struct awaiter_ref {
+			T* awaiter;
+
+			decltype(auto) await_ready() { return awaiter->await_ready(); }
+			template<typename TPromise>
+			decltype(auto) await_suspend(coroutine_handle<TPromise> hndl) {
+				return awaiter->await_suspend(hndl);
+			}
+			decltype(auto) await_resume() { return awaiter->await_resume(); }
+		};
+
+		/**
+		 * \brief Pass an awaitable through await_transform, see awaiter_ref
+		 */
+		template<typename T>
+		decltype(auto) forward_awaitable(T&& awaitable) noexcept {
+			if constexpr (requires(std::remove_reference_t<T>& val) { val.await_ready(); })
+				return awaiter_ref<std::remove_reference_t<T>>{&awaitable};
+			else
+				return static_cast<T&&>(awaitable);
+		}
+
+		/**
+		 * \brief Entry of a coroutine frame in the frame_registry, embedded into the promise.
+		 *
+		 * Only the coroutine itself updates the suspension point and continuation, using relaxed atomics so they can
+		 * be read by frame_registry::snapshot() at any time.
+		 */
+		class frame_entry {
+		public:
+			frame_entry(const char* kind, const void* address) noexcept;
+			~frame_entry();
+			frame_entry(const frame_entry&) = delete;
+			frame_entry& operator=(const frame_entry&) = delete;
+
+			/// \brief Record the location of a co_await
+			void suspended_at(const std::source_location& loc) noexcept {
+				m_file.store(loc.file_name(), std::memory_order::relaxed);
+				m_function.store(loc.function_name(), std::memory_order::relaxed);
+				m_line.store(loc.line(), std::memory_order::relaxed);
+			}
+			/// \brief Record the coroutine awaiting this one
+			void continuation(coroutine_handle<> hndl) noexcept {
+				m_continuation.store(hndl.address(), std::memory_order::relaxed);
+			}
+
+		private:
+			friend class asyncpp::frame_registry;
+
+			const char* const m_kind;
+			const void* const m_address;
+			const std::size_t m_size{std::exchange(g_last_frame_size, 0)};
+			const std::chrono::steady_clock::time_point m_created{std::chrono::steady_clock::now()};
+			std::atomic<const char*> m_file{nullptr};
+			std::atomic<const char*> m_function{nullptr};
+			std::atomic<std::uint_least32_t> m_line{0};
+			std::atomic<const void*> m_continuation{nullptr};
+			// Protected by the mutex of the shard
+			frame_entry* m_prev{nullptr};
+			frame_entry* m_next{nullptr};
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Registry of all live coroutine frames of task, launch() and fire_and_forget_task.
+	 *
+	 * Only available if ASYNCPP_TRACK_FRAMES is set. Frames are spread over a number of shards by their address, so
+	 * creating and destroying coroutines on different threads rarely contends on the same lock. Every co_await
+	 * records its std::source_location and awaiting a task records the awaiting coroutine, which allows printing an
+	 * async stack trace for every suspended coroutine chain.
+	 */
+	class frame_registry {
+		static constexpr std::size_t shard_count = 64;
+
+		struct alignas(64) shard {
+			std::mutex mutex{};
+			detail::frame_entry* head{nullptr};
+			std::size_t count{0};
+		};
+
+		std::array<shard, shard_count> m_shards{};
+
+		// Never destroyed, coroutines might outlive static destruction
+		static frame_registry& instance() {
+			static auto* const registry = new frame_registry();
+			return *registry;
+		}
+
+		static shard& shard_of(const void* address) noexcept {
+			// Frames are at least 16 byte aligned, so the lowest bits carry no information
+			const auto value = reinterpret_cast<std::uintptr_t>(address) >> 4;
+			return instance().m_shards[(value ^ (value >> 7)) % shard_count];
+		}
+
+		friend class detail::frame_entry;
+
+	public:
+		/**
+		 * \brief Get the number of live frames
+		 */
+		static std::size_t size() {
+			std::size_t res = 0;
+			for (auto& shard : instance().m_shards) {
+				std::unique_lock lck{shard.mutex};
+				res += shard.count;
+			}
+			return res;
+		}
+
+		/**
+		 * \brief Get the state of all live frames.
+		 *
+		 * The shards are locked one after another, so coroutines created or destroyed meanwhile might be missing.
+		 */
+		static std::vector<frame_snapshot> snapshot() {
+			std::vector<frame_snapshot> res;
+			const auto now = std::chrono::steady_clock::now();
+			for (auto& shard : instance().m_shards) {
+				std::unique_lock lck{shard.mutex};
+				res.reserve(res.size() + shard.count);
+				for (auto entry = shard.head; entry != nullptr; entry = entry->m_next) {
+					res.push_back(frame_snapshot{
+						entry->m_address,
+						entry->m_kind,
+						entry->m_size,
+						now - entry->m_created,
+						entry->m_file.load(std::memory_order::relaxed),
+						entry->m_function.load(std::memory_order::relaxed),
+						entry->m_line.load(std::memory_order::relaxed),
+						entry->m_continuation.load(std::memory_order::relaxed),
+					});
+				}
+			}
+			return res;
+		}
+
+		/**
+		 * \brief Print a summary of the live frames.
+		 *
+		 * The output contains the number and total size of the frames, the suspension points ordered by the number
+		 * of coroutines waiting there and the async stack traces of the oldest coroutine chains, starting at the
+		 * innermost coroutine.
+		 * \param out The stream to write to
+		 * \param max_stacks Maximum number of stack traces to print
+		 */
+		static void dump(std::ostream& out, std::size_t max_stacks = 16) {
+			auto frames = snapshot();
+			std::size_t total_size = 0;
+			for (auto& frame : frames)
+				total_size += frame.size;
+			out << "asyncpp: " << frames.size() << " live coroutine frames, " << total_size << " bytes\n";
+			if (frames.empty()) return;
+
+			struct point_stats {
+				std::size_t count{0};
+				std::size_t size{0};
+				std::chrono::nanoseconds oldest{0};
+			};
+			// The strings are literals owned by the binary, but might be duplicated so compare their contents
+			using point = std::tuple<std::string_view, std::uint_least32_t, std::string_view>;
+			std::map<point, point_stats> points;
+			std::unordered_map<const void*, const frame_snapshot*> by_address;
+			std::unordered_set<const void*> awaited;
+			for (auto& frame : frames) {
+				auto& stats = points[point{frame.file ? frame.file : "<not started>", frame.line,
+										   frame.function ? frame.function : ""}];
+				stats.count++;
+				stats.size += frame.size;
+				stats.oldest = (std::max)(stats.oldest, frame.age);
+				by_address[frame.address] = &frame;
+				if (frame.continuation != nullptr) awaited.insert(frame.continuation);
+			}
+			std::vector<std::pair<point, point_stats>> sorted(points.begin(), points.end());
+			std::sort(sorted.begin(), sorted.end(),
+					  [](const auto& lhs, const auto& rhs) { return lhs.second.count > rhs.second.count; });
+			out << "Suspension points:\n";
+			for (auto& [pt, stats] : sorted) {
+				out << "  " << stats.count << " frames, " << stats.size << " bytes, oldest " << to_ms(stats.oldest)
+					<< "ms at " << std::get<0>(pt) << ":" << std::get<1>(pt);
+				if (!std::get<2>(pt).empty()) out << " in " << std::get<2>(pt);
+				out << "\n";
+			}
+
+			// Innermost coroutines are the ones nobody else is waiting for, print the oldest chains first
+			std::vector<const frame_snapshot*> leaves;
+			for (auto& frame : frames) {
+				if (!awaited.contains(frame.address)) leaves.push_back(&frame);
+			}
+			std::sort(leaves.begin(), leaves.end(), [](auto lhs, auto rhs) { return lhs->age > rhs->age; });
+			out << "Async stacks:\n";
+			for (std::size_t i = 0; i < leaves.size() && i < max_stacks; i++) {
+				out << "  Stack " << i << ":\n";
+				auto frame = leaves[i];
+				// The depth is bounded in case a continuation got reused by another frame in between
+				for (std::size_t depth = 0; frame != nullptr && depth < frames.size(); depth++) {
+					out << "    #" << depth << " " << frame->kind << " " << frame->address;
+					if (frame->file != nullptr) {
+						out << " at " << frame->file << ":" << frame->line;
+						if (frame->function != nullptr) out << " in " << frame->function;
+					}
+					out << " (" << frame->size << " bytes, age " << to_ms(frame->age) << "ms)\n";
+					auto next = by_address.find(frame->continuation);
+					frame = next == by_address.end() ? nullptr : next->second;
+				}
+			}
+			if (leaves.size() > max_stacks) out << "  ... " << (leaves.size() - max_stacks) << " more\n";
+		}
+
+	private:
+		static long long to_ms(std::chrono::nanoseconds duration) noexcept {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+		}
+	};
+
+	namespace detail {
+		inline frame_entry::frame_entry(const char* kind, const void* address) noexcept
+			: m_kind{kind}, m_address{address} {
+			auto& shard = frame_registry::shard_of(address);
+			std::unique_lock lck{shard.mutex};
+			m_next = shard.head;
+			if (m_next != nullptr) m_next->m_prev = this;
+			shard.head = this;
+			shard.count++;
+		}
+
+		inline frame_entry::~frame_entry() {
+			auto& shard = frame_registry::shard_of(m_address);
+			std::unique_lock lck{shard.mutex};
+			if (m_prev != nullptr)
+				m_prev->m_next = m_next;
+			else
+				shard.head = m_next;
+			if (m_next != nullptr) m_next->m_prev = m_prev;
+			shard.count--;
+		}
+	} // namespace detail
+} // namespace asyncpp
+#endif
@@ -3,12 +3,21 @@
 #include <asyncpp/detail/std_import.h>
 #include <exception>
 #include <functional>
+#include <span>
 
 namespace asyncpp {
 	template<class T, ByteAllocator Allocator = default_allocator_type>
 	class generator;
 
 	namespace detail {
+		// Yielding an empty chunk does not suspend, so the consumer never sees one
+		struct generator_chunk_yield {
+			bool m_empty;
+			[[nodiscard]] constexpr bool await_ready() const noexcept { return m_empty; }
+			constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+			constexpr void await_resume() const noexcept {}
+		};
+
 		template<class T, ByteAllocator Allocator>
 		class generator_promise : public promise_allocator_base<Allocator> {
 		public:
@@ -31,18 +40,34 @@ namespace asyncpp {
 
 			suspend_always yield_value(std::remove_reference_t<T>&& value) noexcept {
 				m_value = std::addressof(value);
+				m_end = m_value + 1;
 				return {};
 			}
 
 			template<class U = T, typename = std::enable_if_t<!std::is_rvalue_reference_v<U>>>
 			suspend_always yield_value(std::remove_reference_t<T>& value) noexcept {
 				m_value = std::addressof(value);
+				m_end = m_value + 1;
 				return {};
 			}
 
+			/**
+			 * \brief Yield a whole chunk of values at once.
+			 *
+			 * The consumer walks the chunk in place and the generator is only resumed once it moved past its end.
+			 * The memory needs to stay valid until then.
+			 */
+			template<class U = T, typename = std::enable_if_t<!std::is_rvalue_reference_v<U>>>
+			generator_chunk_yield yield_value(std::span<value_type> chunk) noexcept {
+				m_value = chunk.data();
+				m_end = chunk.data() + chunk.size();
+				return {chunk.empty()};
+			}
+
 			void unhandled_exception() noexcept { m_exception = std::current_exception(); }
 
 			pointer_type value() const noexcept { return m_value; }
+			pointer_type value_end() const noexcept { return m_end; }
 
 			std::exception_ptr exception() const noexcept { return m_exception; }
 
@@ -52,6 +77,7 @@ namespace asyncpp {
 
 		private:
 			T* m_value{nullptr};
+			pointer_type m_end{nullptr};
 			std::exception_ptr m_exception{nullptr};
 		};
 
@@ -69,28 +95,51 @@ namespace asyncpp {
 			using pointer = typename promise_type::pointer_type;
 
 			constexpr generator_iterator() noexcept : m_coro{nullptr} {}
-			explicit constexpr generator_iterator(handle_t hdl) noexcept : m_coro{hdl} {}
+			explicit constexpr generator_iterator(handle_t hdl) noexcept : m_coro{hdl} { load_chunk(); }
 
 			bool operator==(generator_end) const noexcept { return !m_coro || m_coro.done(); }
 
 			generator_iterator& operator++() {
+				// Only resume the generator once the current chunk is exhausted
+				if (++m_pos != m_end) return *this;
+				return next_chunk();
+			}
+
+			// Not really supported, but many people prefer postincrement even if the result is unused
+			void operator++(int) { ++(*this); }
+
+			reference operator*() const noexcept { return static_cast<reference>(*m_pos); }
+
+			pointer operator->() const noexcept { return m_pos; }
+
+			/**
+			 * \brief Get the remaining values of the current chunk, starting with the current one.
+			 *
+			 * Values yielded on their own form a chunk of size one.
+			 */
+			std::span<value_type> chunk() const noexcept { return {m_pos, m_end}; }
+
+			/// \brief Skip the rest of the current chunk and resume the generator.
+			generator_iterator& next_chunk() {
 				m_coro.resume();
 				if (m_coro.done()) {
 					auto except = m_coro.promise().exception();
 					if (except) std::rethrow_exception(except);
 				}
+				load_chunk();
 				return *this;
 			}
 
-			// Not really supported, but many people prefer postincrement even if the result is unused
-			void operator++(int) { ++(*this); }
-
-			reference operator*() const noexcept { return static_cast<reference>(*m_coro.promise().value()); }
-
-			pointer operator->() const noexcept { return m_coro.promise().value(); }
-
 		private:
 			handle_t m_coro;
+			pointer m_pos{nullptr};
+			pointer m_end{nullptr};
+
+			void load_chunk() noexcept {
+				if (!m_coro || m_coro.done()) return;
+				m_pos = m_coro.promise().value();
+				m_end = m_coro.promise().value_end();
+			}
 		};
 
 		template<typename T, ByteAllocator Allocator>
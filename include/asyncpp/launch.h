@@ -1,6 +1,9 @@
 #pragma once
+#include <asyncpp/detail/cpu_pause.h>
 #include <asyncpp/detail/promise_allocator_base.h>
+#include <asyncpp/frame_arena.h>
 #include <asyncpp/scope_guard.h>
+#include <asyncpp/trampoline.h>
 #include <atomic>
 #include <cassert>
 #include <exception>
@@ -26,6 +29,16 @@ namespace asyncpp {
 				constexpr suspend_never final_suspend() noexcept { return {}; }
 				constexpr void return_void() noexcept {}
 				void unhandled_exception() noexcept { std::terminate(); }
+#if ASYNCPP_TRACK_FRAMES
+				template<class U>
+				decltype(auto) await_transform(U&& awaitable,
+											   std::source_location loc = std::source_location::current()) noexcept {
+					m_frame.suspended_at(loc);
+					return forward_awaitable(std::forward<U>(awaitable));
+				}
+
+				frame_entry m_frame{"launch_task", coroutine_handle<promise_type>::from_promise(*this).address()};
+#endif
 			};
 		};
 	} // namespace detail
@@ -47,13 +60,88 @@ namespace asyncpp {
 
 	/**
 	 * \brief Holder class for spawning child tasks. Allows waiting for all of them to finish.
+	 *
+	 * A scope constructed with use_arena allocates the wrapper task of every child launched without a custom
+	 * allocator type from a frame_arena it owns. Launching a child then only bumps a pointer and finishing one
+	 * decrements the live count of its chunk. Once all children finished the arena starts over with the same memory.
 	 */
 	class async_launch_scope {
 		std::atomic<size_t> m_count{0U};
 		std::atomic<void*> m_continuation{nullptr};
+		bool m_use_arena{false};
+		std::atomic<bool> m_arena_locked{false};
+		frame_arena m_arena{};
+
+		// Allocates from the scope's arena, children might launch siblings from any thread
+		class arena_allocator {
+		public:
+			using value_type = std::byte;
+
+			constexpr arena_allocator(async_launch_scope* scope) noexcept : m_scope{scope} {}
+
+			[[nodiscard]] std::byte* allocate(size_t size) {
+				while (m_scope->m_arena_locked.exchange(true, std::memory_order::acquire))
+					detail::cpu_pause();
+				auto res = static_cast<std::byte*>(m_scope->m_arena.allocate(size));
+				m_scope->m_arena_locked.store(false, std::memory_order::release);
+				return res;
+			}
+			void deallocate(std::byte* ptr, size_t) noexcept { frame_arena::deallocate(ptr); }
+			[[nodiscard]] static arena_allocator owner_of(std::byte*) noexcept { return arena_allocator{nullptr}; }
+
+		private:
+			async_launch_scope* m_scope;
+		};
+
+		void child_done() noexcept {
+			// If this is the last task
+			if (m_count.fetch_sub(1) == 1) {
+				// And we are being awaited
+				auto hdl = m_continuation.exchange(nullptr);
+				// Resume the awaiter
+				if (hdl != nullptr) resume_trampoline::resume(coroutine_handle<>::from_address(hdl));
+			}
+		}
+
+		template<typename Awaitable, ByteAllocator Allocator>
+		void launch_impl(Awaitable&& awaitable, const Allocator& allocator) {
+			[](async_launch_scope* scope, std::decay_t<Awaitable> awaitable,
+			   const Allocator&) -> detail::launch_task<Allocator> {
+				scope->m_count.fetch_add(1);
+				scope_guard guard{[scope]() noexcept { scope->child_done(); }};
+				co_await awaitable;
+			}(this, std::forward<decltype(awaitable)>(awaitable), allocator);
+		}
+
+		template<typename Callable, typename... Args, ByteAllocator Allocator>
+		void invoke_tuple_impl(Callable&& callable, std::tuple<Args...>&& args, const Allocator& allocator) {
+			[](async_launch_scope* scope, Callable callable, std::tuple<Args...>&& args,
+			   const Allocator&) -> detail::launch_task<Allocator> {
+				scope->m_count.fetch_add(1);
+				scope_guard guard{[scope]() noexcept { scope->child_done(); }};
+				co_await std::apply(callable, std::move(args));
+			}(this, std::forward<Callable>(callable), std::move(args), allocator);
+		}
+
+		template<ByteAllocator Allocator, typename Callable, typename... Args>
+		void invoke_impl(const Allocator& allocator, Callable&& callable, Args&&... args) {
+			// The allocator needs to be the last parameter of the coroutine
+			[](async_launch_scope* scope, Callable callable, Args&&... args,
+			   const Allocator&) -> detail::launch_task<Allocator> {
+				scope->m_count.fetch_add(1);
+				scope_guard guard{[scope]() noexcept { scope->child_done(); }};
+				co_await std::invoke(callable, std::forward<Args>(args)...);
+			}(this, std::forward<Callable>(callable), std::forward<Args>(args)..., allocator);
+		}
 
 	public:
+		/// \brief Tag value used to construct a scope allocating its children from an arena
+		constexpr static struct {
+		} use_arena{};
+
 		constexpr async_launch_scope() noexcept = default;
+		/// \brief Construct a scope allocating the wrapper tasks of its children from an arena
+		explicit constexpr async_launch_scope(decltype(use_arena)) noexcept : m_use_arena{true} {}
 		async_launch_scope(const async_launch_scope&) = delete;
 		async_launch_scope& operator=(const async_launch_scope&) = delete;
 		~async_launch_scope() { assert(m_count.load() == 0); }
@@ -65,20 +153,10 @@ namespace asyncpp {
 		 */
 		template<typename Awaitable, ByteAllocator Allocator = default_allocator_type>
 		void launch(Awaitable&& awaitable, const Allocator& allocator = {}) {
-			[](async_launch_scope* scope, std::decay_t<Awaitable> awaitable,
-			   const Allocator&) -> detail::launch_task<Allocator> {
-				scope->m_count.fetch_add(1);
-				scope_guard guard{[scope]() noexcept {
-					// If this is the last task
-					if (scope->m_count.fetch_sub(1) == 1) {
-						// And we are being awaited
-						auto hdl = scope->m_continuation.exchange(nullptr);
-						// Resume the awaiter
-						if (hdl != nullptr) coroutine_handle<>::from_address(hdl).resume();
-					}
-				}};
-				co_await awaitable;
-			}(this, std::forward<decltype(awaitable)>(awaitable), allocator);
+			if constexpr (std::is_same_v<Allocator, default_allocator_type>) {
+				if (m_use_arena) return launch_impl(std::forward<Awaitable>(awaitable), arena_allocator{this});
+			}
+			launch_impl(std::forward<Awaitable>(awaitable), allocator);
 		}
 
 		/**
@@ -91,20 +169,11 @@ namespace asyncpp {
 		template<typename Callable, typename... Args, ByteAllocator Allocator = default_allocator_type>
 			requires(std::is_invocable_v<Callable, Args...>)
 		void invoke_tuple(Callable&& callable, std::tuple<Args...>&& args, const Allocator& allocator = {}) {
-			[](async_launch_scope* scope, Callable callable, std::tuple<Args...>&& args,
-			   const Allocator&) -> detail::launch_task<Allocator> {
-				scope->m_count.fetch_add(1);
-				scope_guard guard{[scope]() noexcept {
-					// If this is the last task
-					if (scope->m_count.fetch_sub(1) == 1) {
-						// And we are being awaited
-						auto hdl = scope->m_continuation.exchange(nullptr);
-						// Resume the awaiter
-						if (hdl != nullptr) coroutine_handle<>::from_address(hdl).resume();
-					}
-				}};
-				co_await std::apply(callable, std::move(args));
-			}(this, std::forward<Callable>(callable), std::move(args), allocator);
+			if constexpr (std::is_same_v<Allocator, default_allocator_type>) {
+				if (m_use_arena)
+					return invoke_tuple_impl(std::forward<Callable>(callable), std::move(args), arena_allocator{this});
+			}
+			invoke_tuple_impl(std::forward<Callable>(callable), std::move(args), allocator);
 		}
 
 		/**
@@ -117,19 +186,11 @@ namespace asyncpp {
 		template<typename Callable, typename... Args>
 			requires(std::is_invocable_v<Callable, Args...>)
 		void invoke(Callable&& callable, Args&&... args) {
-			[](async_launch_scope* scope, Callable callable, Args&&... args) -> detail::launch_task<> {
-				scope->m_count.fetch_add(1);
-				scope_guard guard{[scope]() noexcept {
-					// If this is the last task
-					if (scope->m_count.fetch_sub(1) == 1) {
-						// And we are being awaited
-						auto hdl = scope->m_continuation.exchange(nullptr);
-						// Resume the awaiter
-						if (hdl != nullptr) coroutine_handle<>::from_address(hdl).resume();
-					}
-				}};
-				co_await std::invoke(callable, std::forward<Args>(args)...);
-			}(this, std::forward<Callable>(callable), std::forward<Args>(args)...);
+			if (m_use_arena) {
+				return invoke_impl(arena_allocator{this}, std::forward<Callable>(callable),
+								   std::forward<Args>(args)...);
+			}
+			invoke_impl(default_allocator_type{}, std::forward<Callable>(callable), std::forward<Args>(args)...);
 		}
 
 		/**
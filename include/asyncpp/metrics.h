@@ -0,0 +1,358 @@
+#pragma once
+#include <asyncpp/dispatcher.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace asyncpp {
+	/**
+	 * \brief Counters of a dispatcher, see thread_pool::metrics() and timer::metrics().
+	 *
+	 * The counters are collected while the dispatcher keeps running, so they are not an exact snapshot.
+	 */
+	struct dispatcher_metrics {
+		/// \brief Number of worker threads the counters were collected from
+		std::size_t workers{0};
+		/// \brief Work waiting to run at the time of the call
+		std::size_t queue_depth{0};
+		/// \brief Number of callbacks and coroutines pushed
+		std::uint64_t pushed{0};
+		/// \brief Number of callbacks and coroutines run
+		std::uint64_t executed{0};
+		/// \brief Number of executed callbacks that were taken from another worker
+		std::uint64_t stolen{0};
+		/// \brief Total time spent running callbacks
+		std::chrono::nanoseconds busy_time{0};
+		/// \brief Total time spent waiting for work
+		std::chrono::nanoseconds idle_time{0};
+		/// \brief Longest time a single callback ran
+		std::chrono::nanoseconds max_callback_time{0};
+
+		/// \brief Average time a callback ran
+		[[nodiscard]] std::chrono::nanoseconds average_callback_time() const noexcept {
+			return executed == 0 ? std::chrono::nanoseconds{0}
+								 : busy_time / static_cast<std::chrono::nanoseconds::rep>(executed);
+		}
+		/// \brief Fraction of the executed callbacks that were stolen
+		[[nodiscard]] double steal_rate() const noexcept {
+			return executed == 0 ? 0.0 : static_cast<double>(stolen) / static_cast<double>(executed);
+		}
+	};
+
+	/**
+	 * \brief Contention counters of a synchronization primitive, see mutex::metrics().
+	 *
+	 * Like dispatcher_metrics the counters are collected while the primitive keeps being used.
+	 */
+	struct contention_metrics {
+		/// \brief Number of times the primitive was awaited
+		std::uint64_t waits{0};
+		/// \brief Number of awaits that actually suspended the coroutine
+		std::uint64_t suspensions{0};
+		/// \brief Total time suspended coroutines waited until they got resumed
+		std::chrono::nanoseconds parked_time{0};
+		/// \brief Longest time a single coroutine waited
+		std::chrono::nanoseconds max_parked_time{0};
+		/// \brief Longest list of waiting coroutines seen
+		std::size_t max_waiters{0};
+
+		/// \brief Fraction of the awaits that suspended
+		[[nodiscard]] double suspend_rate() const noexcept {
+			return waits == 0 ? 0.0 : static_cast<double>(suspensions) / static_cast<double>(waits);
+		}
+		/// \brief Average time a suspended coroutine waited
+		[[nodiscard]] std::chrono::nanoseconds average_parked_time() const noexcept {
+			return suspensions == 0 ? std::chrono::nanoseconds{0}
+									: parked_time / static_cast<std::chrono::nanoseconds::rep>(suspensions);
+		}
+	};
+
+	namespace detail {
+		/**
+		 * \brief Contention counters embedded into a synchronization primitive.
+		 *
+		 * Unlike metrics_slot every counter might be updated by multiple threads at once.
+		 */
+		class contention_counters {
+		public:
+			/// \brief Count an await
+			void count_wait() noexcept { m_waits.fetch_add(1, std::memory_order::relaxed); }
+			/// \brief Count an await that suspended for the given duration
+			void count_parked(std::chrono::nanoseconds duration) noexcept {
+				const auto value = static_cast<std::uint64_t>(duration.count());
+				m_suspensions.fetch_add(1, std::memory_order::relaxed);
+				m_parked_ns.fetch_add(value, std::memory_order::relaxed);
+				update_max(m_max_parked_ns, value);
+			}
+			/// \brief Record the current length of the waiter list
+			void count_waiters(std::size_t count) noexcept { update_max(m_max_waiters, count); }
+
+			/// \brief Get the current values
+			[[nodiscard]] contention_metrics collect() const noexcept {
+				return contention_metrics{
+					m_waits.load(std::memory_order::relaxed),
+					m_suspensions.load(std::memory_order::relaxed),
+					std::chrono::nanoseconds{m_parked_ns.load(std::memory_order::relaxed)},
+					std::chrono::nanoseconds{m_max_parked_ns.load(std::memory_order::relaxed)},
+					static_cast<std::size_t>(m_max_waiters.load(std::memory_order::relaxed)),
+				};
+			}
+
+		private:
+			static void update_max(std::atomic<std::uint64_t>& value, std::uint64_t candidate) noexcept {
+				auto old = value.load(std::memory_order::relaxed);
+				while (candidate > old && !value.compare_exchange_weak(old, candidate, std::memory_order::relaxed)) {}
+			}
+
+			std::atomic<std::uint64_t> m_waits{0};
+			std::atomic<std::uint64_t> m_suspensions{0};
+			std::atomic<std::uint64_t> m_parked_ns{0};
+			std::atomic<std::uint64_t> m_max_parked_ns{0};
+			std::atomic<std::uint64_t> m_max_waiters{0};
+		};
+
+		/**
+		 * \brief Measures how long an awaiter stays suspended.
+		 *
+		 * start() has to be called before the awaiter becomes visible to the waking side, because the coroutine
+		 * might be resumed and the awaiter destroyed right after. cancel() undoes it if the awaiter did not suspend.
+		 * finish() is called by the waking side right before the coroutine is resumed, the primitive might already
+		 * be gone once the coroutine runs.
+		 */
+		class park_timer {
+		public:
+			void start() noexcept { m_since = std::chrono::steady_clock::now(); }
+			void cancel() noexcept { m_since = {}; }
+			/// \brief Count the suspension if there was one
+			void finish(contention_counters& counters) const noexcept {
+				if (m_since != std::chrono::steady_clock::time_point{})
+					counters.count_parked(std::chrono::steady_clock::now() - m_since);
+			}
+
+		private:
+			std::chrono::steady_clock::time_point m_since{};
+		};
+
+		/**
+		 * \brief Counters of a single worker thread.
+		 *
+		 * Every counter has exactly one writer, usually the worker owning the slot, so updating them does not need
+		 * any atomic read-modify-write. The slot fills a whole cache line, which keeps workers from invalidating each
+		 * others counters. Readers can collect() at any time.
+		 */
+		class alignas(64) metrics_slot {
+		public:
+			/// \brief Count pushed work
+			void count_push(std::uint64_t count = 1) noexcept { bump(m_pushed, count); }
+			/// \brief Count work taken from another worker, the callback itself is counted by count_callback()
+			void count_steal() noexcept { bump(m_stolen, 1); }
+			/// \brief Count a callback that ran for the given duration
+			void count_callback(std::chrono::nanoseconds duration) noexcept {
+				const auto value = static_cast<std::uint64_t>(duration.count());
+				bump(m_executed, 1);
+				bump(m_busy_ns, value);
+				if (value > m_max_ns.load(std::memory_order::relaxed))
+					m_max_ns.store(value, std::memory_order::relaxed);
+			}
+			/// \brief Count time spent waiting for work
+			void count_idle(std::chrono::nanoseconds duration) noexcept {
+				bump(m_idle_ns, static_cast<std::uint64_t>(duration.count()));
+			}
+
+			/// \brief Add the counters of this slot to res, workers and queue_depth are not touched
+			void collect(dispatcher_metrics& res) const noexcept {
+				res.pushed += m_pushed.load(std::memory_order::relaxed);
+				res.executed += m_executed.load(std::memory_order::relaxed);
+				res.stolen += m_stolen.load(std::memory_order::relaxed);
+				res.busy_time += std::chrono::nanoseconds{m_busy_ns.load(std::memory_order::relaxed)};
+				res.idle_time += std::chrono::nanoseconds{m_idle_ns.load(std::memory_order::relaxed)};
+				res.max_callback_time = (std::max)(res.max_callback_time,
+												   std::chrono::nanoseconds{m_max_ns.load(std::memory_order::relaxed)});
+			}
+
+		private:
+			static void bump(std::atomic<std::uint64_t>& value, std::uint64_t count) noexcept {
+				value.store(value.load(std::memory_order::relaxed) + count, std::memory_order::relaxed);
+			}
+
+			std::atomic<std::uint64_t> m_pushed{0};
+			std::atomic<std::uint64_t> m_executed{0};
+			std::atomic<std::uint64_t> m_stolen{0};
+			std::atomic<std::uint64_t> m_busy_ns{0};
+			std::atomic<std::uint64_t> m_idle_ns{0};
+			std::atomic<std::uint64_t> m_max_ns{0};
+		};
+	} // namespace detail
+
+	/**
+	 * \brief dispatch_observer recording the events in the Chrome trace event format.
+	 *
+	 * Every thread appends to a buffer of its own, the recorder only takes its lock the first time a thread
+	 * reports an event. write() produces JSON that can be loaded by Perfetto (ui.perfetto.dev) or chrome://tracing.
+	 * Callbacks show up as slices on the track of the thread running them, pushes and steals as instant events on
+	 * the track of the thread causing them.
+	 */
+	class chrome_trace_recorder final : public dispatch_observer {
+		struct record {
+			std::chrono::steady_clock::duration time;
+			const dispatcher* disp;
+			std::size_t worker;
+			dispatch_event event;
+		};
+		struct thread_buffer {
+			std::mutex mutex{};
+			std::vector<record> records{};
+			std::thread::id thread;
+			std::size_t tid;
+			std::string name;
+		};
+		// Zero initialized, the ids of the recorders start at 1
+		struct thread_cache {
+			std::uint64_t recorder;
+			thread_buffer* buffer;
+		};
+
+		inline static std::atomic<std::uint64_t> g_next_id{1};
+		inline static thread_local thread_cache g_cache;
+
+		const std::uint64_t m_id{g_next_id.fetch_add(1, std::memory_order::relaxed)};
+		const std::chrono::steady_clock::time_point m_origin{std::chrono::steady_clock::now()};
+		mutable std::mutex m_mtx{};
+		std::vector<std::unique_ptr<thread_buffer>> m_buffers{};
+
+	public:
+		chrome_trace_recorder() = default;
+		chrome_trace_recorder(const chrome_trace_recorder&) = delete;
+		chrome_trace_recorder& operator=(const chrome_trace_recorder&) = delete;
+
+		void on_event(const dispatcher& disp, dispatch_event event, std::size_t worker) noexcept override {
+			const auto now = std::chrono::steady_clock::now();
+			try {
+				auto buffer = local_buffer();
+				std::unique_lock lck{buffer->mutex};
+				buffer->records.push_back(record{now - m_origin, &disp, worker, event});
+			} catch (...) {
+				// Dropping the event is better than terminating the dispatcher
+			}
+		}
+
+		/**
+		 * \brief Get the number of events recorded so far
+		 */
+		[[nodiscard]] std::size_t size() const {
+			std::unique_lock lck{m_mtx};
+			std::size_t res = 0;
+			for (auto& buffer : m_buffers) {
+				std::unique_lock buffer_lck{buffer->mutex};
+				res += buffer->records.size();
+			}
+			return res;
+		}
+
+		/**
+		 * \brief Drop all recorded events
+		 */
+		void clear() {
+			std::unique_lock lck{m_mtx};
+			for (auto& buffer : m_buffers) {
+				std::unique_lock buffer_lck{buffer->mutex};
+				buffer->records.clear();
+			}
+		}
+
+		/**
+		 * \brief Write the recorded events as a JSON trace, events keep being recorded while writing.
+		 * \param out The stream to write to
+		 */
+		void write(std::ostream& out) const {
+			std::unique_lock lck{m_mtx};
+			out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+			bool first = true;
+			char line[256];
+			for (auto& buffer : m_buffers) {
+				std::snprintf(line, sizeof(line),
+							  R"(%s{"ph":"M","pid":1,"tid":%zu,"name":"thread_name","args":{"name":")",
+							  first ? "" : ",", buffer->tid);
+				out << line << escape(buffer->name) << "\"}}";
+				first = false;
+				std::unique_lock buffer_lck{buffer->mutex};
+				for (auto& rec : buffer->records) {
+					const auto micros = std::chrono::duration<double, std::micro>(rec.time).count();
+					std::snprintf(line, sizeof(line), R"(,{"ph":"%s","pid":1,"tid":%zu,"ts":%.3f,"cat":"asyncpp",)",
+								  phase(rec.event), buffer->tid, micros);
+					out << line;
+					// Instant events are scoped to their thread
+					const bool instant = rec.event == dispatch_event::push || rec.event == dispatch_event::steal;
+					std::snprintf(line, sizeof(line), R"("name":"%s",%s"args":{"dispatcher":"%p","worker":%zu}})",
+								  name(rec.event), instant ? R"("s":"t",)" : "", static_cast<const void*>(rec.disp),
+								  rec.worker);
+					out << line;
+				}
+			}
+			out << "]}";
+		}
+
+	private:
+		thread_buffer* local_buffer() {
+			if (g_cache.recorder == m_id) return g_cache.buffer;
+			const auto self = std::this_thread::get_id();
+			std::unique_lock lck{m_mtx};
+			// The thread might have reported to another recorder in between
+			for (auto& buffer : m_buffers) {
+				if (buffer->thread != self) continue;
+				g_cache = {m_id, buffer.get()};
+				return g_cache.buffer;
+			}
+			auto buffer = std::make_unique<thread_buffer>();
+			buffer->thread = self;
+#ifdef __linux__
+			char name[32]{};
+			if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) buffer->name = name;
+#endif
+			buffer->tid = m_buffers.size() + 1;
+			if (buffer->name.empty()) buffer->name = "thread " + std::to_string(buffer->tid);
+			m_buffers.push_back(std::move(buffer));
+			g_cache = {m_id, m_buffers.back().get()};
+			return g_cache.buffer;
+		}
+
+		static const char* phase(dispatch_event event) noexcept {
+			switch (event) {
+			case dispatch_event::start: return "B";
+			case dispatch_event::end: return "E";
+			default: return "i";
+			}
+		}
+
+		static const char* name(dispatch_event event) noexcept {
+			switch (event) {
+			case dispatch_event::push: return "push";
+			case dispatch_event::steal: return "steal";
+			default: return "callback";
+			}
+		}
+
+		static std::string escape(const std::string& str) {
+			std::string res;
+			for (auto c : str) {
+				if (c == '"' || c == '\\') res += '\\';
+				if (static_cast<unsigned char>(c) >= 0x20) res += c;
+			}
+			return res;
+		}
+	};
+} // namespace asyncpp
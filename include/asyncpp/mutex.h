@@ -1,14 +1,44 @@
 #pragma once
+#include <asyncpp/detail/cpu_pause.h>
 #include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/trampoline.h>
+#if ASYNCPP_ENABLE_METRICS
+#include <asyncpp/metrics.h>
+#endif
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 
 namespace asyncpp {
 	class mutex_lock;
 	/**
+	 * \brief Options controlling how a mutex behaves under contention.
+	 */
+	struct mutex_options {
+		/**
+		 * \brief Number of pause iterations lock() spins before the coroutine gets suspended.
+		 *
+		 * Spinning only happens while the mutex is held without any waiters, as soon as someone is queued the
+		 * lock gets handed over in order anyway. 0 disables spinning.
+		 */
+		std::uint32_t spin_count = 0;
+		/**
+		 * \brief Resume waiters on the dispatcher they suspended on instead of inline in unlock().
+		 *
+		 * This prevents long resumption chains on the unlocking stack at the cost of a dispatcher round trip.
+		 * Waiters that suspended without a dispatcher are still resumed inline.
+		 */
+		bool dispatch_waiters = false;
+
+		/// \brief Options suitable for short critical sections that are contended across threads
+		static constexpr mutex_options adaptive() noexcept { return {.spin_count = 128, .dispatch_waiters = true}; }
+	};
+
+	/**
      * \brief A mutex with an asynchronous lock() operation.
      *
      * Provides a asynchronous lock() method that can be awaited to allow
@@ -27,9 +57,12 @@ namespace asyncpp {
 		friend class mutex_lock;
 		/// \brief Construct mutex in its unlocked state
 		constexpr mutex() noexcept : m_state{state_unlocked}, m_awaiters{nullptr} {}
+		/// \brief Construct mutex in its unlocked state using the specified options
+		explicit constexpr mutex(mutex_options opts) noexcept
+			: m_state{state_unlocked}, m_awaiters{nullptr}, m_options{opts} {}
 		/// \brief Construct mutex in its locked state
-		explicit constexpr mutex(decltype(construct_locked)) noexcept
-			: m_state{state_locked_no_waiters}, m_awaiters{nullptr} {}
+		explicit constexpr mutex(decltype(construct_locked), mutex_options opts = {}) noexcept
+			: m_state{state_locked_no_waiters}, m_awaiters{nullptr}, m_options{opts} {}
 		/**
          * \brief Destruct mutex
          *
@@ -74,7 +107,8 @@ namespace asyncpp {
          * \brief Unlock the mutex
          *
          * \note Behaviour is undefined if the mutex is not currently locked. Resumes one
-         *       of the waiting coroutines (if any) on the current thread before it returns.
+         *       of the waiting coroutines (if any) on the current thread before it returns,
+         *       unless mutex_options::dispatch_waiters is set.
          */
 		void unlock() noexcept;
 		/**
@@ -84,25 +118,64 @@ namespace asyncpp {
 		[[nodiscard]] bool is_locked() const noexcept {
 			return m_state.load(std::memory_order::relaxed) != state_unlocked;
 		}
+		/// \brief Get the options of this mutex
+		[[nodiscard]] constexpr const mutex_options& options() const noexcept { return m_options; }
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Get the contention counters of this mutex.
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set. The waiter count is taken whenever unlock() moves newly
+		 * queued coroutines into the list of waiters.
+		 */
+		[[nodiscard]] contention_metrics metrics() const noexcept { return m_contention.collect(); }
+#endif
 
 	private:
 		static constexpr std::uintptr_t state_locked_no_waiters = 0;
 		static constexpr std::uintptr_t state_unlocked = 1;
 		std::atomic<uintptr_t> m_state;
 		lock_awaiter* m_awaiters;
+		mutex_options m_options{};
+#if ASYNCPP_ENABLE_METRICS
+		detail::contention_counters m_contention{};
+#endif
+
+		bool spin_lock() noexcept {
+			for (std::uint32_t i = 0; i < m_options.spin_count; i++) {
+				const auto state = m_state.load(std::memory_order::relaxed);
+				if (state == state_unlocked && try_lock()) return true;
+				// Once there are waiters the lock is passed on to them directly, so there is no point in spinning
+				if (state != state_unlocked && state != state_locked_no_waiters) return false;
+				detail::cpu_pause();
+			}
+			return false;
+		}
 	};
 
 	struct [[nodiscard]] mutex::lock_awaiter {
 		constexpr explicit lock_awaiter(class mutex* mtx) : mutex(mtx) {}
-		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		[[nodiscard]] bool await_ready() noexcept {
+#if ASYNCPP_ENABLE_METRICS
+			mutex->m_contention.count_wait();
+#endif
+			return mutex->m_options.spin_count != 0 && mutex->spin_lock();
+		}
 		[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept {
 			handle = hndl;
+			if (mutex->m_options.dispatch_waiters) dispatcher = asyncpp::dispatcher::current();
+#if ASYNCPP_ENABLE_METRICS
+			park.start();
+#endif
 			auto old = mutex->m_state.load(std::memory_order::acquire);
 			while (true) {
 				if (old == state_unlocked) {
 					if (mutex->m_state.compare_exchange_weak(old, state_locked_no_waiters, std::memory_order::acquire,
-															 std::memory_order::relaxed))
+															 std::memory_order::relaxed)) {
+#if ASYNCPP_ENABLE_METRICS
+						park.cancel();
+#endif
 						return false;
+					}
 				} else {
 					// NOLINTNEXTLINE(performance-no-int-to-ptr)
 					next = reinterpret_cast<lock_awaiter*>(old);
@@ -117,6 +190,10 @@ namespace asyncpp {
 		class mutex* mutex;
 		lock_awaiter* next{nullptr};
 		coroutine_handle<> handle{};
+		class dispatcher* dispatcher{nullptr};
+#if ASYNCPP_ENABLE_METRICS
+		detail::park_timer park{};
+#endif
 	};
 
 	/**
@@ -184,7 +261,7 @@ namespace asyncpp {
 		[[nodiscard]] auto lock() noexcept {
 			struct awaiter {
 				explicit awaiter(mutex_lock* parent) : m_parent(parent), m_mutex_awaiter(parent->m_mtx) {}
-				[[nodiscard]] bool await_ready() const noexcept {
+				[[nodiscard]] bool await_ready() noexcept {
 					return m_parent->m_locked || m_mutex_awaiter.await_ready();
 				}
 				[[nodiscard]] auto await_suspend(coroutine_handle<> hndl) noexcept {
@@ -214,7 +291,7 @@ namespace asyncpp {
 
 	struct [[nodiscard]] mutex::scoped_lock_awaiter {
 		constexpr explicit scoped_lock_awaiter(class mutex* mtx) : awaiter(mtx) {}
-		[[nodiscard]] constexpr bool await_ready() const noexcept { return awaiter.await_ready(); }
+		[[nodiscard]] bool await_ready() noexcept { return awaiter.await_ready(); }
 		[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept { return awaiter.await_suspend(hndl); }
 		[[nodiscard]] mutex_lock await_resume() const noexcept {
 			awaiter.await_resume();
@@ -242,16 +319,31 @@ namespace asyncpp {
 			assert(old != state_locked_no_waiters && old != state_unlocked);
 			//NOLINTNEXTLINE(performance-no-int-to-ptr)
 			auto next = reinterpret_cast<lock_awaiter*>(old);
+			[[maybe_unused]] std::size_t waiters = 0;
 			do {
 				auto temp = next->next;
 				next->next = head;
 				head = next;
 				next = temp;
+				waiters++;
 			} while (next != nullptr);
+#if ASYNCPP_ENABLE_METRICS
+			m_contention.count_waiters(waiters);
+#endif
 		}
 		assert(head != nullptr);
 		m_awaiters = head->next;
-		head->handle.resume();
+#if ASYNCPP_ENABLE_METRICS
+		head->park.finish(m_contention);
+#endif
+		// The lock is passed on to head directly, so it is fine if it runs a bit later on its dispatcher
+		if (head->dispatcher != nullptr) {
+			try {
+				head->dispatcher->push_resume(head->handle);
+				return;
+			} catch (...) {}
+		}
+		resume_trampoline::resume(head->handle);
 	}
 
 } // namespace asyncpp
@@ -0,0 +1,270 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/when_all.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace asyncpp {
+	namespace detail {
+		/**
+		 * \brief Awaitable running a parallel algorithm over the index range [0, size) on a dispatcher.
+		 *
+		 * The range is split using lazy binary splitting: a task processes its range grain_size indices at a time
+		 * and only before each step checks if it should split. If no previously split off half is still waiting to be
+		 * picked up, the upper half of the remaining range is pushed to the dispatcher as a new task. Idle workers
+		 * therefore cause more splits, while busy ones keep working on contiguous memory without scheduling
+		 * overhead. Instead of looking at the workers deque, which the dispatcher interface does not expose, a
+		 * shared count of pushed but not yet started tasks is checked.
+		 *
+		 * Impl provides the algorithm:
+		 * - `local_type` holding the state of a single task, created using `make_local()`,
+		 * - `run(local_type&, size_t begin, size_t end)` processing a chunk,
+		 * - `finish(local_type&&)` called once a task is done and
+		 * - `result()` returning the result of the algorithm.
+		 */
+		template<typename Impl>
+		class parallel_awaiter : private join_state {
+		public:
+			template<typename... Args>
+			parallel_awaiter(dispatcher& dsp, size_t size, size_t grain_size, Args&&... args)
+				: m_impl{std::forward<Args>(args)...}, m_dispatcher{&dsp}, m_size{size},
+				  m_grain{grain_size != 0 ? grain_size : default_grain(size)} {}
+			parallel_awaiter(const parallel_awaiter&) = delete;
+			parallel_awaiter& operator=(const parallel_awaiter&) = delete;
+
+			[[nodiscard]] bool await_ready() const noexcept { return m_size == 0; }
+			bool await_suspend(coroutine_handle<> hndl) {
+				prepare(hndl, 1, m_dispatcher);
+				push_task(0, m_size);
+				return finish_suspend();
+			}
+			decltype(auto) await_resume() {
+				if (m_exception) std::rethrow_exception(m_exception);
+				return m_impl.result();
+			}
+
+		private:
+			/// \brief Chunks per task a range is split into by default, if all of them end up running in parallel
+			static constexpr size_t default_chunks = 256;
+
+			Impl m_impl;
+			dispatcher* const m_dispatcher;
+			const size_t m_size;
+			const size_t m_grain;
+			// Tasks pushed to the dispatcher that did not start yet
+			std::atomic<size_t> m_unstarted{0};
+			std::atomic<bool> m_failed{false};
+			// Written once by the task that set m_failed, read after all tasks arrived
+			std::exception_ptr m_exception{};
+
+			static size_t default_grain(size_t size) noexcept { return std::max<size_t>(1, size / default_chunks); }
+
+			// Counted in m_pending as long as it runs, so the awaiting coroutine stays suspended
+			void push_task(size_t begin, size_t end) {
+				m_unstarted.fetch_add(1, std::memory_order::relaxed);
+				m_dispatcher->push([this, begin, end]() {
+					m_unstarted.fetch_sub(1, std::memory_order::relaxed);
+					run_task(begin, end);
+				});
+			}
+
+			void run_task(size_t begin, size_t end) noexcept {
+				try {
+					auto local = m_impl.make_local();
+					bool can_split = true;
+					while (begin < end && !m_failed.load(std::memory_order::relaxed)) {
+						if (can_split && end - begin > m_grain && m_unstarted.load(std::memory_order::relaxed) == 0) {
+							const auto mid = begin + (end - begin) / 2;
+							m_pending.fetch_add(1, std::memory_order::relaxed);
+							try {
+								push_task(mid, end);
+								end = mid;
+							} catch (...) {
+								// Could not split (e.g. the pool is shutting down), keep going on our own
+								m_pending.fetch_sub(1, std::memory_order::relaxed);
+								m_unstarted.fetch_sub(1, std::memory_order::relaxed);
+								can_split = false;
+							}
+							continue;
+						}
+						const auto next = std::min(end, begin + m_grain);
+						m_impl.run(local, begin, next);
+						begin = next;
+					}
+					m_impl.finish(std::move(local));
+				} catch (...) {
+					if (!m_failed.exchange(true, std::memory_order::relaxed)) m_exception = std::current_exception();
+				}
+				child_done(0).resume();
+			}
+
+			coroutine_handle<> child_done(size_t) noexcept override { return arrive(); }
+		};
+
+		template<typename Index, typename Func>
+		struct parallel_for_impl {
+			struct local_type {};
+			Func m_func;
+			Index m_first;
+
+			local_type make_local() const noexcept { return {}; }
+			void run(local_type&, size_t begin, size_t end) {
+				for (auto i = begin; i < end; i++)
+					std::invoke(m_func, static_cast<Index>(m_first + static_cast<Index>(i)));
+			}
+			void finish(local_type&&) const noexcept {}
+			void result() const noexcept {}
+		};
+
+		template<typename InputIt, typename OutputIt, typename Func>
+		struct parallel_transform_impl {
+			struct local_type {};
+			InputIt m_first;
+			OutputIt m_out;
+			Func m_func;
+			size_t m_size;
+
+			local_type make_local() const noexcept { return {}; }
+			void run(local_type&, size_t begin, size_t end) {
+				auto it = std::next(m_first, begin);
+				auto out = std::next(m_out, begin);
+				for (auto i = begin; i < end; i++, ++it, ++out)
+					*out = std::invoke(m_func, *it);
+			}
+			void finish(local_type&&) const noexcept {}
+			OutputIt result() const noexcept { return std::next(m_out, m_size); }
+		};
+
+		template<typename It, typename T, typename Reduce, typename Transform>
+		struct parallel_transform_reduce_impl {
+			using local_type = std::optional<T>;
+			It m_first;
+			Reduce m_reduce;
+			Transform m_transform;
+			T m_value;
+			// Combines the results of the individual tasks
+			std::mutex m_mtx{};
+
+			local_type make_local() const noexcept { return std::nullopt; }
+			void run(local_type& local, size_t begin, size_t end) {
+				auto it = std::next(m_first, begin);
+				for (auto i = begin; i < end; i++, ++it) {
+					if (local)
+						local.emplace(std::invoke(m_reduce, std::move(*local), std::invoke(m_transform, *it)));
+					else
+						local.emplace(std::invoke(m_transform, *it));
+				}
+			}
+			void finish(local_type&& local) {
+				if (!local) return;
+				std::unique_lock lck{m_mtx};
+				m_value = std::invoke(m_reduce, std::move(m_value), std::move(*local));
+			}
+			T result() { return std::move(m_value); }
+		};
+
+		struct identity_transform {
+			template<typename T>
+			constexpr T&& operator()(T&& value) const noexcept {
+				return std::forward<T>(value);
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Invoke func for every index in [first, last) in parallel on a dispatcher.
+	 *
+	 * The range is split adaptively using lazy binary splitting, see detail::parallel_awaiter. The awaiting
+	 * coroutine is resumed once all indices have been processed, on the dispatcher it was suspended on. If func
+	 * throws, the remaining chunks are skipped and the first exception is rethrown.
+	 * \param dsp The dispatcher to run on, usually a thread_pool
+	 * \param first The first index
+	 * \param last One past the last index
+	 * \param func Function invoked with every index
+	 * \param grain_size Number of indices processed between split checks, 0 picks one based on the range size
+	 * \return Awaitable resuming once all indices have been processed
+	 */
+	template<std::integral Index, std::invocable<Index> Func>
+	[[nodiscard]] auto parallel_for(dispatcher& dsp, Index first, Index last, Func func, size_t grain_size = 0) {
+		assert(first <= last);
+		using impl = detail::parallel_for_impl<Index, Func>;
+		return detail::parallel_awaiter<impl>{dsp, static_cast<size_t>(last - first), grain_size, std::move(func),
+											  first};
+	}
+
+	/**
+	 * \brief Store the result of func for every element of [first, last) in the range starting at out in parallel.
+	 *
+	 * Works like std::transform, but splits the range like parallel_for().
+	 * \param dsp The dispatcher to run on, usually a thread_pool
+	 * \param first The first element
+	 * \param last One past the last element
+	 * \param out The first element of the output range
+	 * \param func Function invoked with every element
+	 * \param grain_size Number of elements processed between split checks, 0 picks one based on the range size
+	 * \return Awaitable resuming with an iterator one past the last element written
+	 */
+	template<std::random_access_iterator InputIt, std::random_access_iterator OutputIt, typename Func>
+		requires std::invocable<Func&, std::iter_reference_t<InputIt>>
+	[[nodiscard]] auto parallel_transform(dispatcher& dsp, InputIt first, InputIt last, OutputIt out, Func func,
+										  size_t grain_size = 0) {
+		const auto size = static_cast<size_t>(std::distance(first, last));
+		return detail::parallel_awaiter<detail::parallel_transform_impl<InputIt, OutputIt, Func>>{
+			dsp, size, grain_size, first, out, std::move(func), size};
+	}
+
+	/**
+	 * \brief Transform every element of [first, last) and combine the results with init in parallel.
+	 *
+	 * Works like std::transform_reduce, but splits the range like parallel_for(). Every task reduces the values
+	 * of its chunks and the results of the tasks are combined with init once they are done. Like with
+	 * std::transform_reduce the order is unspecified, so reduce needs to be associative and commutative.
+	 * \param dsp The dispatcher to run on, usually a thread_pool
+	 * \param first The first element
+	 * \param last One past the last element
+	 * \param init The initial value
+	 * \param reduce Binary function combining two values
+	 * \param transform Function invoked with every element
+	 * \param grain_size Number of elements processed between split checks, 0 picks one based on the range size
+	 * \return Awaitable resuming with the result
+	 */
+	template<std::random_access_iterator It, typename T, typename Reduce, typename Transform>
+		requires std::invocable<Transform&, std::iter_reference_t<It>>
+	[[nodiscard]] auto parallel_transform_reduce(dispatcher& dsp, It first, It last, T init, Reduce reduce,
+												 Transform transform, size_t grain_size = 0) {
+		using impl = detail::parallel_transform_reduce_impl<It, T, Reduce, Transform>;
+		return detail::parallel_awaiter<impl>{dsp, static_cast<size_t>(std::distance(first, last)), grain_size,
+											  first, std::move(reduce), std::move(transform), std::move(init)};
+	}
+
+	/**
+	 * \brief Combine every element of [first, last) with init in parallel.
+	 *
+	 * Works like std::reduce, see parallel_transform_reduce() for details.
+	 * \param dsp The dispatcher to run on, usually a thread_pool
+	 * \param first The first element
+	 * \param last One past the last element
+	 * \param init The initial value
+	 * \param reduce Binary function combining two values
+	 * \param grain_size Number of elements processed between split checks, 0 picks one based on the range size
+	 * \return Awaitable resuming with the result
+	 */
+	template<std::random_access_iterator It, typename T, typename Reduce = std::plus<>>
+	[[nodiscard]] auto parallel_reduce(dispatcher& dsp, It first, It last, T init, Reduce reduce = {},
+									   size_t grain_size = 0) {
+		return parallel_transform_reduce(dsp, first, last, std::move(init), std::move(reduce),
+										 detail::identity_transform{}, grain_size);
+	}
+} // namespace asyncpp
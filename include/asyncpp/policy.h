@@ -26,4 +26,34 @@ namespace asyncpp {
 	};
 	inline const exception_policy exception_policy::terminate = {[]() { std::terminate(); }};
 	inline const exception_policy exception_policy::ignore = {};
+
+	/**
+	 * \brief Compile time exception policy selecting the runtime exception_policy.
+	 *
+	 * The task stores a std::function which is set by awaiting an exception_policy and defaults to std::terminate().
+	 */
+	struct exception_policy_dynamic {};
+
+	/// \brief Compile time exception policy calling std::terminate() if an exception leaves the coroutine.
+	struct exception_policy_terminate {
+		[[noreturn]] static void on_exception() noexcept { std::terminate(); }
+	};
+
+	/// \brief Compile time exception policy ignoring exceptions leaving the coroutine, which ends at the throw point.
+	struct exception_policy_ignore {
+		static void on_exception() noexcept {}
+	};
+
+	/**
+	 * \brief Compile time exception policy calling Handler if an exception leaves the coroutine.
+	 * \tparam Handler Function pointer called within the catch block, so it can use `throw;` to inspect the exception
+	 */
+	template<void (*Handler)()>
+	struct exception_policy_handler {
+		static void on_exception() noexcept { Handler(); }
+	};
+
+	/// \brief Check if T is an exception policy which is resolved at compile time
+	template<typename T>
+	concept StaticExceptionPolicy = requires { T::on_exception(); };
 } // namespace asyncpp
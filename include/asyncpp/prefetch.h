@@ -0,0 +1,72 @@
+#pragma once
+#include <asyncpp/async_generator.h>
+#include <asyncpp/channel.h>
+#include <asyncpp/defer.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/launch.h>
+#include <asyncpp/scope_guard.h>
+#include <asyncpp/task.h>
+
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace asyncpp {
+	namespace detail {
+		template<typename T>
+		struct prefetch_state {
+			explicit prefetch_state(size_t capacity) : m_channel{capacity} {}
+			channel<T> m_channel;
+			// Written before the channel is closed, so it is visible once the consumer reads the close
+			std::exception_ptr m_exception{};
+		};
+
+		template<typename T, ByteAllocator Allocator>
+		task<void> prefetch_producer(async_generator<T, Allocator> source, dispatcher* dsp,
+									 std::shared_ptr<prefetch_state<std::remove_cvref_t<T>>> state) {
+			co_await defer{dsp};
+			try {
+				auto it = co_await source.begin();
+				while (it != source.end()) {
+					// A closed channel means the consumer is gone
+					if (!co_await state->m_channel.write(std::move(*it)).resume_on(dsp)) break;
+					co_await ++it;
+				}
+			} catch (...) { state->m_exception = std::current_exception(); }
+			state->m_channel.close();
+		}
+	} // namespace detail
+
+	/**
+	 * \brief Run a generator ahead of its consumer on a dispatcher.
+	 *
+	 * Normally the producer of an async_generator only runs while the consumer waits for the next value, so they
+	 * never run at the same time. The returned generator instead starts the source on dsp once it begins and lets
+	 * it produce up to capacity values ahead, which are moved into a bounded buffer the consumer drains. This
+	 * allows stages of a pipeline to run in parallel on different threads. The producer waits on dsp if the buffer
+	 * is full, while the consumer waits on the dispatcher it was running on (or inside the producer if none).
+	 *
+	 * Exceptions thrown by the source are rethrown to the consumer after all values produced before. If the
+	 * returned generator is destroyed early, the source is stopped and destroyed by dsp at its next co_yield.
+	 * \param source The generator to run ahead
+	 * \param dsp The dispatcher to run the source on
+	 * \param capacity Maximum number of values produced ahead of the consumer, needs to be at least 1
+	 * \return A generator yielding the values of source
+	 */
+	template<typename T, ByteAllocator Allocator>
+	async_generator<std::remove_cvref_t<T>> prefetch(async_generator<T, Allocator> source, dispatcher* dsp,
+													  size_t capacity) {
+		using value_type = std::remove_cvref_t<T>;
+		assert(dsp != nullptr);
+		assert(capacity != 0);
+		auto state = std::make_shared<detail::prefetch_state<value_type>>(capacity);
+		scope_guard close_guard{[&state]() noexcept { state->m_channel.close(); }};
+		launch(detail::prefetch_producer(std::move(source), dsp, state));
+		auto resume_dispatcher = dispatcher::current();
+		while (auto value = co_await state->m_channel.read().resume_on(resume_dispatcher))
+			co_yield std::move(*value);
+		if (state->m_exception) std::rethrow_exception(state->m_exception);
+	}
+} // namespace asyncpp
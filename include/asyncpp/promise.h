@@ -1,13 +1,19 @@
 #pragma once
+#include <asyncpp/detail/cpu_pause.h>
 #include <asyncpp/detail/std_import.h>
+#include <asyncpp/ptr_tag.h>
 #include <asyncpp/ref.h>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -17,96 +23,248 @@ namespace asyncpp {
 	class promise;
 
 	namespace detail {
+		/**
+		 * \brief Shared state of a promise.
+		 *
+		 * The state is kept in a single atomic tagged pointer. While pending it points to an intrusive list of
+		 * continuations, the tag marks a promise that is currently being settled by one thread or has been settled.
+		 * Registering a continuation and settling the promise are lock free. A mutex and condition variable are only
+		 * allocated if a thread blocks in get(). Awaiters destroyed while suspended unlink their continuation again,
+		 * which takes a lock bit in the tag so removals do not race with each other or with settling.
+		 */
 		template<typename T, typename TError>
 		struct promise_state : intrusive_refcount<promise_state<T, TError>> {
 			inline constexpr static size_t pending_index = 0;
 			inline constexpr static size_t fulfilled_index = 1;
 			inline constexpr static size_t rejected_index = 2;
 
-			std::mutex m_mtx{};
-			std::condition_variable m_cv{};
+			/**
+			 * \brief Continuation invoked once the promise is settled.
+			 * \note The node might be destroyed by invoke(), so m_next is read before.
+			 */
+			struct continuation {
+				continuation* m_next{};
+				virtual ~continuation() = default;
+				virtual void invoke(promise_state& state) noexcept = 0;
+			};
+
 			std::variant<std::monostate, T, TError> m_value{};
-			std::vector<std::function<void()>> m_on_settle{};
-			std::vector<std::function<void(const T&)>> m_on_fulfill{};
-			std::vector<std::function<void(const TError&)>> m_on_reject{};
 
-			bool try_fulfill(auto&& value) {
-				std::unique_lock lck{m_mtx};
-				if (m_value.index() != pending_index) return false;
-				m_value.template emplace<fulfilled_index>(std::forward<decltype(value)>(value));
-				m_cv.notify_all();
-				auto settle_cbs = std::move(m_on_settle);
-				auto fulfill_cbs = std::move(m_on_fulfill);
-				m_on_settle.clear();
-				m_on_fulfill.clear();
-				m_on_reject.clear();
-				auto& res = std::get<fulfilled_index>(m_value);
-				lck.unlock();
-				for (auto& cbfn : settle_cbs) {
-					try {
-						cbfn();
-					} catch (...) { std::terminate(); }
-				}
-				for (auto& cbfn : fulfill_cbs) {
-					try {
-						cbfn(res);
-					} catch (...) { std::terminate(); }
+			promise_state() = default;
+			promise_state(const promise_state&) = delete;
+			promise_state& operator=(const promise_state&) = delete;
+			~promise_state() noexcept {
+				// Only heap allocated continuations can be left, awaiters unlink theirs when they are destroyed
+				const auto head = m_head.load(std::memory_order::acquire);
+				if (head.tag() != settled_tag) {
+					auto n = head.ptr();
+					while (n != nullptr)
+						delete std::exchange(n, n->m_next);
 				}
+				delete m_sync.load(std::memory_order::acquire);
+			}
+
+			/// \brief Check if the promise is fulfilled or rejected, m_value can be accessed if this returns true
+			[[nodiscard]] bool is_settled(std::memory_order order = std::memory_order::acquire) const noexcept {
+				return m_head.load(order).tag() == settled_tag;
+			}
+
+			bool try_fulfill(auto&& value) {
+				return try_settle<fulfilled_index>(std::forward<decltype(value)>(value));
+			}
+
+			bool try_reject(auto&& value) { return try_settle<rejected_index>(std::forward<decltype(value)>(value)); }
+
+			/**
+			 * \brief Register a continuation.
+			 * \return True if the continuation was registered, false if the promise was already settled, in which case
+			 * 		the continuation is not invoked.
+			 */
+			bool add_continuation(continuation* cont) noexcept {
+				auto head = m_head.load(std::memory_order::acquire);
+				do {
+					if (head.tag() == settled_tag) return false;
+					cont->m_next = head.ptr();
+				} while (!m_head.compare_exchange_weak(head, cont, head.tag(), std::memory_order::release,
+													   std::memory_order::acquire));
 				return true;
 			}
 
-			bool try_reject(auto&& value) {
-				std::unique_lock lck{m_mtx};
-				if (m_value.index() != pending_index) return false;
-				m_value.template emplace<rejected_index>(std::forward<decltype(value)>(value));
-				m_cv.notify_all();
-				auto settle_cbs = std::move(m_on_settle);
-				auto reject_cbs = std::move(m_on_reject);
-				m_on_settle.clear();
-				m_on_fulfill.clear();
-				m_on_reject.clear();
-				auto& error = std::get<rejected_index>(m_value);
-				lck.unlock();
-				for (auto& cbfn : settle_cbs) {
-					try {
-						cbfn();
-					} catch (...) { std::terminate(); }
+			/**
+			 * \brief Unregister a continuation that was not invoked yet, because its owner is destroyed.
+			 * \note Does nothing if the promise was settled in the meantime, the continuation is invoked in that case.
+			 */
+			void remove_continuation(continuation* cont) noexcept {
+				auto head = m_head.load(std::memory_order::acquire);
+				while (true) {
+					if (head.tag() == settled_tag) return;
+					if ((head.tag() & locked_tag) != 0) {
+						detail::cpu_pause();
+						head = m_head.load(std::memory_order::acquire);
+					} else if (m_head.compare_exchange_weak(head, head.ptr(), head.tag() | locked_tag,
+															std::memory_order::acquire, std::memory_order::acquire))
+						break;
 				}
-				for (auto& cbfn : reject_cbs) {
-					try {
-						cbfn(error);
-					} catch (...) { std::terminate(); }
+				// Registrations keep pushing to the front meanwhile, but nobody else changes the links behind it
+				while (true) {
+					if (head.ptr() == cont) {
+						if (m_head.compare_exchange_weak(head, cont->m_next, head.tag(), std::memory_order::acquire,
+														 std::memory_order::acquire))
+							break;
+						continue;
+					}
+					auto prev = head.ptr();
+					while (prev != nullptr && prev->m_next != cont)
+						prev = prev->m_next;
+					if (prev != nullptr) prev->m_next = cont->m_next;
+					break;
 				}
-				return true;
+				head = m_head.load(std::memory_order::relaxed);
+				while (!m_head.compare_exchange_weak(head, head.ptr(), head.tag() & ~locked_tag,
+													 std::memory_order::release, std::memory_order::relaxed))
+					;
 			}
 
 			void then(std::function<void(const T&)> then_cb, std::function<void(const TError&)> catch_cb) {
-				std::unique_lock lck{m_mtx};
-				switch (m_value.index()) {
-				case pending_index:
-					if (then_cb) m_on_fulfill.emplace_back(std::move(then_cb));
-					if (catch_cb) m_on_reject.emplace_back(std::move(catch_cb));
-					break;
-				case fulfilled_index:
-					lck.unlock();
-					if (then_cb) then_cb(std::get<fulfilled_index>(m_value));
-					break;
-				case rejected_index:
-					lck.unlock();
-					if (catch_cb) catch_cb(std::get<rejected_index>(m_value));
-					break;
+				if (!is_settled()) {
+					auto node = std::make_unique<then_node>(std::move(then_cb), std::move(catch_cb));
+					if (add_continuation(node.get())) {
+						node.release();
+						return;
+					}
+					then_cb = std::move(node->m_then);
+					catch_cb = std::move(node->m_catch);
 				}
+				if (m_value.index() == fulfilled_index) {
+					if (then_cb) then_cb(std::get<fulfilled_index>(m_value));
+				} else if (catch_cb)
+					catch_cb(std::get<rejected_index>(m_value));
 			}
 
 			void on_settle(std::function<void()> settle_cb) {
 				if (!settle_cb) return;
-				std::unique_lock lck{m_mtx};
-				if (m_value.index() == pending_index)
-					m_on_settle.emplace_back(std::move(settle_cb));
-				else {
-					lck.unlock();
-					settle_cb();
+				if (!is_settled()) {
+					auto node = std::make_unique<settle_node>(std::move(settle_cb));
+					if (add_continuation(node.get())) {
+						node.release();
+						return;
+					}
+					settle_cb = std::move(node->m_cb);
 				}
+				settle_cb();
+			}
+
+			/// \brief Block until the promise is settled
+			void wait() {
+				if (is_settled()) return;
+				auto& sync = get_sync();
+				std::unique_lock lck{sync.m_mtx};
+				sync.m_cv.wait(lck, [this]() { return is_settled(std::memory_order::seq_cst); });
+			}
+
+			/**
+			 * \brief Block until the promise is settled or the timeout expired
+			 * \return True if the promise is settled
+			 */
+			template<class Clock, class Duration>
+			bool wait_until(std::chrono::time_point<Clock, Duration> until) {
+				if (is_settled()) return true;
+				auto& sync = get_sync();
+				std::unique_lock lck{sync.m_mtx};
+				return sync.m_cv.wait_until(lck, until, [this]() { return is_settled(std::memory_order::seq_cst); });
+			}
+
+		private:
+			inline constexpr static size_t claimed_tag = 1;
+			inline constexpr static size_t settled_tag = 2;
+			// Set while remove_continuation() unlinks a node, never combined with settled_tag
+			inline constexpr static size_t locked_tag = 4;
+
+			struct sync_state {
+				std::mutex m_mtx;
+				std::condition_variable m_cv;
+			};
+
+			struct settle_node final : continuation {
+				explicit settle_node(std::function<void()> cbfn) : m_cb{std::move(cbfn)} {}
+				std::function<void()> m_cb;
+				void invoke(promise_state&) noexcept override {
+					m_cb();
+					delete this;
+				}
+			};
+
+			struct then_node final : continuation {
+				then_node(std::function<void(const T&)> then_cb, std::function<void(const TError&)> catch_cb)
+					: m_then{std::move(then_cb)}, m_catch{std::move(catch_cb)} {}
+				std::function<void(const T&)> m_then;
+				std::function<void(const TError&)> m_catch;
+				void invoke(promise_state& state) noexcept override {
+					if (state.m_value.index() == fulfilled_index) {
+						if (m_then) m_then(std::get<fulfilled_index>(state.m_value));
+					} else if (m_catch)
+						m_catch(std::get<rejected_index>(state.m_value));
+					delete this;
+				}
+			};
+
+			atomic_tagged_ptr<continuation> m_head{};
+			std::atomic<sync_state*> m_sync{nullptr};
+
+			template<size_t Index>
+			bool try_settle(auto&& value) {
+				// Claim the promise, so only one thread gets to write the value
+				auto head = m_head.load(std::memory_order::relaxed);
+				do {
+					if ((head.tag() & ~locked_tag) != 0) return false;
+				} while (!m_head.compare_exchange_weak(head, head.ptr(), head.tag() | claimed_tag,
+													   std::memory_order::acquire, std::memory_order::relaxed));
+				try {
+					m_value.template emplace<Index>(std::forward<decltype(value)>(value));
+				} catch (...) {
+					// Release the claim again, the promise stays pending
+					head = m_head.load(std::memory_order::relaxed);
+					while (!m_head.compare_exchange_weak(head, head.ptr(), head.tag() & ~claimed_tag,
+														 std::memory_order::relaxed))
+						;
+					throw;
+				}
+				// Wait for a concurrent remove_continuation() to finish unlinking before taking the list
+				head = m_head.load(std::memory_order::relaxed);
+				while (true) {
+					if ((head.tag() & locked_tag) != 0) {
+						detail::cpu_pause();
+						head = m_head.load(std::memory_order::relaxed);
+					} else if (m_head.compare_exchange_weak(head, nullptr, settled_tag, std::memory_order::seq_cst,
+															std::memory_order::relaxed))
+						break;
+				}
+				auto list = head.ptr();
+				// Pairs with the registration of m_sync in get_sync()
+				if (auto sync = m_sync.load(); sync != nullptr) {
+					std::unique_lock lck{sync->m_mtx};
+					sync->m_cv.notify_all();
+				}
+				// Continuations are pushed in front, reverse them to invoke in registration order
+				continuation* ordered = nullptr;
+				while (list != nullptr) {
+					auto next = list->m_next;
+					list->m_next = ordered;
+					ordered = list;
+					list = next;
+				}
+				while (ordered != nullptr)
+					std::exchange(ordered, ordered->m_next)->invoke(*this);
+				return true;
+			}
+
+			sync_state& get_sync() {
+				// All accesses are seq_cst, so either the settling thread sees the state or we see the promise settled
+				auto sync = m_sync.load();
+				if (sync != nullptr) return *sync;
+				auto created = std::make_unique<sync_state>();
+				if (m_sync.compare_exchange_strong(sync, created.get())) return *created.release();
+				return *sync;
 			}
 		};
 
@@ -143,10 +301,7 @@ namespace asyncpp {
          * \brief Check if the promise is pending
          * \note This is a temporary snapshot and should only be used for logging. Consider the returned value potentially invalid by the moment the call returns.
          */
-		bool is_pending() const noexcept {
-			std::unique_lock lck{m_state->m_mtx};
-			return m_state->m_value.index() == state::pending_index;
-		}
+		bool is_pending() const noexcept { return !m_state->is_settled(); }
 
 		/**
          * \brief Check if the promise is fulfilled
@@ -154,8 +309,7 @@ namespace asyncpp {
          * \return true if the promise contains a value.
          */
 		bool is_fulfilled() const noexcept {
-			std::unique_lock lck{m_state->m_mtx};
-			return m_state->m_value.index() == state::fulfilled_index;
+			return m_state->is_settled() && m_state->m_value.index() == state::fulfilled_index;
 		}
 
 		/**
@@ -164,8 +318,7 @@ namespace asyncpp {
          * \return true if the promise contains an exception.
          */
 		bool is_rejected() const noexcept {
-			std::unique_lock lck{m_state->m_mtx};
-			return m_state->m_value.index() == state::rejected_index;
+			return m_state->is_settled() && m_state->m_value.index() == state::rejected_index;
 		}
 
 		/**
@@ -251,10 +404,7 @@ namespace asyncpp {
          */
 		[[nodiscard]] TResult& get() const {
 			state& info = *m_state;
-			std::unique_lock lck{info.m_mtx};
-			while (info.m_value.index() == state::pending_index) {
-				info.m_cv.wait(lck);
-			}
+			info.wait();
 			if (info.m_value.index() == state::fulfilled_index) return std::get<state::fulfilled_index>(info.m_value);
 			std::rethrow_exception(std::get<state::rejected_index>(info.m_value));
 		}
@@ -267,9 +417,7 @@ namespace asyncpp {
 		[[nodiscard]] TResult* get(std::chrono::duration<Rep, Period> timeout) const {
 			auto until = std::chrono::steady_clock::now() + timeout;
 			state& info = *m_state;
-			std::unique_lock lck{info.m_mtx};
-			if (!info.m_cv.wait_until(lck, until, [&info]() { return info.m_value.index() != state::pending_index; }))
-				return nullptr;
+			if (!info.wait_until(until)) return nullptr;
 			if (info.m_value.index() == state::fulfilled_index) return &std::get<state::fulfilled_index>(info.m_value);
 			std::rethrow_exception(std::get<state::rejected_index>(info.m_value));
 		}
@@ -280,8 +428,7 @@ namespace asyncpp {
          */
 		[[nodiscard]] std::pair<TResult*, std::exception_ptr> try_get(std::nothrow_t) const noexcept {
 			state& info = *m_state;
-			std::unique_lock lck{info.m_mtx};
-			if (info.m_value.index() == state::pending_index) return {nullptr, nullptr};
+			if (!info.is_settled()) return {nullptr, nullptr};
 			if (info.m_value.index() == state::fulfilled_index)
 				return {&std::get<state::fulfilled_index>(info.m_value), nullptr};
 			return {nullptr, std::get<state::rejected_index>(info.m_value)};
@@ -301,40 +448,71 @@ namespace asyncpp {
          * \brief Asynchronously get the result. If the promise is rejected the rejecting exception gets thrown.
          * \return TResult& Pointer to the result value
          */
-		[[nodiscard]] auto operator co_await() const noexcept {
+		[[nodiscard]] auto operator co_await() const& noexcept {
+			assert(this->m_state);
+			return make_awaiter(m_state);
+		}
+
+		/**
+         * \brief Asynchronously get the result. If the promise is rejected the rejecting exception gets thrown.
+         *
+         * The reference to the shared state is moved into the awaiter, so awaiting a temporary does not touch the
+         * reference count. The promise is empty afterwards.
+         * \return TResult& Pointer to the result value
+         */
+		[[nodiscard]] auto operator co_await() && noexcept {
+			assert(this->m_state);
+			return make_awaiter(std::move(m_state));
+		}
+
+	private:
+		static auto make_awaiter(ref<state> st) noexcept {
 			struct awaiter {
 				constexpr explicit awaiter(ref<state> state) : m_state(std::move(state)) {}
 				[[nodiscard]] constexpr bool await_ready() noexcept {
 					assert(m_state);
-					std::unique_lock lck{m_state->m_mtx};
-					return m_state->m_value.index() != state::pending_index;
+					return m_state->is_settled();
 				}
 				[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept {
 					assert(m_state);
 					assert(hndl);
-					std::unique_lock lck{m_state->m_mtx};
-					if (m_state->m_value.index() == state::pending_index) {
-						m_state->m_on_settle.emplace_back([hndl]() mutable { hndl.resume(); });
-						return true;
-					}
+					// The continuation is part of the awaiter, so waiting does not allocate
+					m_node.m_handle = hndl;
+					if (m_state->add_continuation(&m_node)) return true;
+					m_node.m_handle = nullptr;
 					return false;
 				}
+				~awaiter() {
+					// Destroyed while suspended, the continuation must not outlive the coroutine frame it lives in
+					if (m_node.m_handle) m_state->remove_continuation(&m_node);
+				}
+				// Only moved before it is awaited, so there is no registered continuation to take over
+				awaiter(awaiter&& other) noexcept : m_state(std::move(other.m_state)) {
+					assert(!other.m_node.m_handle);
+				}
+				awaiter& operator=(awaiter&&) = delete;
+
 				[[nodiscard]] TResult& await_resume() {
 					assert(m_state);
-					std::unique_lock lck{m_state->m_mtx};
-					assert(m_state->m_value.index() != state::pending_index);
+					assert(m_state->is_settled());
 					if (m_state->m_value.index() == state::fulfilled_index)
 						return std::get<state::fulfilled_index>(m_state->m_value);
 					std::rethrow_exception(std::get<state::rejected_index>(m_state->m_value));
 				}
 
 			private:
+				struct resume_node final : state::continuation {
+					coroutine_handle<> m_handle;
+					void invoke(state&) noexcept override { std::exchange(m_handle, nullptr).resume(); }
+				};
 				ref<state> m_state;
+				resume_node m_node{};
 			};
-			assert(this->m_state);
-			return awaiter{m_state};
+			return awaiter{std::move(st)};
 		}
 
+	public:
+
 		/**
          * \brief Get a fufilled promise with the specified value
          * \param value Value for the fulfilled promise
@@ -420,13 +598,14 @@ namespace asyncpp {
 			return res.first != nullptr;
 		}
 
-		[[nodiscard]] auto operator co_await() const noexcept {
+	private:
+		static auto wrap_awaiter(decltype(std::declval<promise<std::monostate>>().operator co_await())&& inner) {
 			struct awaiter {
 			private:
 				decltype(std::declval<promise<std::monostate>>().operator co_await()) m_awaiter;
 
 			public:
-				constexpr explicit awaiter(decltype(m_awaiter)&& awaiter)
+				explicit awaiter(decltype(m_awaiter)&& awaiter)
 					: m_awaiter(std::forward<decltype(awaiter)>(awaiter)) {}
 				[[nodiscard]] constexpr bool await_ready() noexcept { return m_awaiter.await_ready(); }
 				[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept {
@@ -434,7 +613,15 @@ namespace asyncpp {
 				}
 				void await_resume() { static_cast<void>(m_awaiter.await_resume()); }
 			};
-			return awaiter{promise<std::monostate>::operator co_await()};
+			return awaiter{std::move(inner)};
+		}
+
+	public:
+		[[nodiscard]] auto operator co_await() const& noexcept {
+			return wrap_awaiter(promise<std::monostate>::operator co_await());
+		}
+		[[nodiscard]] auto operator co_await() && noexcept {
+			return wrap_awaiter(static_cast<promise<std::monostate>&&>(*this).operator co_await());
 		}
 
 		[[nodiscard]] static promise make_fulfilled() {
@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -144,4 +145,147 @@ namespace asyncpp {
 		return reinterpret_cast<uintptr_t>(vptr) & align_mask;
 	}
 
+	template<typename T, typename TTag>
+	class atomic_tagged_ptr;
+
+	/**
+	 * \brief Value of an atomic_tagged_ptr, a pointer with a tag in its alignment bits and a generation.
+	 *
+	 * All three are packed into a single 64 bit integer. On 64 bit platforms the pointer uses the lower 48 bits,
+	 * which covers the user space addresses of x86_64 and aarch64, leaving a 16 bit generation. On 32 bit platforms
+	 * the generation takes the upper 32 bits. Two values only compare equal if their generations match as well.
+	 * \tparam T The type of the pointer, the tag can use the bits below alignof(T)
+	 * \tparam TTag The type of the tag, an integer or enum
+	 */
+	template<typename T, typename TTag = size_t>
+	class tagged_ptr {
+	public:
+		/// \brief Integer the pointer, tag and generation are packed into
+		using storage_type = std::uint64_t;
+		/// \brief Number of bits used by the pointer (including the tag)
+		static constexpr unsigned pointer_bits = sizeof(void*) == 4 ? 32 : 48;
+		/// \brief Number of bits used by the generation, it wraps around after 2^generation_bits modifications
+		static constexpr unsigned generation_bits = 64 - pointer_bits;
+
+		constexpr tagged_ptr() noexcept = default;
+		explicit tagged_ptr(T* ptr, TTag tag = TTag{}) noexcept : m_value{pack(ptr, tag, 0)} {}
+
+		/// \brief Get the pointer without the tag
+		[[nodiscard]] T* ptr() const noexcept { return ptr_untag<T>(to_void()).first; }
+		/// \brief Get the tag
+		[[nodiscard]] TTag tag() const noexcept { return static_cast<TTag>(ptr_untag<T>(to_void()).second); }
+		/// \brief Get the generation, which is incremented by every modification of the atomic_tagged_ptr
+		[[nodiscard]] constexpr storage_type generation() const noexcept { return m_value >> pointer_bits; }
+		/// \brief Get the packed value
+		[[nodiscard]] constexpr storage_type raw() const noexcept { return m_value; }
+
+		friend constexpr bool operator==(const tagged_ptr&, const tagged_ptr&) noexcept = default;
+
+	private:
+		template<typename, typename>
+		friend class atomic_tagged_ptr;
+
+		static constexpr storage_type pointer_mask = (storage_type{1} << pointer_bits) - 1;
+		storage_type m_value{0};
+
+		struct raw_value {};
+		constexpr tagged_ptr(raw_value, storage_type value) noexcept : m_value{value} {}
+
+		// Computed in here instead of a static member, so T can be incomplete until the value is used
+		static storage_type pack(T* ptr, TTag tag, storage_type generation) noexcept {
+			const auto addr = static_cast<storage_type>(reinterpret_cast<std::uintptr_t>(ptr));
+			const auto tag_value = static_cast<storage_type>(tag);
+			assert((addr & (alignof(T) - 1)) == 0 && (addr & ~pointer_mask) == 0);
+			assert(tag_value < alignof(T));
+			return (generation << pointer_bits) | addr | tag_value;
+		}
+		[[nodiscard]] void* to_void() const noexcept {
+			//NOLINTNEXTLINE(performance-no-int-to-ptr)
+			return reinterpret_cast<void*>(static_cast<std::uintptr_t>(m_value & pointer_mask));
+		}
+	};
+
+	/**
+	 * \brief Atomic pointer with a tag in its alignment bits, protected against the ABA problem.
+	 *
+	 * Every store, exchange and successful compare_exchange increments the generation stored next to the pointer.
+	 * A compare_exchange with a value loaded before the pointer was changed and changed back therefore fails, which
+	 * makes it safe to pop single nodes of a lock-free stack as long as the nodes themselves stay valid. The value
+	 * fits into a single std::uint64_t, so no double width CAS is needed on 64 bit platforms, and the class refuses
+	 * to compile where that is not lock-free.
+	 *
+	 * \warning The generation only has value_type::generation_bits bits, which is 16 on 64 bit platforms. It wraps
+	 * after 65536 modifications, so a compare_exchange still succeeds wrongly if the pointer is changed back and
+	 * the generation advanced by an exact multiple of 65536 between the load and the compare_exchange. This takes a
+	 * thread being preempted while others keep modifying the pointer at a high rate. Widening it would need a
+	 * double width CAS, which is not available everywhere, so do not use this where a thread can hold on to a
+	 * loaded value for an unbounded amount of modifications and an ABA problem would be fatal.
+	 * \tparam T The type of the pointer, the tag can use the bits below alignof(T)
+	 * \tparam TTag The type of the tag, an integer or enum
+	 */
+	template<typename T, typename TTag = size_t>
+	class atomic_tagged_ptr {
+	public:
+		using value_type = tagged_ptr<T, TTag>;
+		using storage_type = typename value_type::storage_type;
+		static constexpr bool is_always_lock_free = std::atomic<storage_type>::is_always_lock_free;
+		static_assert(is_always_lock_free, "atomic_tagged_ptr requires lock-free 64 bit atomics");
+
+		constexpr atomic_tagged_ptr() noexcept = default;
+		explicit atomic_tagged_ptr(T* ptr, TTag tag = TTag{}) noexcept : m_value{value_type{ptr, tag}.m_value} {}
+		atomic_tagged_ptr(const atomic_tagged_ptr&) = delete;
+		atomic_tagged_ptr& operator=(const atomic_tagged_ptr&) = delete;
+
+		[[nodiscard]] value_type load(std::memory_order order = std::memory_order::seq_cst) const noexcept {
+			return value_type{typename value_type::raw_value{}, m_value.load(order)};
+		}
+		void store(T* ptr, TTag tag = TTag{}, std::memory_order order = std::memory_order::seq_cst) noexcept {
+			exchange(ptr, tag, order);
+		}
+		value_type exchange(T* ptr, TTag tag = TTag{}, std::memory_order order = std::memory_order::seq_cst) noexcept {
+			// The generation needs to be incremented, so this can not be a plain exchange
+			auto old = m_value.load(std::memory_order::relaxed);
+			while (!m_value.compare_exchange_weak(old, next(old, ptr, tag), order, std::memory_order::relaxed)) {}
+			return value_type{typename value_type::raw_value{}, old};
+		}
+
+		/**
+		 * \brief Replace the value if it still equals expected, including its generation.
+		 * \param expected The expected value, updated to the current one on failure
+		 * \param ptr The new pointer
+		 * \param tag The new tag
+		 * \return true if the value was replaced
+		 */
+		bool compare_exchange_weak(value_type& expected, T* ptr, TTag tag, std::memory_order success,
+								   std::memory_order failure) noexcept {
+			return m_value.compare_exchange_weak(expected.m_value, next(expected.m_value, ptr, tag), success,
+												 failure);
+		}
+		bool compare_exchange_weak(value_type& expected, T* ptr, TTag tag = TTag{},
+								   std::memory_order order = std::memory_order::seq_cst) noexcept {
+			return compare_exchange_weak(expected, ptr, tag, order, failure_order(order));
+		}
+		/// \brief Same as compare_exchange_weak, but does not fail spuriously
+		bool compare_exchange_strong(value_type& expected, T* ptr, TTag tag, std::memory_order success,
+									 std::memory_order failure) noexcept {
+			return m_value.compare_exchange_strong(expected.m_value, next(expected.m_value, ptr, tag), success,
+												   failure);
+		}
+		bool compare_exchange_strong(value_type& expected, T* ptr, TTag tag = TTag{},
+									 std::memory_order order = std::memory_order::seq_cst) noexcept {
+			return compare_exchange_strong(expected, ptr, tag, order, failure_order(order));
+		}
+
+	private:
+		std::atomic<storage_type> m_value{0};
+
+		static storage_type next(storage_type old, T* ptr, TTag tag) noexcept {
+			return value_type::pack(ptr, tag, (old >> value_type::pointer_bits) + 1);
+		}
+		static constexpr std::memory_order failure_order(std::memory_order order) noexcept {
+			if (order == std::memory_order::acq_rel) return std::memory_order::acquire;
+			if (order == std::memory_order::release) return std::memory_order::relaxed;
+			return order;
+		}
+	};
 } // namespace asyncpp
@@ -0,0 +1,547 @@
+#pragma once
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) ||                  \
+	defined(__OpenBSD__) || defined(__DragonFly__)
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/stop_token.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#endif
+
+#define ASYNCPP_HAS_REACTOR 1
+
+namespace asyncpp {
+	/**
+	 * \brief Dispatcher running an event loop on top of the readiness notification of the OS.
+	 *
+	 * This uses epoll on Linux and kqueue on BSD and macOS, which makes it a portable alternative to
+	 * uring_dispatcher. Next to executing callbacks like simple_dispatcher it provides awaitables that resume once
+	 * a file descriptor becomes readable or writable, after which the actual I/O can be done without blocking.
+	 *
+	 * The dispatcher also provides the scheduling interface of timer, sharing the same loop: scheduled entries
+	 * are kept in a sorted map only touched by the loop thread and the earliest deadline is used as the timeout
+	 * of the poll. A single thread can therefore serve I/O and timeouts without any cross thread wakeup. Entries
+	 * scheduled from other threads are handed to the loop first.
+	 *
+	 * Callbacks pushed from other threads wake up the loop using an eventfd (EVFILT_USER on kqueue), which is only
+	 * signalled if the loop is actually waiting inside the kernel.
+	 */
+	class reactor_dispatcher final : public dispatcher {
+	public:
+		class readiness_awaiter;
+
+		/**
+		 * \brief Create the poller
+		 * \throw std::system_error if creating it failed
+		 */
+		reactor_dispatcher() {
+#ifdef __linux__
+			m_fd = epoll_create1(EPOLL_CLOEXEC);
+			if (m_fd < 0) throw std::system_error(errno, std::system_category(), "epoll_create1 failed");
+			m_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+			epoll_event evt{};
+			evt.events = EPOLLIN;
+			evt.data.u64 = wake_tag;
+			if (m_wake_fd < 0 || epoll_ctl(m_fd, EPOLL_CTL_ADD, m_wake_fd, &evt) < 0) {
+				const auto err = errno;
+				if (m_wake_fd >= 0) close(m_wake_fd);
+				close(m_fd);
+				throw std::system_error(err, std::system_category(), "creating the wakeup eventfd failed");
+			}
+#else
+			m_fd = kqueue();
+			if (m_fd < 0) throw std::system_error(errno, std::system_category(), "kqueue failed");
+			struct kevent evt {};
+			EV_SET(&evt, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+			if (kevent(m_fd, &evt, 1, nullptr, 0, nullptr) < 0) {
+				const auto err = errno;
+				close(m_fd);
+				throw std::system_error(err, std::system_category(), "registering the wakeup event failed");
+			}
+#endif
+		}
+		~reactor_dispatcher() {
+			assert(m_fds.empty() && "reactor_dispatcher destroyed with pending waits");
+			assert(m_timers.empty() && "reactor_dispatcher destroyed with scheduled entries");
+#ifdef __linux__
+			close(m_wake_fd);
+#endif
+			close(m_fd);
+		}
+		reactor_dispatcher(const reactor_dispatcher&) = delete;
+		reactor_dispatcher& operator=(const reactor_dispatcher&) = delete;
+
+		/**
+		 * \brief Push a function to be executed on the dispatcher.
+		 * \param cbfn The callback
+		 */
+		void push(std::function<void()> cbfn) override {
+			if (!cbfn) return;
+			{
+				std::unique_lock lck{m_mtx};
+				m_queue.emplace_back(std::move(cbfn));
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed on the dispatcher.
+		 * \param hndl The coroutine to resume
+		 */
+		void push_resume(coroutine_handle<> hndl) override {
+			if (!hndl) return;
+			{
+				std::unique_lock lck{m_mtx};
+				// coroutine_handle is trivially copyable and small enough to be stored without allocation
+				m_queue.emplace_back(hndl);
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Push multiple coroutines to be resumed on the dispatcher, taking the lock only once.
+		 * \param hndls The coroutines to resume
+		 */
+		void push_resume_batch(std::span<const coroutine_handle<>> hndls) override {
+			{
+				std::unique_lock lck{m_mtx};
+				for (auto hndl : hndls) {
+					if (hndl) m_queue.emplace_back(hndl);
+				}
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Stop the dispatcher. It will return on the next iteration, regardless if there is any work left.
+		 *
+		 * A stop requested before run() is called makes it return right away, same as simple_dispatcher.
+		 */
+		void stop() noexcept {
+			m_done = true;
+			wake();
+		}
+
+		/**
+		 * \brief Block and process callbacks, readiness events and scheduled entries until stop is called.
+		 */
+		void run() {
+			dispatcher* const old_dispatcher = dispatcher::current(this);
+			std::deque<std::function<void()>> queue;
+			while (!m_done) {
+				{
+					std::unique_lock lck{m_mtx};
+					queue.swap(m_queue);
+				}
+				for (auto& cbfn : queue)
+					cbfn();
+				queue.clear();
+				run_due_timers();
+				// Only sleep in the kernel if nothing got pushed in the meantime, see wake()
+				m_sleeping.store(true);
+				bool wait = !m_done;
+				if (wait) {
+					std::unique_lock lck{m_mtx};
+					wait = m_queue.empty();
+				}
+				std::optional<std::chrono::nanoseconds> timeout{std::chrono::nanoseconds{0}};
+				if (wait) timeout = next_timeout();
+				poll(timeout);
+				m_sleeping.store(false, std::memory_order::relaxed);
+			}
+			dispatcher::current(old_dispatcher);
+		}
+
+		/**
+		 * \brief Get an awaitable that resumes once fd becomes readable or reports an error.
+		 * \note Only one coroutine can wait for each direction of a file descriptor at a time.
+		 * \throw std::system_error on resumption if the file descriptor could not be registered
+		 */
+		[[nodiscard]] readiness_awaiter wait_readable(int fd) noexcept;
+		/**
+		 * \brief Get an awaitable that resumes once fd becomes writable or reports an error.
+		 * \note Only one coroutine can wait for each direction of a file descriptor at a time.
+		 * \throw std::system_error on resumption if the file descriptor could not be registered
+		 */
+		[[nodiscard]] readiness_awaiter wait_writable(int fd) noexcept;
+
+		/**
+		 * \brief Schedule a callback to be executed at a specific point in time, see timer::schedule().
+		 * \param cbfn The callback to execute, invoked with true once the time_point is reached
+		 * \param timeout The time_point at which the callback should get executed
+		 */
+		void schedule(std::function<void(bool)> cbfn, std::chrono::steady_clock::time_point timeout) {
+			schedule_entry(timeout, {}, std::move(cbfn), {}, nullptr);
+		}
+		/**
+		 * \brief Schedule a callback to be executed after a certain duration expires.
+		 * \param cbfn The callback to execute
+		 * \param timeout The duration to wait before executing the callback
+		 */
+		void schedule(std::function<void(bool)> cbfn, std::chrono::nanoseconds timeout) {
+			schedule(std::move(cbfn), std::chrono::steady_clock::now() + timeout);
+		}
+		/**
+		 * \brief Schedule a callback to be executed at a specific point in time with a stop_token
+		 * \param cbfn The callback to execute, invoked with false if stoken got signalled first
+		 * \param timeout The time_point at which the callback should get executed
+		 * \param stoken stop_token allowing to cancel the callback
+		 */
+		void schedule(std::function<void(bool)> cbfn, std::chrono::steady_clock::time_point timeout,
+					  asyncpp::stop_token stoken) {
+			schedule_entry(timeout, std::move(stoken), std::move(cbfn), {}, nullptr);
+		}
+		/**
+		 * \brief Schedule a callback to be executed after a certain duration expires with a stop_token
+		 * \param cbfn The callback to execute
+		 * \param timeout The duration to wait before executing the callback
+		 * \param stoken stop_token allowing to cancel the callback
+		 */
+		void schedule(std::function<void(bool)> cbfn, std::chrono::nanoseconds timeout, asyncpp::stop_token stoken) {
+			schedule(std::move(cbfn), std::chrono::steady_clock::now() + timeout, std::move(stoken));
+		}
+
+		// Defined before the non cancellable version, so its awaiter can deduce the return type of this one
+		/**
+		 * \brief Get an awaitable that pauses the current coroutine until the specified time_point is reached, allows cancellation.
+		 * \param timeout The time_point to wait for
+		 * \param stoken A stop_token that allows cancellation of the wait
+		 * \return An awaitable resuming with false if the wait got cancelled
+		 */
+		auto wait(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken) noexcept {
+			struct awaiter {
+				reactor_dispatcher* const m_parent;
+				const std::chrono::steady_clock::time_point m_timeout;
+				asyncpp::stop_token m_stoptoken;
+				bool m_result{true};
+				awaiter(reactor_dispatcher* parent, std::chrono::steady_clock::time_point timeout,
+						asyncpp::stop_token stoken) noexcept
+					: m_parent(parent), m_timeout(timeout), m_stoptoken(std::move(stoken)) {}
+
+				[[nodiscard]] bool await_ready() const noexcept {
+					return std::chrono::steady_clock::now() >= m_timeout;
+				}
+				void await_suspend(coroutine_handle<> hndl) {
+					m_parent->schedule_entry(m_timeout, std::move(m_stoptoken), {}, hndl, &m_result);
+				}
+				//NOLINTNEXTLINE(modernize-use-nodiscard)
+				constexpr bool await_resume() const noexcept { return m_result; }
+			};
+			return awaiter{this, timeout, std::move(stoken)};
+		}
+
+		/**
+		 * \brief Get an awaitable that pauses the current coroutine until the specified time_point is reached.
+		 * \return An awaitable
+		 */
+		auto wait(std::chrono::steady_clock::time_point timeout) noexcept {
+			struct awaiter {
+				reactor_dispatcher* const m_parent;
+				const std::chrono::steady_clock::time_point m_timeout;
+				bool m_result{true};
+				constexpr awaiter(reactor_dispatcher* parent, std::chrono::steady_clock::time_point timeout) noexcept
+					: m_parent(parent), m_timeout(timeout) {}
+
+				[[nodiscard]] bool await_ready() const noexcept {
+					return std::chrono::steady_clock::now() >= m_timeout;
+				}
+				void await_suspend(coroutine_handle<> hndl) {
+					m_parent->schedule_entry(m_timeout, {}, {}, hndl, &m_result);
+				}
+				//NOLINTNEXTLINE(modernize-use-nodiscard)
+				constexpr bool await_resume() const noexcept { return m_result; }
+				/// \brief Turn this into a cancellable wait, used by cancellable_task.
+				[[nodiscard]] auto with_stop_token(asyncpp::stop_token stoken) const noexcept {
+					return m_parent->wait(m_timeout, std::move(stoken));
+				}
+			};
+			return awaiter{this, timeout};
+		}
+		/**
+		 * \brief Get an awaitable that pauses the current coroutine until the specified duration is elapsed.
+		 * \return An awaitable
+		 */
+		template<typename Rep, typename Period>
+		auto wait(std::chrono::duration<Rep, Period> timeout) noexcept {
+			return wait(std::chrono::steady_clock::now() + timeout);
+		}
+		/**
+		 * \brief Get an awaitable that pauses the current coroutine until the specified duration is elapsed, allows cancellation.
+		 * \param timeout The duration to wait for
+		 * \param stoken A stop_token that allows cancellation of the wait
+		 * \return An awaitable resuming with false if the wait got cancelled
+		 */
+		template<typename Rep, typename Period>
+		auto wait(std::chrono::duration<Rep, Period> timeout, asyncpp::stop_token stoken) noexcept {
+			return wait(std::chrono::steady_clock::now() + timeout, std::move(stoken));
+		}
+
+	private:
+		using timer_key = std::pair<std::chrono::steady_clock::time_point, std::uint64_t>;
+		struct timer_entry {
+			/// \brief Callback type used with stop_tokens
+			struct cancel_callback {
+				reactor_dispatcher* parent;
+				timer_key key;
+				// Might be invoked on any thread, so the entry is removed by the loop
+				void operator()() const {
+					parent->push([parent = parent, key = key]() { parent->cancel_timer(key); });
+				}
+			};
+			std::function<void(bool)> invokable{};
+			/// \brief Coroutine resumed by wait(), used instead of invokable to avoid allocating a std::function
+			coroutine_handle<> handle{};
+			bool* result{};
+			std::optional<asyncpp::stop_callback<cancel_callback>> cancel_token{};
+
+			void invoke(bool res) const {
+				if (handle) {
+					*result = res;
+					handle.resume();
+				} else if (invokable)
+					invokable(res);
+			}
+		};
+		struct fd_state {
+			readiness_awaiter* reader{nullptr};
+			readiness_awaiter* writer{nullptr};
+			// Registered with epoll, unused on kqueue which keeps both filters separate
+			bool registered{false};
+		};
+
+		int m_fd{-1};
+#ifdef __linux__
+		// epoll data of the eventfd, other entries store their fd in the lower bits
+		static constexpr uint64_t wake_tag = ~uint64_t{0};
+		int m_wake_fd{-1};
+#endif
+		// Loop thread only
+		std::map<timer_key, timer_entry> m_timers{};
+		std::uint64_t m_next_timer_id{0};
+		std::unordered_map<int, fd_state> m_fds{};
+
+		std::mutex m_mtx{};
+		std::deque<std::function<void()>> m_queue{};
+		std::atomic<bool> m_done{false};
+		std::atomic<bool> m_sleeping{false};
+
+		void wake() noexcept {
+			if (!m_sleeping.load()) return;
+#ifdef __linux__
+			uint64_t one = 1;
+			[[maybe_unused]] auto res = ::write(m_wake_fd, &one, sizeof(one));
+#else
+			struct kevent evt {};
+			EV_SET(&evt, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+			kevent(m_fd, &evt, 1, nullptr, 0, nullptr);
+#endif
+		}
+
+		void schedule_entry(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken,
+							std::function<void(bool)> cbfn, coroutine_handle<> hndl, bool* result) {
+			if (dispatcher::current() == this)
+				add_timer(timeout, std::move(stoken), std::move(cbfn), hndl, result);
+			else {
+				push([this, timeout, stoken = std::move(stoken), cbfn = std::move(cbfn), hndl, result]() mutable {
+					add_timer(timeout, std::move(stoken), std::move(cbfn), hndl, result);
+				});
+			}
+		}
+		void add_timer(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken,
+					   std::function<void(bool)> cbfn, coroutine_handle<> hndl, bool* result) {
+			const timer_key key{timeout, m_next_timer_id++};
+			auto& entry = m_timers[key];
+			entry.invokable = std::move(cbfn);
+			entry.handle = hndl;
+			entry.result = result;
+			// A token that is already stopped invokes the callback right away, which pushes the cancellation
+			if (stoken.stop_possible())
+				entry.cancel_token.emplace(std::move(stoken), timer_entry::cancel_callback{this, key});
+		}
+		void cancel_timer(const timer_key& key) {
+			auto it = m_timers.find(key);
+			// Already expired
+			if (it == m_timers.end()) return;
+			auto node = m_timers.extract(it);
+			node.mapped().invoke(false);
+		}
+		void run_due_timers() {
+			if (m_timers.empty()) return;
+			const auto now = std::chrono::steady_clock::now();
+			while (!m_timers.empty() && m_timers.begin()->first.first <= now) {
+				auto node = m_timers.extract(m_timers.begin());
+				node.mapped().invoke(true);
+			}
+		}
+		[[nodiscard]] std::optional<std::chrono::nanoseconds> next_timeout() const noexcept {
+			if (m_timers.empty()) return std::nullopt;
+			const auto remaining = m_timers.begin()->first.first - std::chrono::steady_clock::now();
+			return std::max<std::chrono::nanoseconds>(std::chrono::nanoseconds{0}, remaining);
+		}
+
+		void arm(int fd, readiness_awaiter* awaiter, bool write) noexcept;
+		void poll(std::optional<std::chrono::nanoseconds> timeout);
+		void ready(int fd, bool read, bool write);
+	};
+
+	/**
+	 * \brief Awaitable resuming once a file descriptor is ready, see reactor_dispatcher::wait_readable().
+	 */
+	class reactor_dispatcher::readiness_awaiter {
+	public:
+		readiness_awaiter(reactor_dispatcher* parent, int fd, bool write) noexcept
+			: m_parent{parent}, m_fd{fd}, m_write{write} {}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		void await_suspend(coroutine_handle<> hndl) {
+			m_handle = hndl;
+			if (dispatcher::current() == m_parent)
+				m_parent->arm(m_fd, this, m_write);
+			else
+				m_parent->push([this]() { m_parent->arm(m_fd, this, m_write); });
+		}
+		void await_resume() const {
+			if (m_error != 0) throw std::system_error(m_error, std::system_category(), "registering the fd failed");
+		}
+
+	private:
+		friend class reactor_dispatcher;
+
+		reactor_dispatcher* m_parent;
+		int m_fd;
+		bool m_write;
+		int m_error{0};
+		coroutine_handle<> m_handle{};
+	};
+
+	inline reactor_dispatcher::readiness_awaiter reactor_dispatcher::wait_readable(int fd) noexcept {
+		return {this, fd, false};
+	}
+
+	inline reactor_dispatcher::readiness_awaiter reactor_dispatcher::wait_writable(int fd) noexcept {
+		return {this, fd, true};
+	}
+
+	inline void reactor_dispatcher::arm(int fd, readiness_awaiter* awaiter, bool write) noexcept {
+		auto& state = m_fds[fd];
+		assert((write ? state.writer : state.reader) == nullptr && "only one waiter per direction supported");
+		(write ? state.writer : state.reader) = awaiter;
+#ifdef __linux__
+		epoll_event evt{};
+		constexpr auto in_flag = static_cast<uint32_t>(EPOLLIN);
+		constexpr auto out_flag = static_cast<uint32_t>(EPOLLOUT);
+		evt.events = (state.reader ? in_flag : 0u) | (state.writer ? out_flag : 0u);
+		evt.data.fd = fd;
+		const auto res = epoll_ctl(m_fd, state.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &evt);
+		if (res == 0) state.registered = true;
+#else
+		struct kevent evt {};
+		EV_SET(&evt, fd, write ? EVFILT_WRITE : EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, nullptr);
+		const auto res = kevent(m_fd, &evt, 1, nullptr, 0, nullptr);
+#endif
+		if (res < 0) {
+			awaiter->m_error = errno;
+			(write ? state.writer : state.reader) = nullptr;
+			if (!state.reader && !state.writer && !state.registered) m_fds.erase(fd);
+			awaiter->m_handle.resume();
+		}
+	}
+
+	// Resume the waiters of fd and deregister the directions nobody waits for anymore
+	inline void reactor_dispatcher::ready(int fd, bool read, bool write) {
+		auto it = m_fds.find(fd);
+		if (it == m_fds.end()) return;
+		auto& state = it->second;
+		readiness_awaiter* reader = read ? std::exchange(state.reader, nullptr) : nullptr;
+		readiness_awaiter* writer = write ? std::exchange(state.writer, nullptr) : nullptr;
+#ifdef __linux__
+		if (state.reader || state.writer) {
+			epoll_event evt{};
+			evt.events = state.reader ? EPOLLIN : EPOLLOUT;
+			evt.data.fd = fd;
+			epoll_ctl(m_fd, EPOLL_CTL_MOD, fd, &evt);
+		} else {
+			// Removed right away, the fd might get closed and its number reused once the waiters resume
+			epoll_ctl(m_fd, EPOLL_CTL_DEL, fd, nullptr);
+			m_fds.erase(it);
+		}
+#else
+		if (!state.reader && !state.writer) m_fds.erase(it);
+#endif
+		if (reader) reader->m_handle.resume();
+		if (writer) writer->m_handle.resume();
+	}
+
+	inline void reactor_dispatcher::poll(std::optional<std::chrono::nanoseconds> timeout) {
+		constexpr size_t max_events = 64;
+#ifdef __linux__
+		int timeout_ms = -1;
+		// Rounded up, so entries never fire before their timepoint
+		if (timeout) {
+			const auto ms = std::chrono::ceil<std::chrono::milliseconds>(*timeout).count();
+			timeout_ms = static_cast<int>(std::min<decltype(ms)>(ms, std::numeric_limits<int>::max()));
+		}
+		std::array<epoll_event, max_events> events{};
+		const auto count = epoll_wait(m_fd, events.data(), static_cast<int>(events.size()), timeout_ms);
+		if (count < 0) {
+			if (errno == EINTR) return;
+			throw std::system_error(errno, std::system_category(), "epoll_wait failed");
+		}
+		for (int i = 0; i < count; i++) {
+			const auto& evt = events[i];
+			if (evt.data.u64 == wake_tag) {
+				uint64_t value{};
+				[[maybe_unused]] auto res = ::read(m_wake_fd, &value, sizeof(value));
+				continue;
+			}
+			// Errors and hangups wake both directions, the following I/O reports them
+			const bool failed = (evt.events & (EPOLLERR | EPOLLHUP)) != 0;
+			ready(evt.data.fd, failed || (evt.events & EPOLLIN) != 0, failed || (evt.events & EPOLLOUT) != 0);
+		}
+#else
+		timespec ts{};
+		if (timeout) {
+			ts.tv_sec = static_cast<time_t>(timeout->count() / 1000000000);
+			ts.tv_nsec = static_cast<long>(timeout->count() % 1000000000);
+		}
+		std::array<struct kevent, max_events> events{};
+		const auto count =
+			kevent(m_fd, nullptr, 0, events.data(), static_cast<int>(events.size()), timeout ? &ts : nullptr);
+		if (count < 0) {
+			if (errno == EINTR) return;
+			throw std::system_error(errno, std::system_category(), "kevent failed");
+		}
+		for (int i = 0; i < count; i++) {
+			const auto& evt = events[i];
+			if (evt.filter == EVFILT_USER) continue;
+			ready(static_cast<int>(evt.ident), evt.filter == EVFILT_READ, evt.filter == EVFILT_WRITE);
+		}
+#endif
+	}
+} // namespace asyncpp
+#endif
@@ -1,4 +1,7 @@
 #pragma once
+#include <asyncpp/detail/cpu_pause.h>
+
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <compare>
@@ -6,6 +9,7 @@
 #include <cstdint>
 #include <functional>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <utility>
 
@@ -48,8 +52,79 @@ namespace asyncpp {
 		[[nodiscard]] size_t count() const noexcept { return m_count; }
 	};
 
+	/**
+	 * \brief Biased refcount policy
+	 *
+	 * The thread taking the first reference becomes the owner of the object. The owner counts the references it
+	 * takes and drops in a counter only it writes to, so taking a reference is a plain store. All other threads use
+	 * a second, atomic counter, which goes negative if they drop references the owner took. The object is released
+	 * once the sum of both is zero. Every decrement publishes its counter and then reads the other one (both
+	 * sequentially consistent), so the last decrement always sees the final sum, and a flag set using a compare
+	 * exchange makes sure only one thread releases the object.
+	 * This is a good fit for objects that are mostly referenced from one thread, but occasionally shared.
+	 *
+	 * \note fetch_decrement() only reliably returns 1 for the last reference, other return values and count() are
+	 *       approximations, since the total can not be read atomically.
+	 */
+	class biased_refcount {
+		// Only written by the owner, atomic so other threads can read it
+		std::atomic<std::int64_t> m_biased;
+		// References of other threads times two, the lowest bit is set once the object is released
+		std::atomic<std::int64_t> m_shared{0};
+		std::atomic<std::thread::id> m_owner;
+
+		static constexpr std::int64_t released_flag = 1;
+
+		// Called after a decrement, shared is the raw value of m_shared this thread knows to be the latest
+		size_t check_released(std::int64_t biased, std::int64_t shared) noexcept {
+			if (biased + (shared >> 1) != 0) return 2;
+			return m_shared.compare_exchange_strong(shared, shared | released_flag, std::memory_order::seq_cst)
+					   ? 1
+					   : 2;
+		}
+
+	public:
+		explicit biased_refcount(size_t init_val = 0) noexcept
+			: m_biased{static_cast<std::int64_t>(init_val)},
+			  m_owner{init_val != 0 ? std::this_thread::get_id() : std::thread::id{}} {}
+		biased_refcount(const biased_refcount& other) = delete;
+		biased_refcount& operator=(const biased_refcount& other) = delete;
+
+		size_t fetch_increment() noexcept {
+			const auto self = std::this_thread::get_id();
+			auto owner = m_owner.load(std::memory_order::relaxed);
+			// Nobody else can hold a reference while the first one is taken, so this can not race
+			if (owner == std::thread::id{}) {
+				m_owner.store(self, std::memory_order::relaxed);
+				owner = self;
+			}
+			if (owner == self) {
+				const auto old = m_biased.load(std::memory_order::relaxed);
+				m_biased.store(old + 1, std::memory_order::relaxed);
+				return static_cast<size_t>(std::max<std::int64_t>(old, 0));
+			}
+			const auto old = m_shared.fetch_add(2, std::memory_order::seq_cst) >> 1;
+			return static_cast<size_t>(std::max<std::int64_t>(old, 0));
+		}
+		[[nodiscard]] size_t fetch_decrement() noexcept {
+			if (m_owner.load(std::memory_order::relaxed) == std::this_thread::get_id()) {
+				const auto biased = m_biased.load(std::memory_order::relaxed) - 1;
+				m_biased.store(biased, std::memory_order::seq_cst);
+				return check_released(biased, m_shared.load(std::memory_order::seq_cst));
+			}
+			const auto shared = m_shared.fetch_sub(2, std::memory_order::seq_cst) - 2;
+			return check_released(m_biased.load(std::memory_order::seq_cst), shared);
+		}
+		[[nodiscard]] size_t count() const noexcept {
+			const auto sum =
+				m_biased.load(std::memory_order::relaxed) + (m_shared.load(std::memory_order::relaxed) >> 1);
+			return static_cast<size_t>(std::max<std::int64_t>(sum, 0));
+		}
+	};
+
 	static_assert(RefCount<thread_safe_refcount>, "[INTERNAL] thread_safe_refcount does not satisfy RefCount");
 	static_assert(RefCount<thread_unsafe_refcount>, "[INTERNAL] thread_unsafe_refcount does not satisfy RefCount");
+	static_assert(RefCount<biased_refcount>, "[INTERNAL] biased_refcount does not satisfy RefCount");
 
 	template<typename T, RefCount TCounter = thread_safe_refcount>
 	class intrusive_refcount;
@@ -57,7 +132,7 @@ namespace asyncpp {
 	/**
 	 * \brief Intrusive refcounting base class
 	 * \tparam T Derived type
-	 * \tparam TCounter Counter policy to use, e.g. thread_safe_refcount or thread_unsafe_refcount
+	 * \tparam TCounter Counter policy to use, e.g. thread_safe_refcount, thread_unsafe_refcount or biased_refcount
 	 */
 	template<typename T, RefCount TCounter>
 	class intrusive_refcount {
@@ -160,6 +235,14 @@ namespace asyncpp {
 		}
 		/// \brief Move constructor
 		constexpr ref(ref&& other) noexcept : m_ptr{std::exchange(other.m_ptr, nullptr)} {}
+		/**
+		 * \brief Converting move constructor, transfers the reference without touching the count
+		 * \param other The ref to take the pointer from
+		 */
+		template<typename U>
+			requires(!std::is_same_v<U, T> && std::is_convertible_v<U*, T*>)
+		// NOLINTNEXTLINE(google-explicit-constructor)
+		constexpr ref(ref<U>&& other) noexcept : m_ptr{other.release()} {}
 		/// \brief Assignment operator
 		ref& operator=(const ref& other) noexcept(
 			noexcept(refcounted_add_ref(std::declval<T*>())) && noexcept(refcounted_remove_ref(std::declval<T*>()))) {
@@ -247,28 +330,6 @@ namespace asyncpp {
 
 		static constexpr uintptr_t lock_mask = uintptr_t{1} << (sizeof(uintptr_t) * 8 - 1);
 
-		/**
-		 * \brief Pause the current cpu. This is effectively an optimized nop
-		 * 	      that reduces congestion in hyperthreading and improves power usage.
-		 */
-		inline static void cpu_pause() noexcept {
-#if defined(__i386) || defined(_M_IX86) || defined(_X86_) || defined(__amd64) || defined(_M_AMD64)
-#ifdef _MSC_VER
-			_mm_pause();
-#else
-			__builtin_ia32_pause();
-#endif
-#elif defined(__arm__) || defined(_ARM) || defined(_M_ARM) || defined(__arm)
-#ifdef _MSC_VER
-			__yield();
-#else
-			asm volatile("yield");
-#endif
-#elif defined(__riscv)
-			asm volatile("pause");
-#endif
-		}
-
 		/**
 		 * \brief Lock the pointer. This is effectively a spinlock on the most significant bit.
 		 */
@@ -276,7 +337,7 @@ namespace asyncpp {
 			// Lock the current pointer value
 			auto val = m_ptr.fetch_or(lock_mask, std::memory_order_acquire);
 			while ((val & lock_mask) == lock_mask) {
-				cpu_pause();
+				detail::cpu_pause();
 				val = m_ptr.fetch_or(lock_mask, std::memory_order_acquire);
 			}
 			return val;
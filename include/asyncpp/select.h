@@ -0,0 +1,116 @@
+#pragma once
+#include <asyncpp/detail/select_state.h>
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+namespace asyncpp {
+	/**
+	 * \brief Awaitable waiting on multiple channel operations at once, see select().
+	 * \tparam Branches The channel awaiters (returned by channel::read() and channel::write()) to wait on
+	 */
+	template<typename... Branches>
+	class select_awaiter {
+		static_assert(sizeof...(Branches) > 0, "select requires at least one branch");
+
+	public:
+		/// \brief Result type, the index of the active alternative is the index of the completed branch
+		using result_type = std::variant<decltype(std::declval<Branches&>().await_resume())...>;
+
+		/**
+		 * \brief Construct a new select awaiter.
+		 * \param branches The channel operations to wait on
+		 */
+		explicit select_awaiter(Branches... branches) : m_branches{std::move(branches)...} {}
+
+		/**
+		 * \brief Specify a dispatcher to resume on.
+		 *
+		 * By default the coroutine is resumed on the current dispatcher or inline of the channel
+		 * operation that completed it if no dispatcher was active at the time of suspension.
+		 * \param dsp The dispatcher to resume on or nullptr to resume inline.
+		 */
+		select_awaiter& resume_on(dispatcher* dsp) noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		bool await_suspend(coroutine_handle<> hndl) {
+			return suspend_impl(hndl, std::index_sequence_for<Branches...>{});
+		}
+		result_type await_resume() { return resume_impl(std::index_sequence_for<Branches...>{}); }
+
+	private:
+		std::tuple<Branches...> m_branches;
+		detail::select_state m_state{};
+		dispatcher* m_dispatcher = dispatcher::current();
+		bool m_registered{false};
+
+		template<size_t... Is>
+		bool suspend_impl(coroutine_handle<> hndl, std::index_sequence<Is...>) {
+			// Lock all involved channels in a consistent order, so no other select can complete one of our
+			// branches while we are still checking the others.
+			std::array<std::mutex*, sizeof...(Branches)> mtxs{&std::get<Is>(m_branches).select_mutex()...};
+			std::sort(mtxs.begin(), mtxs.end());
+			auto end = std::unique(mtxs.begin(), mtxs.end());
+			for (auto it = mtxs.begin(); it != end; it++)
+				(*it)->lock();
+			// Check for a branch that can complete right away, earlier branches take precedence
+			size_t ready = detail::select_state::npos;
+			((ready == detail::select_state::npos && std::get<Is>(m_branches).select_try_complete() ? ready = Is : 0),
+			 ...);
+			if (ready == detail::select_state::npos) {
+				(std::get<Is>(m_branches).select_enqueue(hndl, &m_state, Is, m_dispatcher), ...);
+				m_registered = true;
+			} else
+				m_state.m_winner.store(ready, std::memory_order::relaxed);
+			// We might get resumed as soon as we unlock, so no members can be accessed after this point
+			for (auto it = mtxs.begin(); it != end; it++)
+				(*it)->unlock();
+			if (ready == detail::select_state::npos) return true;
+			((ready == Is ? std::get<Is>(m_branches).select_finish() : void()), ...);
+			return false;
+		}
+
+		template<size_t... Is>
+		result_type resume_impl(std::index_sequence<Is...>) {
+			const auto winner = m_state.m_winner.load(std::memory_order::acquire);
+			// Remove the other branches from their channels, they might have been skipped already
+			if (m_registered) ((winner != Is ? std::get<Is>(m_branches).select_cancel() : void()), ...);
+			std::optional<result_type> res;
+			((winner == Is ? (void)res.emplace(std::in_place_index<Is>, std::get<Is>(m_branches).await_resume())
+						   : void()),
+			 ...);
+			return std::move(*res);
+		}
+	};
+
+	/**
+	 * \brief Wait on multiple channel operations and complete with the first one that is ready.
+	 *
+	 * This works similar to the select statement in go. Every branch is a read or write awaiter obtained from a
+	 * channel, for example `co_await select(chan_a.read(), chan_b.write(42))`. If one of the branches can complete
+	 * right away the first of those is used, otherwise every branch is registered on its channel and the first
+	 * one that gets ready completes the select. Once a branch completes all remaining ones are cancelled, no
+	 * value is consumed or written by them.
+	 *
+	 * \note Operations on closed channels are ready right away. A read on a closed channel completes with nullopt
+	 * 		and a write completes with false, just like the corresponding non select operations.
+	 * \param branches The channel operations to wait on
+	 * \return An awaitable that resumes with a std::variant whose index is the index of the completed branch and
+	 * 		whose value is the result of that branch.
+	 */
+	template<typename... Branches>
+	[[nodiscard]] inline select_awaiter<Branches...> select(Branches... branches) {
+		return select_awaiter<Branches...>{std::move(branches)...};
+	}
+} // namespace asyncpp
@@ -0,0 +1,214 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/trampoline.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace asyncpp {
+	/**
+	 * \brief Counting semaphore with an asynchronous acquire() operation.
+	 *
+	 * The semaphore holds a number of permits. acquire(n) resumes once n permits could be taken, release(n) gives
+	 * permits back and resumes waiting coroutines in the order they started to wait. A waiter that needs more
+	 * permits than available blocks all waiters behind it, so large requests can not get starved.
+	 *
+	 * As long as no coroutine has to wait the state is a single counter, so acquiring and releasing is a single
+	 * atomic operation. Waiters are kept in an intrusive lock-free list similar to multi_consumer_event. Coroutines
+	 * are resumed on the dispatcher passed to acquire(), or inline in release() if none was provided.
+	 * The implementation is lock-free and does not throw.
+	 */
+	class async_semaphore {
+		struct awaiter;
+
+	public:
+		/**
+		 * \brief Construct a new semaphore
+		 * \param initial The initial number of permits
+		 */
+		explicit constexpr async_semaphore(size_t initial = 0) noexcept : m_state{make_counter(initial)} {}
+#ifndef NDEBUG
+		~async_semaphore() noexcept { assert(is_counter(m_state.load(std::memory_order::relaxed))); }
+#endif
+		async_semaphore(const async_semaphore&) = delete;
+		async_semaphore(async_semaphore&&) = delete;
+		async_semaphore& operator=(const async_semaphore&) = delete;
+		async_semaphore& operator=(async_semaphore&&) = delete;
+
+		/**
+		 * \brief Try to take permits without suspending
+		 * \param count The number of permits to take
+		 * \return true if the permits were taken, false if not enough were available or coroutines are waiting
+		 */
+		[[nodiscard]] bool try_acquire(size_t count = 1) noexcept {
+			auto old = m_state.load(std::memory_order::relaxed);
+			while (is_counter(old) && permits(old) >= count) {
+				if (m_state.compare_exchange_weak(old, old - (count << 1), std::memory_order::acquire,
+												  std::memory_order::relaxed))
+					return true;
+			}
+			return false;
+		}
+
+		/**
+		 * \brief Take permits from the semaphore, suspending until enough are available.
+		 *
+		 * The coroutine will resume on the current dispatcher if the thread belongs to a dispatcher or inside
+		 * release() if not.
+		 * \param count The number of permits to take
+		 * \return Awaitable
+		 */
+		[[nodiscard]] auto acquire(size_t count = 1) noexcept { return awaiter{this, count, dispatcher::current()}; }
+
+		/**
+		 * \brief Take permits from the semaphore, suspending until enough are available.
+		 * \param count The number of permits to take
+		 * \param resume_dispatcher The dispatcher to resume on or nullptr to resume inside release()
+		 * \return Awaitable
+		 */
+		[[nodiscard]] constexpr auto acquire(size_t count, dispatcher* resume_dispatcher) noexcept {
+			return awaiter{this, count, resume_dispatcher};
+		}
+
+		/**
+		 * \brief Give permits back to the semaphore
+		 * \note Waiting coroutines without a dispatcher are resumed inside this call.
+		 * \param count The number of permits to release
+		 */
+		void release(size_t count = 1) noexcept {
+			auto old = m_state.load(std::memory_order::relaxed);
+			while (is_counter(old)) {
+				if (m_state.compare_exchange_weak(old, old + (count << 1), std::memory_order::release,
+												  std::memory_order::relaxed))
+					return;
+			}
+			release_contended(count);
+		}
+
+		/**
+		 * \brief Query the number of permits that can be taken right away
+		 * \note Do not base decisions on this value, as it might change at any time
+		 */
+		[[nodiscard]] size_t available() const noexcept {
+			auto state = m_state.load(std::memory_order::relaxed);
+			return is_counter(state) ? permits(state) : 0;
+		}
+
+	private:
+		/* lowest bit set => counter, permits stored in the upper bits
+		 * 0 => coroutines are waiting, no new ones were pushed since the list was last taken
+		 * x => head of newly pushed awaiter* list
+		 */
+		std::atomic<std::uintptr_t> m_state;
+		/* Permits released while coroutines were waiting and not yet looked at. Whoever raises this from zero
+		 * hands out permits until it can bring it back down, which makes it the only one touching the members below.
+		 */
+		std::atomic<size_t> m_pending{0};
+		// Permits not handed out yet, because they are not enough for the first waiter
+		size_t m_leftover{0};
+		// Waiters in order of arrival
+		awaiter* m_awaiters{nullptr};
+
+		static constexpr std::uintptr_t make_counter(size_t permits) noexcept { return (permits << 1) | 1; }
+		static constexpr bool is_counter(std::uintptr_t state) noexcept { return (state & 1) != 0; }
+		static constexpr size_t permits(std::uintptr_t state) noexcept { return state >> 1; }
+
+		struct [[nodiscard]] awaiter {
+			constexpr awaiter(async_semaphore* parent, size_t count, dispatcher* dispatcher) noexcept
+				: m_parent(parent), m_dispatcher(dispatcher), m_count(count) {}
+			[[nodiscard]] bool await_ready() noexcept { return m_count == 0 || m_parent->try_acquire(m_count); }
+			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) noexcept {
+				m_handle = hdl;
+				return m_parent->enqueue(this);
+			}
+			constexpr void await_resume() const noexcept {}
+
+			async_semaphore* m_parent;
+			dispatcher* m_dispatcher;
+			size_t m_count;
+			awaiter* m_next{nullptr};
+			coroutine_handle<> m_handle{};
+		};
+
+		bool enqueue(awaiter* await) noexcept {
+			auto old = m_state.load(std::memory_order::acquire);
+			while (true) {
+				if (is_counter(old)) {
+					if (permits(old) >= await->m_count) {
+						if (m_state.compare_exchange_weak(old, old - (await->m_count << 1), std::memory_order::acquire,
+														  std::memory_order::relaxed))
+							return false;
+						continue;
+					}
+					// Not enough permits, we become the first waiter
+					await->m_next = nullptr;
+					if (!m_state.compare_exchange_weak(old, reinterpret_cast<std::uintptr_t>(await),
+													   std::memory_order::acq_rel, std::memory_order::acquire))
+						continue;
+					// The permits that were left in the counter are handed out like released ones.
+					// We might already be resumed at this point, so the awaiter must not be touched anymore.
+					if (permits(old) != 0) release_contended(permits(old));
+					return true;
+				}
+				// NOLINTNEXTLINE(performance-no-int-to-ptr)
+				await->m_next = reinterpret_cast<awaiter*>(old);
+				if (m_state.compare_exchange_weak(old, reinterpret_cast<std::uintptr_t>(await),
+												  std::memory_order::release, std::memory_order::acquire))
+					return true;
+			}
+		}
+
+		void release_contended(size_t count) noexcept {
+			// Someone else is already handing out permits and will pick ours up
+			if (m_pending.fetch_add(count, std::memory_order::acq_rel) != 0) return;
+			while (true) {
+				m_leftover += count;
+				resume_waiters();
+				const auto rest = m_pending.fetch_sub(count, std::memory_order::acq_rel) - count;
+				if (rest == 0) return;
+				count = rest;
+			}
+		}
+
+		void resume_waiters() noexcept {
+			while (true) {
+				if (m_awaiters == nullptr) {
+					// Nobody is left in our list, go back to a counter or take the newly pushed waiters
+					auto old = m_state.load(std::memory_order::acquire);
+					while (true) {
+						if (is_counter(old) || old == 0) {
+							const auto next = is_counter(old) ? old + (m_leftover << 1) : make_counter(m_leftover);
+							if (m_state.compare_exchange_weak(old, next, std::memory_order::release,
+															  std::memory_order::acquire)) {
+								m_leftover = 0;
+								return;
+							}
+						} else if (m_state.compare_exchange_weak(old, 0, std::memory_order::acquire,
+																 std::memory_order::acquire))
+							break;
+					}
+					// Reverse the list, so waiters are resumed in the order they arrived
+					// NOLINTNEXTLINE(performance-no-int-to-ptr)
+					auto next = reinterpret_cast<awaiter*>(old);
+					do {
+						auto temp = next->m_next;
+						next->m_next = m_awaiters;
+						m_awaiters = next;
+						next = temp;
+					} while (next != nullptr);
+				}
+				auto head = m_awaiters;
+				if (head->m_count > m_leftover) return;
+				m_leftover -= head->m_count;
+				m_awaiters = head->m_next;
+				if (head->m_dispatcher != nullptr)
+					head->m_dispatcher->push_resume(head->m_handle);
+				else
+					resume_trampoline::resume(head->m_handle);
+			}
+		}
+	};
+} // namespace asyncpp
@@ -0,0 +1,274 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/trampoline.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace asyncpp {
+	/**
+	 * \brief A reader/writer mutex with asynchronous lock() and lock_shared() operations.
+	 *
+	 * Any number of coroutines can hold the mutex in shared mode at the same time, while exclusive mode is only
+	 * granted to a single coroutine. Like mutex it is not tied to a particular thread and the implementation is
+	 * lock-free and does not throw.
+	 *
+	 * As long as there is no contention the state is a single counter. Once a coroutine has to wait the state turns
+	 * into a lock-free list of waiters, similar to mutex. From then on new readers queue up as well, so writers can
+	 * not get starved. Whoever releases the mutex last hands it over to the waiters in the order they arrived.
+	 * A released writer lets all readers queued in front of the next writer go in one batch.
+	 */
+	class async_shared_mutex {
+	public:
+		struct lock_awaiter;
+		struct lock_shared_awaiter;
+
+		/// \brief Construct mutex in its unlocked state
+		constexpr async_shared_mutex() noexcept = default;
+		/**
+		 * \brief Destruct mutex
+		 *
+		 * \note If the mutex is destroyed while it is locked or coroutines try to lock it, the behaviour is undefined.
+		 */
+		~async_shared_mutex() {
+			assert(m_state.load(std::memory_order::relaxed) == state_unlocked);
+			assert(m_awaiters == nullptr);
+		}
+		async_shared_mutex(const async_shared_mutex&) noexcept = delete;
+		async_shared_mutex(async_shared_mutex&&) noexcept = delete;
+		async_shared_mutex& operator=(const async_shared_mutex&) noexcept = delete;
+		async_shared_mutex& operator=(async_shared_mutex&&) noexcept = delete;
+
+		/**
+		 * \brief Attempt to acquire the mutex exclusively whitout blocking or yielding.
+		 * \return true if the lock was aquired, false otherwise
+		 */
+		[[nodiscard]] bool try_lock() noexcept {
+			auto old = state_unlocked;
+			return m_state.compare_exchange_strong(old, state_writer, std::memory_order::acquire,
+												   std::memory_order::relaxed);
+		}
+		/**
+		 * \brief Attempt to acquire the mutex in shared mode whitout blocking or yielding.
+		 * \return true if the lock was aquired, false otherwise
+		 */
+		[[nodiscard]] bool try_lock_shared() noexcept {
+			auto old = m_state.load(std::memory_order::relaxed);
+			while (is_shareable(old)) {
+				if (m_state.compare_exchange_weak(old, old + reader_increment, std::memory_order::acquire,
+												  std::memory_order::relaxed))
+					return true;
+			}
+			return false;
+		}
+		/**
+		 * \brief Acquire the mutex exclusively using co_await.
+		 * \return An awaitable type that resumes once it holds the mutex.
+		 */
+		[[nodiscard]] constexpr lock_awaiter lock() noexcept;
+		/**
+		 * \brief Acquire the mutex in shared mode using co_await.
+		 * \return An awaitable type that resumes once it holds the mutex.
+		 */
+		[[nodiscard]] constexpr lock_shared_awaiter lock_shared() noexcept;
+		/**
+		 * \brief Release an exclusive lock
+		 *
+		 * \note Behaviour is undefined if the mutex is not locked exclusively. Resumes the next waiting
+		 *       coroutine or all of the next waiting readers (if any) on the current thread before it returns.
+		 */
+		void unlock() noexcept;
+		/**
+		 * \brief Release a shared lock
+		 *
+		 * \note Behaviour is undefined if the mutex is not locked in shared mode. If this was the last reader
+		 *       the next waiting coroutine (if any) is resumed on the current thread before it returns.
+		 */
+		void unlock_shared() noexcept;
+		/**
+		 * \brief Query if the lock is currently locked in any mode
+		 * \warning This is unreliable if the mutex is used in multiple preemtive threads.
+		 */
+		[[nodiscard]] bool is_locked() const noexcept {
+			return m_state.load(std::memory_order::relaxed) != state_unlocked;
+		}
+
+	private:
+		/**
+		 * m_state is either a counter (lowest bit set) or a pointer to the most recently queued waiter (lowest bit
+		 * clear). A counter stores the number of readers in the upper bits and uses bit 1 for the writer. A value of
+		 * 0 means there is contention but no new waiters got pushed since the last time the list was taken.
+		 *
+		 * While contended, the readers that hold the lock are counted in m_readers instead. The waiter that turns a
+		 * counter into a list adds the readers of the counter to it, which might happen after some of them already
+		 * left. The one that brings it down to zero hands the mutex over to the next waiters.
+		 */
+		static constexpr std::uintptr_t state_contended_no_waiters = 0;
+		static constexpr std::uintptr_t state_unlocked = 1;
+		static constexpr std::uintptr_t writer_bit = 2;
+		static constexpr std::uintptr_t state_writer = state_unlocked | writer_bit;
+		static constexpr std::uintptr_t reader_increment = 4;
+
+		/// \brief Common part of the lock awaiters, forming the intrusive list of waiters
+		struct waiter {
+			waiter* next{nullptr};
+			coroutine_handle<> handle{};
+			bool writer{false};
+		};
+
+		std::atomic<std::uintptr_t> m_state{state_unlocked};
+		std::atomic<std::intptr_t> m_readers{0};
+		// Owned by whoever hands over the mutex, waiters in order of arrival
+		waiter* m_awaiters{nullptr};
+
+		static constexpr bool is_counter(std::uintptr_t state) noexcept { return (state & 1) != 0; }
+		static constexpr bool is_shareable(std::uintptr_t state) noexcept {
+			return is_counter(state) && (state & writer_bit) == 0;
+		}
+
+		bool enqueue(waiter* awaiter, bool writer) noexcept;
+		void release_contended() noexcept;
+	};
+
+	struct [[nodiscard]] async_shared_mutex::lock_awaiter : waiter {
+		constexpr explicit lock_awaiter(async_shared_mutex* mtx) noexcept : mutex(mtx) {}
+		[[nodiscard]] bool await_ready() noexcept { return mutex->try_lock(); }
+		[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept {
+			handle = hndl;
+			return mutex->enqueue(this, true);
+		}
+		constexpr void await_resume() const noexcept {}
+
+		async_shared_mutex* mutex;
+	};
+
+	struct [[nodiscard]] async_shared_mutex::lock_shared_awaiter : waiter {
+		constexpr explicit lock_shared_awaiter(async_shared_mutex* mtx) noexcept : mutex(mtx) {}
+		[[nodiscard]] bool await_ready() noexcept { return mutex->try_lock_shared(); }
+		[[nodiscard]] bool await_suspend(coroutine_handle<> hndl) noexcept {
+			handle = hndl;
+			return mutex->enqueue(this, false);
+		}
+		constexpr void await_resume() const noexcept {}
+
+		async_shared_mutex* mutex;
+	};
+
+	constexpr inline async_shared_mutex::lock_awaiter async_shared_mutex::lock() noexcept {
+		return lock_awaiter{this};
+	}
+
+	constexpr inline async_shared_mutex::lock_shared_awaiter async_shared_mutex::lock_shared() noexcept {
+		return lock_shared_awaiter{this};
+	}
+
+	inline bool async_shared_mutex::enqueue(waiter* awaiter, bool writer) noexcept {
+		awaiter->writer = writer;
+		auto old = m_state.load(std::memory_order::acquire);
+		while (true) {
+			if (is_counter(old)) {
+				if (writer ? old == state_unlocked : is_shareable(old)) {
+					const auto next = writer ? state_writer : old + reader_increment;
+					if (m_state.compare_exchange_weak(old, next, std::memory_order::acquire,
+													  std::memory_order::relaxed))
+						return false;
+					continue;
+				}
+				// The mutex is held incompatibly, turn the counter into a list of waiters.
+				awaiter->next = nullptr;
+				if (!m_state.compare_exchange_weak(old, reinterpret_cast<std::uintptr_t>(awaiter),
+												   std::memory_order::acq_rel, std::memory_order::acquire))
+					continue;
+				// A writer hands over the mutex on unlock. Readers might however already have left, in which
+				// case we are the one bringing the count to zero and have to do it.
+				if ((old & writer_bit) == 0) {
+					const auto readers = static_cast<std::intptr_t>(old / reader_increment);
+					if (m_readers.fetch_add(readers, std::memory_order::acq_rel) + readers == 0) release_contended();
+				}
+				// We might already be resumed at this point, so the awaiter must not be touched anymore.
+				return true;
+			}
+			// NOLINTNEXTLINE(performance-no-int-to-ptr)
+			awaiter->next = reinterpret_cast<waiter*>(old);
+			if (m_state.compare_exchange_weak(old, reinterpret_cast<std::uintptr_t>(awaiter),
+											  std::memory_order::release, std::memory_order::acquire))
+				return true;
+		}
+	}
+
+	inline void async_shared_mutex::release_contended() noexcept {
+		// Nobody holds the mutex at this point and the state is not a counter
+		if (m_awaiters == nullptr) {
+			auto old = state_contended_no_waiters;
+			if (m_state.compare_exchange_strong(old, state_unlocked, std::memory_order::release,
+												std::memory_order::relaxed))
+				return;
+			old = m_state.exchange(state_contended_no_waiters, std::memory_order::acquire);
+			assert(old != state_contended_no_waiters && !is_counter(old));
+			// Reverse the queued waiters, so they get the mutex in the order they arrived
+			// NOLINTNEXTLINE(performance-no-int-to-ptr)
+			auto next = reinterpret_cast<waiter*>(old);
+			waiter* head = nullptr;
+			do {
+				auto temp = next->next;
+				next->next = head;
+				head = next;
+				next = temp;
+			} while (next != nullptr);
+			m_awaiters = head;
+		}
+		auto head = m_awaiters;
+		if (head->writer) {
+			m_awaiters = head->next;
+			// Without any other waiters we can go back to a plain counter, otherwise the writer hands over on unlock
+			auto old = state_contended_no_waiters;
+			if (m_awaiters == nullptr)
+				m_state.compare_exchange_strong(old, state_writer, std::memory_order::relaxed,
+												std::memory_order::relaxed);
+			resume_trampoline::resume(head->handle);
+			return;
+		}
+		// Let all readers up to the next writer go at once
+		std::intptr_t count = 0;
+		waiter* last = nullptr;
+		for (auto it = head; it != nullptr && !it->writer; it = it->next) {
+			last = it;
+			count++;
+		}
+		m_awaiters = last->next;
+		last->next = nullptr;
+		auto old = state_contended_no_waiters;
+		if (m_awaiters != nullptr ||
+			!m_state.compare_exchange_strong(old, state_unlocked + count * reader_increment,
+											 std::memory_order::relaxed, std::memory_order::relaxed))
+			m_readers.store(count, std::memory_order::relaxed);
+		// Resuming a reader might destroy its awaiter, so we need to fetch next before doing so
+		for (auto it = head; it != nullptr;) {
+			auto next = it->next;
+			resume_trampoline::resume(it->handle);
+			it = next;
+		}
+	}
+
+	inline void async_shared_mutex::unlock() noexcept {
+		auto old = state_writer;
+		if (m_state.compare_exchange_strong(old, state_unlocked, std::memory_order::release,
+											std::memory_order::acquire))
+			return;
+		assert(!is_counter(old));
+		release_contended();
+	}
+
+	inline void async_shared_mutex::unlock_shared() noexcept {
+		auto old = m_state.load(std::memory_order::relaxed);
+		while (is_counter(old)) {
+			assert(old >= state_unlocked + reader_increment && (old & writer_bit) == 0);
+			if (m_state.compare_exchange_weak(old, old - reader_increment, std::memory_order::release,
+											  std::memory_order::relaxed))
+				return;
+		}
+		if (m_readers.fetch_sub(1, std::memory_order::acq_rel) == 1) release_contended();
+	}
+} // namespace asyncpp
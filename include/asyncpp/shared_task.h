@@ -0,0 +1,217 @@
+#pragma once
+#include <asyncpp/detail/promise_allocator_base.h>
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/task.h>
+#include <asyncpp/trampoline.h>
+
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace asyncpp {
+	template<class T, ByteAllocator Allocator>
+	class shared_task;
+
+	namespace detail {
+		struct shared_task_waiter {
+			coroutine_handle<> m_handle{};
+			shared_task_waiter* m_next{nullptr};
+		};
+
+		template<class TVal, ByteAllocator Allocator, class TPromise>
+		class shared_task_promise_base : public promise_allocator_base<Allocator> {
+		public:
+			shared_task_promise_base() noexcept = default;
+			~shared_task_promise_base() = default;
+			shared_task_promise_base(const shared_task_promise_base&) = delete;
+			shared_task_promise_base(shared_task_promise_base&&) = delete;
+			shared_task_promise_base& operator=(const shared_task_promise_base&) = delete;
+			shared_task_promise_base& operator=(shared_task_promise_base&&) = delete;
+
+			coroutine_handle<TPromise> get_return_object() noexcept {
+				return coroutine_handle<TPromise>::from_promise(*static_cast<TPromise*>(this));
+			}
+
+			suspend_always initial_suspend() noexcept { return {}; }
+			auto final_suspend() noexcept {
+				struct awaiter {
+					constexpr bool await_ready() noexcept { return false; }
+					void await_suspend(coroutine_handle<TPromise> hndl) noexcept {
+						auto state = hndl.promise().m_state.exchange(&hndl.promise(), std::memory_order::acq_rel);
+						// A resumed waiter might destroy the task, so the frame must not be touched from here on
+						auto waiter = static_cast<shared_task_waiter*>(state);
+						while (waiter != nullptr) {
+							auto next = waiter->m_next;
+							resume_trampoline::resume(waiter->m_handle);
+							waiter = next;
+						}
+					}
+					constexpr void await_resume() noexcept {}
+				};
+				return awaiter{};
+			}
+
+			void unhandled_exception() noexcept {
+				m_value.template emplace<std::exception_ptr>(std::current_exception());
+			}
+
+			/// \brief Check if the coroutine has finished, a true result makes the value visible to the caller.
+			[[nodiscard]] bool is_ready() const noexcept { return m_state.load(std::memory_order::acquire) == this; }
+
+			/**
+			 * \brief Add a waiter, starting the coroutine if it is the first one.
+			 * \return The coroutine to transfer to
+			 */
+			coroutine_handle<> add_waiter(shared_task_waiter* waiter) noexcept {
+				void* old_state = m_state.load(std::memory_order::acquire);
+				do {
+					if (old_state == this) return waiter->m_handle;
+					waiter->m_next = old_state == not_started() ? nullptr : static_cast<shared_task_waiter*>(old_state);
+				} while (!m_state.compare_exchange_weak(old_state, waiter, std::memory_order::acq_rel,
+														std::memory_order::acquire));
+				if (old_state != not_started()) return noop_coroutine();
+				return coroutine_handle<TPromise>::from_promise(*static_cast<TPromise*>(this));
+			}
+
+			void add_ref() noexcept { m_refs.fetch_add(1, std::memory_order::relaxed); }
+			/// \return true if this was the last reference
+			[[nodiscard]] bool release() noexcept { return m_refs.fetch_sub(1, std::memory_order::acq_rel) == 1; }
+
+			const TVal& rethrow_if_exception() const {
+				if (std::holds_alternative<std::exception_ptr>(m_value))
+					std::rethrow_exception(std::get<std::exception_ptr>(m_value));
+				return std::get<TVal>(m_value);
+			}
+
+			std::variant<std::monostate, TVal, std::exception_ptr> m_value{};
+
+		private:
+			/* not_started() => not started
+			 * this => done
+			 * nullptr => running without waiters (can not happen, the first waiter starts it)
+			 * x => head of shared_task_waiter* list
+			 */
+			std::atomic<void*> m_state{not_started()};
+			std::atomic<size_t> m_refs{1};
+
+			void* not_started() noexcept { return &m_refs; }
+		};
+
+		template<class T, ByteAllocator Allocator>
+		class shared_task_promise : public shared_task_promise_base<T, Allocator, shared_task_promise<T, Allocator>> {
+		public:
+			template<class U>
+			void return_value(U&& value)
+				requires(std::is_convertible_v<U, T>)
+			{
+				this->m_value.template emplace<T>(std::forward<U>(value));
+			}
+			const T& get() const { return this->rethrow_if_exception(); }
+		};
+
+		template<ByteAllocator Allocator>
+		class shared_task_promise<void, Allocator>
+			: public shared_task_promise_base<returned, Allocator, shared_task_promise<void, Allocator>> {
+		public:
+			void return_void() { this->m_value.template emplace<returned>(); }
+			void get() const { this->rethrow_if_exception(); }
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Lazy task that can be awaited by any number of coroutines.
+	 *
+	 * The coroutine starts once the first copy of the task is awaited. Coroutines awaiting it while it runs are
+	 * kept in an intrusive lock-free list similar to multi_consumer_event and get resumed inside the completing
+	 * coroutine once it finishes. Awaiting a finished shared_task does not suspend and only needs a single acquire
+	 * load. Every awaiter gets a const reference to the same result, which lives as long as a copy of the task
+	 * does, or the same exception. Copies share the coroutine, which is destroyed together with the last copy.
+	 *
+	 * This is useful for coalescing identical requests, where many coroutines are interested in the result of one
+	 * operation in flight.
+	 * \tparam T Return type of the task
+	 */
+	template<class T = void, ByteAllocator Allocator = default_allocator_type>
+	class [[nodiscard]] shared_task {
+	public:
+		/// \brief Promise type
+		using promise_type = detail::shared_task_promise<T, Allocator>;
+		/// \brief Handle type
+		using handle_t = coroutine_handle<promise_type>;
+
+		/// \brief Construct from handle
+		//NOLINTNEXTLINE(google-explicit-constructor)
+		shared_task(handle_t hndl) noexcept : m_coro(hndl) {
+			assert(this->m_coro);
+			assert(!this->m_coro.done());
+		}
+
+		/// \brief Construct from nullptr. The resulting task is invalid.
+		explicit shared_task(std::nullptr_t) noexcept : m_coro{} {}
+
+		/// \brief Copy constructor, the copy refers to the same coroutine
+		shared_task(const shared_task& other) noexcept : m_coro{other.m_coro} {
+			if (m_coro) m_coro.promise().add_ref();
+		}
+		/// \brief Move constructor
+		shared_task(shared_task&& other) noexcept : m_coro{std::exchange(other.m_coro, {})} {}
+		/// \brief Copy assignment
+		shared_task& operator=(const shared_task& other) noexcept {
+			if (m_coro != other.m_coro) {
+				if (other.m_coro) other.m_coro.promise().add_ref();
+				reset();
+				m_coro = other.m_coro;
+			}
+			return *this;
+		}
+		/// \brief Move assignment
+		shared_task& operator=(shared_task&& other) noexcept {
+			m_coro = std::exchange(other.m_coro, m_coro);
+			return *this;
+		}
+
+		/// \brief Destructor
+		~shared_task() { reset(); }
+
+		/// \brief Check if the task holds a valid coroutine.
+		explicit operator bool() const noexcept { return m_coro != nullptr; }
+		/// \brief Check if the task does not hold a valid coroutine.
+		bool operator!() const noexcept { return m_coro == nullptr; }
+
+		/// \brief Check if the task has finished and awaiting it would not suspend.
+		[[nodiscard]] bool is_ready() const noexcept { return m_coro && m_coro.promise().is_ready(); }
+
+		/// \brief Operator co_await
+		auto operator co_await() const noexcept {
+			struct awaiter : detail::shared_task_waiter {
+				constexpr explicit awaiter(handle_t coro) : m_coro(coro) {}
+				[[nodiscard]] bool await_ready() const noexcept { return m_coro.promise().is_ready(); }
+				coroutine_handle<> await_suspend(coroutine_handle<> hndl) noexcept {
+					assert(this->m_coro);
+					this->m_handle = hndl;
+					return m_coro.promise().add_waiter(this);
+				}
+				decltype(auto) await_resume() const {
+					assert(this->m_coro);
+					return this->m_coro.promise().get();
+				}
+
+			private:
+				handle_t m_coro;
+			};
+			assert(this->m_coro);
+			return awaiter{m_coro};
+		}
+
+	private:
+		handle_t m_coro;
+
+		void reset() noexcept {
+			if (m_coro && m_coro.promise().release()) m_coro.destroy();
+			m_coro = nullptr;
+		}
+	};
+} // namespace asyncpp
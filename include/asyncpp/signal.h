@@ -1,13 +1,21 @@
 #pragma once
 #include <asyncpp/ref.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <shared_mutex>
+#include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace asyncpp {
 	struct signal_traits_mt {
@@ -23,43 +31,73 @@ namespace asyncpp {
 		using mutex_type = noop_mutex;
 		using refcount_type = thread_unsafe_refcount;
 	};
+	/**
+	 * \brief Traits for a multi threaded signal whose emission never takes a lock.
+	 *
+	 * Emitting walks an immutable snapshot of the connected slots, while connecting and removing slots copies the
+	 * snapshot and publishes the new one. This makes emission wait-free at the cost of more expensive modifications.
+	 */
+	struct signal_traits_rcu {
+		using mutex_type = std::mutex;
+		using refcount_type = thread_safe_refcount;
+	};
+	/**
+	 * \brief Traits for a single threaded signal storing its slots contiguously instead of in a linked list.
+	 *
+	 * Small callables are stored inline and invoked through a function pointer, which turns emission into a linear
+	 * scan over an array. Like signal_traits_st this is not thread safe.
+	 */
+	struct signal_traits_flat {
+		using mutex_type = signal_traits_st::noop_mutex;
+		using refcount_type = thread_unsafe_refcount;
+	};
 
 	template<typename, typename = signal_traits_mt>
 	class signal;
 
 	namespace detail {
+		static constexpr size_t signal_removed_counter = 0;
 		struct signal_node_base : intrusive_refcount<signal_node_base> {
 			virtual ~signal_node_base() noexcept = default;
+			/**
+			 * \brief Disconnect the slot referenced by a handle.
+			 * \param slot Slot id stored in the handle, only used by signals sharing one node between all slots
+			 */
+			virtual void disconnect([[maybe_unused]] std::uint64_t slot) noexcept { counter = signal_removed_counter; }
+			/// \brief Check if the slot referenced by a handle is still connected
+			[[nodiscard]] virtual bool connected([[maybe_unused]] std::uint64_t slot) const noexcept {
+				return counter != signal_removed_counter;
+			}
 			std::atomic<size_t> counter;
 		};
-		static constexpr size_t signal_removed_counter = 0;
 	} // namespace detail
 
 	class signal_handle {
 		ref<detail::signal_node_base> m_node;
+		std::uint64_t m_slot{};
 		template<typename, typename>
 		friend class signal;
 
 	public:
-		explicit signal_handle(ref<detail::signal_node_base> hndl = {}) : m_node(std::move(hndl)) {}
+		explicit signal_handle(ref<detail::signal_node_base> hndl = {}, std::uint64_t slot = 0)
+			: m_node(std::move(hndl)), m_slot(slot) {}
 		explicit operator bool() const noexcept { return valid(); }
 		[[nodiscard]] bool operator!() const noexcept { return !valid(); }
-		[[nodiscard]] bool valid() const noexcept {
-			return m_node && m_node->counter != detail::signal_removed_counter;
-		}
+		[[nodiscard]] bool valid() const noexcept { return m_node && m_node->connected(m_slot); }
 		void disconnect() noexcept {
-			if (m_node) m_node->counter = detail::signal_removed_counter;
+			if (m_node) m_node->disconnect(m_slot);
 			m_node.reset();
 		}
 
 		friend inline constexpr auto operator<=>(const signal_handle& lhs, const signal_handle& rhs) noexcept {
-			return lhs.m_node.get() <=> rhs.m_node.get();
+			if (auto res = lhs.m_node.get() <=> rhs.m_node.get(); res != 0) return res;
+			return lhs.m_slot <=> rhs.m_slot;
 		}
 		friend inline constexpr auto operator==(const signal_handle& lhs, const signal_handle& rhs) noexcept {
-			return lhs.m_node.get() == rhs.m_node.get();
+			return lhs.m_node.get() == rhs.m_node.get() && lhs.m_slot == rhs.m_slot;
 		}
 		friend inline constexpr auto operator!=(const signal_handle& lhs, const signal_handle& rhs) noexcept {
-			return lhs.m_node.get() != rhs.m_node.get();
+			return !(lhs == rhs);
 		}
 	};
 
@@ -177,16 +215,620 @@ namespace asyncpp {
 		}
 	};
 
+	/**
+	 * \brief Signal with a lock-free and wait-free emission path, see signal_traits_rcu.
+	 *
+	 * The connected slots are stored in an immutable snapshot. Emitting acquires a reference to the current snapshot
+	 * and invokes all slots in it, modifications build a new snapshot and swap it in. Snapshots are reclaimed using
+	 * a split reference count: the pointer in m_snapshot carries the number of emissions that acquired it in its
+	 * upper bits, which gets transferred to the snapshot once it is replaced. This way emitting only needs a single
+	 * fetch_add to acquire the snapshot and a single fetch_sub to release it. Slots removed while an emission is in
+	 * progress are skipped by it, slots added are not invoked until the next emission.
+	 */
+	template<typename... TParams>
+	class signal<void(TParams...), signal_traits_rcu> {
+		struct node : detail::signal_node_base {
+			~node() noexcept override = default;
+			virtual void invoke(const TParams&...) = 0;
+		};
+		template<typename FN>
+		struct node_impl final : node {
+			~node_impl() noexcept = default;
+			void invoke(const TParams&... params) override { m_fn(params...); }
+			[[no_unique_address]] FN m_fn;
+			template<typename T>
+			explicit node_impl(T&& fncb) : m_fn(std::forward<T>(fncb)) {}
+		};
+
+		static_assert(sizeof(std::uintptr_t) == 8, "rcu signals require 64bit pointers");
+		static constexpr std::uintptr_t count_shift = 48;
+		static constexpr std::uintptr_t count_unit = std::uintptr_t{1} << count_shift;
+		static constexpr std::uintptr_t pointer_mask = count_unit - 1;
+		// Emissions move their acquired counts into the snapshot once this many piled up, preventing an overflow
+		static constexpr std::uintptr_t renormalize_threshold = std::uintptr_t{1} << 14;
+		// Held by the signal as long as the snapshot is current, keeps early releases from reaching zero
+		static constexpr std::intptr_t snapshot_bias = std::intptr_t{1} << 60;
+
+		struct snapshot {
+			std::atomic<std::intptr_t> refs{snapshot_bias};
+			std::vector<ref<node>> nodes;
+		};
+
+	public:
+		using traits_type = signal_traits_rcu;
+		using handle = signal_handle;
+
+		signal() = default;
+		~signal() { retire(m_snapshot.load(std::memory_order::acquire)); }
+		signal(const signal&) = delete;
+		//NOLINTNEXTLINE(performance-noexcept-move-constructor)
+		signal(signal&& other) {
+			std::scoped_lock lck{m_mutex, other.m_mutex};
+			m_snapshot.store(other.m_snapshot.exchange(0, std::memory_order::acq_rel), std::memory_order::release);
+		}
+		signal& operator=(const signal&) = delete;
+		//NOLINTNEXTLINE(performance-noexcept-move-constructor)
+		signal& operator=(signal&& other) {
+			std::scoped_lock lck{m_mutex, other.m_mutex};
+			retire(m_snapshot.exchange(other.m_snapshot.exchange(0, std::memory_order::acq_rel),
+									   std::memory_order::acq_rel));
+			return *this;
+		}
+
+		[[nodiscard]] size_t size() const noexcept {
+			std::lock_guard lck{m_mutex};
+			size_t res = 0;
+			if (auto snap = current(); snap != nullptr) {
+				for (auto& e : snap->nodes) {
+					if (e->counter != detail::signal_removed_counter) res++;
+				}
+			}
+			return res;
+		}
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		template<typename FN>
+		handle append(FN&& fncb) {
+			return insert(std::forward<FN>(fncb), false);
+		}
+		template<typename FN>
+		handle prepend(FN&& fncb) {
+			return insert(std::forward<FN>(fncb), true);
+		}
+
+		bool remove(const handle& hdl) {
+			auto node = static_ref_cast<signal::node>(hdl.m_node);
+			if (!node) return false;
+			node->counter = detail::signal_removed_counter;
+			std::lock_guard lck{m_mutex};
+			// Publishing a new snapshot also drops all other slots disconnected through their handle
+			publish(copy_live_nodes(0));
+			return true;
+		}
+
+		[[nodiscard]] bool owns_handle(const handle& hdl) const {
+			auto node = static_ref_cast<signal::node>(hdl.m_node);
+			if (!node || node->counter == detail::signal_removed_counter) return false;
+			std::lock_guard lck{m_mutex};
+			auto snap = current();
+			if (snap == nullptr) return false;
+			for (auto& e : snap->nodes) {
+				if (e == node) return true;
+			}
+			return false;
+		}
+
+		size_t operator()(const TParams&... params) const {
+			const auto state = m_snapshot.fetch_add(count_unit, std::memory_order::acquire);
+			// NOLINTNEXTLINE(performance-no-int-to-ptr)
+			auto snap = reinterpret_cast<snapshot*>(state & pointer_mask);
+			// The counter in a null state is never looked at and simply wraps around
+			if (snap == nullptr) return 0;
+			if ((state >> count_shift) + 1 >= renormalize_threshold) renormalize(snap, state + count_unit);
+
+			struct release_guard {
+				snapshot* snap;
+				~release_guard() {
+					if (snap->refs.fetch_sub(1, std::memory_order::acq_rel) == 1) delete snap;
+				}
+			} guard{snap};
+			size_t ninvoked = 0;
+			for (auto& e : snap->nodes) {
+				if (e->counter == detail::signal_removed_counter) continue;
+				e->invoke(params...);
+				++ninvoked;
+			}
+			return ninvoked;
+		}
+
+		template<typename FN>
+		handle operator+=(FN&& fncb) {
+			return append(std::forward<decltype(fncb)>(fncb));
+		}
+
+		void operator-=(const handle& hdl) { remove(hdl); }
+
+	private:
+		// Serializes modifications, emission never takes it
+		mutable std::mutex m_mutex{};
+		mutable std::atomic<std::uintptr_t> m_snapshot{0};
+
+		// Only valid while holding m_mutex, the signal keeps the current snapshot alive until it publishes a new one
+		[[nodiscard]] snapshot* current() const noexcept {
+			// NOLINTNEXTLINE(performance-no-int-to-ptr)
+			return reinterpret_cast<snapshot*>(m_snapshot.load(std::memory_order::relaxed) & pointer_mask);
+		}
+
+		template<typename FN>
+		handle insert(FN&& fncb, bool front) {
+			ref<node> new_node(new node_impl<std::decay_t<FN>>(std::forward<FN>(fncb)));
+			new_node->counter = 1;
+			std::lock_guard lck{m_mutex};
+			auto snap = copy_live_nodes(1);
+			if (front)
+				snap->nodes.insert(snap->nodes.begin(), new_node);
+			else
+				snap->nodes.push_back(new_node);
+			publish(snap);
+			return handle(static_ref_cast<detail::signal_node_base>(std::move(new_node)));
+		}
+
+		snapshot* copy_live_nodes(size_t extra) const {
+			auto res = new snapshot{};
+			if (auto snap = current(); snap != nullptr) {
+				res->nodes.reserve(snap->nodes.size() + extra);
+				for (auto& e : snap->nodes) {
+					if (e->counter != detail::signal_removed_counter) res->nodes.push_back(e);
+				}
+			}
+			return res;
+		}
+
+		void publish(snapshot* snap) noexcept {
+			const auto ptr = reinterpret_cast<std::uintptr_t>(snap);
+			assert((ptr & ~pointer_mask) == 0);
+			retire(m_snapshot.exchange(ptr, std::memory_order::acq_rel));
+		}
+
+		// Drop the signals reference to a snapshot that is no longer current
+		static void retire(std::uintptr_t state) noexcept {
+			// NOLINTNEXTLINE(performance-no-int-to-ptr)
+			auto snap = reinterpret_cast<snapshot*>(state & pointer_mask);
+			if (snap == nullptr) return;
+			// Transfer the references acquired by emissions and give up the bias
+			const auto diff = static_cast<std::intptr_t>(state >> count_shift) - snapshot_bias;
+			if (snap->refs.fetch_add(diff, std::memory_order::acq_rel) + diff == 0) delete snap;
+		}
+
+		// Move the references acquired by emissions into the snapshot, so the counter in m_snapshot can not overflow
+		void renormalize(snapshot* snap, std::uintptr_t expected) const noexcept {
+			const auto count = static_cast<std::intptr_t>(expected >> count_shift);
+			// Adding first is safe, because we hold a reference ourself, so undoing can not bring it down to zero
+			snap->refs.fetch_add(count, std::memory_order::relaxed);
+			if (!m_snapshot.compare_exchange_strong(expected, expected & pointer_mask, std::memory_order::relaxed,
+													std::memory_order::relaxed))
+				snap->refs.fetch_sub(count, std::memory_order::relaxed);
+		}
+	};
+
+	/**
+	 * \brief Signal storing its slots contiguously, see signal_traits_flat.
+	 *
+	 * Slots live in fixed size blocks of cache line sized entries. Callables small enough are constructed
+	 * inside the entry, larger ones are allocated separately. Every entry holds a plain function pointer to
+	 * invoke the callable, so emitting is a linear scan without virtual calls or pointer chasing. Disconnected
+	 * entries are put on a free list and reused by later connections. This means slots are invoked in the order of
+	 * their entries, which is only the order of connection as long as nothing was disconnected, so there is no
+	 * prepend(). Slots can be connected or disconnected from within an emission. Disconnected slots are destroyed
+	 * once the outermost emission finishes and new ones are only invoked by the next emission.
+	 */
+	template<typename... TParams>
+	class signal<void(TParams...), signal_traits_flat> {
+		static constexpr size_t inline_size = 5 * sizeof(void*);
+		static constexpr size_t block_size = 64;
+		static constexpr std::uint32_t npos = UINT32_MAX;
+
+		struct entry {
+			// nullptr if the entry is free or got disconnected
+			void (*invoke)(void*, const TParams&...){nullptr};
+			// Not nullptr as long as the storage holds a callable
+			void (*destroy)(void*) noexcept {nullptr};
+			std::uint32_t generation{1};
+			std::uint32_t next_free{npos};
+			alignas(void*) std::byte storage[inline_size];
+		};
+
+		// Shared with the handles, so they can disconnect without a reference to the signal
+		struct state final : detail::signal_node_base {
+			std::vector<std::unique_ptr<entry[]>> blocks{};
+			std::uint32_t used{0};
+			std::uint32_t free_head{npos};
+			// Disconnected while an emission was running, linked through next_free
+			std::uint32_t pending_head{npos};
+			size_t live{0};
+			size_t emitting{0};
+
+			state() noexcept { counter = 1; }
+			~state() noexcept override { clear(); }
+
+			entry& at(std::uint32_t idx) const noexcept { return blocks[idx / block_size][idx % block_size]; }
+
+			void disconnect(std::uint64_t slot) noexcept override { remove(slot); }
+			[[nodiscard]] bool connected(std::uint64_t slot) const noexcept override {
+				const auto idx = static_cast<std::uint32_t>(slot);
+				if (idx >= used) return false;
+				auto& e = at(idx);
+				return e.invoke != nullptr && e.generation == static_cast<std::uint32_t>(slot >> 32);
+			}
+
+			template<typename FN>
+			std::uint64_t emplace(FN&& fncb) {
+				using fn_type = std::decay_t<FN>;
+				// Reusing a free entry while emitting could get the new slot invoked by the running emission
+				std::uint32_t idx = npos;
+				if (free_head != npos && emitting == 0) {
+					idx = free_head;
+					free_head = at(idx).next_free;
+				} else {
+					if (used == blocks.size() * block_size) blocks.push_back(std::make_unique<entry[]>(block_size));
+					idx = used++;
+				}
+				auto& e = at(idx);
+				try {
+					if constexpr (sizeof(fn_type) <= inline_size && alignof(fn_type) <= alignof(void*)) {
+						new (e.storage) fn_type(std::forward<FN>(fncb));
+						e.invoke = [](void* ptr, const TParams&... params) {
+							(*std::launder(reinterpret_cast<fn_type*>(ptr)))(params...);
+						};
+						e.destroy = [](void* ptr) noexcept {
+							std::launder(reinterpret_cast<fn_type*>(ptr))->~fn_type();
+						};
+					} else {
+						new (e.storage) fn_type*(new fn_type(std::forward<FN>(fncb)));
+						e.invoke = [](void* ptr, const TParams&... params) {
+							(**std::launder(reinterpret_cast<fn_type**>(ptr)))(params...);
+						};
+						e.destroy = [](void* ptr) noexcept { delete *std::launder(reinterpret_cast<fn_type**>(ptr)); };
+					}
+				} catch (...) {
+					e.next_free = free_head;
+					free_head = idx;
+					throw;
+				}
+				live++;
+				return (static_cast<std::uint64_t>(e.generation) << 32) | idx;
+			}
+
+			bool remove(std::uint64_t slot) noexcept {
+				if (!connected(slot)) return false;
+				const auto idx = static_cast<std::uint32_t>(slot);
+				auto& e = at(idx);
+				e.invoke = nullptr;
+				live--;
+				if (emitting != 0) {
+					// The slot might be running right now, so we can not destroy it yet
+					e.next_free = pending_head;
+					pending_head = idx;
+				} else
+					release(idx);
+				return true;
+			}
+
+			void release(std::uint32_t idx) noexcept {
+				auto& e = at(idx);
+				std::exchange(e.destroy, nullptr)(e.storage);
+				// Invalidate all handles to the old slot, 0 is skipped so a handle never has a slot id of 0
+				if (++e.generation == 0) e.generation = 1;
+				e.next_free = free_head;
+				free_head = idx;
+			}
+
+			void release_pending() noexcept {
+				while (pending_head != npos) {
+					const auto idx = pending_head;
+					pending_head = at(idx).next_free;
+					release(idx);
+				}
+			}
+
+			void clear() noexcept {
+				if (emitting != 0) {
+					// The signal got destroyed by one of its slots, the running emission still needs the blocks
+					for (std::uint32_t i = 0; i < used; i++) {
+						if (at(i).invoke != nullptr) remove((static_cast<std::uint64_t>(at(i).generation) << 32) | i);
+					}
+					return;
+				}
+				for (std::uint32_t i = 0; i < used; i++) {
+					auto& e = at(i);
+					e.invoke = nullptr;
+					if (e.destroy != nullptr) std::exchange(e.destroy, nullptr)(e.storage);
+				}
+				blocks.clear();
+				used = 0;
+				free_head = pending_head = npos;
+				live = 0;
+			}
+		};
+
+	public:
+		using traits_type = signal_traits_flat;
+		using handle = signal_handle;
+
+		signal() = default;
+		~signal() {
+			if (m_state) m_state->clear();
+		}
+		signal(const signal&) = delete;
+		signal(signal&& other) noexcept : m_state(std::exchange(other.m_state, nullptr)) {}
+		signal& operator=(const signal&) = delete;
+		signal& operator=(signal&& other) noexcept {
+			if (m_state) m_state->clear();
+			m_state = std::exchange(other.m_state, nullptr);
+			return *this;
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return m_state ? m_state->live : 0; }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		template<typename FN>
+		handle append(FN&& fncb) {
+			if (!m_state) m_state = make_ref<state>();
+			const auto slot = m_state->emplace(std::forward<FN>(fncb));
+			return handle(static_ref_cast<detail::signal_node_base>(m_state), slot);
+		}
+
+		bool remove(const handle& hdl) noexcept {
+			return m_state && hdl.m_node.get() == m_state.get() && m_state->remove(hdl.m_slot);
+		}
+		[[nodiscard]] bool owns_handle(const handle& hdl) const noexcept {
+			return m_state && hdl.m_node.get() == m_state.get() && m_state->connected(hdl.m_slot);
+		}
+
+		size_t operator()(const TParams&... params) const {
+			if (!m_state) return 0;
+			// Keeps the state alive in case a slot destroys the signal
+			const ref<state> st = m_state;
+			st->emitting++;
+			struct emit_guard {
+				state* st;
+				~emit_guard() {
+					if (--st->emitting == 0) st->release_pending();
+				}
+			} guard{st.get()};
+			// Slots connected while emitting get new entries past the end and are not invoked
+			const auto end = st->used;
+			size_t ninvoked = 0;
+			for (std::uint32_t block = 0; block * block_size < end; block++) {
+				// The block list might grow while invoking, but blocks themselves never move
+				entry* const entries = st->blocks[block].get();
+				const auto count = std::min<std::uint32_t>(block_size, end - block * block_size);
+				for (std::uint32_t i = 0; i < count; i++) {
+					if (entries[i].invoke == nullptr) continue;
+					entries[i].invoke(entries[i].storage, params...);
+					++ninvoked;
+				}
+			}
+			return ninvoked;
+		}
+
+		template<typename FN>
+		handle operator+=(FN&& fncb) {
+			return append(std::forward<decltype(fncb)>(fncb));
+		}
+
+		void operator-=(const handle& hdl) { remove(hdl); }
+
+	private:
+		ref<state> m_state{};
+	};
+
 	template<typename T>
 	using signal_st = signal<T, signal_traits_st>;
 	template<typename T>
 	using signal_mt = signal<T, signal_traits_mt>;
+	template<typename T>
+	using signal_rcu = signal<T, signal_traits_rcu>;
+	template<typename T>
+	using signal_flat = signal<T, signal_traits_flat>;
+
+	/// \brief Lookup mode of a signal_manager keeping its signals in a std::unordered_map behind a std::shared_mutex
+	struct signal_map_locked {};
+	/**
+	 * \brief Lookup mode of a signal_manager that never locks when looking up the signal of an event.
+	 *
+	 * Signals are kept in an open addressing hash table of atomic pointers. Adding a new event takes a lock and
+	 * might publish a bigger table, looking up an event only reads the current table and never writes to shared
+	 * memory. In exchange signals and replaced tables are only freed once the manager is destroyed, so
+	 * shrink_to_fit() does nothing. This suits a set of events that is mostly known after startup. Combined with
+	 * signal_traits_rcu emitting does not lock at all.
+	 */
+	struct signal_map_concurrent {};
+
+	/**
+	 * \brief Number of values of an enum used as event type of a signal_manager.
+	 *
+	 * Specializing this for an enum whose values are 0 to N-1 makes signal_manager store one signal per value in an
+	 * array, so finding the signal of an event needs neither a lock nor a hash lookup.
+	 */
+	template<typename T>
+	inline constexpr size_t signal_event_count = 0;
+
+	namespace detail {
+		template<typename TEventType>
+		concept dense_signal_event = std::is_enum_v<TEventType> && signal_event_count<TEventType> != 0;
+
+		template<typename TEventType, typename TSignal, typename TMap>
+		class signal_map;
+
+		template<typename TEventType, typename TSignal>
+			requires(!dense_signal_event<TEventType>)
+		class signal_map<TEventType, TSignal, signal_map_locked> {
+		public:
+			TSignal& find_or_create(const TEventType& evt) {
+				std::shared_lock lck{m_mutex};
+				auto iter = m_mapping.find(evt);
+				if (iter != m_mapping.end()) return iter->second;
+				lck.unlock();
+				std::unique_lock unique{m_mutex};
+				return m_mapping.try_emplace(evt).first->second;
+			}
+
+			// Invoke fn with the signal of evt or nullptr, shrink_to_fit() can not remove it while fn runs
+			template<typename FN>
+			decltype(auto) visit(const TEventType& evt, FN&& fn) {
+				std::shared_lock lck{m_mutex};
+				auto iter = m_mapping.find(evt);
+				return fn(iter == m_mapping.end() ? nullptr : &iter->second);
+			}
+			template<typename FN>
+			decltype(auto) visit(const TEventType& evt, FN&& fn) const {
+				std::shared_lock lck{m_mutex};
+				auto iter = m_mapping.find(evt);
+				return fn(iter == m_mapping.end() ? nullptr : &iter->second);
+			}
+
+			size_t shrink_to_fit() {
+				std::unique_lock lck{m_mutex};
+				return std::erase_if(m_mapping, [](const auto& e) { return e.second.empty(); });
+			}
+
+		private:
+			mutable std::shared_mutex m_mutex{};
+			std::unordered_map<TEventType, TSignal> m_mapping;
+		};
+
+		template<typename TEventType, typename TSignal>
+			requires(!dense_signal_event<TEventType>)
+		class signal_map<TEventType, TSignal, signal_map_concurrent> {
+			struct entry {
+				const TEventType key;
+				TSignal signal{};
+			};
+			struct table {
+				explicit table(unsigned bits)
+					: shift{64 - bits}, mask{(size_t{1} << bits) - 1}, slots{new std::atomic<entry*>[mask + 1]{}} {}
+				const unsigned shift;
+				const size_t mask;
+				const std::unique_ptr<std::atomic<entry*>[]> slots;
+				// The table this one replaced, emissions might still be probing it
+				std::unique_ptr<table> previous{};
+
+				size_t index_of(const TEventType& evt) const {
+					// Fibonacci hashing spreads the identity hashes of integers and pointers over the whole table
+					return static_cast<size_t>(
+						(static_cast<std::uint64_t>(std::hash<TEventType>{}(evt)) * 0x9E3779B97F4A7C15ull) >> shift);
+				}
+			};
+			static constexpr unsigned initial_bits = 4;
+
+			std::mutex m_mutex{};
+			std::atomic<table*> m_table{nullptr};
+			// Protected by m_mutex
+			size_t m_size{0};
+
+			// Slots are never cleared, so a probe can stop at the first empty one. Tables are at most half full.
+			entry* lookup(const TEventType& evt) const {
+				auto tbl = m_table.load(std::memory_order::acquire);
+				if (tbl == nullptr) return nullptr;
+				for (auto idx = tbl->index_of(evt);; idx = (idx + 1) & tbl->mask) {
+					auto e = tbl->slots[idx].load(std::memory_order::acquire);
+					if (e == nullptr || e->key == evt) return e;
+				}
+			}
+
+			static void place(table& tbl, entry* e) noexcept {
+				auto idx = tbl.index_of(e->key);
+				while (tbl.slots[idx].load(std::memory_order::relaxed) != nullptr)
+					idx = (idx + 1) & tbl.mask;
+				tbl.slots[idx].store(e, std::memory_order::release);
+			}
+
+		public:
+			signal_map() = default;
+			~signal_map() {
+				std::unique_ptr<table> tbl{m_table.load(std::memory_order::acquire)};
+				if (tbl == nullptr) return;
+				for (size_t i = 0; i <= tbl->mask; i++)
+					delete tbl->slots[i].load(std::memory_order::relaxed);
+			}
+			signal_map(const signal_map&) = delete;
+			signal_map& operator=(const signal_map&) = delete;
+
+			TSignal& find_or_create(const TEventType& evt) {
+				if (auto e = lookup(evt); e != nullptr) return e->signal;
+				std::unique_lock lck{m_mutex};
+				if (auto e = lookup(evt); e != nullptr) return e->signal;
+				auto tbl = m_table.load(std::memory_order::relaxed);
+				if (tbl == nullptr || (m_size + 1) * 2 > tbl->mask + 1) {
+					auto grown = std::make_unique<table>(tbl == nullptr ? initial_bits : 65 - tbl->shift);
+					if (tbl != nullptr) {
+						for (size_t i = 0; i <= tbl->mask; i++) {
+							if (auto e = tbl->slots[i].load(std::memory_order::relaxed)) place(*grown, e);
+						}
+					}
+					grown->previous.reset(tbl);
+					tbl = grown.release();
+					m_table.store(tbl, std::memory_order::release);
+				}
+				auto e = new entry{evt};
+				place(*tbl, e);
+				m_size++;
+				return e->signal;
+			}
+
+			template<typename FN>
+			decltype(auto) visit(const TEventType& evt, FN&& fn) const {
+				auto e = lookup(evt);
+				return fn(e == nullptr ? nullptr : &e->signal);
+			}
+
+			// Entries can not be freed while emissions might be using them
+			constexpr size_t shrink_to_fit() const noexcept { return 0; }
+		};
 
-	template<typename, typename, typename = signal_traits_mt>
+		template<typename TEventType, typename TSignal, typename TMap>
+			requires dense_signal_event<TEventType>
+		class signal_map<TEventType, TSignal, TMap> {
+			static constexpr auto index_of(TEventType evt) noexcept {
+				return static_cast<std::make_unsigned_t<std::underlying_type_t<TEventType>>>(evt);
+			}
+			static constexpr bool contains(TEventType evt) noexcept {
+				return index_of(evt) < signal_event_count<TEventType>;
+			}
+
+			std::array<TSignal, signal_event_count<TEventType>> m_signals{};
+
+		public:
+			TSignal& find_or_create(TEventType evt) {
+				if (!contains(evt)) throw std::out_of_range("event is outside of signal_event_count");
+				return m_signals[index_of(evt)];
+			}
+
+			template<typename FN>
+			decltype(auto) visit(TEventType evt, FN&& fn) {
+				return fn(contains(evt) ? &m_signals[index_of(evt)] : nullptr);
+			}
+			template<typename FN>
+			decltype(auto) visit(TEventType evt, FN&& fn) const {
+				return fn(contains(evt) ? &m_signals[index_of(evt)] : nullptr);
+			}
+
+			constexpr size_t shrink_to_fit() const noexcept { return 0; }
+		};
+	} // namespace detail
+
+	template<typename, typename, typename = signal_traits_mt, typename = signal_map_locked>
 	class signal_manager;
 
-	template<typename TEventType, typename... TParams, typename TTraits>
-	class signal_manager<TEventType, void(TParams...), TTraits> {
+	/**
+	 * \brief A set of signals, one per event.
+	 *
+	 * TMap selects how the signal of an event is found, see signal_map_locked and signal_map_concurrent. Enums that
+	 * specialize signal_event_count always use an array indexed by the event instead.
+	 */
+	template<typename TEventType, typename... TParams, typename TTraits, typename TMap>
+	class signal_manager<TEventType, void(TParams...), TTraits, TMap> {
 	public:
 		using event_type = TEventType;
 		using signal_type = signal<void(TParams...), TTraits>;
@@ -203,67 +845,35 @@ namespace asyncpp {
 
 		template<typename FN>
 		handle append(event_type event, FN&& fncb) {
-			auto iter = find_or_create_slot(event);
-			assert(iter != m_mapping.end());
-			return iter->second.append(std::forward<decltype(fncb)>(fncb));
+			return m_mapping.find_or_create(event).append(std::forward<decltype(fncb)>(fncb));
 		}
 		template<typename FN>
 		handle prepend(event_type event, FN&& fncb) {
-			auto iter = find_or_create_slot(event);
-			assert(iter != m_mapping.end());
-			return iter->second.prepend(std::forward<decltype(fncb)>(fncb));
+			return m_mapping.find_or_create(event).prepend(std::forward<decltype(fncb)>(fncb));
 		}
 
 		bool remove(event_type event, const handle& hdl) {
-			std::shared_lock lck{m_mutex};
-			auto iter = m_mapping.find(event);
-			return iter != m_mapping.end() && iter->second.remove(hdl);
+			return m_mapping.visit(event, [&](auto* sig) { return sig != nullptr && sig->remove(hdl); });
 		}
 
 		bool owns_handle(event_type event, const handle& hdl) const {
-			std::shared_lock lck{m_mutex};
-			auto iter = m_mapping.find(event);
-			return iter != m_mapping.end() && iter->second.owns_handle(hdl);
+			return m_mapping.visit(event, [&](auto* sig) { return sig != nullptr && sig->owns_handle(hdl); });
 		}
 
 		size_t invoke(event_type event, const TParams&... params) const {
-			std::shared_lock lck{m_mutex};
-			auto iter = m_mapping.find(event);
-			if (iter == m_mapping.end()) return 0;
-			return iter->second(params...);
+			return m_mapping.visit(event, [&](auto* sig) -> size_t { return sig == nullptr ? 0 : (*sig)(params...); });
 		}
 
 		size_t operator()(event_type event, const TParams&... params) const { return invoke(event, params...); }
 
-		size_t shrink_to_fit() {
-			std::unique_lock lck{m_mutex};
-			size_t res = 0;
-			for (auto it = m_mapping.begin(); it != m_mapping.end();) {
-				if (it->second.empty()) {
-					res++;
-					it = m_mapping.erase(it);
-				} else
-					it++;
-			}
-			return res;
-		}
+		/**
+		 * \brief Drop the signals of events that have no slots connected.
+		 * \return The number of signals dropped, always 0 for signal_map_concurrent and enums using an array
+		 */
+		size_t shrink_to_fit() { return m_mapping.shrink_to_fit(); }
 
 	private:
-		mutable std::shared_mutex m_mutex{};
-		std::unordered_map<event_type, signal_type> m_mapping;
-
-		auto find_or_create_slot(event_type evt) {
-			std::shared_lock lck{m_mutex};
-			auto iter = m_mapping.find(evt);
-			if (iter == m_mapping.end()) {
-				lck.unlock();
-				std::unique_lock unique{m_mutex};
-				iter = m_mapping.find(evt);
-				if (iter != m_mapping.end()) return iter;
-				iter = m_mapping.emplace(evt, signal_type{}).first;
-			}
-			return iter;
-		}
+		detail::signal_map<event_type, signal_type, TMap> m_mapping;
 	};
 
 	template<typename... TParams, typename TTraits>
@@ -282,10 +892,10 @@ namespace asyncpp {
 		auto node = m_head;
 		m_head.reset();
 		while (node) {
-			auto next = node->next;
+			// Moving the links out avoids touching the reference counts
+			auto next = std::move(node->next);
 			node->previous = nullptr;
-			node->next.reset();
-			node = next;
+			node = std::move(next);
 		}
 		assert(!node);
 		m_head = std::exchange(other.m_head, nullptr);
@@ -298,10 +908,10 @@ namespace asyncpp {
 		auto node = m_head;
 		m_head.reset();
 		while (node) {
-			auto next = node->next;
+			// Moving the links out avoids touching the reference counts
+			auto next = std::move(node->next);
 			node->previous = nullptr;
-			node->next.reset();
-			node = next;
+			node = std::move(next);
 		}
 		assert(!node);
 	}
@@ -331,7 +941,7 @@ namespace asyncpp {
 			m_head = new_node;
 			m_tail = new_node.get();
 		}
-		return handle(static_ref_cast<detail::signal_node_base>(new_node));
+		return handle(static_ref_cast<detail::signal_node_base>(std::move(new_node)));
 	}
 
 	template<typename... TParams, typename TTraits>
@@ -345,9 +955,9 @@ namespace asyncpp {
 			m_head = new_node;
 		} else {
 			m_head = new_node;
-			m_tail = new_node;
+			m_tail = new_node.get();
 		}
-		return handle(static_ref_cast<detail::signal_node_base>(new_node));
+		return handle(static_ref_cast<detail::signal_node_base>(std::move(new_node)));
 	}
 
 	template<typename... TParams, typename TTraits>
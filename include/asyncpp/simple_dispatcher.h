@@ -1,38 +1,129 @@
 #pragma once
 #include <asyncpp/dispatcher.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace asyncpp {
+	/**
+	 * \brief Queueing strategy used by simple_dispatcher
+	 */
+	enum class simple_dispatcher_mode {
+		/// \brief All callbacks go through one mutex protected queue
+		locked,
+		/// \brief Callbacks pushed from the dispatcher thread go to an unsynchronized ring buffer, while other threads
+		/// push to a lock-free inbox. The loop only blocks (using a futex) if both are empty.
+		inline_fast_path,
+	};
 
 	/**
      * \brief A very basic dispatcher that runs in a single thread until manually stopped.
+     *
+     * Using simple_dispatcher_mode::inline_fast_path the loop does not take any locks. Pushes from the thread
+     * running the dispatcher, which are the majority for single threaded services, are appended to a local ring
+     * buffer. Pushes from other threads are prepended to an intrusive lock-free list, which the loop takes over
+     * as a whole and appends to the ring buffer in order. If the loop runs out of work it waits on an atomic,
+     * which is only notified if the loop actually announced it is going to sleep.
      */
 	class simple_dispatcher : public dispatcher {
+		struct inbox_node {
+			std::function<void()> cbfn;
+			inbox_node* next{nullptr};
+		};
+
 		std::mutex m_mtx;
 		std::condition_variable m_cv;
 		std::deque<std::function<void()>> m_queue;
 		std::atomic<bool> m_done = false;
 
+		// Only used with simple_dispatcher_mode::inline_fast_path
+		const simple_dispatcher_mode m_mode{simple_dispatcher_mode::locked};
+		// Ring buffer for pushes from the dispatcher thread, the capacity is always a power of two. Loop thread only.
+		std::vector<std::function<void()>> m_ring{};
+		size_t m_ring_head{0};
+		size_t m_ring_size{0};
+		// Pushes from other threads, the newest node is at the front
+		std::atomic<inbox_node*> m_inbox{nullptr};
+		std::atomic<bool> m_sleeping{false};
+		// Bumped to wake up the loop, which waits for it to change
+		std::atomic<std::uint32_t> m_wake_epoch{0};
+
 	public:
+		simple_dispatcher() = default;
+		/**
+		 * \brief Construct a dispatcher using the given queueing strategy
+		 * \param mode The strategy, see simple_dispatcher_mode
+		 */
+		explicit simple_dispatcher(simple_dispatcher_mode mode) : m_mode{mode} {}
+		~simple_dispatcher() {
+			auto node = m_inbox.exchange(nullptr, std::memory_order::acquire);
+			while (node != nullptr)
+				delete std::exchange(node, node->next);
+		}
+		simple_dispatcher(const simple_dispatcher&) = delete;
+		simple_dispatcher& operator=(const simple_dispatcher&) = delete;
+
 		/**
 		 * \brief Push a function to be executed on the dispatcher.
 		 * \param cbfn The callback
 		 */
 		void push(std::function<void()> cbfn) override {
 			if (!cbfn) return;
+			if (m_mode == simple_dispatcher_mode::inline_fast_path) return push_fast(std::move(cbfn));
 			std::unique_lock lck{m_mtx};
 			m_queue.emplace_back(std::move(cbfn));
-			m_cv.notify_all();
+			// Nobody is waiting if we are running on the dispatcher ourselves
+			if (dispatcher::current() != this) m_cv.notify_all();
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed on the dispatcher.
+		 * \param hndl The coroutine to resume
+		 */
+		void push_resume(coroutine_handle<> hndl) override {
+			if (!hndl) return;
+			// coroutine_handle is trivially copyable and small enough to be stored without allocation
+			if (m_mode == simple_dispatcher_mode::inline_fast_path) return push_fast(hndl);
+			std::unique_lock lck{m_mtx};
+			m_queue.emplace_back(hndl);
+			if (dispatcher::current() != this) m_cv.notify_all();
+		}
+
+		/**
+		 * \brief Push multiple coroutines to be resumed on the dispatcher, taking the lock only once.
+		 * \param hndls The coroutines to resume
+		 */
+		void push_resume_batch(std::span<const coroutine_handle<>> hndls) override {
+			if (m_mode == simple_dispatcher_mode::inline_fast_path) {
+				for (auto hndl : hndls) {
+					if (hndl) push_fast(hndl);
+				}
+				return;
+			}
+			std::unique_lock lck{m_mtx};
+			for (auto hndl : hndls) {
+				if (hndl) m_queue.emplace_back(hndl);
+			}
+			if (dispatcher::current() != this) m_cv.notify_all();
 		}
 
 		/**
          * \brief Stop the dispatcher. It will return the on the next iteration, regardless if there is any work left.
          */
 		void stop() noexcept {
+			if (m_mode == simple_dispatcher_mode::inline_fast_path) {
+				m_done = true;
+				wake();
+				return;
+			}
 			std::unique_lock lck{m_mtx};
 			m_done = true;
 			m_cv.notify_all();
@@ -41,12 +132,30 @@ namespace asyncpp {
 		/**
          * \brief Block and process tasks pushed to it until stop is called.
          */
-		void run() {
+		void run() { run_until(m_done); }
+
+		/**
+		 * \brief Block and process tasks pushed to it until the flag is set.
+		 *
+		 * The flag is only checked between callbacks, so it needs to be set by a callback running on this dispatcher.
+		 * Calling stop() does not end the loop, it only makes the next call to run() return right away. This way
+		 * code waiting for the flag can rely on it being set once this returns.
+		 * \param flag The flag ending the loop once it is true
+		 * \param first Optional coroutine resumed on this dispatcher before anything else
+		 */
+		void run_until(const std::atomic<bool>& flag, coroutine_handle<> first = {}) {
 			dispatcher* const old_dispatcher = dispatcher::current(this);
-			while (!m_done) {
+			if (first) first.resume();
+			if (m_mode == simple_dispatcher_mode::inline_fast_path) {
+				run_fast(flag);
+				dispatcher::current(old_dispatcher);
+				return;
+			}
+			while (!flag.load(std::memory_order::relaxed)) {
 				std::unique_lock lck{m_mtx};
 				if (m_queue.empty()) {
-					m_cv.wait(lck);
+					// stop() sets m_done while holding the lock, checking again avoids missing its notification
+					if (!flag.load(std::memory_order::relaxed)) m_cv.wait(lck);
 					continue;
 				}
 				auto cbfn = std::move(m_queue.front());
@@ -56,5 +165,68 @@ namespace asyncpp {
 			}
 			dispatcher::current(old_dispatcher);
 		}
+
+	private:
+		void push_fast(std::function<void()> cbfn) {
+			if (dispatcher::current() == this) return ring_push(std::move(cbfn));
+			auto node = new inbox_node{std::move(cbfn)};
+			node->next = m_inbox.load(std::memory_order::relaxed);
+			while (!m_inbox.compare_exchange_weak(node->next, node, std::memory_order::seq_cst,
+												  std::memory_order::relaxed)) {}
+			// Pairs with the store in run_fast(). Either we see the loop going to sleep or it sees our node.
+			if (m_sleeping.load(std::memory_order::seq_cst)) wake();
+		}
+
+		void wake() noexcept {
+			m_wake_epoch.fetch_add(1, std::memory_order::release);
+			m_wake_epoch.notify_one();
+		}
+
+		void ring_push(std::function<void()> cbfn) {
+			if (m_ring_size == m_ring.size()) {
+				std::vector<std::function<void()>> ring(std::max<size_t>(16, m_ring.size() * 2));
+				for (size_t i = 0; i < m_ring_size; i++)
+					ring[i] = std::move(m_ring[(m_ring_head + i) & (m_ring.size() - 1)]);
+				m_ring.swap(ring);
+				m_ring_head = 0;
+			}
+			m_ring[(m_ring_head + m_ring_size) & (m_ring.size() - 1)] = std::move(cbfn);
+			m_ring_size++;
+		}
+
+		// Move everything pushed from other threads to the ring buffer, oldest first
+		void drain_inbox() {
+			auto node = m_inbox.exchange(nullptr, std::memory_order::acquire);
+			// The list is newest first, reverse it to keep the order of the pushes
+			inbox_node* oldest = nullptr;
+			while (node != nullptr) {
+				auto next = node->next;
+				node->next = oldest;
+				oldest = node;
+				node = next;
+			}
+			while (oldest != nullptr) {
+				std::unique_ptr<inbox_node> current{std::exchange(oldest, oldest->next)};
+				ring_push(std::move(current->cbfn));
+			}
+		}
+
+		void run_fast(const std::atomic<bool>& flag) {
+			while (!flag.load(std::memory_order::relaxed)) {
+				if (m_inbox.load(std::memory_order::relaxed) != nullptr) drain_inbox();
+				if (m_ring_size != 0) {
+					auto cbfn = std::move(m_ring[m_ring_head]);
+					m_ring_head = (m_ring_head + 1) & (m_ring.size() - 1);
+					m_ring_size--;
+					cbfn();
+					continue;
+				}
+				const auto epoch = m_wake_epoch.load(std::memory_order::acquire);
+				m_sleeping.store(true, std::memory_order::seq_cst);
+				if (m_inbox.load(std::memory_order::seq_cst) == nullptr && !flag.load(std::memory_order::relaxed))
+					m_wake_epoch.wait(epoch);
+				m_sleeping.store(false, std::memory_order::relaxed);
+			}
+		}
 	};
 } // namespace asyncpp
@@ -11,7 +11,10 @@
 #include <version>
 #if defined(_LIBCPP_VERSION) || ASYNCPP_FORCE_CUSTOM_STOP_TOKEN
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <thread>
+#include <utility>
 #else
 #include <stop_token>
 #endif
@@ -58,24 +61,20 @@ namespace asyncpp {
 		template<typename _Callback>
 		friend class stop_callback;
 
-		static void yield() noexcept {
-#if defined __i386__ || defined __x86_64__
-			__builtin_ia32_pause();
-#endif
-			std::this_thread::yield();
-		}
-
 		struct binary_semaphore {
 			explicit binary_semaphore(int initial) : m_counter(initial > 0) {}
 
-			void release() { m_counter.fetch_add(1, std::memory_order::release); }
+			void release() {
+				m_counter.fetch_add(1, std::memory_order::release);
+				m_counter.notify_one();
+			}
 
 			void acquire() {
 				int old = 1;
 				while (
 					!m_counter.compare_exchange_weak(old, 0, std::memory_order::acquire, std::memory_order::relaxed)) {
+					if (old == 0) m_counter.wait(0, std::memory_order::relaxed);
 					old = 1;
-					yield();
 				}
 			}
 
@@ -85,8 +84,8 @@ namespace asyncpp {
 		struct stop_cb_node_t {
 			using cb_fn_t = void(stop_cb_node_t*) noexcept;
 			cb_fn_t* m_callback;
-			stop_cb_node_t* m_prev = nullptr;
-			stop_cb_node_t* m_next = nullptr;
+			// The slot this callback is registered in
+			std::atomic<stop_cb_node_t*>* m_slot = nullptr;
 			bool* m_destroyed = nullptr;
 			binary_semaphore m_done{0};
 
@@ -95,21 +94,92 @@ namespace asyncpp {
 			void run() noexcept { m_callback(this); }
 		};
 
+		/*
+		 * Callbacks are stored in slots instead of a linked list. Registering claims a free slot using a single
+		 * compare exchange and removing clears it again, so neither needs a lock. The first slots are part of the
+		 * state itself, more are added in chunks if they are all taken. Chunks are only freed with the state.
+		 * request_stop() sets the stop bit and then empties every slot using exchange. Registration claims the slot
+		 * before checking the stop bit, so either the callback is seen by request_stop() or the stop bit is seen
+		 * by the registration.
+		 */
 		class stop_state_t {
 			using value_type = uint32_t;
 			static constexpr value_type mask_stop_requested_bit = 1;
-			static constexpr value_type mask_locked_bit = 2;
-			static constexpr value_type mask_ssrc_counter_inc = 4;
+			static constexpr value_type mask_ssrc_counter_inc = 2;
+			static constexpr size_t inline_slots = 8;
+			static constexpr size_t chunk_slots = 32;
+
+			struct slot_chunk {
+				std::atomic<stop_cb_node_t*> slots[chunk_slots]{};
+				std::atomic<slot_chunk*> next{nullptr};
+			};
 
 			std::atomic<value_type> m_owners{1};
 			std::atomic<value_type> m_value{mask_ssrc_counter_inc};
-			stop_cb_node_t* m_head = nullptr;
-			std::thread::id m_requester;
+			std::atomic<stop_cb_node_t*> m_inline[inline_slots]{};
+			std::atomic<slot_chunk*> m_chunks{nullptr};
+			// Last slot that was freed, registration tries it first
+			std::atomic<std::atomic<stop_cb_node_t*>*> m_free_hint{nullptr};
+			std::atomic<std::thread::id> m_requester{};
+
+			template<typename Fn>
+			bool for_each_slot(Fn&& fn) noexcept {
+				for (auto& e : m_inline) {
+					if (fn(e)) return true;
+				}
+				// seq_cst, request_stop() needs to see chunks appended before it set the stop bit
+				for (auto chunk = m_chunks.load(std::memory_order::seq_cst); chunk != nullptr;
+					 chunk = chunk->next.load(std::memory_order::seq_cst)) {
+					for (auto& e : chunk->slots) {
+						if (fn(e)) return true;
+					}
+				}
+				return false;
+			}
+
+			static bool try_claim(std::atomic<stop_cb_node_t*>& slot, stop_cb_node_t* cb) noexcept {
+				stop_cb_node_t* expected = nullptr;
+				if (slot.load(std::memory_order::relaxed) != nullptr ||
+					!slot.compare_exchange_strong(expected, cb, std::memory_order::seq_cst))
+					return false;
+				cb->m_slot = &slot;
+				return true;
+			}
+
+			// Allocation free, returns false if every slot is taken
+			bool try_claim_slot(stop_cb_node_t* cb) noexcept {
+				auto hint = m_free_hint.exchange(nullptr, std::memory_order::relaxed);
+				if (hint != nullptr && try_claim(*hint, cb)) return true;
+				return for_each_slot([cb](std::atomic<stop_cb_node_t*>& e) { return try_claim(e, cb); });
+			}
+
+			// Append a new chunk with cb in its first slot, throws std::bad_alloc if it can not be allocated
+			void append_chunk(stop_cb_node_t* cb) {
+				auto chunk = new slot_chunk();
+				chunk->slots[0].store(cb, std::memory_order::relaxed);
+				cb->m_slot = &chunk->slots[0];
+				auto link = &m_chunks;
+				slot_chunk* expected = nullptr;
+				while (!link->compare_exchange_weak(expected, chunk, std::memory_order::seq_cst,
+													std::memory_order::acquire)) {
+					if (expected != nullptr) {
+						link = &expected->next;
+						expected = nullptr;
+					}
+				}
+			}
 
 		public:
 			stop_state_t() = default;
+			~stop_state_t() {
+				auto chunk = m_chunks.load(std::memory_order::acquire);
+				while (chunk != nullptr)
+					delete std::exchange(chunk, chunk->next.load(std::memory_order::relaxed));
+			}
+			stop_state_t(const stop_state_t&) = delete;
+			stop_state_t& operator=(const stop_state_t&) = delete;
 
-			bool stop_possible() noexcept { return m_value.load(std::memory_order::acquire) & ~mask_locked_bit; }
+			bool stop_possible() noexcept { return m_value.load(std::memory_order::acquire) != 0; }
 
 			bool stop_requested() noexcept {
 				return m_value.load(std::memory_order::acquire) & mask_stop_requested_bit;
@@ -126,25 +196,13 @@ namespace asyncpp {
 			void sub_ssrc() noexcept { m_value.fetch_sub(mask_ssrc_counter_inc, std::memory_order::release); }
 
 			bool request_stop() noexcept {
-				auto old = m_value.load(std::memory_order::acquire);
-				do {
-					if (old & mask_stop_requested_bit) return false;
-				} while (
-					!try_lock(old, mask_stop_requested_bit, std::memory_order::acq_rel, std::memory_order::acquire));
-
-				m_requester = std::this_thread::get_id();
-
-				while (m_head) {
-					bool is_last_cb{true};
-					stop_cb_node_t* cb = m_head;
-					m_head = m_head->m_next;
-					if (m_head) {
-						m_head->m_prev = nullptr;
-						is_last_cb = false;
-					}
-
-					unlock();
-
+				if (m_value.fetch_or(mask_stop_requested_bit, std::memory_order::seq_cst) & mask_stop_requested_bit)
+					return false;
+				m_requester.store(std::this_thread::get_id(), std::memory_order::relaxed);
+				for_each_slot([this](std::atomic<stop_cb_node_t*>& e) {
+					if (e.load(std::memory_order::seq_cst) == nullptr) return false;
+					auto cb = e.exchange(nullptr, std::memory_order::seq_cst);
+					if (cb == nullptr) return false;
 					bool is_destroyed = false;
 					cb->m_destroyed = &is_destroyed;
 
@@ -154,77 +212,47 @@ namespace asyncpp {
 						cb->m_destroyed = nullptr;
 						cb->m_done.release();
 					}
-
-					if (is_last_cb) return true;
-
-					lock();
-				}
-
-				unlock();
+					return false;
+				});
 				return true;
 			}
 
-			bool register_callback(stop_cb_node_t* cb) noexcept {
+			bool register_callback(stop_cb_node_t* cb) {
 				auto old = m_value.load(std::memory_order::acquire);
-				do {
-					if (old & mask_stop_requested_bit) {
+				if (old & mask_stop_requested_bit) {
+					cb->run();
+					return false;
+				}
+				if (old < mask_ssrc_counter_inc) return false;
+
+				if (!try_claim_slot(cb)) append_chunk(cb);
+				if (m_value.load(std::memory_order::seq_cst) & mask_stop_requested_bit) {
+					// If we get the slot back request_stop() did not see us
+					auto expected = cb;
+					if (cb->m_slot->compare_exchange_strong(expected, nullptr, std::memory_order::acq_rel)) {
 						cb->run();
 						return false;
 					}
-
-					if (old < mask_ssrc_counter_inc) return false;
-				} while (!try_lock(old, 0, std::memory_order::acquire, std::memory_order::acquire));
-
-				cb->m_next = m_head;
-				if (m_head) { m_head->m_prev = cb; }
-				m_head = cb;
-				unlock();
+				}
 				return true;
 			}
 
 			void remove_callback(stop_cb_node_t* cb) {
-				lock();
-
-				if (cb == m_head) {
-					m_head = m_head->m_next;
-					if (m_head) m_head->m_prev = nullptr;
-					unlock();
-					return;
-				} else if (cb->m_prev) {
-					cb->m_prev->m_next = cb->m_next;
-					if (cb->m_next) cb->m_next->m_prev = cb->m_prev;
-					unlock();
+				auto expected = cb;
+				if (cb->m_slot->compare_exchange_strong(expected, nullptr, std::memory_order::acq_rel,
+														std::memory_order::acquire)) {
+					m_free_hint.store(cb->m_slot, std::memory_order::relaxed);
 					return;
 				}
 
-				unlock();
-
-				if (!(m_requester == std::this_thread::get_id())) {
+				// request_stop() took the callback, wait until it finished running unless we are called from it
+				if (m_requester.load(std::memory_order::relaxed) != std::this_thread::get_id()) {
 					cb->m_done.acquire();
 					return;
 				}
 
 				if (cb->m_destroyed) *cb->m_destroyed = true;
 			}
-
-		private:
-			void lock() noexcept {
-				auto old = m_value.load(std::memory_order::relaxed);
-				while (!try_lock(old, 0, std::memory_order::acquire, std::memory_order::relaxed)) {}
-			}
-
-			void unlock() noexcept { m_value.fetch_sub(mask_locked_bit, std::memory_order::release); }
-
-			bool try_lock(value_type& curval, value_type newbits, std::memory_order success,
-						  std::memory_order failure) noexcept {
-				if (curval & mask_locked_bit) {
-					yield();
-					curval = m_value.load(failure);
-					return false;
-				}
-				newbits |= mask_locked_bit;
-				return m_value.compare_exchange_weak(curval, curval | newbits, success, failure);
-			}
 		};
 
 		struct stop_state_ref {
@@ -345,18 +373,26 @@ namespace asyncpp {
 	public:
 		using callback_type = Callback;
 
+		/**
+		 * \brief Register a callback with the stop state of token.
+		 *
+		 * Unlike std::stop_callback this is not noexcept. Registering does not allocate as long as there is a free
+		 * slot in the stop state, once all of them are taken a new chunk of slots is allocated.
+		 * \throw std::bad_alloc if a new chunk of slots is needed and can not be allocated
+		 */
 		template<typename Cb>
 			requires(std::is_constructible_v<Callback, Cb>)
-		explicit stop_callback(const stop_token& token, Cb&& cb) noexcept(std::is_nothrow_constructible_v<Callback, Cb>)
+		explicit stop_callback(const stop_token& token, Cb&& cb)
 			: m_cb(std::forward<Cb>(cb)) {
 			if (auto state = token.m_state) {
 				if (state->register_callback(&m_cb)) m_state.swap(state);
 			}
 		}
 
+		/// \copydoc stop_callback(const stop_token&, Cb&&)
 		template<typename Cb>
 			requires(std::is_constructible_v<Callback, Cb>)
-		explicit stop_callback(stop_token&& token, Cb&& cb) noexcept(std::is_nothrow_constructible_v<Callback, Cb>)
+		explicit stop_callback(stop_token&& token, Cb&& cb)
 			: m_cb(std::forward<Cb>(cb)) {
 			if (auto& state = token.m_state) {
 				if (state->register_callback(&m_cb)) m_state.swap(state);
@@ -1,12 +1,231 @@
 #pragma once
 /**
  * \file sync_wait.h
- * \brief Utility functions for quickly converting a awaitable to a std::future
+ * \brief Utility functions for synchronously waiting on an awaitable or converting it to a std::future
  */
+#include <asyncpp/detail/cpu_pause.h>
 #include <asyncpp/fire_and_forget.h>
+#include <asyncpp/frame_pool.h>
+#include <asyncpp/simple_dispatcher.h>
+
+#include <atomic>
+#include <exception>
 #include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 namespace asyncpp {
+	namespace detail {
+		/**
+		 * \brief Completion flag of a sync_wait call, living on the stack of the waiting thread.
+		 *
+		 * Without a loop the waiting thread blocks on the atomic itself. The setting thread still calls notify_one()
+		 * after the flag is visible, so the waiter additionally waits for m_notified before it returns and frees the
+		 * flag. With a loop the flag is only set on the loop's thread, either inline or by pushing a callback to it,
+		 * which also wakes it up.
+		 */
+		class sync_wait_signal {
+		public:
+			explicit sync_wait_signal(simple_dispatcher* loop) noexcept : m_loop{loop} {}
+			sync_wait_signal(const sync_wait_signal&) = delete;
+			sync_wait_signal& operator=(const sync_wait_signal&) = delete;
+
+			void set() noexcept {
+				if (m_loop == nullptr) {
+					m_done.store(true, std::memory_order::release);
+					m_done.notify_one();
+					// Last access to this object, the waiter might return right after
+					m_notified.store(true, std::memory_order::release);
+				} else if (dispatcher::current() == m_loop) {
+					m_done.store(true, std::memory_order::relaxed);
+				} else {
+					// The loop keeps running until the callback executed, so this stays valid
+					m_loop->push([this]() noexcept { m_done.store(true, std::memory_order::relaxed); });
+				}
+			}
+
+			// Start the coroutine and wait for it to call set()
+			void wait(coroutine_handle<> start) {
+				if (m_loop != nullptr) {
+					// Started on the loop, so continuations using the current dispatcher come back to it
+					m_loop->run_until(m_done, start);
+					return;
+				}
+				start.resume();
+				while (!m_done.load(std::memory_order::acquire))
+					m_done.wait(false, std::memory_order::acquire);
+				// Only the notify_one() call is left on the other side, so this spins for a very short time
+				while (!m_notified.load(std::memory_order::acquire))
+					cpu_pause();
+			}
+
+			void set_exception(std::exception_ptr ex) noexcept { m_exception = std::move(ex); }
+			void rethrow_exception() const {
+				if (m_exception) std::rethrow_exception(m_exception);
+			}
+
+		private:
+			std::atomic<bool> m_done{false};
+			std::atomic<bool> m_notified{false};
+			simple_dispatcher* const m_loop;
+			std::exception_ptr m_exception;
+		};
+
+		/**
+		 * \brief Result of a sync_wait call, a value or a pointer for references.
+		 */
+		template<typename T>
+		class sync_wait_state : public sync_wait_signal {
+			using stored_type = std::conditional_t<std::is_reference_v<T>, std::add_pointer_t<T>, T>;
+
+		public:
+			using sync_wait_signal::sync_wait_signal;
+
+			template<typename U>
+			void set_value(U&& value) {
+				if constexpr (std::is_reference_v<T>)
+					m_result.template emplace<1>(std::addressof(value));
+				else
+					m_result.template emplace<1>(std::forward<U>(value));
+			}
+
+			T get() {
+				rethrow_exception();
+				if constexpr (std::is_reference_v<T>)
+					return static_cast<T>(*std::get<1>(m_result));
+				else
+					return std::move(std::get<1>(m_result));
+			}
+
+		private:
+			std::variant<std::monostate, stored_type> m_result;
+		};
+
+		template<>
+		class sync_wait_state<void> : public sync_wait_signal {
+		public:
+			using sync_wait_signal::sync_wait_signal;
+
+			void get() const { rethrow_exception(); }
+		};
+
+		/**
+		 * \brief Coroutine driving the awaitable of a sync_wait call.
+		 *
+		 * The frame comes from frame_pool_allocator, so repeated calls reuse it instead of allocating. Once done, the
+		 * frame destroys itself before signalling the waiting thread, which might return and free the state right
+		 * away.
+		 */
+		struct sync_wait_task {
+			struct promise_type;
+			coroutine_handle<promise_type> m_handle;
+
+			struct promise_type : promise_allocator_base<frame_pool_allocator> {
+				sync_wait_signal* m_signal;
+
+				template<typename Awaitable>
+				promise_type(Awaitable&, sync_wait_signal& signal) noexcept : m_signal{&signal} {}
+
+				sync_wait_task get_return_object() noexcept {
+					return {coroutine_handle<promise_type>::from_promise(*this)};
+				}
+				constexpr suspend_always initial_suspend() noexcept { return {}; }
+				auto final_suspend() noexcept {
+					struct awaiter {
+						constexpr bool await_ready() const noexcept { return false; }
+						void await_suspend(coroutine_handle<promise_type> hndl) const noexcept {
+							auto signal = hndl.promise().m_signal;
+							hndl.destroy();
+							signal->set();
+						}
+						constexpr void await_resume() const noexcept {}
+					};
+					return awaiter{};
+				}
+				constexpr void return_void() noexcept {}
+				void unhandled_exception() noexcept { m_signal->set_exception(std::current_exception()); }
+#if ASYNCPP_TRACK_FRAMES
+				template<class U>
+				decltype(auto) await_transform(U&& awaitable,
+											   std::source_location loc = std::source_location::current()) noexcept {
+					m_frame.suspended_at(loc);
+					return forward_awaitable(std::forward<U>(awaitable));
+				}
+
+				frame_entry m_frame{"sync_wait", coroutine_handle<promise_type>::from_promise(*this).address()};
+#endif
+			};
+		};
+
+		template<typename T, typename Awaitable>
+		sync_wait_task sync_wait_impl(Awaitable awaitable, sync_wait_state<T>& state) {
+			if constexpr (std::is_void_v<T>) {
+				co_await std::move(awaitable);
+			} else {
+				state.set_value(co_await std::move(awaitable));
+			}
+		}
+
+		template<typename T, typename Awaitable>
+		T sync_wait(Awaitable&& awaitable, simple_dispatcher* loop) {
+			sync_wait_state<T> state{loop};
+			state.wait(sync_wait_impl<T, std::decay_t<Awaitable>>(std::forward<Awaitable>(awaitable), state).m_handle);
+			return state.get();
+		}
+	} // namespace detail
+
+	/**
+	 * \brief Execute the given awaitable and block the calling thread until it finished.
+	 *
+	 * In contrast to as_promise() there is no shared state, mutex or condition variable involved. The result is
+	 * stored on the stack of the caller, which blocks on an atomic flag, and the frame of the wrapping coroutine is
+	 * taken from frame_pool_allocator. Exceptions thrown by the awaitable are rethrown.
+	 * \note Work pushed to a dispatcher running on the calling thread deadlocks, use the overload taking a loop instead.
+	 * \tparam T The result type of the co_await expression
+	 * \param awaitable The awaitable to wait for
+	 * \return The result of the co_await expression
+	 */
+	template<typename T, typename Awaitable>
+	T sync_wait(Awaitable&& awaitable) {
+		return detail::sync_wait<T>(std::forward<Awaitable>(awaitable), nullptr);
+	}
+
+	/**
+	 * \brief Execute the given awaitable and run the given dispatcher on the calling thread until it finished.
+	 *
+	 * The awaitable is started with loop as the current dispatcher, so work it pushes back to "its" dispatcher runs
+	 * on the calling thread while waiting. The loop is not stopped and can be used for the next call. Stopping it
+	 * while waiting does not end the wait, the loop keeps running until the awaitable finished.
+	 * \tparam T The result type of the co_await expression
+	 * \param awaitable The awaitable to wait for
+	 * \param loop The dispatcher to run while waiting, it must not be running on another thread
+	 * \return The result of the co_await expression
+	 */
+	template<typename T, typename Awaitable>
+	T sync_wait(Awaitable&& awaitable, simple_dispatcher& loop) {
+		return detail::sync_wait<T>(std::forward<Awaitable>(awaitable), &loop);
+	}
+
+	/**
+	 * \brief Execute the given awaitable and block the calling thread until it finished.
+	 * \note This function tries to autodetect the return type of the co_await expression, see as_promise().
+	 */
+	decltype(auto) sync_wait(auto&& awaitable) {
+		return sync_wait<typename detail::await_return_type<std::remove_cvref_t<decltype(awaitable)>>::type>(
+			std::forward<decltype(awaitable)>(awaitable));
+	}
+
+	/**
+	 * \brief Execute the given awaitable and run the given dispatcher on the calling thread until it finished.
+	 * \note This function tries to autodetect the return type of the co_await expression, see as_promise().
+	 */
+	decltype(auto) sync_wait(auto&& awaitable, simple_dispatcher& loop) {
+		return sync_wait<typename detail::await_return_type<std::remove_cvref_t<decltype(awaitable)>>::type>(
+			std::forward<decltype(awaitable)>(awaitable), loop);
+	}
+
 	/**
 	 * \brief Execute the given awaitable and return a std::promise representing the call.
 	 * \note The returned promise will block until the async function finishes or throws.
@@ -19,7 +238,7 @@ namespace asyncpp {
 	{
 		std::promise<T> promise;
 		auto res = promise.get_future();
-		[](std::decay_t<Awaitable> awaiter, std::promise<T> promise) -> eager_fire_and_forget_task<> {
+		[](std::decay_t<Awaitable> awaiter, std::promise<T> promise) -> detached_task<> {
 			try {
 				promise.set_value(co_await std::move(awaiter));
 			} catch (...) { promise.set_exception(std::current_exception()); }
@@ -39,7 +258,7 @@ namespace asyncpp {
 	{
 		std::promise<void> promise;
 		auto res = promise.get_future();
-		[](std::decay_t<Awaitable> awaiter, std::promise<void> promise) -> eager_fire_and_forget_task<> {
+		[](std::decay_t<Awaitable> awaiter, std::promise<void> promise) -> detached_task<> {
 			try {
 				co_await std::move(awaiter);
 				promise.set_value();
@@ -3,6 +3,7 @@
 #include <asyncpp/detail/std_import.h>
 #include <cassert>
 #include <exception>
+#include <type_traits>
 #include <variant>
 
 namespace asyncpp {
@@ -42,6 +43,15 @@ namespace asyncpp {
 				m_value.template emplace<std::exception_ptr>(std::current_exception());
 			}
 
+#if ASYNCPP_TRACK_FRAMES
+			template<class U>
+			decltype(auto) await_transform(U&& awaitable,
+										   std::source_location loc = std::source_location::current()) noexcept {
+				m_frame.suspended_at(loc);
+				return forward_awaitable(std::forward<U>(awaitable));
+			}
+#endif
+
 			TVal rethrow_if_exception() {
 				if (std::holds_alternative<std::exception_ptr>(m_value))
 					std::rethrow_exception(std::get<std::exception_ptr>(m_value));
@@ -50,10 +60,19 @@ namespace asyncpp {
 
 			coroutine_handle<> m_continuation{};
 			std::variant<std::monostate, TVal, std::exception_ptr> m_value{};
+#if ASYNCPP_TRACK_FRAMES
+			frame_entry m_frame{"task",
+								coroutine_handle<TPromise>::from_promise(*static_cast<TPromise*>(this)).address()};
+#endif
 		};
 
-		template<class T, ByteAllocator Allocator>
-		class task_promise : public task_promise_base<T, Allocator, task_promise<T, Allocator>> {
+		// TPromise allows derived promise types (like the one of cancellable_task) to reuse the return handling
+		template<class TSelf, class TPromise>
+		using task_promise_self = std::conditional_t<std::is_void_v<TPromise>, TSelf, TPromise>;
+
+		template<class T, ByteAllocator Allocator, class TPromise = void>
+		class task_promise
+			: public task_promise_base<T, Allocator, task_promise_self<task_promise<T, Allocator>, TPromise>> {
 		public:
 			template<class U>
 			void return_value(U&& value)
@@ -71,9 +90,10 @@ namespace asyncpp {
 		};
 
 		struct returned {};
-		template<ByteAllocator Allocator>
-		class task_promise<void, Allocator>
-			: public task_promise_base<returned, Allocator, task_promise<void, Allocator>> {
+		template<ByteAllocator Allocator, class TPromise>
+		class task_promise<void, Allocator, TPromise>
+			: public task_promise_base<returned, Allocator,
+									   task_promise_self<task_promise<void, Allocator>, TPromise>> {
 		public:
 			void return_void() { this->m_value.template emplace<returned>(); }
 			void get() { this->rethrow_if_exception(); }
@@ -132,6 +152,9 @@ namespace asyncpp {
 					assert(this->m_coro);
 					assert(hndl);
 					m_coro.promise().m_continuation = hndl;
+#if ASYNCPP_TRACK_FRAMES
+					m_coro.promise().m_frame.continuation(hndl);
+#endif
 					return m_coro;
 				}
 				T await_resume() {
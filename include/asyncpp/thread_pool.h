@@ -1,14 +1,25 @@
 #pragma once
+#include <asyncpp/detail/cpu_topology.h>
+#include <asyncpp/detail/work_stealing_deque.h>
 #include <asyncpp/dispatcher.h>
+#include <asyncpp/metrics.h>
+#include <asyncpp/ptr_tag.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <random>
 #include <shared_mutex>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -20,8 +31,55 @@
 #endif
 
 namespace asyncpp {
+	/**
+	 * \brief Options used to construct a thread_pool
+	 */
+	struct thread_pool_options {
+		/// \brief The initial number of threads to spawn
+		size_t size{std::thread::hardware_concurrency()};
+		/// \brief Pin every worker to its own cpu and keep work within its NUMA node where possible.
+		///
+		/// Workers are assigned the cpus the process may run on in order, grouped by NUMA node, and every worker
+		/// allocates its queues after pinning itself, so the memory ends up on its own node. Idle workers steal from
+		/// workers of their own node first and work pushed from outside goes to a worker on the node of the calling
+		/// cpu. This is only supported on Linux and ignored on other platforms.
+		bool sharded{false};
+		/// \brief Lower bound for auto scaling
+		size_t min_size{1};
+		/// \brief Upper bound for auto scaling, auto scaling is enabled if this is greater than min_size.
+		///
+		/// A monitor thread looks at the pool every scale_interval. If work is queued while no worker is idle and
+		/// either a worker is stuck in the same callback for at least stall_threshold (e.g. a blocking call) or
+		/// more work is queued than there are workers, the pool grows. If workers were idle without any queued
+		/// work for idle_timeout, it shrinks by one worker. Shrinking never waits for the removed worker.
+		size_t max_size{0};
+		/// \brief Interval in which the monitor thread checks the pool
+		std::chrono::milliseconds scale_interval{10};
+		/// \brief Time a worker has to spend in a single callback to be considered stalled
+		std::chrono::milliseconds stall_threshold{50};
+		/// \brief Time the pool has to be idle before it shrinks by one worker
+		std::chrono::milliseconds idle_timeout{1000};
+	};
+
 	/**
 	 * \brief A basic thread pool implementation for usage as a dispatcher
+	 *
+	 * Every worker owns a lock-free work stealing deque. Callbacks pushed from within a worker thread are added to
+	 * the bottom of its own deque without locking, while idle workers steal from the top of other workers deques.
+	 * Callbacks pushed from outside the pool are handed to a random worker using a mutex protected queue.
+	 *
+	 * Workers that run out of work spin for a short while and then park themselves inside an idle registry. Pushing
+	 * new work wakes exactly one parked worker, if there is one, and does not notify anybody otherwise.
+	 *
+	 * In sharded mode (see thread_pool_options::sharded) the workers are pinned to cpus and grouped by NUMA node.
+	 *
+	 * Work pushed using push_prioritized() with task_priority::high or task_priority::low goes into one of two
+	 * pool wide lanes. Workers take high priority work before anything else and low priority work only if they
+	 * found nothing else to do. To guarantee progress every normal_interval-th pick skips the high lane and every
+	 * low_interval-th pick looks at the low lane first.
+	 *
+	 * If auto scaling is enabled (see thread_pool_options::max_size) a monitor thread resizes the pool based on the
+	 * queue depth and stalled workers.
 	 */
 	class thread_pool : public dispatcher {
 	public:
@@ -30,7 +88,39 @@ namespace asyncpp {
 		 * \param initial_size The initial number of threads to spawn
 		 */
 		explicit thread_pool(size_t initial_size = std::thread::hardware_concurrency()) { this->resize(initial_size); }
-		~thread_pool() { this->resize(0); }
+		/**
+		 * \brief Construct a new thread pool
+		 * \param opts Options for the pool
+		 */
+		explicit thread_pool(const thread_pool_options& opts) : m_scaling{opts} {
+			if (opts.sharded) {
+				m_cpus = detail::get_cpu_topology();
+				for (auto& slot : m_cpus) {
+					if (static_cast<size_t>(slot.cpu) >= m_node_of_cpu.size()) m_node_of_cpu.resize(slot.cpu + 1, -1);
+					m_node_of_cpu[slot.cpu] = slot.node;
+					m_multi_node = m_multi_node || slot.node != m_cpus.front().node;
+				}
+			}
+			if (m_scaling.max_size > m_scaling.min_size) {
+				this->resize(std::clamp(opts.size, m_scaling.min_size, m_scaling.max_size));
+				m_scaler = std::thread{[this]() { this->run_scaler(); }};
+			} else
+				this->resize(opts.size);
+		}
+		~thread_pool() {
+			if (m_scaler.joinable()) {
+				{
+					std::unique_lock lck{m_scaler_mtx};
+					m_scaler_exit = true;
+				}
+				m_scaler_cv.notify_all();
+				m_scaler.join();
+			}
+			this->resize(0);
+			for (auto& thread : m_retired)
+				thread->thread.join();
+			assert(m_lane_entries.load() == 0);
+		}
 		thread_pool(const thread_pool&) = delete;
 		thread_pool& operator=(const thread_pool&) = delete;
 
@@ -40,20 +130,93 @@ namespace asyncpp {
 		 */
 		void push(std::function<void()> cbfn) override {
 			if (!cbfn) return;
-			if (g_current_thread != nullptr) {
-				std::unique_lock lck{g_current_thread->mutex};
-				g_current_thread->queue.emplace(std::move(cbfn));
+			if (g_current_thread != nullptr && g_current_thread->pool == this) {
+				auto box = g_current_thread->make_box(std::move(cbfn));
+				try {
+					g_current_thread->local_queue.push(ptr_tag<function_tag>(box));
+				} catch (...) {
+					g_current_thread->recycle_box(box);
+					throw;
+				}
+				trace_push(g_current_thread->thread_index);
+				wake_idle();
 			} else {
-				std::shared_lock lck{m_threads_mtx};
-				auto size = m_valid_size.load();
-				if (size == 0) throw std::runtime_error("pool is shutting down");
-				auto thread = m_threads[g_queue_rand() % size].get();
-				std::unique_lock lck2{thread->mutex};
-				thread->queue.emplace(std::move(cbfn));
-				thread->cv.notify_one();
+				push_external(std::move(cbfn));
+			}
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed on the pool
+		 *
+		 * Unlike push() this never allocates if called from within the pool, because the
+		 * handle is directly stored inside the workers deque.
+		 * \param hndl The coroutine to resume
+		 */
+		void push_resume(coroutine_handle<> hndl) override {
+			if (!hndl) return;
+			if (g_current_thread != nullptr && g_current_thread->pool == this) {
+				g_current_thread->local_queue.push(hndl.address());
+				trace_push(g_current_thread->thread_index);
+				wake_idle();
+			} else {
+				// coroutine_handle is trivially copyable and small enough to be stored without allocation
+				push_external(std::function<void()>{hndl});
+			}
+		}
+
+		/**
+		 * \brief Push multiple coroutines to be resumed on the pool
+		 *
+		 * From within the pool all handles are added to the current workers deque and up to one parked worker per
+		 * handle is woken to steal them. From outside the handles are split evenly across the workers, locking
+		 * every workers queue only once.
+		 * \param hndls The coroutines to resume
+		 */
+		void push_resume_batch(std::span<const coroutine_handle<>> hndls) override {
+			if (hndls.empty()) return;
+			if (g_current_thread != nullptr && g_current_thread->pool == this) {
+				for (auto hndl : hndls) {
+					if (hndl) g_current_thread->local_queue.push(hndl.address());
+				}
+				trace_push(g_current_thread->thread_index, hndls.size());
+				wake_idle(hndls.size());
+			} else {
+				push_external_batch(hndls);
 			}
 		}
 
+		/**
+		 * \brief Push a callback into the pool with a priority
+		 * \param cbfn The callback to execute on the pool
+		 * \param prio The priority, task_priority::normal is the same as push()
+		 */
+		void push_prioritized(std::function<void()> cbfn, task_priority prio) override {
+			if (!cbfn) return;
+			if (prio == task_priority::normal) return push(std::move(cbfn));
+			function_box* box = nullptr;
+			if (g_current_thread != nullptr && g_current_thread->pool == this)
+				box = g_current_thread->make_box(std::move(cbfn));
+			else
+				box = new function_box{std::move(cbfn)};
+			try {
+				push_lane(prio, ptr_tag<function_tag>(box));
+			} catch (...) {
+				delete box;
+				throw;
+			}
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed on the pool with a priority
+		 * \param hndl The coroutine to resume
+		 * \param prio The priority, task_priority::normal is the same as push_resume()
+		 */
+		void push_resume_prioritized(coroutine_handle<> hndl, task_priority prio) override {
+			if (!hndl) return;
+			if (prio == task_priority::normal) return push_resume(hndl);
+			push_lane(prio, hndl.address());
+		}
+
 		/**
 		 * \brief Update the number of threads currently running
 		 * \param target_size The new number of threads
@@ -68,9 +231,17 @@ namespace asyncpp {
 				// Notify all and join threads, if the threads index is greater or equal to m_target_size,
 				// it will invoke its remaining tasks and exit.
 				for (size_t i = target_size; i < m_threads.size(); i++) {
-					m_threads[i]->cv.notify_all();
+					{
+						// Lock so we dont lose the wakeup if the thread is about to park
+						std::unique_lock th_lck{m_threads[i]->mutex};
+						m_threads[i]->cv.notify_all();
+					}
 					if (m_threads[i]->thread.joinable()) m_threads[i]->thread.join();
 					assert(m_threads[i]->queue.empty());
+					assert(m_threads[i]->local_queue.empty());
+#if ASYNCPP_ENABLE_METRICS
+					m_threads[i]->metrics.collect(m_exited_metrics);
+#endif
 				}
 				std::unique_lock lck{m_threads_mtx};
 				m_threads.resize(target_size);
@@ -81,7 +252,7 @@ namespace asyncpp {
 				threads_lck.unlock();
 				// We need some new threads, spawn them with the relevant indexes
 				for (size_t i = old; i < target_size; i++) {
-					m_threads[i] = std::make_unique<thread_state>(this, i);
+					m_threads[i] = spawn_worker(i);
 				}
 				// Allow pushing work to our new threads
 				m_valid_size = target_size;
@@ -97,34 +268,454 @@ namespace asyncpp {
 		 */
 		size_t size() const noexcept { return m_valid_size.load(); }
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Collect the counters of all workers, including the ones removed by resize().
+		 *
+		 * Only available if ASYNCPP_ENABLE_METRICS is set.
+		 */
+		dispatcher_metrics metrics() {
+			std::unique_lock lck{m_resize_mtx};
+			auto res = m_exited_metrics;
+			res.pushed += m_external_pushed.load(std::memory_order::relaxed);
+			res.queue_depth = m_lane_entries.load(std::memory_order::relaxed);
+			for (auto& thread : m_retired)
+				thread->metrics.collect(res);
+			std::shared_lock threads_lck{m_threads_mtx};
+			res.workers = m_threads.size();
+			for (auto& thread : m_threads) {
+				thread->metrics.collect(res);
+				res.queue_depth += thread->local_queue.size();
+				std::unique_lock th_lck{thread->mutex};
+				res.queue_depth += thread->queue.size();
+			}
+			return res;
+		}
+#endif
+
 	private:
+		/// \brief Tag used for function_box entries, untagged entries are coroutine handles
+		static constexpr size_t function_tag = 1;
+		/// \brief Number of unused function_box's a worker keeps for reuse
+		static constexpr size_t box_cache_limit = 256;
+
+		/// \brief Heap allocated std::function stored in the deques. Workers recycle them, see thread_state::make_box
+		struct function_box {
+			std::function<void()> cbfn;
+			function_box* next{nullptr};
+		};
+
+		/// \brief Every n-th pick of a worker skips the high priority lane, so normal work is never starved
+		static constexpr size_t normal_interval = 8;
+		/// \brief Every n-th pick of a worker prefers the low priority lane, so background work is never starved
+		static constexpr size_t low_interval = 32;
+
+		struct thread_state;
+
+		struct priority_lane {
+			std::mutex mutex{};
+			// Same encoding as thread_state::local_queue
+			std::deque<void*> entries{};
+		};
+
+		[[nodiscard]] priority_lane& lane(task_priority prio) noexcept {
+			return m_lanes[prio == task_priority::high ? 0 : 1];
+		}
+
+		void push_lane(task_priority prio, void* entry) {
+			{
+				std::shared_lock lck{m_threads_mtx};
+				if (m_valid_size.load() == 0) throw std::runtime_error("pool is shutting down");
+				auto& target = lane(prio);
+				std::unique_lock lane_lck{target.mutex};
+				target.entries.push_back(entry);
+				m_lane_entries.fetch_add(1, std::memory_order::relaxed);
+			}
+			// Lanes are shared by all workers, so the event is reported for the pushing worker if there is one
+			trace_push(g_current_thread != nullptr && g_current_thread->pool == this ? g_current_thread->thread_index
+																					   : 0);
+			wake_idle();
+		}
+
+		std::optional<void*> pop_lane(task_priority prio) {
+			if (m_lane_entries.load(std::memory_order::relaxed) == 0) return std::nullopt;
+			auto& source = lane(prio);
+			std::unique_lock lck{source.mutex};
+			if (source.entries.empty()) return std::nullopt;
+			auto res = source.entries.front();
+			source.entries.pop_front();
+			m_lane_entries.fetch_sub(1, std::memory_order::relaxed);
+			return res;
+		}
+
+		[[nodiscard]] int node_of_worker(size_t index) const noexcept {
+			return m_cpus.empty() ? 0 : m_cpus[index % m_cpus.size()].node;
+		}
+
+		std::unique_ptr<thread_state> spawn_worker(size_t index) {
+			if (m_cpus.empty()) {
+				auto res = std::make_unique<thread_state>(this, index, 0);
+				res->thread = std::thread{[state = res.get()]() { state->run(); }};
+				return res;
+			}
+			const auto slot = m_cpus[index % m_cpus.size()];
+			std::promise<thread_state*> created;
+			auto future = created.get_future();
+			std::thread thread{[this, index, slot, created = std::move(created)]() mutable {
+				detail::pin_current_thread(slot.cpu);
+				// Allocated by the pinned worker, so the first touch places its queues on its own node
+				auto state = new thread_state(this, index, slot.node);
+				created.set_value(state);
+				state->run();
+			}};
+			std::unique_ptr<thread_state> res{future.get()};
+			// The worker never touches its own std::thread
+			res->thread = std::move(thread);
+			return res;
+		}
+
+		// Pick the worker receiving work from outside the pool, preferring the node of the calling cpu
+		size_t pick_external_worker(size_t size) {
+			const auto start = g_queue_rand() % size;
+			if (!m_multi_node) return start;
+			const auto cpu = detail::current_cpu();
+			if (cpu < 0 || static_cast<size_t>(cpu) >= m_node_of_cpu.size() || m_node_of_cpu[cpu] < 0) return start;
+			for (size_t i = 0; i < size; i++) {
+				const auto index = (start + i) % size;
+				if (node_of_worker(index) == m_node_of_cpu[cpu]) return index;
+			}
+			return start;
+		}
+
+		void push_external(std::function<void()> cbfn) {
+			std::shared_lock lck{m_threads_mtx};
+			auto size = m_valid_size.load();
+			if (size == 0) throw std::runtime_error("pool is shutting down");
+			auto thread = m_threads[pick_external_worker(size)].get();
+			{
+				std::unique_lock lck2{thread->mutex};
+				thread->queue.emplace(std::move(cbfn));
+			}
+			trace_push(thread->thread_index);
+			lck.unlock();
+			wake_idle();
+		}
+
+		void push_external_batch(std::span<const coroutine_handle<>> hndls) {
+			std::shared_lock lck{m_threads_mtx};
+			auto size = m_valid_size.load();
+			if (size == 0) throw std::runtime_error("pool is shutting down");
+			// Hand every worker a contiguous chunk, starting at a random one
+			const auto workers = std::min<size_t>(size, hndls.size());
+			const auto chunk = (hndls.size() + workers - 1) / workers;
+			const auto first = g_queue_rand() % size;
+			for (size_t i = 0; i < workers; i++) {
+				auto thread = m_threads[(first + i) % size].get();
+				std::unique_lock lck2{thread->mutex};
+				const auto part = hndls.subspan(i * chunk, std::min(chunk, hndls.size() - i * chunk));
+				for (auto hndl : part) {
+					// coroutine_handle is trivially copyable and small enough to be stored without allocation
+					if (hndl) thread->queue.emplace(hndl);
+				}
+				trace_push(thread->thread_index, part.size());
+			}
+			lck.unlock();
+			wake_idle(workers);
+		}
+
+		// Count and report work pushed to the given worker, the calling thread might not be part of the pool
+		void trace_push([[maybe_unused]] size_t worker, [[maybe_unused]] size_t count = 1) noexcept {
+#if ASYNCPP_ENABLE_METRICS
+			if (g_current_thread != nullptr && g_current_thread->pool == this)
+				g_current_thread->metrics.count_push(count);
+			else
+				m_external_pushed.fetch_add(count, std::memory_order::relaxed);
+			if (observer() == nullptr) return;
+			for (size_t i = 0; i < count; i++)
+				trace(dispatch_event::push, worker);
+#endif
+		}
+
+		/**
+		 * \brief Wake up to count parked workers, if there are any.
+		 *
+		 * Has to be called after new work was made visible. Together with the recheck in thread_state::park()
+		 * this ensures a worker never sleeps while work is available.
+		 */
+		void wake_idle(size_t count = 1) {
+			// Pairs with the fence in thread_state::park()
+			std::atomic_thread_fence(std::memory_order::seq_cst);
+			if (m_num_idle.load(std::memory_order::relaxed) == 0) return;
+			std::unique_lock lck{m_idle_mtx};
+			for (; count != 0; count--) {
+				// Most recently parked worker first, its caches are most likely still warm. Workers that are about
+				// to exit because of resize() would not run the work, so we skip them.
+				auto it = std::find_if(m_idle.rbegin(), m_idle.rend(),
+									   [](thread_state* th) { return !th->should_exit(); });
+				if (it == m_idle.rend()) return;
+				auto thread = *it;
+				m_idle.erase(std::next(it).base());
+				m_num_idle.fetch_sub(1, std::memory_order::relaxed);
+				// Workers unregister under m_idle_mtx before exiting, so the thread stays valid while we hold it
+				std::unique_lock th_lck{thread->mutex};
+				thread->wakeup = true;
+				thread->cv.notify_one();
+			}
+		}
+
 		struct thread_state {
+			/// \brief Every n-th local task is taken from the top of the deque to prevent starvation
+			static constexpr size_t fairness_interval = 61;
+			/// \brief Number of times an idle worker looks for new work before it parks
+			static constexpr size_t spin_count = 32;
+
 			thread_pool* const pool;
 			size_t const thread_index;
+			// NUMA node of the cpu this worker is pinned to, always 0 if the pool is not sharded
+			int const node;
 			std::mutex mutex{};
 			std::condition_variable cv{};
+			// Callbacks pushed from outside the pool
 			std::queue<std::function<void()>> queue{};
+			// Work pushed from within this thread, only this thread pushes/pops at the bottom.
+			// Entries are either coroutine handle addresses or tagged pointers to function_box's.
+			detail::work_stealing_deque<void*> local_queue{};
+			// Boxes of callbacks this thread ran, reused for the callbacks it pushes. Only accessed by this thread.
+			function_box* free_boxes{nullptr};
+			size_t num_free_boxes{0};
+			size_t local_tick{0};
+			// Set by wake_idle() after removing this thread from the idle registry, protected by mutex
+			bool wakeup{false};
+			// Set if the worker got removed by the auto scaler without waiting for it to exit
+			std::atomic<bool> retired{false};
+			std::atomic<bool> exited{false};
+			// Incremented before and after every callback, so it is odd while one is running. Only this thread
+			// writes it, the auto scaler uses it to detect stalled workers.
+			std::atomic<size_t> progress{0};
 			std::thread thread;
+#if ASYNCPP_ENABLE_METRICS
+			detail::metrics_slot metrics{};
+#endif
+
+			// The thread is started by thread_pool::spawn_worker()
+			thread_state(thread_pool* parent, size_t index, int numa_node)
+				: pool{parent}, thread_index{index}, node{numa_node} {}
+
+			thread_state(const thread_state&) = delete;
+			thread_state& operator=(const thread_state&) = delete;
+			~thread_state() {
+				while (free_boxes != nullptr)
+					delete std::exchange(free_boxes, free_boxes->next);
+			}
+
+			// Take a box from the cache, boxes move between workers with the work, so this only allocates until the
+			// caches are warmed up
+			function_box* make_box(std::function<void()> cbfn) {
+				if (free_boxes == nullptr) return new function_box{std::move(cbfn)};
+				auto box = std::exchange(free_boxes, free_boxes->next);
+				num_free_boxes--;
+				box->cbfn = std::move(cbfn);
+				box->next = nullptr;
+				return box;
+			}
+
+			void recycle_box(function_box* box) noexcept {
+				box->cbfn = nullptr;
+				if (num_free_boxes >= box_cache_limit) {
+					delete box;
+					return;
+				}
+				box->next = free_boxes;
+				free_boxes = box;
+				num_free_boxes++;
+			}
+
+			void invoke(void* entry) {
+				if (ptr_get_tag<function_box>(entry) == function_tag) {
+					auto box = ptr_untag<function_box>(entry).first;
+					// Moving a std::function does not allocate, and the box is recycled even if the callback throws
+					auto cbfn = std::move(box->cbfn);
+					recycle_box(box);
+					cbfn();
+				} else {
+					coroutine_handle<>::from_address(entry).resume();
+				}
+			}
+
+			[[nodiscard]] bool should_exit() const noexcept {
+				return thread_index >= pool->m_target_size || retired.load(std::memory_order::relaxed);
+			}
+
+			template<typename Fn>
+			void run_tracked(Fn&& fn) {
+				const auto value = progress.load(std::memory_order::relaxed);
+				progress.store(value + 1, std::memory_order::relaxed);
+#if ASYNCPP_ENABLE_METRICS
+				pool->trace(dispatch_event::start, thread_index);
+				const auto start = std::chrono::steady_clock::now();
+				fn();
+				metrics.count_callback(std::chrono::steady_clock::now() - start);
+				pool->trace(dispatch_event::end, thread_index);
+#else
+				fn();
+#endif
+				progress.store(value + 2, std::memory_order::relaxed);
+			}
+
+			void count_steal() noexcept {
+#if ASYNCPP_ENABLE_METRICS
+				metrics.count_steal();
+				pool->trace(dispatch_event::steal, thread_index);
+#endif
+			}
+
+			std::optional<void*> pop_local() {
+				// Only picks that found something count, so the intervals are not skewed by idle polling
+				auto res = pick_local(local_tick + 1);
+				if (res) local_tick++;
+				return res;
+			}
+
+			std::optional<void*> pick_local(size_t tick) {
+				const bool skip_high = tick % normal_interval == 0;
+				if (pool->m_lane_entries.load(std::memory_order::relaxed) != 0) {
+					if (tick % low_interval == 0) {
+						if (auto res = pool->pop_lane(task_priority::low); res) return res;
+					}
+					if (!skip_high) {
+						if (auto res = pool->pop_lane(task_priority::high); res) return res;
+					}
+				}
+				// Popping at the bottom is LIFO, which is great for locality but can starve older tasks if a task
+				// keeps rescheduling itself (e.g. a yield loop using defer). Every couple of tasks we therefore take
+				// the oldest one instead.
+				if (tick % fairness_interval == 0) {
+					if (auto res = local_queue.steal(); res) return res;
+				}
+				if (auto res = local_queue.pop(); res) return res;
+				// Leaves the other queues a turn if high priority work keeps coming in
+				if (skip_high) return std::nullopt;
+				return pool->pop_lane(task_priority::high);
+			}
 
-			thread_state(thread_pool* parent, size_t index)
-				: pool{parent}, thread_index{index}, thread{[this]() { this->run(); }} {}
+			// Run the oldest callback pushed from outside the pool, if there is one
+			bool run_external() {
+				std::unique_lock lck{mutex};
+				if (queue.empty()) return false;
+				auto cbfn = std::move(queue.front());
+				queue.pop();
+				lck.unlock();
+				run_tracked(cbfn);
+				return true;
+			}
 
-			std::function<void()> try_steal_task() {
+			bool try_run_stolen_task() {
 				// Make sure we dont wait if its locked uniquely cause that might deadlock with resize()
-				if (!pool->m_threads_mtx.try_lock_shared()) return {};
+				if (!pool->m_threads_mtx.try_lock_shared()) return false;
+				std::shared_lock lck{pool->m_threads_mtx, std::adopt_lock};
+				const size_t size = pool->m_valid_size;
+				// Workers on our own node come first, the others are only visited if the pool spans multiple nodes
+				const int passes = pool->m_multi_node ? 2 : 1;
+				for (int pass = 0; pass < passes; pass++) {
+					// Start at our neighbour so not every thread hammers the first one
+					for (size_t n = 1; n < size; n++) {
+						auto& thread = pool->m_threads[(thread_index + n) % size];
+						if (!is_victim(thread.get(), pass == 0)) continue;
+						if (auto res = thread->local_queue.steal(); res) {
+							lck.unlock();
+							count_steal();
+							run_tracked([&]() { invoke(*res); });
+							return true;
+						}
+					}
+					for (size_t n = 1; n < size; n++) {
+						auto& thread = pool->m_threads[(thread_index + n) % size];
+						if (!is_victim(thread.get(), pass == 0)) continue;
+						// if the other thread is currently locked skip it, we dont wanna wait too long
+						if (!thread->mutex.try_lock()) continue;
+						std::unique_lock th_lck{thread->mutex, std::adopt_lock};
+						if (thread->queue.empty()) continue;
+						auto cbfn = std::move(thread->queue.front());
+						thread->queue.pop();
+						th_lck.unlock();
+						lck.unlock();
+						count_steal();
+						run_tracked(cbfn);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			bool is_victim(const thread_state* thread, bool same_node) const noexcept {
+				return thread != nullptr && thread != this && (thread->node == node) == same_node;
+			}
+
+			bool has_queued_work() {
+				std::unique_lock lck{mutex};
+				return !queue.empty();
+			}
+
+			bool spin_for_work() {
+				for (size_t i = 0; i < spin_count; i++) {
+					if (pool->m_lane_entries.load(std::memory_order::relaxed) != 0) return true;
+					if (has_queued_work() || try_run_stolen_task()) return true;
+					if (should_exit()) return true;
+					std::this_thread::yield();
+				}
+				return false;
+			}
+
+			// Check if there is any work we could take, used after registering as idle. This errs on the side of
+			// returning true, the worst case is another round of spinning.
+			bool may_have_work() {
+				if (pool->m_lane_entries.load() != 0 || has_queued_work()) return true;
+				if (!pool->m_threads_mtx.try_lock_shared()) return true;
 				std::shared_lock lck{pool->m_threads_mtx, std::adopt_lock};
-				for (size_t i = 0; i < pool->m_valid_size; i++) {
-					auto& thread = pool->m_threads[i];
+				const size_t size = pool->m_valid_size;
+				for (size_t n = 1; n < size; n++) {
+					auto& thread = pool->m_threads[(thread_index + n) % size];
 					if (thread.get() == this || thread == nullptr) continue;
-					// if the other thread is currently locked skip it, we dont wanna wait too long
-					if (!thread->mutex.try_lock()) continue;
+					if (!thread->local_queue.empty()) return true;
+					if (!thread->mutex.try_lock()) return true;
 					std::unique_lock th_lck{thread->mutex, std::adopt_lock};
-					if (thread->queue.empty()) continue;
-					auto cbfn = std::move(thread->queue.front());
-					thread->queue.pop();
-					return cbfn;
+					if (!thread->queue.empty()) return true;
 				}
-				return {};
+				return false;
+			}
+
+			void unregister_idle() {
+				std::unique_lock lck{pool->m_idle_mtx};
+				auto it = std::find(pool->m_idle.begin(), pool->m_idle.end(), this);
+				if (it == pool->m_idle.end()) return;
+				pool->m_idle.erase(it);
+				pool->m_num_idle.fetch_sub(1, std::memory_order::relaxed);
+			}
+
+			void park() {
+				{
+					std::unique_lock lck{mutex};
+					wakeup = false;
+				}
+				{
+					std::unique_lock lck{pool->m_idle_mtx};
+					pool->m_idle.push_back(this);
+					pool->m_num_idle.fetch_add(1, std::memory_order::relaxed);
+				}
+				// Pairs with the fence in wake_idle(). Either the pusher sees us as idle and wakes us, or we see
+				// the work it pushed in the recheck below.
+				std::atomic_thread_fence(std::memory_order::seq_cst);
+				if (!may_have_work()) {
+#if ASYNCPP_ENABLE_METRICS
+					const auto start = std::chrono::steady_clock::now();
+#endif
+					std::unique_lock lck{mutex};
+					cv.wait(lck, [this]() { return wakeup || !queue.empty() || should_exit(); });
+#if ASYNCPP_ENABLE_METRICS
+					metrics.count_idle(std::chrono::steady_clock::now() - start);
+#endif
+				}
+				unregister_idle();
 			}
 
 			void run() {
@@ -137,28 +728,31 @@ namespace asyncpp {
 				dispatcher::current(pool);
 				g_current_thread = this;
 				while (true) {
-					{
-						std::unique_lock lck{mutex};
-						while (!queue.empty()) {
-							auto cbfn = std::move(queue.front());
-							queue.pop();
-							lck.unlock();
-							cbfn();
-							lck.lock();
-						}
+					while (auto cbfn = pop_local()) {
+						run_tracked([&]() { invoke(*cbfn); });
+						// A task that keeps rescheduling itself locally would starve callbacks pushed from outside
+						if (local_tick % fairness_interval == 0) run_external();
 					}
-					if (thread_index >= pool->m_target_size) break;
-					if (auto cbfn = try_steal_task(); cbfn) {
-						cbfn();
+					if (run_external()) continue;
+					if (should_exit()) break;
+					if (try_run_stolen_task()) continue;
+					if (auto res = pool->pop_lane(task_priority::low); res) {
+						run_tracked([&]() { invoke(*res); });
 						continue;
 					}
-					if (thread_index < pool->m_target_size) {
-						std::unique_lock lck{mutex};
-						cv.wait_for(lck, std::chrono::milliseconds{100});
-					}
+					if (spin_for_work()) continue;
+					park();
 				}
-				std::unique_lock lck{mutex};
 				g_current_thread = nullptr;
+				// Callbacks pushed from now on are no longer added to our local queue
+				while (auto cbfn = local_queue.pop())
+					invoke(*cbfn);
+				// Other workers might be exiting too, so everybody helps draining the lanes
+				while (auto cbfn = pool->pop_lane(task_priority::high))
+					invoke(*cbfn);
+				while (auto cbfn = pool->pop_lane(task_priority::low))
+					invoke(*cbfn);
+				std::unique_lock lck{mutex};
 				while (!queue.empty()) {
 					auto& cbfn = queue.front();
 					lck.unlock();
@@ -167,9 +761,96 @@ namespace asyncpp {
 					queue.pop();
 				}
 				dispatcher::current(nullptr);
+				exited = true;
+			}
+		};
+
+		/**
+		 * \brief Remove the workers with an index of target_size and above without waiting for them.
+		 *
+		 * They are moved to m_retired and finish their current callback as well as the work left in their queues
+		 * on their own. The auto scaler joins them once they exited.
+		 */
+		void shrink_detached(size_t target_size) {
+			std::unique_lock lck{m_resize_mtx};
+			if (target_size >= m_target_size) return;
+			m_valid_size = target_size;
+			m_target_size = target_size;
+			std::unique_lock threads_lck{m_threads_mtx};
+			for (size_t i = target_size; i < m_threads.size(); i++) {
+				auto& thread = m_threads[i];
+				thread->retired = true;
+				{
+					std::unique_lock th_lck{thread->mutex};
+					thread->cv.notify_all();
+				}
+				m_retired.push_back(std::move(thread));
 			}
+			m_threads.resize(target_size);
+		}
+
+		struct scaler_sample {
+			size_t progress{0};
+			std::chrono::steady_clock::time_point since{};
 		};
 
+		void run_scaler() {
+#ifdef __linux__
+			pthread_setname_np(pthread_self(), "pool_scaler");
+#endif
+			std::vector<scaler_sample> samples;
+			auto idle_since = std::chrono::steady_clock::now();
+			std::unique_lock lck{m_scaler_mtx};
+			while (!m_scaler_cv.wait_for(lck, m_scaling.scale_interval, [this]() { return m_scaler_exit; })) {
+				lck.unlock();
+				const auto now = std::chrono::steady_clock::now();
+				size_t depth = m_lane_entries.load(std::memory_order::relaxed);
+				size_t stalled = 0;
+				size_t size = 0;
+				{
+					std::shared_lock threads_lck{m_threads_mtx};
+					size = m_threads.size();
+					samples.resize(size);
+					for (size_t i = 0; i < size; i++) {
+						auto& thread = *m_threads[i];
+						depth += thread.local_queue.size();
+						{
+							std::unique_lock th_lck{thread.mutex};
+							depth += thread.queue.size();
+						}
+						// A worker is stalled if it is inside the same callback since the last samples
+						const auto progress = thread.progress.load(std::memory_order::relaxed);
+						if (samples[i].progress != progress || progress % 2 == 0) samples[i] = {progress, now};
+						else if (now - samples[i].since >= m_scaling.stall_threshold)
+							stalled++;
+					}
+				}
+				const auto idle = m_num_idle.load(std::memory_order::relaxed);
+				if (depth != 0 && idle == 0 && (stalled != 0 || depth > size) && size < m_scaling.max_size) {
+					resize(std::min(m_scaling.max_size, size + std::max<size_t>(stalled, 1)));
+					idle_since = now;
+				} else if (depth != 0 || idle == 0 || stalled != 0) {
+					idle_since = now;
+				} else if (now - idle_since >= m_scaling.idle_timeout && size > m_scaling.min_size) {
+					shrink_detached(size - 1);
+					idle_since = now;
+				}
+				// Join the removed workers that are done
+				{
+					std::unique_lock resize_lck{m_resize_mtx};
+					std::erase_if(m_retired, [&](auto& thread) {
+						if (!thread->exited.load()) return false;
+						thread->thread.join();
+#if ASYNCPP_ENABLE_METRICS
+						thread->metrics.collect(m_exited_metrics);
+#endif
+						return true;
+					});
+				}
+				lck.lock();
+			}
+		}
+
 		inline static thread_local thread_state* g_current_thread{nullptr};
 		// This makes the conversion explicit to avoid compiler warning/error; only, should the hash not fit in an unsigned int, an error would occur;
 		// Would it be worth it to create a function to convert and check if hash <= unsigned_int?
@@ -182,5 +863,29 @@ namespace asyncpp {
 		std::shared_mutex m_threads_mtx{};
 		// We use pointers, so nodes don't move with insert/erase
 		std::vector<std::unique_ptr<thread_state>> m_threads{};
+		// Registry of parked workers, m_num_idle allows pushers to skip the lock if nobody sleeps
+		std::mutex m_idle_mtx{};
+		std::vector<thread_state*> m_idle{};
+		std::atomic<size_t> m_num_idle{0};
+#if ASYNCPP_ENABLE_METRICS
+		// Pushes from outside the pool, the workers count theirs in their own slot
+		std::atomic<std::uint64_t> m_external_pushed{0};
+		// Counters of the workers that already got destroyed, protected by m_resize_mtx
+		dispatcher_metrics m_exited_metrics{};
+#endif
+		// Only used in sharded mode, cpus assigned to the workers in order
+		std::vector<detail::cpu_slot> m_cpus{};
+		std::vector<int> m_node_of_cpu{};
+		bool m_multi_node{false};
+		// High and low priority work, m_lane_entries allows workers to skip the locks if both are empty
+		std::array<priority_lane, 2> m_lanes{};
+		std::atomic<size_t> m_lane_entries{0};
+		// Auto scaling, m_retired is protected by m_resize_mtx
+		const thread_pool_options m_scaling{.min_size = 0, .max_size = 0};
+		std::vector<std::unique_ptr<thread_state>> m_retired{};
+		std::mutex m_scaler_mtx{};
+		std::condition_variable m_scaler_cv{};
+		bool m_scaler_exit{false};
+		std::thread m_scaler{};
 	};
 } // namespace asyncpp
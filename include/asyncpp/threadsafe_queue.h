@@ -1,8 +1,17 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
 #include <queue>
+#include <type_traits>
 #include <utility>
 
 namespace asyncpp {
@@ -81,4 +90,350 @@ namespace asyncpp {
 			m_queue.emplace(std::forward<Args>(args)...);
 		}
 	};
+
+	/**
+	 * \brief A bounded lock-free multi producer multi consumer queue.
+	 *
+	 * This is a ring buffer with a sequence number per slot (as described by Dmitry Vyukov). Producers and consumers
+	 * claim a slot by advancing their position using a compare exchange and use the sequence number of the slot to
+	 * find out if it is ready for them. The positions are kept on separate cache lines to avoid false sharing between
+	 * producers and consumers. No memory is allocated after construction.
+	 *
+	 * \tparam T Type of the contained elements
+	 */
+	template<typename T>
+	class bounded_mpmc_queue {
+		static_assert(std::is_nothrow_move_constructible_v<T>, "T needs to be nothrow move constructible");
+
+		struct slot {
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T& value() noexcept { return *std::launder(reinterpret_cast<T*>(storage)); }
+		};
+
+		const size_t m_mask;
+		const std::unique_ptr<slot[]> m_slots;
+		alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+		alignas(64) std::atomic<size_t> m_dequeue_pos{0};
+
+	public:
+		/**
+		 * \brief Construct a new queue
+		 * \param capacity The maximum number of elements, rounded up to the next power of two
+		 */
+		explicit bounded_mpmc_queue(size_t capacity)
+			: m_mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1}, m_slots{new slot[m_mask + 1]} {
+			for (size_t i = 0; i <= m_mask; i++)
+				m_slots[i].sequence.store(i, std::memory_order::relaxed);
+		}
+		~bounded_mpmc_queue() {
+			while (pop()) {}
+		}
+		bounded_mpmc_queue(const bounded_mpmc_queue&) = delete;
+		bounded_mpmc_queue& operator=(const bounded_mpmc_queue&) = delete;
+
+		/**
+		 * \brief Get the maximum number of elements in the queue.
+		 */
+		[[nodiscard]] size_t capacity() const noexcept { return m_mask + 1; }
+
+		/**
+		 * \brief Pop the first element from the queue.
+		 * \return The first element of the queue or std::nullopt if the queue is empty.
+		 */
+		std::optional<T> pop() {
+			auto pos = m_dequeue_pos.load(std::memory_order::relaxed);
+			while (true) {
+				auto& cell = m_slots[pos & m_mask];
+				const auto seq = cell.sequence.load(std::memory_order::acquire);
+				const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+				if (diff == 0) {
+					if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+						std::optional<T> res{std::move(cell.value())};
+						cell.value().~T();
+						// Hand the slot to the producer one lap ahead
+						cell.sequence.store(pos + m_mask + 1, std::memory_order::release);
+						return res;
+					}
+				} else if (diff < 0) {
+					return std::nullopt;
+				} else {
+					pos = m_dequeue_pos.load(std::memory_order::relaxed);
+				}
+			}
+		}
+
+		/**
+		 * \brief Push an element to the queue
+		 * \param val The element to push
+		 * \return false if the queue is full, in which case val is discarded
+		 */
+		bool push(T val) {
+			auto pos = m_enqueue_pos.load(std::memory_order::relaxed);
+			while (true) {
+				auto& cell = m_slots[pos & m_mask];
+				const auto seq = cell.sequence.load(std::memory_order::acquire);
+				const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+				if (diff == 0) {
+					if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+						new (cell.storage) T(std::move(val));
+						cell.sequence.store(pos + 1, std::memory_order::release);
+						return true;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					pos = m_enqueue_pos.load(std::memory_order::relaxed);
+				}
+			}
+		}
+
+		/**
+		 * \brief Emplace a new element to the queue
+		 *
+		 * The element is constructed before a slot is claimed, so a throwing constructor can not leave a claimed
+		 * slot behind.
+		 * \param args Arguments to forward to the element constructor
+		 * \return false if the queue is full, in which case the element is discarded
+		 */
+		template<typename... Args>
+		bool emplace(Args&&... args) {
+			return push(T(std::forward<Args>(args)...));
+		}
+	};
+
+	/**
+	 * \brief An unbounded lock-free multi producer multi consumer queue.
+	 *
+	 * Elements are stored in a linked list of fixed size segments. Producers and consumers claim a slot inside the
+	 * current segment using a single fetch_add and only fall back to compare exchange when moving to the next
+	 * segment, so a segment is allocated once every SegmentSize pushes. A consumer that gets ahead of a producer in
+	 * the same slot marks it as taken, and the producer retries with a new slot.
+	 *
+	 * Segments are reference counted individually. The head and tail keep a count of the operations that entered
+	 * the segment they point to next to the pointer, so entering is a single fetch_add on the head (consumers) or
+	 * the tail (producers). The count is moved to the segment once the head or tail moves on, so a segment is freed
+	 * as soon as the last operation inside it is done, no matter how busy the rest of the queue is.
+	 *
+	 * \tparam T Type of the contained elements
+	 * \tparam SegmentSize Number of slots per segment
+	 */
+	template<typename T, size_t SegmentSize = 64>
+	class segmented_mpmc_queue {
+		static_assert(std::is_nothrow_move_constructible_v<T>, "T needs to be nothrow move constructible");
+		static_assert(SegmentSize > 0);
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "requires lock-free 64 bit atomics");
+
+		enum : std::uint8_t { slot_empty, slot_writing, slot_ready, slot_taken };
+
+		struct slot {
+			std::atomic<std::uint8_t> state{slot_empty};
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T& value() noexcept { return *std::launder(reinterpret_cast<T*>(storage)); }
+		};
+
+		// A segment is referenced by its predecessor, the head and the tail, each of them counting as link_ref.
+		// Operations are added to refs once the head or tail they entered through moved on and subtract one when
+		// leaving, so refs only drops to zero once all links are gone and the last operation left.
+		static constexpr std::int64_t link_ref = std::int64_t{1} << 40;
+
+		struct segment {
+			alignas(64) std::atomic<size_t> enqueue_idx{0};
+			alignas(64) std::atomic<size_t> dequeue_idx{0};
+			alignas(64) std::atomic<segment*> next{nullptr};
+			alignas(64) std::atomic<std::int64_t> refs;
+			slot slots[SegmentSize];
+
+			explicit segment(std::int64_t initial_refs) noexcept : refs{initial_refs} {}
+			~segment() {
+				for (auto& e : slots) {
+					if (e.state.load(std::memory_order::relaxed) == slot_ready) e.value().~T();
+				}
+			}
+		};
+
+		// The head and tail pack the segment pointer and the number of operations that entered it since it was
+		// stored, the same way tagged_ptr does with its generation
+		using word_type = std::uint64_t;
+		static constexpr unsigned pointer_bits = sizeof(void*) == 4 ? 32 : 48;
+		static constexpr word_type one_entry = word_type{1} << pointer_bits;
+		static constexpr word_type pointer_mask = one_entry - 1;
+		// Move the entries to the segment once half of the counter is used up, so it never overflows
+		static constexpr word_type flush_threshold = word_type{1} << (63 - pointer_bits);
+
+		alignas(64) std::atomic<word_type> m_head;
+		alignas(64) std::atomic<word_type> m_tail;
+
+		static segment* to_segment(word_type word) noexcept {
+			//NOLINTNEXTLINE(performance-no-int-to-ptr)
+			return reinterpret_cast<segment*>(static_cast<std::uintptr_t>(word & pointer_mask));
+		}
+		static word_type to_word(segment* seg) noexcept {
+			const auto word = static_cast<word_type>(reinterpret_cast<std::uintptr_t>(seg));
+			assert((word & ~pointer_mask) == 0);
+			return word;
+		}
+
+		// Keeps the segment the head or tail points to alive while the operation is running
+		class segment_ref {
+			segment* m_segment;
+
+		public:
+			explicit segment_ref(std::atomic<word_type>& word) noexcept : m_segment{enter(word)} {}
+			~segment_ref() { leave(m_segment); }
+			segment_ref(const segment_ref&) = delete;
+			segment_ref& operator=(const segment_ref&) = delete;
+
+			segment* get() const noexcept { return m_segment; }
+			// Move the head or tail past the current segment and enter the one it points to afterwards
+			void advance(std::atomic<word_type>& word, segment* next) noexcept {
+				segmented_mpmc_queue::advance(word, m_segment, next);
+				leave(std::exchange(m_segment, enter(word)));
+			}
+		};
+
+		static segment* enter(std::atomic<word_type>& word) noexcept {
+			const auto old = word.fetch_add(one_entry, std::memory_order::acquire);
+			const auto seg = to_segment(old);
+			if ((old >> pointer_bits) + 1 >= flush_threshold) flush_entries(word, seg);
+			return seg;
+		}
+
+		static void leave(segment* seg) noexcept {
+			if (seg->refs.fetch_sub(1, std::memory_order::acq_rel) == 1) destroy(seg);
+		}
+
+		static void flush_entries(std::atomic<word_type>& word, segment* seg) noexcept {
+			auto cur = word.load(std::memory_order::relaxed);
+			while (to_segment(cur) == seg) {
+				if (word.compare_exchange_weak(cur, to_word(seg), std::memory_order::relaxed)) {
+					// The link of the word is still counted, so this can not free the segment
+					seg->refs.fetch_add(static_cast<std::int64_t>(cur >> pointer_bits), std::memory_order::acq_rel);
+					return;
+				}
+			}
+		}
+
+		// Needs to be called from within seg, which keeps next alive through its link
+		static void advance(std::atomic<word_type>& word, segment* seg, segment* next) noexcept {
+			next->refs.fetch_add(link_ref, std::memory_order::relaxed);
+			auto cur = word.load(std::memory_order::relaxed);
+			while (to_segment(cur) == seg) {
+				if (word.compare_exchange_weak(cur, to_word(next), std::memory_order::acq_rel,
+											   std::memory_order::relaxed)) {
+					release_link(seg, cur >> pointer_bits);
+					return;
+				}
+			}
+			// Someone else moved it already
+			next->refs.fetch_sub(link_ref, std::memory_order::relaxed);
+		}
+
+		static void release_link(segment* seg, word_type entries) noexcept {
+			const auto delta = static_cast<std::int64_t>(entries) - link_ref;
+			if (seg->refs.fetch_add(delta, std::memory_order::acq_rel) == -delta) destroy(seg);
+		}
+
+		static void destroy(segment* seg) noexcept {
+			while (seg != nullptr) {
+				const auto next = seg->next.load(std::memory_order::acquire);
+				delete seg;
+				if (next == nullptr || next->refs.fetch_sub(link_ref, std::memory_order::acq_rel) != link_ref) return;
+				seg = next;
+			}
+		}
+
+	public:
+		/**
+		 * \brief Construct a new queue
+		 */
+		segmented_mpmc_queue() {
+			const auto word = to_word(new segment(2 * link_ref));
+			m_head.store(word, std::memory_order::relaxed);
+			m_tail.store(word, std::memory_order::relaxed);
+		}
+		~segmented_mpmc_queue() {
+			// No operation is running, so dropping the links of the head and tail frees all segments
+			const auto tail = m_tail.load(std::memory_order::relaxed);
+			release_link(to_segment(tail), tail >> pointer_bits);
+			const auto head = m_head.load(std::memory_order::relaxed);
+			release_link(to_segment(head), head >> pointer_bits);
+		}
+		segmented_mpmc_queue(const segmented_mpmc_queue&) = delete;
+		segmented_mpmc_queue& operator=(const segmented_mpmc_queue&) = delete;
+
+		/**
+		 * \brief Pop the first element from the queue.
+		 * \return The first element of the queue or std::nullopt if the queue is empty.
+		 */
+		std::optional<T> pop() {
+			segment_ref ref{m_head};
+			while (true) {
+				const auto seg = ref.get();
+				const auto next = seg->next.load(std::memory_order::acquire);
+				if (seg->dequeue_idx.load(std::memory_order::relaxed) >=
+						seg->enqueue_idx.load(std::memory_order::relaxed) &&
+					next == nullptr)
+					return std::nullopt;
+				const auto idx = seg->dequeue_idx.fetch_add(1, std::memory_order::acq_rel);
+				if (idx >= SegmentSize) {
+					auto fresh_next = seg->next.load(std::memory_order::acquire);
+					if (fresh_next == nullptr) return std::nullopt;
+					ref.advance(m_head, fresh_next);
+					continue;
+				}
+				auto& cell = seg->slots[idx];
+				auto state = cell.state.load(std::memory_order::acquire);
+				if (state == slot_empty &&
+					cell.state.compare_exchange_strong(state, slot_taken, std::memory_order::acq_rel))
+					continue; // The producer of this slot is not there yet, it will retry elsewhere
+				while (state != slot_ready)
+					state = cell.state.load(std::memory_order::acquire);
+				std::optional<T> res{std::move(cell.value())};
+				cell.value().~T();
+				cell.state.store(slot_taken, std::memory_order::relaxed);
+				return res;
+			}
+		}
+
+		/**
+		 * \brief Push an element to the queue
+		 * \param val The element to push
+		 */
+		void push(T val) {
+			segment_ref ref{m_tail};
+			while (true) {
+				const auto seg = ref.get();
+				const auto idx = seg->enqueue_idx.fetch_add(1, std::memory_order::acq_rel);
+				if (idx < SegmentSize) {
+					auto& cell = seg->slots[idx];
+					std::uint8_t state = slot_empty;
+					if (!cell.state.compare_exchange_strong(state, slot_writing, std::memory_order::acq_rel))
+						continue;
+					new (cell.storage) T(std::move(val));
+					cell.state.store(slot_ready, std::memory_order::release);
+					return;
+				}
+				auto next = seg->next.load(std::memory_order::acquire);
+				if (next == nullptr) {
+					// The new segment is linked from its predecessor
+					auto fresh = std::make_unique<segment>(link_ref);
+					if (seg->next.compare_exchange_strong(next, fresh.get(), std::memory_order::acq_rel))
+						next = fresh.release();
+				}
+				ref.advance(m_tail, next);
+			}
+		}
+
+		/**
+		 * \brief Emplace a new element to the queue
+		 * \param args Arguments to forward to the element constructor
+		 */
+		template<typename... Args>
+		void emplace(Args&&... args) {
+			push(T(std::forward<Args>(args)...));
+		}
+	};
 } // namespace asyncpp
@@ -1,18 +1,52 @@
 #pragma once
 #include <asyncpp/detail/std_import.h>
+#include <asyncpp/detail/timing_wheel.h>
 #include <asyncpp/dispatcher.h>
+#include <asyncpp/metrics.h>
 #include <asyncpp/stop_token.h>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <set>
 #include <thread>
+#include <vector>
 
 namespace asyncpp {
+	/**
+	 * \brief Storage backend used by a timer for scheduled entries
+	 */
+	enum class timer_backend {
+		/// \brief Entries are kept in a sorted set, insert and cancellation take O(log n)
+		ordered_set,
+		/// \brief Entries are kept in a hierarchical timing wheel, insert and cancellation take O(1).
+		/// Entries fire on the first tick after their timepoint, so they might be delayed by up to one tick.
+		timing_wheel,
+	};
+
+	/**
+	 * \brief Options used to construct a timer
+	 */
+	struct timer_options {
+		/// \brief The backend used to store scheduled entries
+		timer_backend backend{timer_backend::ordered_set};
+		/// \brief Tick length used by the timing_wheel backend, ignored for ordered_set
+		std::chrono::nanoseconds resolution{std::chrono::milliseconds{1}};
+		/// \brief Run all due entries as one batch and submit non cancellable entries using a lock-free list.
+		///
+		/// In batched mode the timer thread takes all expired entries and pushed callbacks in a single critical
+		/// section and invokes them afterwards. schedule() and wait() without a stop_token never take the timer
+		/// lock and instead push onto an intrusive multi producer list, which the timer thread drains. With the
+		/// ordered_set backend the submitted nodes are kept in a binary heap instead of the set, so every entry
+		/// only needs the single allocation of its node.
+		bool batched{false};
+	};
+
 	/**
 	 * \brief A dispatcher that provides a way to schedule coroutines based on time.
 	 */
@@ -20,9 +54,36 @@ namespace asyncpp {
 		struct scheduled_entry {
 			std::chrono::steady_clock::time_point timepoint;
 			std::function<void(bool)> invokable;
+			/// \brief Coroutine resumed by wait(), used instead of invokable to avoid allocating a std::function
+			coroutine_handle<> handle{};
+			/// \brief Result location for handle
+			bool* result{};
 
 			scheduled_entry(std::chrono::steady_clock::time_point time, std::function<void(bool)> cbfn) noexcept
 				: timepoint(time), invokable(std::move(cbfn)) {}
+			scheduled_entry(std::chrono::steady_clock::time_point time, coroutine_handle<> hndl, bool* res) noexcept
+				: timepoint(time), handle(hndl), result(res) {}
+
+			/// \brief Check if the entry has a callback
+			explicit operator bool() const noexcept { return handle || invokable; }
+			/// \brief Invoke the callback or resume the coroutine
+			void invoke(bool res) const {
+				if (handle) {
+					*result = res;
+					handle.resume();
+				} else if (invokable)
+					invokable(res);
+			}
+			/// \brief Get a callback that invokes this entry with false, used on cancellation
+			std::function<void()> into_cancelled() && {
+				if (handle) {
+					return [hndl = handle, res = result]() {
+						*res = false;
+						hndl.resume();
+					};
+				}
+				return [cbfn = std::move(invokable)]() { cbfn(false); };
+			}
 
 			/// \brief Comparator struct that compares the timepoints
 			struct time_less {
@@ -52,18 +113,18 @@ namespace asyncpp {
 						auto entry =
 							new std::multiset<cancellable_scheduled_entry, scheduled_entry::time_less>::node_type(
 								parent->m_scheduled_cancellable_set.extract(it));
-						if (entry->value().invokable) {
+						if (entry->value()) {
 							parent->m_pushed.emplace([entry]() {
-								entry->value().invokable(false);
+								entry->value().invoke(false);
 								delete entry;
 							});
-						}
+						} else
+							delete entry;
 					} else {
 						std::unique_lock lck{parent->m_mtx};
 						auto entry = parent->m_scheduled_cancellable_set.extract(it);
-						lck.unlock();
-						if (entry.value().invokable) {
-							parent->m_pushed.emplace([cbfn = std::move(entry.value().invokable)]() { cbfn(false); });
+						if (entry.value()) {
+							parent->m_pushed.emplace(std::move(entry.value()).into_cancelled());
 							parent->m_cv.notify_all();
 						}
 					}
@@ -75,6 +136,38 @@ namespace asyncpp {
 			cancellable_scheduled_entry(std::chrono::steady_clock::time_point time,
 										std::function<void(bool)> cbfn) noexcept
 				: scheduled_entry{time, std::move(cbfn)} {}
+			cancellable_scheduled_entry(std::chrono::steady_clock::time_point time, coroutine_handle<> hndl,
+										bool* res) noexcept
+				: scheduled_entry{time, hndl, res} {}
+		};
+		struct wheel_entry;
+		using wheel_node = detail::timing_wheel_node<wheel_entry>;
+		struct wheel_entry : public scheduled_entry {
+			/// \brief Callback type used with stop_tokens
+			struct cancel_callback {
+				/// \brief Pointer to the timer containing this node
+				timer* parent;
+				/// \brief The wheel node containing this entry
+				wheel_node* node;
+				/// \brief Invocation operator called on cancellation
+				void operator()() const {
+					// If the stop_token is already signalled on construction we are called from within schedule(),
+					// which holds the lock and checks the cancelled flag once the callback is registered.
+					auto& entry = node->value();
+					entry.cancelled = true;
+					if (entry.in_construction) return;
+					std::unique_lock lck{parent->m_mtx};
+					parent->cancel_wheel_node(node);
+				}
+			};
+			mutable std::optional<asyncpp::stop_callback<cancel_callback>> cancel_token;
+			std::atomic<bool> cancelled{false};
+			std::atomic<bool> in_construction{true};
+			/// \brief Set once the node is removed from the wheel, protected by m_mtx
+			bool done{false};
+
+			template<typename... Args>
+			explicit wheel_entry(Args&&... args) noexcept : scheduled_entry{std::forward<Args>(args)...} {}
 		};
 
 	public:
@@ -82,6 +175,23 @@ namespace asyncpp {
 		 * \brief Construct a new timer
 		 */
 		timer() : m_thread{[this]() noexcept { this->run(); }} {}
+		/**
+		 * \brief Construct a new timer using a specific backend
+		 * \param backend The backend used to store scheduled entries
+		 * \param resolution Tick length used by the timing_wheel backend, ignored for ordered_set
+		 */
+		explicit timer(timer_backend backend, std::chrono::nanoseconds resolution = std::chrono::milliseconds{1})
+			: timer(timer_options{.backend = backend, .resolution = resolution}) {}
+		/**
+		 * \brief Construct a new timer
+		 * \param opts Options for the timer
+		 */
+		explicit timer(const timer_options& opts)
+			: m_resolution{(std::max)(opts.resolution, std::chrono::nanoseconds{1})}, m_batched{opts.batched} {
+			if (opts.backend == timer_backend::timing_wheel)
+				m_wheel = std::make_unique<detail::timing_wheel<wheel_entry>>();
+			m_thread = std::thread{[this]() noexcept { this->run(); }};
+		}
 		~timer() {
 			{
 				std::unique_lock lck{m_mtx};
@@ -92,6 +202,9 @@ namespace asyncpp {
 			assert(m_pushed.empty());
 			assert(m_scheduled_set.empty());
 			assert(m_scheduled_cancellable_set.empty());
+			assert(m_scheduled_heap.empty());
+			assert(!m_wheel || m_wheel->empty());
+			assert(m_submitted.load() == nullptr);
 		}
 		timer(const timer&) = delete;
 		timer& operator=(const timer&) = delete;
@@ -104,6 +217,20 @@ namespace asyncpp {
 			if (m_exit) throw std::logic_error("shutting down");
 			std::unique_lock lck(m_mtx);
 			m_pushed.emplace(std::move(cbfn));
+			count_push();
+			m_cv.notify_all();
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed in the timer thread
+		 * \param hndl The coroutine to resume
+		 */
+		void push_resume(coroutine_handle<> hndl) override {
+			if (m_exit) throw std::logic_error("shutting down");
+			std::unique_lock lck(m_mtx);
+			// coroutine_handle is trivially copyable and small enough to be stored without allocation
+			m_pushed.emplace(hndl);
+			count_push();
 			m_cv.notify_all();
 		}
 
@@ -113,10 +240,7 @@ namespace asyncpp {
 		 * \param timeout The time_point at which the callback should get executed
 		 */
 		void schedule(std::function<void(bool)> cbfn, std::chrono::steady_clock::time_point timeout) {
-			if (m_exit) throw std::logic_error("shutting down");
-			std::unique_lock lck(m_mtx);
-			m_scheduled_set.emplace(timeout, std::move(cbfn));
-			m_cv.notify_all();
+			schedule_entry(timeout, std::move(cbfn));
 		}
 		/**
 		 * \brief Schedule a callback to be executed after a certain duration expires.
@@ -144,12 +268,7 @@ namespace asyncpp {
 		 */
 		void schedule(std::function<void(bool)> cbfn, std::chrono::steady_clock::time_point timeout,
 					  asyncpp::stop_token stoken) {
-			if (m_exit) throw std::logic_error("shutting down");
-			std::unique_lock lck(m_mtx);
-			auto iter = m_scheduled_cancellable_set.emplace(timeout, std::move(cbfn));
-			iter->cancel_token.emplace(std::move(stoken), cancellable_scheduled_entry::cancel_callback{this, iter});
-			iter->in_construction = false;
-			m_cv.notify_all();
+			schedule_cancellable_entry(timeout, std::move(stoken), std::move(cbfn));
 		}
 		/**
 		 * \brief Schedule a callback to be executed after a certain duration expires with a stop_token
@@ -172,6 +291,35 @@ namespace asyncpp {
 			schedule(std::move(cbfn), timeout - Clock::now(), std::move(stoken));
 		}
 
+		// Defined before the non cancellable version, so its awaiter can deduce the return type of this one
+		/**
+		 * \brief Get an awaitable that pauses the current coroutine until the specified time_point is reached, allows cancellation.
+		 * \param timeout The time_point to wait for
+		 * \param stoken A stop_token that allows cancellation of the wait
+		 * \return An awaitable
+		 */
+		auto wait(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken) noexcept {
+			struct awaiter {
+				timer* const m_parent;
+				const std::chrono::steady_clock::time_point m_timeout;
+				asyncpp::stop_token m_stoptoken;
+				bool m_result{true};
+				awaiter(timer* parent, std::chrono::steady_clock::time_point timeout,
+						asyncpp::stop_token stoken) noexcept
+					: m_parent(parent), m_timeout(timeout), m_stoptoken(std::move(stoken)) {}
+
+				[[nodiscard]] bool await_ready() const noexcept {
+					return std::chrono::steady_clock::now() >= m_timeout;
+				}
+				void await_suspend(coroutine_handle<> hndl) {
+					m_parent->schedule_cancellable_entry(m_timeout, std::move(m_stoptoken), hndl, &m_result);
+				}
+				//NOLINTNEXTLINE(modernize-use-nodiscard)
+				constexpr bool await_resume() const noexcept { return m_result; }
+			};
+			return awaiter{this, timeout, std::move(stoken)};
+		}
+
 		/**
 		 * \brief Get an awaitable that pauses the current coroutine until the specified time_point is reached.
 		 * \return An awaitable
@@ -187,16 +335,13 @@ namespace asyncpp {
 				[[nodiscard]] bool await_ready() const noexcept {
 					return std::chrono::steady_clock::now() >= m_timeout;
 				}
-				void await_suspend(coroutine_handle<> hndl) {
-					m_parent->schedule(
-						[this, hndl](bool res) mutable {
-							m_result = res;
-							hndl.resume();
-						},
-						m_timeout);
-				}
+				void await_suspend(coroutine_handle<> hndl) { m_parent->schedule_entry(m_timeout, hndl, &m_result); }
 				//NOLINTNEXTLINE(modernize-use-nodiscard)
 				constexpr bool await_resume() const noexcept { return m_result; }
+				/// \brief Turn this into a cancellable wait, used by cancellable_task.
+				[[nodiscard]] auto with_stop_token(asyncpp::stop_token stoken) const noexcept {
+					return m_parent->wait(m_timeout, std::move(stoken));
+				}
 			};
 			return awaiter{this, timeout};
 		}
@@ -217,39 +362,6 @@ namespace asyncpp {
 			return wait(timeout - Clock::now());
 		}
 
-		/**
-		 * \brief Get an awaitable that pauses the current coroutine until the specified time_point is reached, allows cancellation.
-		 * \param timeout The time_point to wait for
-		 * \param stoken A stop_token that allows cancellation of the wait
-		 * \return An awaitable
-		 */
-		auto wait(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken) noexcept {
-			struct awaiter {
-				timer* const m_parent;
-				const std::chrono::steady_clock::time_point m_timeout;
-				asyncpp::stop_token m_stoptoken;
-				bool m_result{true};
-				awaiter(timer* parent, std::chrono::steady_clock::time_point timeout,
-						asyncpp::stop_token stoken) noexcept
-					: m_parent(parent), m_timeout(timeout), m_stoptoken(std::move(stoken)) {}
-
-				[[nodiscard]] bool await_ready() const noexcept {
-					return std::chrono::steady_clock::now() >= m_timeout;
-				}
-				void await_suspend(coroutine_handle<> hndl) {
-					m_parent->schedule(
-						[this, hndl](bool res) mutable {
-							m_result = res;
-							hndl.resume();
-						},
-						m_timeout, std::move(m_stoptoken));
-				}
-				//NOLINTNEXTLINE(modernize-use-nodiscard)
-				constexpr bool await_resume() const noexcept { return m_result; }
-			};
-			return awaiter{this, timeout, std::move(stoken)};
-		}
-
 		/**
 		 * \brief Get an awaitable that pauses the current coroutine until the specified duration is elapsed, allows cancellation.
 		 * \param timeout The duration to wait for
@@ -279,42 +391,291 @@ namespace asyncpp {
 			return instance;
 		}
 
+#if ASYNCPP_ENABLE_METRICS
+		/**
+		 * \brief Collect the counters of the timer thread.
+		 *
+		 * queue_depth contains both pushed callbacks and scheduled entries. Only available if ASYNCPP_ENABLE_METRICS
+		 * is set.
+		 */
+		dispatcher_metrics metrics() {
+			dispatcher_metrics res{};
+			res.workers = 1;
+			std::unique_lock lck(m_mtx);
+			m_metrics.collect(res);
+			res.queue_depth = m_pushed.size() + m_scheduled_set.size() + m_scheduled_cancellable_set.size() +
+							  m_scheduled_heap.size();
+			if (m_wheel) res.queue_depth += m_wheel->size();
+			return res;
+		}
+#endif
+
 	private:
 		std::mutex m_mtx{};
 		std::condition_variable m_cv{};
 		std::queue<std::function<void()>> m_pushed{};
 		std::multiset<scheduled_entry, scheduled_entry::time_less> m_scheduled_set{};
 		std::multiset<cancellable_scheduled_entry, scheduled_entry::time_less> m_scheduled_cancellable_set{};
+		// Only used with timer_backend::timing_wheel
+		const std::chrono::steady_clock::time_point m_origin{std::chrono::steady_clock::now()};
+		const std::chrono::nanoseconds m_resolution{std::chrono::milliseconds{1}};
+		std::unique_ptr<detail::timing_wheel<wheel_entry>> m_wheel{};
+		// Nodes cancelled but not yet invoked, linked using node::next
+		wheel_node* m_wheel_cancelled{};
+		// Only used in batched mode
+		const bool m_batched{false};
+		// Lock-free submission list, linked using node::next. The newest node is at the front.
+		std::atomic<wheel_node*> m_submitted{nullptr};
+		// Submitted nodes with the ordered_set backend, a min heap on the timepoint. The unused expiry field of
+		// each node holds a sequence number, so entries with equal timepoints keep their order.
+		std::vector<wheel_node*> m_scheduled_heap{};
+		std::uint64_t m_heap_sequence{};
+		// Set by the timer thread before it blocks on m_cv, so submitters know they need to wake it
+		std::atomic<bool> m_sleeping{false};
+		// Reused buffers for expired entries, only accessed by the timer thread
+		std::vector<decltype(m_scheduled_set)::node_type> m_due{};
+		std::vector<decltype(m_scheduled_cancellable_set)::node_type> m_due_cancellable{};
+		std::vector<wheel_node*> m_due_nodes{};
 		std::atomic<bool> m_exit{};
+#if ASYNCPP_ENABLE_METRICS
+		// The push counter is written with m_mtx held, all others by the timer thread
+		detail::metrics_slot m_metrics{};
+#endif
 		std::thread m_thread{};
 
+		std::uint64_t to_tick(std::chrono::steady_clock::time_point time) const noexcept {
+			if (time <= m_origin) return 0;
+			// Round up, so entries never fire before their timepoint
+			return static_cast<std::uint64_t>((time - m_origin + m_resolution - std::chrono::nanoseconds{1}) /
+											  m_resolution);
+		}
+
+		template<typename... Args>
+		void schedule_entry(std::chrono::steady_clock::time_point timeout, Args&&... args) {
+			if (m_exit) throw std::logic_error("shutting down");
+			if (m_batched) {
+				submit(detail::timing_wheel<wheel_entry>::make_node(to_tick(timeout), timeout,
+																	std::forward<Args>(args)...));
+				return;
+			}
+			std::unique_lock lck(m_mtx);
+			if (m_wheel)
+				m_wheel->emplace(to_tick(timeout), timeout, std::forward<Args>(args)...);
+			else
+				m_scheduled_set.emplace(timeout, std::forward<Args>(args)...);
+			m_cv.notify_all();
+		}
+
+		template<typename... Args>
+		void schedule_cancellable_entry(std::chrono::steady_clock::time_point timeout, asyncpp::stop_token stoken,
+										Args&&... args) {
+			if (m_exit) throw std::logic_error("shutting down");
+			std::unique_lock lck(m_mtx);
+			if (m_wheel) {
+				auto node = m_wheel->emplace(to_tick(timeout), timeout, std::forward<Args>(args)...);
+				auto& entry = node->value();
+				entry.cancel_token.emplace(std::move(stoken), wheel_entry::cancel_callback{this, node});
+				entry.in_construction = false;
+				if (entry.cancelled) cancel_wheel_node(node);
+			} else {
+				auto iter = m_scheduled_cancellable_set.emplace(timeout, std::forward<Args>(args)...);
+				iter->cancel_token.emplace(std::move(stoken), cancellable_scheduled_entry::cancel_callback{this, iter});
+				iter->in_construction = false;
+			}
+			m_cv.notify_all();
+		}
+
+		void submit(wheel_node* node) noexcept {
+			auto head = m_submitted.load(std::memory_order::relaxed);
+			do {
+				node->next = head;
+			} while (!m_submitted.compare_exchange_weak(head, node, std::memory_order::seq_cst,
+														std::memory_order::relaxed));
+			// If the list was not empty, whoever pushed the first node already took care of waking the timer
+			if (head == nullptr && m_sleeping.load(std::memory_order::seq_cst)) {
+				std::unique_lock lck{m_mtx};
+				m_cv.notify_all();
+			}
+		}
+
+		// Move all submitted nodes into the backend, needs to be called with m_mtx held
+		void take_submitted() noexcept {
+			auto list = m_submitted.exchange(nullptr, std::memory_order::acquire);
+			// Reverse the list, so entries with equal timepoints keep their order
+			wheel_node* reversed = nullptr;
+			while (list != nullptr) {
+				auto next = list->next;
+				list->next = reversed;
+				reversed = list;
+				list = next;
+			}
+			while (reversed != nullptr) {
+				auto node = std::exchange(reversed, reversed->next);
+				if (m_wheel) {
+					node->value().in_construction = false;
+					m_wheel->adopt(node);
+				} else {
+					node->expiry = m_heap_sequence++;
+					m_scheduled_heap.push_back(node);
+					std::push_heap(m_scheduled_heap.begin(), m_scheduled_heap.end(), heap_later);
+				}
+			}
+		}
+
+		// Heap comparator, the node firing first ends up at the front
+		static bool heap_later(const wheel_node* lhs, const wheel_node* rhs) noexcept {
+			if (lhs->value().timepoint != rhs->value().timepoint)
+				return lhs->value().timepoint > rhs->value().timepoint;
+			return lhs->expiry > rhs->expiry;
+		}
+
+		// Remove the first node from m_scheduled_heap, needs to be called with m_mtx held
+		wheel_node* pop_heap_node() noexcept {
+			std::pop_heap(m_scheduled_heap.begin(), m_scheduled_heap.end(), heap_later);
+			auto node = m_scheduled_heap.back();
+			m_scheduled_heap.pop_back();
+			return node;
+		}
+
+		// Needs to be called with m_mtx held, which serializes the writers of the push counter
+		void count_push() noexcept {
+#if ASYNCPP_ENABLE_METRICS
+			m_metrics.count_push();
+			trace(dispatch_event::push);
+#endif
+		}
+
+		// Invoke a callback on the timer thread, m_mtx must not be held
+		template<typename Fn>
+		void run_traced(Fn&& fn) noexcept {
+#if ASYNCPP_ENABLE_METRICS
+			trace(dispatch_event::start);
+			const auto start = std::chrono::steady_clock::now();
+#endif
+			try {
+				fn();
+			} catch (...) { std::terminate(); }
+#if ASYNCPP_ENABLE_METRICS
+			m_metrics.count_callback(std::chrono::steady_clock::now() - start);
+			trace(dispatch_event::end);
+#endif
+		}
+
+		void run_pushed_batch(std::unique_lock<std::mutex>& lck) noexcept {
+			if (m_pushed.empty()) return;
+			auto list = std::exchange(m_pushed, {});
+			lck.unlock();
+			while (!list.empty()) {
+				if (list.front()) run_traced(list.front());
+				list.pop();
+			}
+			lck.lock();
+		}
+
+		void run_due_batch(std::unique_lock<std::mutex>& lck, std::chrono::steady_clock::time_point now) noexcept {
+			while (!m_scheduled_heap.empty() && m_scheduled_heap.front()->value().timepoint <= now)
+				m_due_nodes.push_back(pop_heap_node());
+			while (!m_scheduled_set.empty() && m_scheduled_set.begin()->timepoint <= now)
+				m_due.emplace_back(m_scheduled_set.extract(m_scheduled_set.begin()));
+			while (!m_scheduled_cancellable_set.empty() && m_scheduled_cancellable_set.begin()->timepoint <= now) {
+				auto& entry = m_due_cancellable.emplace_back(
+					m_scheduled_cancellable_set.extract(m_scheduled_cancellable_set.begin()));
+				entry.value().cancel_token.reset();
+			}
+			if (m_due_nodes.empty() && m_due.empty() && m_due_cancellable.empty()) return;
+			lck.unlock();
+			for (auto node : m_due_nodes) {
+				if (node->value()) run_traced([&]() { node->value().invoke(true); });
+				detail::timing_wheel<wheel_entry>::destroy_node(node);
+			}
+			for (auto& e : m_due) {
+				if (e.value()) run_traced([&]() { e.value().invoke(true); });
+			}
+			for (auto& e : m_due_cancellable) {
+				if (e.value()) run_traced([&]() { e.value().invoke(true); });
+			}
+			m_due_nodes.clear();
+			m_due.clear();
+			m_due_cancellable.clear();
+			lck.lock();
+		}
+
+		// Needs to be called with m_mtx held
+		void cancel_wheel_node(wheel_node* node) noexcept {
+			// The node might already have expired or been cancelled
+			if (node->value().done) return;
+			node->value().done = true;
+			m_wheel->unlink(node);
+			node->next = m_wheel_cancelled;
+			m_wheel_cancelled = node;
+			m_cv.notify_all();
+		}
+
+		// Invoke and release a list of nodes taken out of the wheel, needs to be called with m_mtx held
+		void invoke_wheel_nodes(std::unique_lock<std::mutex>& lck, wheel_node* list, bool result) noexcept {
+			if (list == nullptr) return;
+			for (auto node = list; node != nullptr; node = node->next)
+				node->value().done = true;
+			// The cancel callback might be running concurrently and waiting for the lock, destroying the
+			// stop_callback waits for it to finish, so we need to unlock first.
+			lck.unlock();
+			for (auto node = list; node != nullptr; node = node->next) {
+				node->value().cancel_token.reset();
+				run_traced([&]() { node->value().invoke(result); });
+			}
+			lck.lock();
+			while (list != nullptr)
+				m_wheel->release(std::exchange(list, list->next));
+		}
+
+		void run_wheel(std::unique_lock<std::mutex>& lck, std::chrono::nanoseconds& timeout) {
+			invoke_wheel_nodes(lck, std::exchange(m_wheel_cancelled, nullptr), false);
+			const auto now = std::chrono::steady_clock::now();
+			invoke_wheel_nodes(lck, m_wheel->advance(static_cast<std::uint64_t>((now - m_origin) / m_resolution)),
+							   true);
+			const auto next = m_wheel->next_tick();
+			if (next == UINT64_MAX) return;
+			if (next <= m_wheel->current_tick() || m_wheel_cancelled != nullptr) {
+				timeout = std::chrono::nanoseconds{0};
+				return;
+			}
+			const auto next_time = m_origin + m_resolution * static_cast<std::chrono::nanoseconds::rep>(next);
+			timeout = (std::min)(std::chrono::duration_cast<std::chrono::nanoseconds>(next_time - now), timeout);
+		}
+
 		void run() noexcept {
 #ifdef __linux__
 			pthread_setname_np(pthread_self(), "asyncpp_timer");
 #endif
 			while (true) {
 				std::unique_lock lck(m_mtx);
-				while (!m_pushed.empty()) {
-					auto entry = std::move(m_pushed.front());
-					m_pushed.pop();
-					if (entry) {
-						lck.unlock();
-						try {
-							entry();
-						} catch (...) { std::terminate(); }
-						lck.lock();
+				take_submitted();
+				if (m_batched) {
+					run_pushed_batch(lck);
+					// Submissions that arrived while the batch was running
+					take_submitted();
+				} else {
+					while (!m_pushed.empty()) {
+						auto entry = std::move(m_pushed.front());
+						m_pushed.pop();
+						if (entry) {
+							lck.unlock();
+							run_traced(entry);
+							lck.lock();
+						}
 					}
 				}
+				std::chrono::nanoseconds timeout{500 * 1000 * 1000};
+				if (m_wheel) run_wheel(lck, timeout);
 				auto now = std::chrono::steady_clock::now();
+				if (m_batched) run_due_batch(lck, now);
 				while (!m_scheduled_set.empty()) {
 					auto elem = m_scheduled_set.begin();
 					if (elem->timepoint > now) break;
 					auto handle = m_scheduled_set.extract(elem);
-					if (handle.value().invokable) {
+					if (handle.value()) {
 						lck.unlock();
-						try {
-							handle.value().invokable(true);
-						} catch (...) { std::terminate(); }
+						run_traced([&]() { handle.value().invoke(true); });
 						lck.lock();
 					}
 				}
@@ -322,40 +683,67 @@ namespace asyncpp {
 					auto elem = m_scheduled_cancellable_set.begin();
 					if (elem->timepoint > now) break;
 					auto handle = m_scheduled_cancellable_set.extract(elem);
-					if (handle.value().invokable) {
+					if (handle.value()) {
 						handle.value().cancel_token.reset();
 						lck.unlock();
-						try {
-							handle.value().invokable(true);
-						} catch (...) { std::terminate(); }
+						run_traced([&]() { handle.value().invoke(true); });
 						lck.lock();
 					}
 				}
 				now = std::chrono::steady_clock::now();
-				std::chrono::nanoseconds timeout{500 * 1000 * 1000};
+				if (!m_scheduled_heap.empty())
+					timeout = (std::min)(m_scheduled_heap.front()->value().timepoint - now, timeout);
 				if (!m_scheduled_set.empty()) timeout = (std::min)(m_scheduled_set.begin()->timepoint - now, timeout);
 				if (!m_scheduled_cancellable_set.empty())
 					timeout = (std::min)(m_scheduled_cancellable_set.begin()->timepoint - now, timeout);
 				if (m_pushed.empty() && timeout.count() > 0) {
 					if (m_exit) break;
-					m_cv.wait_for(lck, timeout);
+					// Pairs with submit(), either we see the new node or the submitter sees us sleeping
+					m_sleeping.store(true, std::memory_order::seq_cst);
+					if (m_submitted.load(std::memory_order::seq_cst) == nullptr) {
+#if ASYNCPP_ENABLE_METRICS
+						const auto start = std::chrono::steady_clock::now();
+						m_cv.wait_for(lck, timeout);
+						m_metrics.count_idle(std::chrono::steady_clock::now() - start);
+#else
+						m_cv.wait_for(lck, timeout);
+#endif
+					}
+					m_sleeping.store(false, std::memory_order::relaxed);
 				}
 			}
 			std::unique_lock lck(m_mtx);
+			take_submitted();
 			auto set = std::move(m_scheduled_set);
 			auto cset = std::move(m_scheduled_cancellable_set);
+			auto heap = std::move(m_scheduled_heap);
+			// Keep the order entries would have fired in
+			std::sort_heap(heap.begin(), heap.end(), heap_later);
+			std::reverse(heap.begin(), heap.end());
+			if (m_wheel) {
+				invoke_wheel_nodes(lck, std::exchange(m_wheel_cancelled, nullptr), false);
+				invoke_wheel_nodes(lck, m_wheel->take_all(), false);
+			}
 			lck.unlock();
+			for (auto node : heap) {
+				if (node->value()) {
+					try {
+						node->value().invoke(false);
+					} catch (...) { std::terminate(); }
+				}
+				detail::timing_wheel<wheel_entry>::destroy_node(node);
+			}
 			for (const auto& entry : set) {
-				if (entry.invokable) {
+				if (entry) {
 					try {
-						entry.invokable(false);
+						entry.invoke(false);
 					} catch (...) { std::terminate(); }
 				}
 			}
 			for (const auto& entry : cset) {
-				if (entry.invokable) {
+				if (entry) {
 					try {
-						entry.invokable(false);
+						entry.invoke(false);
 					} catch (...) { std::terminate(); }
 				}
 			}
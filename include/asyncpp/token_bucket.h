@@ -0,0 +1,226 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/timer.h>
+#include <asyncpp/trampoline.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace asyncpp {
+	/**
+	 * \brief Rate limiter handing out tokens that are refilled at a fixed rate.
+	 *
+	 * The bucket holds up to capacity tokens and starts full. Every interval tokens_per_interval tokens are added.
+	 * acquire(n) resumes once n tokens could be taken, waiters are served in the order they started to wait, so a
+	 * big request blocks all requests behind it instead of getting starved.
+	 *
+	 * Tokens are refilled lazily from the elapsed time, so nothing is scheduled as long as nobody has to wait.
+	 * Waiters are kept in an intrusive list and at most one timer entry is scheduled at any time, for the point the
+	 * first waiter can be served. It releases as many waiters as the tokens allow and schedules the next refill if
+	 * some are left, so the load on the timer does not depend on the number of waiting coroutines.
+	 * \note The bucket needs to outlive all waiting coroutines and the timer needs to outlive the bucket.
+	 */
+	class token_bucket {
+		struct awaiter;
+
+	public:
+		/**
+		 * \brief Construct a new token bucket
+		 * \param tmr The timer used to wake up waiting coroutines
+		 * \param capacity The maximum number of tokens, which is also the initial number
+		 * \param interval The time between two refills
+		 * \param tokens_per_interval The number of tokens added on every refill
+		 */
+		token_bucket(timer& tmr, size_t capacity, std::chrono::nanoseconds interval, size_t tokens_per_interval = 1)
+			: m_timer{tmr}, m_capacity{capacity}, m_interval{interval}, m_tokens_per_interval{tokens_per_interval},
+			  m_tokens{capacity} {
+			assert(capacity != 0 && tokens_per_interval != 0 && interval.count() > 0);
+		}
+#ifndef NDEBUG
+		~token_bucket() noexcept { assert(m_awaiters == nullptr && !m_refill_scheduled); }
+#endif
+		token_bucket(const token_bucket&) = delete;
+		token_bucket(token_bucket&&) = delete;
+		token_bucket& operator=(const token_bucket&) = delete;
+		token_bucket& operator=(token_bucket&&) = delete;
+
+		/**
+		 * \brief Try to take tokens without suspending
+		 * \param count The number of tokens to take
+		 * \return true if the tokens were taken, false if not enough were available or coroutines are waiting
+		 */
+		[[nodiscard]] bool try_acquire(size_t count = 1) {
+			std::unique_lock lck{m_mtx};
+			return take(count, std::chrono::steady_clock::now());
+		}
+
+		/**
+		 * \brief Take tokens from the bucket, suspending until enough are available.
+		 *
+		 * The coroutine will resume on the current dispatcher if the thread belongs to a dispatcher or inside the
+		 * timer thread if not. The awaitable returns false if the tokens could not be taken because the timer
+		 * is shutting down.
+		 * \param count The number of tokens to take, at most the capacity
+		 * \return Awaitable
+		 */
+		[[nodiscard]] auto acquire(size_t count = 1) noexcept { return awaiter{this, count, dispatcher::current()}; }
+
+		/**
+		 * \brief Take tokens from the bucket, suspending until enough are available.
+		 * \param count The number of tokens to take, at most the capacity
+		 * \param resume_dispatcher The dispatcher to resume on or nullptr to resume inside the timer thread
+		 * \return Awaitable
+		 */
+		[[nodiscard]] auto acquire(size_t count, dispatcher* resume_dispatcher) noexcept {
+			return awaiter{this, count, resume_dispatcher};
+		}
+
+		/**
+		 * \brief Query the number of tokens that can be taken right away
+		 * \note Do not base decisions on this value, as it might change at any time
+		 */
+		[[nodiscard]] size_t available() {
+			std::unique_lock lck{m_mtx};
+			if (m_awaiters != nullptr) return 0;
+			refill(std::chrono::steady_clock::now());
+			return m_tokens;
+		}
+
+	private:
+		timer& m_timer;
+		const size_t m_capacity;
+		const std::chrono::nanoseconds m_interval;
+		const size_t m_tokens_per_interval;
+
+		std::mutex m_mtx{};
+		size_t m_tokens;
+		std::chrono::steady_clock::time_point m_last_refill{std::chrono::steady_clock::now()};
+		// Waiters in order of arrival
+		awaiter* m_awaiters{nullptr};
+		awaiter* m_awaiters_tail{nullptr};
+		// Set while a refill entry is scheduled on the timer, which is the case iff coroutines are waiting
+		bool m_refill_scheduled{false};
+
+		struct [[nodiscard]] awaiter {
+			constexpr awaiter(token_bucket* parent, size_t count, dispatcher* dispatcher) noexcept
+				: m_parent(parent), m_dispatcher(dispatcher), m_count(count) {}
+			[[nodiscard]] bool await_ready() { return m_count == 0 || m_parent->try_acquire(m_count); }
+			[[nodiscard]] bool await_suspend(coroutine_handle<> hdl) {
+				m_handle = hdl;
+				return m_parent->enqueue(this);
+			}
+			//NOLINTNEXTLINE(modernize-use-nodiscard)
+			constexpr bool await_resume() const noexcept { return m_result; }
+
+			token_bucket* m_parent;
+			dispatcher* m_dispatcher;
+			size_t m_count;
+			awaiter* m_next{nullptr};
+			coroutine_handle<> m_handle{};
+			bool m_result{true};
+		};
+
+		// Add the tokens of all intervals passed since the last refill, needs to be called with m_mtx held
+		void refill(std::chrono::steady_clock::time_point now) noexcept {
+			if (now < m_last_refill + m_interval) return;
+			const auto intervals = static_cast<size_t>((now - m_last_refill) / m_interval);
+			m_last_refill += m_interval * intervals;
+			// Clamping the intervals first avoids overflowing after a long idle time
+			m_tokens = (std::min)(m_capacity, m_tokens + (std::min)(intervals, m_capacity) * m_tokens_per_interval);
+		}
+
+		// Needs to be called with m_mtx held
+		bool take(size_t count, std::chrono::steady_clock::time_point now) noexcept {
+			// Do not overtake waiting coroutines
+			if (m_awaiters != nullptr) return false;
+			refill(now);
+			if (m_tokens < count) return false;
+			m_tokens -= count;
+			return true;
+		}
+
+		// Point in time at which the first waiter can be served, needs to be called with m_mtx held
+		std::chrono::steady_clock::time_point next_refill() const noexcept {
+			const auto missing = m_awaiters->m_count - m_tokens;
+			const auto intervals = (missing + m_tokens_per_interval - 1) / m_tokens_per_interval;
+			return m_last_refill + m_interval * intervals;
+		}
+
+		bool enqueue(awaiter* await) {
+			assert(await->m_count <= m_capacity);
+			std::unique_lock lck{m_mtx};
+			if (take(await->m_count, std::chrono::steady_clock::now())) return false;
+			if (m_awaiters == nullptr)
+				m_awaiters = await;
+			else
+				m_awaiters_tail->m_next = await;
+			m_awaiters_tail = await;
+			if (m_refill_scheduled) return true;
+			try {
+				// Callbacks are invoked without holding the timer lock, so this can not deadlock with on_refill()
+				m_timer.schedule([this](bool ok) { on_refill(ok); }, next_refill());
+			} catch (...) {
+				// The timer is shutting down. Nobody else was waiting, otherwise a refill would be scheduled.
+				m_awaiters = m_awaiters_tail = nullptr;
+				await->m_result = false;
+				return false;
+			}
+			m_refill_scheduled = true;
+			return true;
+		}
+
+		void on_refill(bool ok) {
+			awaiter* ready = nullptr;
+			awaiter* ready_tail = nullptr;
+			{
+				std::unique_lock lck{m_mtx};
+				refill(std::chrono::steady_clock::now());
+				while (m_awaiters != nullptr && (!ok || m_awaiters->m_count <= m_tokens)) {
+					auto head = m_awaiters;
+					m_awaiters = head->m_next;
+					head->m_next = nullptr;
+					if (ok)
+						m_tokens -= head->m_count;
+					else
+						head->m_result = false;
+					if (ready == nullptr)
+						ready = head;
+					else
+						ready_tail->m_next = head;
+					ready_tail = head;
+				}
+				if (m_awaiters == nullptr) {
+					m_awaiters_tail = nullptr;
+					m_refill_scheduled = false;
+				} else {
+					try {
+						m_timer.schedule([this](bool ok) { on_refill(ok); }, next_refill());
+					} catch (...) {
+						// The timer is shutting down, fail everyone still waiting
+						for (auto it = m_awaiters; it != nullptr; it = it->m_next)
+							it->m_result = false;
+						if (ready == nullptr)
+							ready = m_awaiters;
+						else
+							ready_tail->m_next = m_awaiters;
+						m_awaiters = m_awaiters_tail = nullptr;
+						m_refill_scheduled = false;
+					}
+				}
+			}
+			// The bucket might be destroyed by a resumed coroutine, so only the awaiters are touched from here on
+			while (ready != nullptr) {
+				auto next = ready->m_next;
+				if (ready->m_dispatcher != nullptr)
+					ready->m_dispatcher->push_resume(ready->m_handle);
+				else
+					resume_trampoline::resume(ready->m_handle);
+				ready = next;
+			}
+		}
+	};
+} // namespace asyncpp
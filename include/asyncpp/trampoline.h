@@ -0,0 +1,95 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+#ifndef ASYNCPP_RESUME_TRAMPOLINE
+#define ASYNCPP_RESUME_TRAMPOLINE 0
+#endif
+
+namespace asyncpp {
+	/**
+	 * \brief Per thread trampoline for resuming coroutines without growing the native stack.
+	 *
+	 * Synchronization primitives like mutex, the events or channel resume waiting coroutines inline, from within
+	 * the call that notifies them. If the resumed coroutine notifies the next one right away (for example in a long
+	 * chain of unlocks), every hand over adds another set of frames to the native stack. With the trampoline enabled
+	 * on a thread, a coroutine notified while another one is resumed by the trampoline is put into a queue instead.
+	 * The outermost resumption drains that queue in a loop once the coroutine it resumed suspends, so the stack
+	 * depth stays constant and coroutines are resumed in the order they were notified.
+	 *
+	 * The trampoline is disabled by default, because a coroutine that blocks the thread (e.g. waiting on a future)
+	 * after notifying another one would prevent it from running. Construct a resume_trampoline to enable it for the
+	 * current thread, or define ASYNCPP_RESUME_TRAMPOLINE to 1 to enable it on all threads.
+	 */
+	class resume_trampoline {
+	public:
+		/**
+		 * \brief Enable (or disable) the trampoline for the current thread until this object gets destroyed
+		 * \param enable Whether to enable or disable the trampoline
+		 */
+		explicit resume_trampoline(bool enable = true) noexcept : m_previous{g_enabled} { g_enabled = enable; }
+		~resume_trampoline() noexcept { g_enabled = m_previous; }
+		resume_trampoline(const resume_trampoline&) = delete;
+		resume_trampoline& operator=(const resume_trampoline&) = delete;
+
+		/// \brief Check if the trampoline is enabled for the current thread
+		[[nodiscard]] static bool enabled() noexcept { return g_enabled; }
+
+		/**
+		 * \brief Resume a coroutine using the trampoline
+		 *
+		 * If the trampoline is disabled this is the same as calling hndl.resume(). Otherwise the coroutine is
+		 * resumed right away if no other one is currently resumed by the trampoline, or queued if there is.
+		 * \param hndl The coroutine to resume
+		 */
+		static void resume(coroutine_handle<> hndl) {
+			if (!g_enabled) return hndl.resume();
+			if (g_draining) {
+				try {
+					g_queue.push_back(hndl);
+					return;
+				} catch (...) {}
+				// Out of memory, fall back to a recursive resume
+				return hndl.resume();
+			}
+			g_draining = true;
+			std::exception_ptr error{};
+			try {
+				hndl.resume();
+			} catch (...) { error = std::current_exception(); }
+			// Resuming a queued coroutine might queue more, so the size needs to be checked in every iteration
+			for (size_t i = 0; i < g_queue.size(); i++) {
+				try {
+					g_queue[i].resume();
+				} catch (...) {
+					if (!error) error = std::current_exception();
+				}
+			}
+			g_queue.clear();
+			g_draining = false;
+			if (error) std::rethrow_exception(error);
+		}
+
+	private:
+		bool m_previous;
+
+#if defined(ASYNCPP_SO_COMPAT)
+		static thread_local bool g_enabled;
+		static thread_local bool g_draining;
+		static thread_local std::vector<coroutine_handle<>> g_queue;
+#else
+		static thread_local inline bool g_enabled = ASYNCPP_RESUME_TRAMPOLINE != 0;
+		static thread_local inline bool g_draining = false;
+		static thread_local inline std::vector<coroutine_handle<>> g_queue{};
+#endif
+	};
+
+#if defined(ASYNCPP_SO_COMPAT_IMPL)
+	thread_local bool resume_trampoline::g_enabled = ASYNCPP_RESUME_TRAMPOLINE != 0;
+	thread_local bool resume_trampoline::g_draining = false;
+	thread_local std::vector<coroutine_handle<>> resume_trampoline::g_queue{};
+#endif
+} // namespace asyncpp
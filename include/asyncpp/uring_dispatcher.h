@@ -0,0 +1,821 @@
+#pragma once
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define ASYNCPP_HAS_URING 1
+
+namespace asyncpp {
+	class uring_buffer;
+	class uring_buffer_pool;
+
+	/**
+	 * \brief Dispatcher running an event loop on top of a Linux io_uring.
+	 *
+	 * Besides executing callbacks like simple_dispatcher it provides awaitables for the most common I/O operations,
+	 * which resume with the result of the corresponding syscall (or the negated errno on failure). Operations
+	 * started on the thread running the loop place their submission queue entry directly in the ring, all of them
+	 * are submitted together with a single io_uring_enter() once the loop ran out of callbacks. The same call waits
+	 * for completions, which are then reaped in bulk and the waiting coroutines resumed on the loop thread.
+	 * Operations started on other threads are handed to the loop first.
+	 *
+	 * Every operation can be limited using timeout(), which adds a linked timeout entry that cancels the operation
+	 * if it does not complete in time. It then resumes with -ECANCELED.
+	 *
+	 * Callbacks pushed from other threads wake up the loop using an eventfd, which the loop keeps a read pending
+	 * on. The eventfd is only written if the loop is actually waiting inside the kernel.
+	 *
+	 * Data can be received into the buffers of a uring_buffer_pool registered with the ring and sent from them
+	 * using send_zc(), which avoids copying it in user space as well as inside the kernel.
+	 */
+	class uring_dispatcher : public dispatcher {
+	public:
+		class io_awaiter;
+
+		/**
+		 * \brief Create a new io_uring
+		 * \param entries The size of the submission queue
+		 * \throw std::system_error if creating the ring failed, e.g. because io_uring is not supported
+		 */
+		explicit uring_dispatcher(unsigned entries = 256) {
+			io_uring_params params{};
+			params.flags = IORING_SETUP_CLAMP;
+			m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+			if (m_fd < 0) throw std::system_error(errno, std::system_category(), "io_uring_setup failed");
+			try {
+				map_rings(params);
+				m_wake_fd = eventfd(0, EFD_CLOEXEC);
+				if (m_wake_fd < 0) throw std::system_error(errno, std::system_category(), "eventfd failed");
+			} catch (...) {
+				unmap_rings();
+				close(m_fd);
+				throw;
+			}
+		}
+		~uring_dispatcher() {
+			assert(m_inflight == 0 && "uring_dispatcher destroyed with pending operations");
+			unmap_rings();
+			close(m_wake_fd);
+			close(m_fd);
+		}
+		uring_dispatcher(const uring_dispatcher&) = delete;
+		uring_dispatcher& operator=(const uring_dispatcher&) = delete;
+
+		/// \brief Get the file descriptor of the ring
+		[[nodiscard]] int native_handle() const noexcept { return m_fd; }
+
+		/**
+		 * \brief Push a function to be executed on the dispatcher.
+		 * \param cbfn The callback
+		 */
+		void push(std::function<void()> cbfn) override {
+			if (!cbfn) return;
+			{
+				std::unique_lock lck{m_mtx};
+				m_queue.emplace_back(std::move(cbfn));
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Push a coroutine to be resumed on the dispatcher.
+		 * \param hndl The coroutine to resume
+		 */
+		void push_resume(coroutine_handle<> hndl) override {
+			if (!hndl) return;
+			{
+				std::unique_lock lck{m_mtx};
+				// coroutine_handle is trivially copyable and small enough to be stored without allocation
+				m_queue.emplace_back(hndl);
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Push multiple coroutines to be resumed on the dispatcher, taking the lock only once.
+		 * \param hndls The coroutines to resume
+		 */
+		void push_resume_batch(std::span<const coroutine_handle<>> hndls) override {
+			{
+				std::unique_lock lck{m_mtx};
+				for (auto hndl : hndls) {
+					if (hndl) m_queue.emplace_back(hndl);
+				}
+			}
+			wake();
+		}
+
+		/**
+		 * \brief Stop the dispatcher. It will return on the next iteration, regardless if there is any work left.
+		 *
+		 * A stop requested before run() is called makes it return right away, same as simple_dispatcher.
+		 */
+		void stop() noexcept {
+			m_done = true;
+			wake();
+		}
+
+		/**
+		 * \brief Block and process callbacks and I/O completions until stop is called.
+		 */
+		void run() {
+			dispatcher* const old_dispatcher = dispatcher::current(this);
+			if (!m_wake_armed) arm_wake();
+			std::deque<std::function<void()>> queue;
+			while (!m_done) {
+				{
+					std::unique_lock lck{m_mtx};
+					queue.swap(m_queue);
+				}
+				for (auto& cbfn : queue)
+					cbfn();
+				queue.clear();
+				// Only sleep in the kernel if nothing got pushed in the meantime, see wake()
+				m_sleeping.store(true);
+				bool wait = !m_done;
+				if (wait) {
+					std::unique_lock lck{m_mtx};
+					wait = m_queue.empty();
+				}
+				enter(wait ? 1 : 0);
+				m_sleeping.store(false, std::memory_order::relaxed);
+				reap();
+			}
+			// Submit whatever was prepared last, so the kernel does not wait for another run()
+			enter(0);
+			dispatcher::current(old_dispatcher);
+		}
+
+		/**
+		 * \brief Read from a file descriptor, like pread(2).
+		 * \param offset The file offset to read from, -1 to use (and update) the current file position
+		 * \return Awaitable resuming with the number of bytes read or -errno
+		 */
+		[[nodiscard]] io_awaiter read(int fd, std::span<std::byte> buffer, uint64_t offset = -1) noexcept;
+		/**
+		 * \brief Write to a file descriptor, like pwrite(2).
+		 * \param offset The file offset to write at, -1 to use (and update) the current file position
+		 * \return Awaitable resuming with the number of bytes written or -errno
+		 */
+		[[nodiscard]] io_awaiter write(int fd, std::span<const std::byte> buffer, uint64_t offset = -1) noexcept;
+		/**
+		 * \brief Receive from a socket, like recv(2).
+		 * \return Awaitable resuming with the number of bytes received or -errno
+		 */
+		[[nodiscard]] io_awaiter recv(int fd, std::span<std::byte> buffer, int flags = 0) noexcept;
+		/**
+		 * \brief Send on a socket, like send(2).
+		 * \return Awaitable resuming with the number of bytes sent or -errno
+		 */
+		[[nodiscard]] io_awaiter send(int fd, std::span<const std::byte> buffer, int flags = 0) noexcept;
+		/**
+		 * \brief Send on a socket without copying the data into the kernel (IORING_OP_SEND_ZC).
+		 *
+		 * The awaiter only resumes once the kernel is done with the buffer, so it can be reused or freed right
+		 * away. Sockets not supporting zero copy (e.g. unix sockets) complete with -EOPNOTSUPP.
+		 * \return Awaitable resuming with the number of bytes sent or -errno
+		 */
+		[[nodiscard]] io_awaiter send_zc(int fd, std::span<const std::byte> buffer, int flags = 0) noexcept;
+		/**
+		 * \brief Send the contents of a leased buffer without copying, using its registration with the ring.
+		 * \note The buffer needs to belong to a pool of this dispatcher and stay alive until the operation completes.
+		 * \return Awaitable resuming with the number of bytes sent or -errno
+		 */
+		[[nodiscard]] io_awaiter send_zc(int fd, const uring_buffer& buffer, int flags = 0) noexcept;
+		/**
+		 * \brief Accept a connection, like accept4(2).
+		 * \note addr and addrlen need to stay valid until the operation completes.
+		 * \return Awaitable resuming with the new file descriptor or -errno
+		 */
+		[[nodiscard]] io_awaiter accept(int fd, sockaddr* addr = nullptr, socklen_t* addrlen = nullptr,
+										int flags = SOCK_CLOEXEC) noexcept;
+		/**
+		 * \brief Connect a socket, like connect(2).
+		 * \note addr needs to stay valid until the operation completes.
+		 * \return Awaitable resuming with 0 or -errno
+		 */
+		[[nodiscard]] io_awaiter connect(int fd, const sockaddr* addr, socklen_t addrlen) noexcept;
+		/**
+		 * \brief Suspend for the given duration, using a timeout inside the ring.
+		 * \return Awaitable resuming with -ETIME once the duration elapsed
+		 */
+		template<typename Rep, typename Period>
+		[[nodiscard]] io_awaiter sleep(std::chrono::duration<Rep, Period> duration) noexcept;
+
+	private:
+		// user_data of entries that do not belong to an awaiter, real awaiters are at least 8 byte aligned
+		static constexpr uint64_t wake_tag = 1;
+		static constexpr uint64_t timeout_tag = 2;
+
+		struct sq_ring {
+			unsigned* head;
+			unsigned* tail;
+			unsigned mask;
+			unsigned entries;
+			unsigned* flags;
+			unsigned* array;
+		};
+		struct cq_ring {
+			unsigned* head;
+			unsigned* tail;
+			unsigned mask;
+			io_uring_cqe* cqes;
+		};
+
+		int m_fd{-1};
+		int m_wake_fd{-1};
+		void* m_sq_ptr{nullptr};
+		size_t m_sq_size{0};
+		void* m_cq_ptr{nullptr};
+		size_t m_cq_size{0};
+		io_uring_sqe* m_sqes{nullptr};
+		size_t m_sqes_size{0};
+		sq_ring m_sq{};
+		cq_ring m_cq{};
+		// Entries placed in the ring, but not yet submitted. Loop thread only.
+		unsigned m_to_submit{0};
+		// Operations submitted, but not yet completed. Loop thread only.
+		size_t m_inflight{0};
+		uint64_t m_wake_buffer{0};
+		bool m_wake_armed{false};
+		std::vector<coroutine_handle<>> m_completed{};
+
+		std::mutex m_mtx{};
+		std::deque<std::function<void()>> m_queue{};
+		std::atomic<bool> m_done{false};
+		std::atomic<bool> m_sleeping{false};
+
+		void map_rings(const io_uring_params& params) {
+			m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (single_mmap) m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+			m_sq_ptr = mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+							IORING_OFF_SQ_RING);
+			if (m_sq_ptr == MAP_FAILED) {
+				m_sq_ptr = nullptr;
+				throw std::system_error(errno, std::system_category(), "mapping io_uring failed");
+			}
+			if (single_mmap) {
+				m_cq_ptr = m_sq_ptr;
+			} else {
+				m_cq_ptr = mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+								IORING_OFF_CQ_RING);
+				if (m_cq_ptr == MAP_FAILED) {
+					m_cq_ptr = nullptr;
+					throw std::system_error(errno, std::system_category(), "mapping io_uring failed");
+				}
+			}
+			m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+			auto sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+							 IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) throw std::system_error(errno, std::system_category(), "mapping io_uring failed");
+			m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+			auto sq = static_cast<std::byte*>(m_sq_ptr);
+			m_sq.head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+			m_sq.tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			m_sq.mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			m_sq.entries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+			m_sq.flags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+			m_sq.array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			// Entries are always used in order, so the indirection array is the identity
+			for (unsigned i = 0; i < m_sq.entries; i++)
+				m_sq.array[i] = i;
+			auto cq = static_cast<std::byte*>(m_cq_ptr);
+			m_cq.head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			m_cq.tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			m_cq.mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			m_cq.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		}
+
+		void unmap_rings() noexcept {
+			if (m_sqes != nullptr) munmap(m_sqes, m_sqes_size);
+			if (m_cq_ptr != nullptr && m_cq_ptr != m_sq_ptr) munmap(m_cq_ptr, m_cq_size);
+			if (m_sq_ptr != nullptr) munmap(m_sq_ptr, m_sq_size);
+			m_sqes = nullptr;
+			m_cq_ptr = m_sq_ptr = nullptr;
+		}
+
+		void wake() noexcept {
+			// Pairs with the store in run(), either we see the loop sleeping or it sees our work in the queue
+			if (!m_sleeping.load()) return;
+			const uint64_t val = 1;
+			[[maybe_unused]] auto res = ::write(m_wake_fd, &val, sizeof(val));
+		}
+
+		/// \brief Submit all prepared entries and wait for at least min_complete completions
+		void enter(unsigned min_complete) {
+			if (m_to_submit == 0 && min_complete == 0) return;
+			const unsigned flags = min_complete != 0 ? IORING_ENTER_GETEVENTS : 0;
+			while (true) {
+				auto res = syscall(__NR_io_uring_enter, m_fd, m_to_submit, min_complete, flags, nullptr, 0);
+				if (res >= 0) {
+					m_to_submit -= static_cast<unsigned>(res);
+					return;
+				}
+				if (errno == EINTR) continue;
+				// The completion queue is full, reaping makes room
+				if (errno == EBUSY || errno == EAGAIN) {
+					reap();
+					if (min_complete != 0) return;
+					continue;
+				}
+				throw std::system_error(errno, std::system_category(), "io_uring_enter failed");
+			}
+		}
+
+		/// \brief Make sure count entries can be placed in the ring without submitting in between
+		void reserve(unsigned count) {
+			const auto head = std::atomic_ref<unsigned>{*m_sq.head}.load(std::memory_order::acquire);
+			if (*m_sq.tail - head + count > m_sq.entries) enter(0);
+		}
+
+		/// \brief Get the next free entry, needs to be called after reserve()
+		io_uring_sqe* next_sqe() noexcept {
+			const auto tail = *m_sq.tail;
+			auto sqe = &m_sqes[tail & m_sq.mask];
+			// Publish the entry to the kernel
+			std::atomic_ref<unsigned>{*m_sq.tail}.store(tail + 1, std::memory_order::release);
+			m_to_submit++;
+			return sqe;
+		}
+
+		void arm_wake() {
+			reserve(1);
+			auto sqe = next_sqe();
+			std::memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = m_wake_fd;
+			sqe->addr = reinterpret_cast<uint64_t>(&m_wake_buffer);
+			sqe->len = sizeof(m_wake_buffer);
+			sqe->user_data = wake_tag;
+			m_wake_armed = true;
+		}
+
+		// Called on the loop thread
+		void submit(io_awaiter* op);
+
+		void reap();
+	};
+
+	/**
+	 * \brief Awaitable for a single io_uring operation, see uring_dispatcher.
+	 *
+	 * The submission queue entry is prepared inside the awaiter and copied into the ring once it gets awaited.
+	 * It resumes with the result field of the completion. The awaiter can be copied until it is awaited.
+	 */
+	class uring_dispatcher::io_awaiter {
+	public:
+		io_awaiter(uring_dispatcher* parent, const io_uring_sqe& sqe) noexcept : m_parent{parent}, m_sqe{sqe} {}
+		/// \brief Construct a timeout operation, the entry gets pointed to the stored timespec on submission
+		io_awaiter(uring_dispatcher* parent, const io_uring_sqe& sqe, __kernel_timespec timeout) noexcept
+			: m_parent{parent}, m_sqe{sqe}, m_timeout{timeout} {}
+
+		/**
+		 * \brief Cancel the operation if it did not complete within the given duration.
+		 *
+		 * This links a timeout entry to the operation, a cancelled operation resumes with -ECANCELED.
+		 */
+		template<typename Rep, typename Period>
+		io_awaiter& timeout(std::chrono::duration<Rep, Period> duration) & noexcept {
+			m_timeout = to_timespec(duration);
+			m_has_timeout = true;
+			return *this;
+		}
+		/// \copydoc timeout()
+		template<typename Rep, typename Period>
+		io_awaiter&& timeout(std::chrono::duration<Rep, Period> duration) && noexcept {
+			return std::move(timeout(duration));
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		void await_suspend(coroutine_handle<> hndl) {
+			m_handle = hndl;
+			if (dispatcher::current() == m_parent)
+				m_parent->submit(this);
+			else
+				m_parent->push([this]() { m_parent->submit(this); });
+		}
+		[[nodiscard]] constexpr int await_resume() const noexcept { return m_result; }
+
+		/// \brief Convert a duration to the timespec used by io_uring
+		template<typename Rep, typename Period>
+		static constexpr __kernel_timespec to_timespec(std::chrono::duration<Rep, Period> duration) noexcept {
+			const auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+			return __kernel_timespec{.tv_sec = nsec / 1000000000, .tv_nsec = nsec % 1000000000};
+		}
+
+	private:
+		friend class uring_dispatcher;
+		friend class uring_buffer_pool;
+
+		uring_dispatcher* m_parent;
+		io_uring_sqe m_sqe;
+		__kernel_timespec m_timeout{};
+		bool m_has_timeout{false};
+		int m_result{0};
+		uint32_t m_flags{0};
+		coroutine_handle<> m_handle{};
+	};
+
+	inline void uring_dispatcher::submit(io_awaiter* op) {
+		reserve(op->m_has_timeout ? 2 : 1);
+		auto sqe = next_sqe();
+		*sqe = op->m_sqe;
+		sqe->user_data = reinterpret_cast<uint64_t>(op);
+		if (sqe->opcode == IORING_OP_TIMEOUT) sqe->addr = reinterpret_cast<uint64_t>(&op->m_timeout);
+		if (op->m_has_timeout) {
+			sqe->flags |= IOSQE_IO_LINK;
+			auto tsqe = next_sqe();
+			std::memset(tsqe, 0, sizeof(*tsqe));
+			tsqe->opcode = IORING_OP_LINK_TIMEOUT;
+			tsqe->fd = -1;
+			tsqe->addr = reinterpret_cast<uint64_t>(&op->m_timeout);
+			tsqe->len = 1;
+			tsqe->user_data = timeout_tag;
+		}
+		m_inflight++;
+	}
+
+	inline void uring_dispatcher::reap() {
+		auto head = *m_cq.head;
+		const auto tail = std::atomic_ref<unsigned>{*m_cq.tail}.load(std::memory_order::acquire);
+		if (head == tail) return;
+		for (; head != tail; head++) {
+			const auto& cqe = m_cq.cqes[head & m_cq.mask];
+			if (cqe.user_data == timeout_tag) continue;
+			if (cqe.user_data == wake_tag) {
+				m_wake_armed = false;
+				continue;
+			}
+			auto op = reinterpret_cast<io_awaiter*>(cqe.user_data);
+			// The notification of a zero copy send only signals the buffer is free, the result came before
+			if ((cqe.flags & IORING_CQE_F_NOTIF) == 0) {
+				op->m_result = cqe.res;
+				op->m_flags = cqe.flags;
+				// Resume on the last completion of operations producing multiple ones
+				if ((cqe.flags & IORING_CQE_F_MORE) != 0) continue;
+			}
+			m_completed.push_back(op->m_handle);
+			m_inflight--;
+		}
+		// Hand the slots back before resuming anyone, the coroutines might start new operations
+		std::atomic_ref<unsigned>{*m_cq.head}.store(tail, std::memory_order::release);
+		if (!m_wake_armed) arm_wake();
+		for (size_t i = 0; i < m_completed.size(); i++)
+			m_completed[i].resume();
+		m_completed.clear();
+	}
+
+	namespace detail {
+		inline io_uring_sqe make_sqe(uint8_t opcode, int fd, const void* addr, uint32_t len, uint64_t off) noexcept {
+			io_uring_sqe sqe{};
+			sqe.opcode = opcode;
+			sqe.fd = fd;
+			sqe.addr = reinterpret_cast<uint64_t>(addr);
+			sqe.len = len;
+			sqe.off = off;
+			return sqe;
+		}
+	} // namespace detail
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::read(int fd, std::span<std::byte> buffer,
+															   uint64_t offset) noexcept {
+		return {this, detail::make_sqe(IORING_OP_READ, fd, buffer.data(), buffer.size(), offset)};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::write(int fd, std::span<const std::byte> buffer,
+																uint64_t offset) noexcept {
+		return {this, detail::make_sqe(IORING_OP_WRITE, fd, buffer.data(), buffer.size(), offset)};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::recv(int fd, std::span<std::byte> buffer,
+															   int flags) noexcept {
+		auto sqe = detail::make_sqe(IORING_OP_RECV, fd, buffer.data(), buffer.size(), 0);
+		sqe.msg_flags = static_cast<uint32_t>(flags);
+		return {this, sqe};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::send(int fd, std::span<const std::byte> buffer,
+															   int flags) noexcept {
+		auto sqe = detail::make_sqe(IORING_OP_SEND, fd, buffer.data(), buffer.size(), 0);
+		sqe.msg_flags = static_cast<uint32_t>(flags);
+		return {this, sqe};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::send_zc(int fd, std::span<const std::byte> buffer,
+																  int flags) noexcept {
+		auto sqe = detail::make_sqe(IORING_OP_SEND_ZC, fd, buffer.data(), buffer.size(), 0);
+		sqe.msg_flags = static_cast<uint32_t>(flags);
+		return {this, sqe};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::accept(int fd, sockaddr* addr, socklen_t* addrlen,
+																 int flags) noexcept {
+		auto sqe = detail::make_sqe(IORING_OP_ACCEPT, fd, addr, 0, reinterpret_cast<uint64_t>(addrlen));
+		sqe.accept_flags = static_cast<uint32_t>(flags);
+		return {this, sqe};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::connect(int fd, const sockaddr* addr,
+																  socklen_t addrlen) noexcept {
+		return {this, detail::make_sqe(IORING_OP_CONNECT, fd, addr, 0, addrlen)};
+	}
+
+	template<typename Rep, typename Period>
+	inline uring_dispatcher::io_awaiter uring_dispatcher::sleep(std::chrono::duration<Rep, Period> duration) noexcept {
+		return {this, detail::make_sqe(IORING_OP_TIMEOUT, -1, nullptr, 1, 0), io_awaiter::to_timespec(duration)};
+	}
+
+	/**
+	 * \brief A buffer leased from a uring_buffer_pool.
+	 *
+	 * The lease is move only and hands the buffer back to its pool once destroyed, so it can be passed around
+	 * (e.g. through a channel) without copying the data. size() is the number of valid bytes, which can be
+	 * changed using resize() up to the size of the buffers in the pool.
+	 */
+	class uring_buffer {
+	public:
+		uring_buffer() noexcept = default;
+		uring_buffer(uring_buffer&& other) noexcept
+			: m_pool{std::exchange(other.m_pool, nullptr)}, m_id{other.m_id}, m_size{other.m_size} {}
+		uring_buffer& operator=(uring_buffer&& other) noexcept {
+			uring_buffer temp{std::move(other)};
+			swap(temp);
+			return *this;
+		}
+		uring_buffer(const uring_buffer&) = delete;
+		uring_buffer& operator=(const uring_buffer&) = delete;
+		~uring_buffer() { reset(); }
+
+		/// \brief Check if this holds a buffer
+		[[nodiscard]] bool valid() const noexcept { return m_pool != nullptr; }
+		/// \copydoc valid()
+		[[nodiscard]] explicit operator bool() const noexcept { return valid(); }
+		/// \brief Get the pool the buffer belongs to
+		[[nodiscard]] uring_buffer_pool* pool() const noexcept { return m_pool; }
+		/// \brief Get the id of the buffer inside its pool, which is also its index in the registered buffers
+		[[nodiscard]] uint16_t id() const noexcept { return m_id; }
+		/// \brief Get the valid bytes of the buffer
+		[[nodiscard]] std::span<std::byte> data() const noexcept;
+		/// \brief Get the number of valid bytes
+		[[nodiscard]] size_t size() const noexcept { return m_size; }
+		/// \brief Get the maximum number of bytes the buffer can hold
+		[[nodiscard]] size_t capacity() const noexcept;
+		/// \brief Change the number of valid bytes, size needs to be less or equal to capacity()
+		void resize(size_t size) noexcept {
+			assert(size <= capacity());
+			m_size = size;
+		}
+		/// \brief Hand the buffer back to its pool
+		void reset() noexcept;
+		void swap(uring_buffer& other) noexcept {
+			std::swap(m_pool, other.m_pool);
+			std::swap(m_id, other.m_id);
+			std::swap(m_size, other.m_size);
+		}
+
+	private:
+		friend class uring_buffer_pool;
+		uring_buffer(uring_buffer_pool* pool, uint16_t id, size_t size) noexcept
+			: m_pool{pool}, m_id{id}, m_size{size} {}
+
+		uring_buffer_pool* m_pool{nullptr};
+		uint16_t m_id{0};
+		size_t m_size{0};
+	};
+
+	/**
+	 * \brief Pool of buffers registered with a uring_dispatcher, which receives directly into them.
+	 *
+	 * The buffers are allocated in one block and registered twice: As a provided buffer ring, so that recv()
+	 * lets the kernel pick a free buffer once data arrives instead of reserving one per pending operation, and as
+	 * fixed buffers, so that uring_dispatcher::send_zc() can send from them without mapping the pages again.
+	 * Received buffers are handed out as uring_buffer leases, which return them to the ring once destroyed. This
+	 * can happen on any thread.
+	 *
+	 * A ring can only have one set of fixed buffers, so only one pool can exist per dispatcher at a time. The
+	 * pool needs to be destroyed before its dispatcher and after all of its leases.
+	 */
+	class uring_buffer_pool {
+	public:
+		class recv_awaiter;
+
+		/**
+		 * \brief Allocate and register the buffers.
+		 * \param parent The dispatcher to register with
+		 * \param count The number of buffers, at most 32768
+		 * \param size The size of every buffer in bytes
+		 * \param group The buffer group id used for the provided buffer ring
+		 * \throw std::system_error if allocating or registering failed, e.g. because the kernel is too old
+		 */
+		uring_buffer_pool(uring_dispatcher& parent, uint16_t count, uint32_t size, uint16_t group = 0)
+			: m_parent{&parent}, m_size{size}, m_count{count}, m_group{group},
+			  m_ring_entries{std::bit_ceil(static_cast<uint32_t>(count))} {
+			assert(count != 0 && count <= 32768 && size != 0);
+			m_memory_size = static_cast<size_t>(count) * size;
+			m_ring_size = m_ring_entries * sizeof(io_uring_buf);
+			auto memory = mmap(nullptr, m_memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED) throw std::system_error(errno, std::system_category(), "mmap failed");
+			m_memory = static_cast<std::byte*>(memory);
+			try {
+				auto ring = mmap(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (ring == MAP_FAILED) throw std::system_error(errno, std::system_category(), "mmap failed");
+				m_ring = static_cast<io_uring_buf*>(ring);
+				io_uring_buf_reg reg{};
+				reg.ring_addr = reinterpret_cast<uint64_t>(m_ring);
+				reg.ring_entries = m_ring_entries;
+				reg.bgid = m_group;
+				register_op(IORING_REGISTER_PBUF_RING, &reg, 1, "registering buffer ring failed");
+				try {
+					std::vector<iovec> iovs(count);
+					for (uint16_t i = 0; i < count; i++)
+						iovs[i] = iovec{.iov_base = buffer(i), .iov_len = m_size};
+					register_op(IORING_REGISTER_BUFFERS, iovs.data(), count, "registering buffers failed");
+				} catch (...) {
+					unregister_ring();
+					throw;
+				}
+			} catch (...) {
+				unmap();
+				throw;
+			}
+			std::unique_lock lck{m_mtx};
+			for (uint16_t i = 0; i < count; i++)
+				provide(i);
+		}
+		~uring_buffer_pool() {
+			assert(m_leased.load() == 0 && "uring_buffer_pool destroyed with leased buffers");
+			syscall(__NR_io_uring_register, m_parent->native_handle(), IORING_UNREGISTER_BUFFERS, nullptr, 0);
+			unregister_ring();
+			unmap();
+		}
+		uring_buffer_pool(const uring_buffer_pool&) = delete;
+		uring_buffer_pool& operator=(const uring_buffer_pool&) = delete;
+
+		/// \brief Get the dispatcher the buffers are registered with
+		[[nodiscard]] uring_dispatcher& parent() const noexcept { return *m_parent; }
+		/// \brief Get the buffer group id
+		[[nodiscard]] uint16_t group() const noexcept { return m_group; }
+		/// \brief Get the number of buffers
+		[[nodiscard]] uint16_t count() const noexcept { return m_count; }
+		/// \brief Get the size of every buffer in bytes
+		[[nodiscard]] size_t buffer_size() const noexcept { return m_size; }
+		/// \brief Get the number of buffers currently leased
+		[[nodiscard]] size_t leased() const noexcept { return m_leased.load(std::memory_order::relaxed); }
+
+		/**
+		 * \brief Receive from a socket into a buffer of the pool picked by the kernel.
+		 *
+		 * The awaiter resumes with the result of the operation and the lease of the buffer holding the data. If
+		 * no buffer was free at the time data arrived, the result is -ENOBUFS and the lease empty.
+		 * \return Awaitable resuming with a `std::pair<int, uring_buffer>`
+		 */
+		[[nodiscard]] recv_awaiter recv(int fd, int flags = 0) noexcept;
+
+	private:
+		friend class uring_buffer;
+
+		uring_dispatcher* const m_parent;
+		const size_t m_size;
+		const uint16_t m_count;
+		const uint16_t m_group;
+		const uint32_t m_ring_entries;
+		std::byte* m_memory{nullptr};
+		size_t m_memory_size{0};
+		io_uring_buf* m_ring{nullptr};
+		size_t m_ring_size{0};
+		// Guards adding buffers to the ring, leases might be returned on any thread
+		std::mutex m_mtx{};
+		uint16_t m_tail{0};
+		std::atomic<size_t> m_leased{0};
+
+		[[nodiscard]] std::byte* buffer(uint16_t id) const noexcept { return m_memory + id * m_size; }
+
+		void register_op(unsigned opcode, void* arg, unsigned nr_args, const char* what) {
+			if (syscall(__NR_io_uring_register, m_parent->native_handle(), opcode, arg, nr_args) < 0)
+				throw std::system_error(errno, std::system_category(), what);
+		}
+		void unregister_ring() noexcept {
+			io_uring_buf_reg reg{};
+			reg.bgid = m_group;
+			syscall(__NR_io_uring_register, m_parent->native_handle(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+		}
+		void unmap() noexcept {
+			if (m_ring != nullptr) munmap(m_ring, m_ring_size);
+			if (m_memory != nullptr) munmap(m_memory, m_memory_size);
+		}
+
+		// Needs m_mtx to be held
+		void provide(uint16_t id) noexcept {
+			// Fields are set one by one, because the resv field of the first entry is the tail of the ring
+			auto& entry = m_ring[m_tail & (m_ring_entries - 1)];
+			entry.addr = reinterpret_cast<uint64_t>(buffer(id));
+			entry.len = static_cast<uint32_t>(m_size);
+			entry.bid = id;
+			m_tail++;
+			std::atomic_ref<uint16_t>{m_ring[0].resv}.store(m_tail, std::memory_order::release);
+		}
+		[[nodiscard]] uring_buffer lease(uint16_t id, size_t size) noexcept {
+			m_leased.fetch_add(1, std::memory_order::relaxed);
+			return uring_buffer{this, id, size};
+		}
+		void release(uint16_t id) noexcept {
+			m_leased.fetch_sub(1, std::memory_order::relaxed);
+			std::unique_lock lck{m_mtx};
+			provide(id);
+		}
+	};
+
+	/**
+	 * \brief Awaitable receiving into a uring_buffer_pool, see uring_buffer_pool::recv().
+	 */
+	class uring_buffer_pool::recv_awaiter {
+	public:
+		recv_awaiter(uring_buffer_pool* pool, const io_uring_sqe& sqe) noexcept
+			: m_pool{pool}, m_op{pool->m_parent, sqe} {}
+
+		/// \copydoc uring_dispatcher::io_awaiter::timeout()
+		template<typename Rep, typename Period>
+		recv_awaiter& timeout(std::chrono::duration<Rep, Period> duration) & noexcept {
+			m_op.timeout(duration);
+			return *this;
+		}
+		/// \copydoc timeout()
+		template<typename Rep, typename Period>
+		recv_awaiter&& timeout(std::chrono::duration<Rep, Period> duration) && noexcept {
+			return std::move(timeout(duration));
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		void await_suspend(coroutine_handle<> hndl) { m_op.await_suspend(hndl); }
+		[[nodiscard]] std::pair<int, uring_buffer> await_resume() const noexcept {
+			const auto res = m_op.m_result;
+			if ((m_op.m_flags & IORING_CQE_F_BUFFER) == 0) return {res, uring_buffer{}};
+			const auto id = static_cast<uint16_t>(m_op.m_flags >> IORING_CQE_BUFFER_SHIFT);
+			return {res, m_pool->lease(id, res > 0 ? static_cast<size_t>(res) : 0)};
+		}
+
+	private:
+		uring_buffer_pool* m_pool;
+		uring_dispatcher::io_awaiter m_op;
+	};
+
+	inline std::span<std::byte> uring_buffer::data() const noexcept {
+		if (m_pool == nullptr) return {};
+		return {m_pool->buffer(m_id), m_size};
+	}
+
+	inline size_t uring_buffer::capacity() const noexcept { return m_pool != nullptr ? m_pool->buffer_size() : 0; }
+
+	inline void uring_buffer::reset() noexcept {
+		if (m_pool != nullptr) std::exchange(m_pool, nullptr)->release(m_id);
+		m_size = 0;
+	}
+
+	inline uring_buffer_pool::recv_awaiter uring_buffer_pool::recv(int fd, int flags) noexcept {
+		auto sqe = detail::make_sqe(IORING_OP_RECV, fd, nullptr, 0, 0);
+		sqe.msg_flags = static_cast<uint32_t>(flags);
+		sqe.flags = IOSQE_BUFFER_SELECT;
+		sqe.buf_group = m_group;
+		return {this, sqe};
+	}
+
+	inline uring_dispatcher::io_awaiter uring_dispatcher::send_zc(int fd, const uring_buffer& buffer,
+																  int flags) noexcept {
+		assert(buffer.valid() && &buffer.pool()->parent() == this);
+		auto data = buffer.data();
+		auto sqe = detail::make_sqe(IORING_OP_SEND_ZC, fd, data.data(), data.size(), 0);
+		sqe.msg_flags = static_cast<uint32_t>(flags);
+		sqe.ioprio = IORING_RECVSEND_FIXED_BUF;
+		sqe.buf_index = buffer.id();
+		return {this, sqe};
+	}
+} // namespace asyncpp
+#endif
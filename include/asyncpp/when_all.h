@@ -0,0 +1,602 @@
+#pragma once
+#include <asyncpp/detail/std_import.h>
+#include <asyncpp/dispatcher.h>
+#include <asyncpp/task.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace asyncpp {
+	namespace detail {
+		template<typename Task>
+		struct task_value;
+		template<typename T, ByteAllocator Allocator>
+		struct task_value<task<T, Allocator>> {
+			using type = T;
+		};
+		template<typename Task>
+		using task_value_t = typename task_value<Task>::type;
+
+		/// \brief Value type used inside result tuples and variants, void is replaced by std::monostate
+		template<typename T>
+		using join_value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+		/**
+		 * \brief Shared state of a when_all() or when_any() operation.
+		 *
+		 * The awaiting coroutine and every child hold one count on m_pending. The count of the awaiting coroutine is
+		 * dropped once all children are started, so it can not get resumed while it is still inside await_suspend().
+		 */
+		class join_state {
+		public:
+			/**
+			 * \brief Called by a driver once its child finished.
+			 * \param index The index of the child
+			 * \return The coroutine to resume next
+			 */
+			virtual coroutine_handle<> child_done(size_t index) noexcept = 0;
+
+		protected:
+			join_state() noexcept = default;
+			/// \brief Move the state, this is only valid before the operation was awaited
+			join_state(join_state&&) noexcept {}
+			join_state& operator=(join_state&&) = delete;
+			~join_state() = default;
+
+			std::atomic<size_t> m_pending{0};
+			coroutine_handle<> m_continuation{};
+			dispatcher* m_resume_on{nullptr};
+
+			/**
+			 * \brief Prepare for suspending the awaiting coroutine.
+			 * \param hndl The awaiting coroutine
+			 * \param count The number of children that need to arrive before the awaiting coroutine is resumed
+			 * \param dsp The dispatcher the children get started on
+			 */
+			void prepare(coroutine_handle<> hndl, size_t count, dispatcher* dsp) noexcept {
+				m_continuation = hndl;
+				// If the children run on a different dispatcher make sure we come back to the one we left
+				const auto current = dispatcher::current();
+				m_resume_on = dsp != nullptr && current != dsp ? current : nullptr;
+				m_pending.store(count + 1, std::memory_order::relaxed);
+			}
+
+			/**
+			 * \brief Drop the count of the awaiting coroutine.
+			 * \return true if the coroutine should stay suspended, false if all children arrived already
+			 */
+			bool finish_suspend() noexcept { return m_pending.fetch_sub(1, std::memory_order::acq_rel) != 1; }
+
+			/**
+			 * \brief Drop the count of a child.
+			 * \return The awaiting coroutine if this was the last count, noop_coroutine() otherwise
+			 */
+			coroutine_handle<> arrive() noexcept {
+				if (m_pending.fetch_sub(1, std::memory_order::acq_rel) != 1) return noop_coroutine();
+				if (m_resume_on == nullptr) return m_continuation;
+				m_resume_on->push_resume(m_continuation);
+				return noop_coroutine();
+			}
+		};
+
+		/**
+		 * \brief Coroutine awaiting a single child of a when_all() or when_any() operation.
+		 *
+		 * The driver is created suspended and destroys itself once the child finished. Apart from its frame
+		 * no allocations are done per child.
+		 */
+		class join_driver {
+		public:
+			struct promise_type : promise_allocator_base<default_allocator_type> {
+				join_state* m_state{};
+				size_t m_index{};
+
+				join_driver get_return_object() noexcept {
+					return join_driver{coroutine_handle<promise_type>::from_promise(*this)};
+				}
+				suspend_always initial_suspend() noexcept { return {}; }
+				auto final_suspend() noexcept {
+					struct awaiter {
+						constexpr bool await_ready() noexcept { return false; }
+						coroutine_handle<> await_suspend(coroutine_handle<promise_type> hndl) noexcept {
+							const auto state = hndl.promise().m_state;
+							const auto index = hndl.promise().m_index;
+							hndl.destroy();
+							return state->child_done(index);
+						}
+						constexpr void await_resume() noexcept {}
+					};
+					return awaiter{};
+				}
+				constexpr void return_void() noexcept {}
+				void unhandled_exception() noexcept { std::terminate(); }
+			};
+
+			join_driver() noexcept = default;
+			join_driver(join_driver&& other) noexcept : m_coro{std::exchange(other.m_coro, {})} {}
+			join_driver& operator=(join_driver&& other) noexcept {
+				m_coro = std::exchange(other.m_coro, m_coro);
+				return *this;
+			}
+			join_driver(const join_driver&) = delete;
+			join_driver& operator=(const join_driver&) = delete;
+			~join_driver() {
+				if (m_coro) m_coro.destroy();
+			}
+
+			/**
+			 * \brief Start the driver, it no longer belongs to this object afterwards.
+			 * \param state The state to notify once the child finished
+			 * \param index The index of the child
+			 * \param dsp The dispatcher to start on or nullptr to start inline
+			 */
+			void start(join_state* state, size_t index, dispatcher* dsp) {
+				assert(m_coro);
+				m_coro.promise().m_state = state;
+				m_coro.promise().m_index = index;
+				auto hndl = std::exchange(m_coro, {});
+				if (dsp != nullptr)
+					dsp->push_resume(hndl);
+				else
+					hndl.resume();
+			}
+
+		private:
+			explicit join_driver(coroutine_handle<promise_type> hndl) noexcept : m_coro{hndl} {}
+
+			coroutine_handle<promise_type> m_coro{};
+		};
+
+		template<typename Awaiter>
+		struct join_start {
+			Awaiter m_child;
+			constexpr bool await_ready() noexcept { return false; }
+			auto await_suspend(coroutine_handle<> hndl) noexcept { return m_child.await_suspend(hndl); }
+			constexpr void await_resume() noexcept {}
+		};
+
+		/**
+		 * \brief Create a driver for the given task.
+		 *
+		 * The driver only starts the child and leaves its result inside the task, where it is picked up later.
+		 */
+		template<typename Task>
+		join_driver make_join_driver(Task& child) {
+			return [](auto awaiter) -> join_driver {
+				co_await join_start<decltype(awaiter)>{awaiter};
+			}(child.operator co_await());
+		}
+
+		/**
+		 * \brief Get the result of a finished task, rethrows the exception if it failed.
+		 */
+		template<typename T, ByteAllocator Allocator>
+		join_value_t<T> join_result(task<T, Allocator>& child) {
+			if constexpr (std::is_void_v<T>) {
+				child.operator co_await().await_resume();
+				return {};
+			} else
+				return child.operator co_await().await_resume();
+		}
+
+		/// \brief Move all tasks out of a range
+		template<typename Range>
+		std::vector<std::ranges::range_value_t<Range>> to_task_vector(Range&& range) {
+			std::vector<std::ranges::range_value_t<Range>> res;
+			if constexpr (std::ranges::sized_range<Range>) res.reserve(std::ranges::size(range));
+			for (auto&& e : range)
+				res.push_back(std::move(e));
+			return res;
+		}
+
+		/**
+		 * \brief Shared state of a when_any() operation.
+		 *
+		 * Children that did not win keep running after the awaiting coroutine got resumed, so the state is reference
+		 * counted and kept alive until the last one of them finished.
+		 */
+		template<typename Tasks>
+		class when_any_state final : public join_state {
+		public:
+			static constexpr size_t npos = SIZE_MAX;
+
+			explicit when_any_state(Tasks tasks) : m_tasks{std::move(tasks)} {}
+
+			/// \brief The children of this operation
+			Tasks m_tasks;
+			/// \brief Index of the first child that finished
+			std::atomic<size_t> m_winner{npos};
+			/// \brief Number of references to this state, one per running child plus one for the awaiter
+			std::atomic<size_t> m_refs{1};
+
+			coroutine_handle<> child_done(size_t index) noexcept override {
+				size_t expected = npos;
+				coroutine_handle<> next = noop_coroutine();
+				if (m_winner.compare_exchange_strong(expected, index, std::memory_order::acq_rel,
+													 std::memory_order::acquire))
+					next = arrive();
+				release();
+				return next;
+			}
+
+			/**
+			 * \brief Suspend the awaiting coroutine and start all children.
+			 * \return false if a child finished inline and the awaiting coroutine should resume right away
+			 */
+			template<typename Drivers>
+			bool suspend(coroutine_handle<> hndl, Drivers& drivers, dispatcher* dsp) {
+				// Only the winner arrives
+				prepare(hndl, 1, dsp);
+				m_refs.fetch_add(drivers.size(), std::memory_order::relaxed);
+				size_t i = 0;
+				for (auto& e : drivers)
+					e.start(this, i++, dsp);
+				return finish_suspend();
+			}
+
+			/// \brief Drop a reference, the last one destroys the state
+			void release() noexcept {
+				if (m_refs.fetch_sub(1, std::memory_order::acq_rel) == 1) delete this;
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Awaitable waiting for multiple tasks to finish, see when_all().
+	 * \tparam Tasks The task types to wait on
+	 */
+	template<typename... Tasks>
+	class when_all_awaiter : private detail::join_state {
+	public:
+		/// \brief Result type, void tasks are represented by std::monostate
+		using result_type = std::tuple<detail::join_value_t<detail::task_value_t<Tasks>>...>;
+
+		/**
+		 * \brief Construct a new awaiter.
+		 * \param tasks The tasks to wait on
+		 */
+		explicit when_all_awaiter(Tasks... tasks)
+			: m_tasks{std::move(tasks)...},
+			  m_drivers{std::apply([](auto&... t) { return std::array{detail::make_join_driver(t)...}; }, m_tasks)} {}
+		/// \brief Move the awaiter, this is only valid before it was awaited
+		when_all_awaiter(when_all_awaiter&& other) noexcept
+			: join_state{std::move(other)}, m_tasks{std::move(other.m_tasks)}, m_drivers{std::move(other.m_drivers)},
+			  m_dispatcher{other.m_dispatcher} {}
+		when_all_awaiter& operator=(when_all_awaiter&&) = delete;
+
+		/**
+		 * \brief Specify a dispatcher to start the tasks on.
+		 *
+		 * By default all tasks are started inline, one after another. If a dispatcher is specified every task is
+		 * pushed to it, so they can run in parallel on e.g. a thread_pool. The awaiting coroutine is resumed on the
+		 * dispatcher it was suspended on.
+		 * \param dsp The dispatcher to start on or nullptr to start inline
+		 */
+		when_all_awaiter& start_on(dispatcher* dsp) & noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+		/// \copydoc start_on()
+		when_all_awaiter&& start_on(dispatcher* dsp) && noexcept {
+			m_dispatcher = dsp;
+			return std::move(*this);
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return sizeof...(Tasks) == 0; }
+		bool await_suspend(coroutine_handle<> hndl) {
+			prepare(hndl, sizeof...(Tasks), m_dispatcher);
+			for (size_t i = 0; i < m_drivers.size(); i++)
+				m_drivers[i].start(this, i, m_dispatcher);
+			return finish_suspend();
+		}
+		/**
+		 * \brief Get the results of all tasks.
+		 * \throw If a task failed its exception is rethrown, the first task in argument order takes precedence
+		 */
+		result_type await_resume() {
+			return std::apply([](auto&... t) { return result_type{detail::join_result(t)...}; }, m_tasks);
+		}
+
+	private:
+		std::tuple<Tasks...> m_tasks;
+		std::array<detail::join_driver, sizeof...(Tasks)> m_drivers;
+		dispatcher* m_dispatcher{nullptr};
+
+		coroutine_handle<> child_done(size_t) noexcept override { return arrive(); }
+	};
+
+	/**
+	 * \brief Awaitable waiting for a range of tasks to finish, see when_all().
+	 * \tparam T The return type of the tasks
+	 * \tparam Allocator The allocator of the tasks
+	 */
+	template<typename T, ByteAllocator Allocator>
+	class when_all_range_awaiter : private detail::join_state {
+	public:
+		/// \brief Result type, void if the tasks do not return a value
+		using result_type = std::conditional_t<std::is_void_v<T>, void, std::vector<detail::join_value_t<T>>>;
+
+		/**
+		 * \brief Construct a new awaiter.
+		 * \param tasks The tasks to wait on
+		 */
+		explicit when_all_range_awaiter(std::vector<task<T, Allocator>> tasks) : m_tasks{std::move(tasks)} {
+			m_drivers.reserve(m_tasks.size());
+			for (auto& e : m_tasks)
+				m_drivers.push_back(detail::make_join_driver(e));
+		}
+		/// \brief Move the awaiter, this is only valid before it was awaited
+		when_all_range_awaiter(when_all_range_awaiter&& other) noexcept
+			: join_state{std::move(other)}, m_tasks{std::move(other.m_tasks)}, m_drivers{std::move(other.m_drivers)},
+			  m_dispatcher{other.m_dispatcher} {}
+		when_all_range_awaiter& operator=(when_all_range_awaiter&&) = delete;
+
+		/**
+		 * \brief Specify a dispatcher to start the tasks on, see when_all_awaiter::start_on().
+		 * \param dsp The dispatcher to start on or nullptr to start inline
+		 */
+		when_all_range_awaiter& start_on(dispatcher* dsp) & noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+		/// \copydoc start_on()
+		when_all_range_awaiter&& start_on(dispatcher* dsp) && noexcept {
+			m_dispatcher = dsp;
+			return std::move(*this);
+		}
+
+		[[nodiscard]] bool await_ready() const noexcept { return m_tasks.empty(); }
+		bool await_suspend(coroutine_handle<> hndl) {
+			prepare(hndl, m_drivers.size(), m_dispatcher);
+			for (size_t i = 0; i < m_drivers.size(); i++)
+				m_drivers[i].start(this, i, m_dispatcher);
+			return finish_suspend();
+		}
+		/**
+		 * \brief Get the results of all tasks.
+		 * \throw If a task failed its exception is rethrown, the first task in the range takes precedence
+		 */
+		result_type await_resume() {
+			if constexpr (std::is_void_v<T>) {
+				for (auto& e : m_tasks)
+					detail::join_result(e);
+			} else {
+				result_type res;
+				res.reserve(m_tasks.size());
+				for (auto& e : m_tasks)
+					res.push_back(detail::join_result(e));
+				return res;
+			}
+		}
+
+	private:
+		std::vector<task<T, Allocator>> m_tasks;
+		std::vector<detail::join_driver> m_drivers;
+		dispatcher* m_dispatcher{nullptr};
+
+		coroutine_handle<> child_done(size_t) noexcept override { return arrive(); }
+	};
+
+	/**
+	 * \brief Awaitable waiting for the first of multiple tasks to finish, see when_any().
+	 * \tparam Tasks The task types to wait on
+	 */
+	template<typename... Tasks>
+	class when_any_awaiter {
+		static_assert(sizeof...(Tasks) > 0, "when_any requires at least one task");
+		using state_type = detail::when_any_state<std::tuple<Tasks...>>;
+
+	public:
+		/// \brief Result type, the index of the active alternative is the index of the task that finished first
+		using result_type = std::variant<detail::join_value_t<detail::task_value_t<Tasks>>...>;
+
+		/**
+		 * \brief Construct a new awaiter.
+		 * \param tasks The tasks to wait on
+		 */
+		explicit when_any_awaiter(Tasks... tasks)
+			: m_state{new state_type{std::tuple<Tasks...>{std::move(tasks)...}}},
+			  m_drivers{std::apply([](auto&... t) { return std::array{detail::make_join_driver(t)...}; },
+								   m_state->m_tasks)} {}
+		when_any_awaiter(when_any_awaiter&& other) noexcept
+			: m_state{std::exchange(other.m_state, nullptr)}, m_drivers{std::move(other.m_drivers)},
+			  m_dispatcher{other.m_dispatcher} {}
+		when_any_awaiter& operator=(when_any_awaiter&&) = delete;
+		~when_any_awaiter() {
+			if (m_state != nullptr) m_state->release();
+		}
+
+		/**
+		 * \brief Specify a dispatcher to start the tasks on, see when_all_awaiter::start_on().
+		 * \param dsp The dispatcher to start on or nullptr to start inline
+		 */
+		when_any_awaiter& start_on(dispatcher* dsp) & noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+		/// \copydoc start_on()
+		when_any_awaiter&& start_on(dispatcher* dsp) && noexcept {
+			m_dispatcher = dsp;
+			return std::move(*this);
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		bool await_suspend(coroutine_handle<> hndl) { return m_state->suspend(hndl, m_drivers, m_dispatcher); }
+		/**
+		 * \brief Get the result of the task that finished first.
+		 * \throw If the first task to finish failed its exception is rethrown
+		 */
+		result_type await_resume() { return resume_impl(std::index_sequence_for<Tasks...>{}); }
+
+	private:
+		state_type* m_state;
+		std::array<detail::join_driver, sizeof...(Tasks)> m_drivers;
+		dispatcher* m_dispatcher{nullptr};
+
+		template<size_t... Is>
+		result_type resume_impl(std::index_sequence<Is...>) {
+			const auto winner = m_state->m_winner.load(std::memory_order::acquire);
+			std::optional<result_type> res;
+			((winner == Is ? (void)res.emplace(std::in_place_index<Is>,
+											   detail::join_result(std::get<Is>(m_state->m_tasks)))
+						   : void()),
+			 ...);
+			return std::move(*res);
+		}
+	};
+
+	/**
+	 * \brief Awaitable waiting for the first of a range of tasks to finish, see when_any().
+	 * \tparam T The return type of the tasks
+	 * \tparam Allocator The allocator of the tasks
+	 */
+	template<typename T, ByteAllocator Allocator>
+	class when_any_range_awaiter {
+		using state_type = detail::when_any_state<std::vector<task<T, Allocator>>>;
+
+	public:
+		/// \brief Result type, the index of the task that finished first and its value if it returned one
+		using result_type = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, detail::join_value_t<T>>>;
+
+		/**
+		 * \brief Construct a new awaiter.
+		 * \param tasks The tasks to wait on, this must not be empty
+		 */
+		explicit when_any_range_awaiter(std::vector<task<T, Allocator>> tasks) {
+			if (tasks.empty()) throw std::invalid_argument("when_any requires at least one task");
+			m_state = new state_type{std::move(tasks)};
+			try {
+				m_drivers.reserve(m_state->m_tasks.size());
+				for (auto& e : m_state->m_tasks)
+					m_drivers.push_back(detail::make_join_driver(e));
+			} catch (...) {
+				m_drivers.clear();
+				m_state->release();
+				throw;
+			}
+		}
+		when_any_range_awaiter(when_any_range_awaiter&& other) noexcept
+			: m_state{std::exchange(other.m_state, nullptr)}, m_drivers{std::move(other.m_drivers)},
+			  m_dispatcher{other.m_dispatcher} {}
+		when_any_range_awaiter& operator=(when_any_range_awaiter&&) = delete;
+		~when_any_range_awaiter() {
+			if (m_state != nullptr) m_state->release();
+		}
+
+		/**
+		 * \brief Specify a dispatcher to start the tasks on, see when_all_awaiter::start_on().
+		 * \param dsp The dispatcher to start on or nullptr to start inline
+		 */
+		when_any_range_awaiter& start_on(dispatcher* dsp) & noexcept {
+			m_dispatcher = dsp;
+			return *this;
+		}
+		/// \copydoc start_on()
+		when_any_range_awaiter&& start_on(dispatcher* dsp) && noexcept {
+			m_dispatcher = dsp;
+			return std::move(*this);
+		}
+
+		[[nodiscard]] constexpr bool await_ready() const noexcept { return false; }
+		bool await_suspend(coroutine_handle<> hndl) { return m_state->suspend(hndl, m_drivers, m_dispatcher); }
+		/**
+		 * \brief Get the result of the task that finished first.
+		 * \throw If the first task to finish failed its exception is rethrown
+		 */
+		result_type await_resume() {
+			const auto winner = m_state->m_winner.load(std::memory_order::acquire);
+			if constexpr (std::is_void_v<T>) {
+				detail::join_result(m_state->m_tasks[winner]);
+				return winner;
+			} else
+				return {winner, detail::join_result(m_state->m_tasks[winner])};
+		}
+
+	private:
+		state_type* m_state{nullptr};
+		std::vector<detail::join_driver> m_drivers;
+		dispatcher* m_dispatcher{nullptr};
+	};
+
+	/**
+	 * \brief Wait for all of the given tasks to finish.
+	 *
+	 * Every task is awaited by a small driver coroutine, all of them are joined using a single atomic counter.
+	 * By default the tasks are started inline one after another, use start_on() to spread them across a
+	 * dispatcher, for example `co_await when_all(a(), b()).start_on(&pool)`.
+	 * \param tasks The tasks to wait on
+	 * \return An awaitable that resumes with a tuple of all results once every task finished
+	 */
+	template<typename... Ts, ByteAllocator... Allocators>
+	[[nodiscard]] inline when_all_awaiter<task<Ts, Allocators>...> when_all(task<Ts, Allocators>... tasks) {
+		return when_all_awaiter<task<Ts, Allocators>...>{std::move(tasks)...};
+	}
+
+	/**
+	 * \brief Wait for all tasks in a vector to finish.
+	 * \param tasks The tasks to wait on
+	 * \return An awaitable that resumes with a vector of all results, or void for tasks not returning a value
+	 */
+	template<typename T, ByteAllocator Allocator>
+	[[nodiscard]] inline when_all_range_awaiter<T, Allocator> when_all(std::vector<task<T, Allocator>> tasks) {
+		return when_all_range_awaiter<T, Allocator>{std::move(tasks)};
+	}
+
+	/**
+	 * \brief Wait for all tasks in a range to finish. The tasks are moved out of the range.
+	 * \param range The tasks to wait on
+	 * \return An awaitable that resumes with a vector of all results, or void for tasks not returning a value
+	 */
+	template<std::ranges::input_range Range>
+		requires(!std::is_same_v<std::remove_cvref_t<Range>, std::vector<std::ranges::range_value_t<Range>>>)
+	[[nodiscard]] inline auto when_all(Range&& range) {
+		return when_all(detail::to_task_vector(std::forward<Range>(range)));
+	}
+
+	/**
+	 * \brief Wait for the first of the given tasks to finish.
+	 *
+	 * \note Tasks can not be cancelled, the remaining ones continue to run after the first one finished and their
+	 * 		results are discarded. Because of this the state of the operation is kept in a single heap allocation
+	 * 		shared by all tasks.
+	 * \param tasks The tasks to wait on
+	 * \return An awaitable that resumes with a std::variant whose index is the index of the task that finished first
+	 */
+	template<typename... Ts, ByteAllocator... Allocators>
+	[[nodiscard]] inline when_any_awaiter<task<Ts, Allocators>...> when_any(task<Ts, Allocators>... tasks) {
+		return when_any_awaiter<task<Ts, Allocators>...>{std::move(tasks)...};
+	}
+
+	/**
+	 * \brief Wait for the first task in a vector to finish, see when_any().
+	 * \param tasks The tasks to wait on, this must not be empty
+	 * \return An awaitable that resumes with the index of the task that finished first and its result
+	 */
+	template<typename T, ByteAllocator Allocator>
+	[[nodiscard]] inline when_any_range_awaiter<T, Allocator> when_any(std::vector<task<T, Allocator>> tasks) {
+		return when_any_range_awaiter<T, Allocator>{std::move(tasks)};
+	}
+
+	/**
+	 * \brief Wait for the first task in a range to finish. The tasks are moved out of the range.
+	 * \param range The tasks to wait on, this must not be empty
+	 * \return An awaitable that resumes with the index of the task that finished first and its result
+	 */
+	template<std::ranges::input_range Range>
+		requires(!std::is_same_v<std::remove_cvref_t<Range>, std::vector<std::ranges::range_value_t<Range>>>)
+	[[nodiscard]] inline auto when_any(Range&& range) {
+		return when_any(detail::to_task_vector(std::forward<Range>(range)));
+	}
+} // namespace asyncpp
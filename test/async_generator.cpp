@@ -7,6 +7,11 @@
 #include <gtest/gtest.h>
 #include <thread>
 
+#include <array>
+#include <numeric>
+#include <span>
+#include <vector>
+
 using namespace asyncpp;
 
 namespace {
@@ -56,3 +61,31 @@ TEST(ASYNCPP, AsyncGeneratorAllocator) {
 	ASSERT_NE(0, alloc.released_sum);
 	ASSERT_NE(0, alloc.released_count);
 }
+
+TEST(ASYNCPP, AsyncGeneratorChunked) {
+	size_t chunks = 0;
+	std::vector<int> values;
+	as_promise([](size_t& chunks, std::vector<int>& values) -> task<> {
+		auto gen = []() -> async_generator<int> {
+			std::array<int, 8> buffer{};
+			for (int base = 0; base < 32; base += 8) {
+				co_await timer::get_default().wait(std::chrono::milliseconds(1));
+				std::iota(buffer.begin(), buffer.end(), base);
+				co_yield std::span<int>{buffer};
+				co_yield std::span<int>{};
+			}
+			co_yield 32;
+		};
+		auto t = gen();
+		for (auto it = co_await t.begin(); it != t.end(); co_await ++it)
+			values.push_back(*it);
+		auto t2 = gen();
+		for (auto it = co_await t2.begin(); it != t2.end(); co_await it.next_chunk())
+			chunks++;
+	}(chunks, values))
+		.get();
+	ASSERT_EQ(values.size(), 33);
+	for (int i = 0; i <= 32; i++)
+		ASSERT_EQ(values[i], i);
+	ASSERT_EQ(chunks, 5);
+}
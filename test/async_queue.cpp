@@ -0,0 +1,67 @@
+#include <asyncpp/async_queue.h>
+#include <asyncpp/defer.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, AsyncQueue) {
+	async_queue<std::unique_ptr<int>> queue;
+	std::vector<int> received;
+	auto consume = [](async_queue<std::unique_ptr<int>>& queue, std::vector<int>& received,
+					  int count) -> eager_fire_and_forget_task<> {
+		for (int i = 0; i < count; i++)
+			received.push_back(*co_await queue.pop(nullptr));
+	};
+	// Values pushed before anyone waits are queued
+	queue.push(std::make_unique<int>(1));
+	ASSERT_EQ(queue.size(), 1);
+	consume(queue, received, 1);
+	ASSERT_EQ(received, std::vector<int>{1});
+	ASSERT_FALSE(queue.try_pop());
+
+	// Waiting consumers get values handed over directly, in the order they started to wait
+	consume(queue, received, 2);
+	consume(queue, received, 1);
+	ASSERT_EQ(received.size(), 1);
+	queue.push(std::make_unique<int>(2));
+	queue.emplace(new int(3));
+	ASSERT_EQ(received, (std::vector<int>{1, 2, 3}));
+	ASSERT_EQ(queue.size(), 0);
+	queue.push(std::make_unique<int>(4));
+	ASSERT_EQ(received, (std::vector<int>{1, 2, 3, 4}));
+	queue.push(std::make_unique<int>(5));
+	ASSERT_EQ(**queue.try_pop(), 5);
+}
+
+TEST(ASYNCPP, AsyncQueueConcurrent) {
+	constexpr size_t num_consumers = 8;
+	constexpr size_t num_values = 2000;
+	thread_pool pool{4};
+	async_queue<size_t> queue;
+	std::vector<std::atomic<size_t>> seen(num_values);
+	std::vector<std::future<void>> results;
+	for (size_t i = 0; i < num_consumers; i++) {
+		results.push_back(as_promise([](thread_pool& pool, async_queue<size_t>& queue,
+										std::vector<std::atomic<size_t>>& seen) -> task<> {
+			co_await defer{pool};
+			for (size_t n = 0; n < num_values / num_consumers; n++)
+				seen[co_await queue.pop()].fetch_add(1);
+		}(pool, queue, seen)));
+	}
+	for (size_t i = 0; i < num_values; i++)
+		pool.push([&queue, i]() { queue.push(i); });
+	for (auto& e : results)
+		e.get();
+	for (auto& e : seen)
+		ASSERT_EQ(e.load(), 1);
+	ASSERT_EQ(queue.size(), 0);
+}
@@ -0,0 +1,80 @@
+#include <asyncpp/barrier.h>
+#include <asyncpp/defer.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, Barrier) {
+	int phases = 0;
+	auto on_complete = [&phases]() noexcept { phases++; };
+	async_barrier barrier{3, on_complete};
+	int passed = 0;
+	auto arrive = [](async_barrier<decltype(on_complete)>& barrier, int& passed) -> eager_fire_and_forget_task<> {
+		co_await barrier.arrive_and_wait(nullptr);
+		passed++;
+		co_await barrier.arrive_and_wait(nullptr);
+		passed++;
+	};
+	arrive(barrier, passed);
+	arrive(barrier, passed);
+	ASSERT_EQ(passed, 0);
+	ASSERT_EQ(phases, 0);
+	// The last arrival completes the phase and resumes everyone. They arrive right away again and the last one
+	// to do so completes the second phase as well.
+	arrive(barrier, passed);
+	ASSERT_EQ(phases, 2);
+	ASSERT_EQ(passed, 6);
+}
+
+TEST(ASYNCPP, BarrierDrop) {
+	int phases = 0;
+	auto on_complete = [&phases]() noexcept { phases++; };
+	async_barrier barrier{2, on_complete};
+	bool done = false;
+	[](async_barrier<decltype(on_complete)>& barrier, bool& done) -> eager_fire_and_forget_task<> {
+		co_await barrier.arrive_and_wait(nullptr);
+		co_await barrier.arrive_and_wait(nullptr);
+		done = true;
+	}(barrier, done);
+	// Dropping completes the first phase and leaves a single participant for the next one
+	barrier.arrive_and_drop();
+	ASSERT_EQ(phases, 2);
+	ASSERT_TRUE(done);
+}
+
+TEST(ASYNCPP, BarrierConcurrent) {
+	constexpr size_t num_tasks = 8;
+	constexpr size_t num_phases = 200;
+	thread_pool pool{4};
+	std::atomic<size_t> arrived{0};
+	std::atomic<bool> violated{false};
+	size_t phases = 0;
+	auto on_complete = [&]() noexcept {
+		if (arrived.exchange(0) != num_tasks) violated = true;
+		phases++;
+	};
+	async_barrier barrier{num_tasks, on_complete};
+	std::vector<std::future<void>> results;
+	for (size_t i = 0; i < num_tasks; i++) {
+		results.push_back(as_promise([](thread_pool& pool, async_barrier<decltype(on_complete)>& barrier,
+										std::atomic<size_t>& arrived) -> task<> {
+			co_await defer{pool};
+			for (size_t n = 0; n < num_phases; n++) {
+				arrived++;
+				co_await barrier.arrive_and_wait();
+			}
+		}(pool, barrier, arrived)));
+	}
+	for (auto& e : results)
+		e.get();
+	ASSERT_FALSE(violated);
+	ASSERT_EQ(phases, num_phases);
+}
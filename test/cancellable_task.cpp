@@ -0,0 +1,93 @@
+#include <asyncpp/cancellable_task.h>
+#include <asyncpp/channel.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/mutex.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/timer.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <optional>
+
+using namespace asyncpp;
+using namespace std::chrono_literals;
+
+TEST(ASYNCPP, CancellableTask) {
+	auto inner = [](int val) -> cancellable_task<int> {
+		auto token = co_await current_stop_token;
+		if (token.stop_possible()) co_return val * 2;
+		co_return val;
+	};
+	auto outer = [](auto& inner) -> cancellable_task<int> { co_return co_await inner(21); };
+	// Without a stop_token it behaves like a regular task
+	ASSERT_EQ(as_promise(outer(inner)).get(), 21);
+	// The token is passed on to the inner task
+	stop_source source;
+	ASSERT_EQ(as_promise(outer(inner).with_stop_token(source.get_token())).get(), 42);
+}
+
+TEST(ASYNCPP, CancellableTaskChannel) {
+	channel<int> chan;
+	stop_source source;
+	bool got_nullopt = false;
+	bool cancelled = false;
+	auto reader = [](channel<int>& chan, bool& got_nullopt) -> cancellable_task<> {
+		auto res = co_await chan.read();
+		got_nullopt = !res.has_value();
+		// The next co_await notices the stop and throws
+		co_await chan.read();
+	};
+	[](auto task, bool& cancelled) -> eager_fire_and_forget_task<> {
+		try {
+			co_await std::move(task);
+		} catch (const operation_cancelled&) { cancelled = true; }
+	}(reader(chan, got_nullopt).with_stop_token(source.get_token()), cancelled);
+	ASSERT_FALSE(got_nullopt);
+	ASSERT_FALSE(cancelled);
+	// Cancelling removes the reader from the channel, so a write has nobody to complete
+	source.request_stop();
+	ASSERT_TRUE(got_nullopt);
+	ASSERT_TRUE(cancelled);
+	ASSERT_FALSE(chan.try_write(1));
+
+	// Values still arrive as long as no stop is requested
+	stop_source source2;
+	std::optional<int> value;
+	[](channel<int>& chan, std::optional<int>& value) -> cancellable_task<> {
+		value = co_await chan.read();
+	}(chan, value)
+		.with_stop_token(source2.get_token());
+	auto task = [](channel<int>& chan, std::optional<int>& value) -> cancellable_task<> {
+		value = co_await chan.read();
+	}(chan, value);
+	[](auto task) -> eager_fire_and_forget_task<> { co_await std::move(task); }(
+		std::move(task.with_stop_token(source2.get_token())));
+	ASSERT_TRUE(chan.try_write(42));
+	ASSERT_EQ(value, 42);
+}
+
+TEST(ASYNCPP, CancellableTaskTimer) {
+	timer tmr;
+	stop_source source;
+	auto waiter = [](timer& tmr) -> cancellable_task<bool> { co_return co_await tmr.wait(10s); };
+	auto start = std::chrono::steady_clock::now();
+	auto res = as_promise(waiter(tmr).with_stop_token(source.get_token()));
+	std::this_thread::sleep_for(10ms);
+	source.request_stop();
+	ASSERT_FALSE(res.get());
+	ASSERT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(ASYNCPP, CancellableTaskMutex) {
+	mutex mtx;
+	stop_source source;
+	source.request_stop();
+	auto locker = [](mutex& mtx) -> cancellable_task<> {
+		co_await mtx.lock();
+		mtx.unlock();
+	};
+	// A stop requested before the lock is attempted cancels it
+	ASSERT_THROW(as_promise(locker(mtx).with_stop_token(source.get_token())).get(), operation_cancelled);
+	ASSERT_FALSE(mtx.is_locked());
+	as_promise(locker(mtx)).get();
+}
@@ -2,6 +2,12 @@
 #include <asyncpp/fire_and_forget.h>
 #include <gtest/gtest.h>
 
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
 using namespace asyncpp;
 
 namespace {
@@ -219,3 +225,114 @@ TEST(ASYNCPP, ChannelResumeOn) {
 	[]() -> eager_fire_and_forget_task<> { co_await chan.read().resume_on(nullptr); }();
 	ASSERT_TRUE(chan.try_write(42));
 }
+
+TEST(ASYNCPP, ChannelBuffered) {
+	static channel<int> chan{2};
+	static std::vector<bool> write_results{};
+	static bool write_did_finish = false;
+	ASSERT_EQ(chan.capacity(), 2);
+
+	// The first two writes fit into the buffer and complete without a reader
+	[]() -> eager_fire_and_forget_task<> {
+		for (int i = 0; i < 3; i++)
+			write_results.push_back(co_await chan.write(i));
+		write_did_finish = true;
+	}();
+	ASSERT_EQ(write_results.size(), 2);
+	ASSERT_FALSE(write_did_finish);
+	ASSERT_FALSE(chan.try_write(10));
+
+	// Reading makes space, so the suspended writer moves its value into the buffer
+	ASSERT_EQ(chan.try_read(), 0);
+	ASSERT_TRUE(write_did_finish);
+	ASSERT_EQ(write_results.size(), 3);
+	ASSERT_FALSE(chan.try_write(3));
+	ASSERT_EQ(chan.try_read(), 1);
+	ASSERT_TRUE(chan.try_write(3));
+
+	// Values stay readable after close
+	chan.close();
+	ASSERT_FALSE(chan.try_write(4));
+	static std::vector<int> read_values{};
+	[]() -> eager_fire_and_forget_task<> {
+		while (auto res = co_await chan.read())
+			read_values.push_back(*res);
+	}();
+	ASSERT_EQ(read_values, (std::vector<int>{2, 3}));
+	for (auto e : write_results)
+		ASSERT_TRUE(e);
+}
+
+TEST(ASYNCPP, ChannelBufferedReaderWaiting) {
+	static channel<int> chan{4};
+	static std::optional<int> read_value{};
+	[]() -> eager_fire_and_forget_task<> { read_value = co_await chan.read(); }();
+	ASSERT_FALSE(read_value.has_value());
+	// A waiting reader receives the value directly instead of it being buffered
+	ASSERT_TRUE(chan.try_write(42));
+	ASSERT_EQ(read_value, 42);
+	ASSERT_FALSE(chan.try_read().has_value());
+}
+
+TEST(ASYNCPP, ChannelWriteMany) {
+	static channel<int> chan{3};
+	static std::vector<int> values{1, 2, 3, 4, 5};
+	static size_t written = 0;
+	static size_t written_waiting = 0;
+	[]() -> eager_fire_and_forget_task<> { written = co_await chan.write_many(values); }();
+	// Only three fit into the buffer
+	ASSERT_EQ(written, 3);
+	ASSERT_EQ(chan.try_write_many(std::span{values}.subspan(3)), 0);
+	// Buffer is full, so this suspends with the first value
+	[]() -> eager_fire_and_forget_task<> {
+		written_waiting = co_await chan.write_many(std::span{values}.subspan(3));
+	}();
+	ASSERT_EQ(written_waiting, 0);
+
+	std::vector<int> out;
+	ASSERT_EQ(chan.try_read_many(std::back_inserter(out), 10), 4);
+	ASSERT_EQ(out, (std::vector<int>{1, 2, 3, 4}));
+	ASSERT_EQ(written_waiting, 1);
+	ASSERT_EQ(chan.try_write_many(std::span{values}.subspan(4)), 1);
+	ASSERT_EQ(chan.try_read(), 5);
+}
+
+TEST(ASYNCPP, ChannelWriteManyClosed) {
+	static channel<std::string> chan{};
+	static std::vector<std::string> values{"first", "second"};
+	static std::optional<size_t> written{};
+	// Unbuffered channel without readers, so this waits with the first value
+	[]() -> eager_fire_and_forget_task<> { written = co_await chan.write_many(values); }();
+	ASSERT_FALSE(written.has_value());
+	chan.close();
+	ASSERT_EQ(written, 0);
+	// Nothing was written, so the span needs to be untouched
+	ASSERT_EQ(values, (std::vector<std::string>{"first", "second"}));
+}
+
+TEST(ASYNCPP, ChannelReadMany) {
+	static channel<int> chan;
+	static std::vector<int> out;
+	static size_t read = 0;
+	// Unbuffered channel, so this waits for the first value
+	[]() -> eager_fire_and_forget_task<> { read = co_await chan.read_many(std::back_inserter(out), 10); }();
+	ASSERT_EQ(read, 0);
+	std::vector<int> values{1, 2, 3};
+	// One reader is waiting, so only a single value can be written
+	ASSERT_EQ(chan.try_write_many(values), 1);
+	ASSERT_EQ(read, 1);
+	ASSERT_EQ(out, (std::vector<int>{1}));
+
+	// Waiting writers are taken in one batch
+	static bool writes_done[2] = {false, false};
+	[]() -> eager_fire_and_forget_task<> { writes_done[0] = co_await chan.write(2); }();
+	[]() -> eager_fire_and_forget_task<> { writes_done[1] = co_await chan.write(3); }();
+	[]() -> eager_fire_and_forget_task<> { read = co_await chan.read_many(std::back_inserter(out), 10); }();
+	ASSERT_EQ(read, 2);
+	ASSERT_EQ(out, (std::vector<int>{1, 2, 3}));
+	ASSERT_TRUE(writes_done[0]);
+	ASSERT_TRUE(writes_done[1]);
+
+	chan.close();
+	ASSERT_EQ(chan.try_read_many(std::back_inserter(out), 10), 0);
+}
@@ -16,3 +16,42 @@ TEST(ASYNCPP, Defer) {
 	[](test_dispatcher& d) -> fire_and_forget_task<> { co_await defer{d}; }(d).start();
 	ASSERT_TRUE(d.push_called);
 }
+
+TEST(ASYNCPP, DeferPushResume) {
+	struct test_dispatcher {
+		bool push_resume_called = false;
+		void push(std::function<void()>) { FAIL(); }
+		void push_resume(coroutine_handle<> hndl) {
+			push_resume_called = true;
+			hndl.resume();
+		}
+	};
+	test_dispatcher d{};
+	[](test_dispatcher& d) -> fire_and_forget_task<> { co_await defer{d}; }(d).start();
+	ASSERT_TRUE(d.push_resume_called);
+}
+
+TEST(ASYNCPP, DeferNoexcept) {
+	struct push_only {
+		void push(std::function<void()>) {}
+	};
+	struct throwing_push_resume {
+		void push(std::function<void()>) noexcept {}
+		void push_resume(coroutine_handle<>) {}
+	};
+	struct throwing_prioritized {
+		void push(std::function<void()>) noexcept {}
+		void push_resume(coroutine_handle<>) noexcept {}
+		void push_resume_prioritized(coroutine_handle<>, task_priority) {}
+	};
+	struct all_noexcept {
+		void push(std::function<void()>) {}
+		void push_resume(coroutine_handle<>) noexcept {}
+		void push_resume_prioritized(coroutine_handle<>, task_priority) noexcept {}
+	};
+	// The specification follows the functions await_suspend() calls, not push()
+	static_assert(!noexcept(std::declval<defer<push_only>&>().await_suspend({})));
+	static_assert(!noexcept(std::declval<defer<throwing_push_resume>&>().await_suspend({})));
+	static_assert(!noexcept(std::declval<defer<throwing_prioritized>&>().await_suspend({})));
+	static_assert(noexcept(std::declval<defer<all_noexcept>&>().await_suspend({})));
+}
@@ -3,6 +3,9 @@
 #include <asyncpp/task.h>
 #include <gtest/gtest.h>
 
+#include <span>
+#include <vector>
+
 using namespace asyncpp;
 
 namespace {
@@ -13,6 +16,19 @@ namespace {
 			fn();
 		}
 	};
+
+	struct batch_dispatcher : dispatcher {
+		std::vector<size_t> batches;
+		void push(std::function<void()> fn) override {
+			batches.push_back(1);
+			fn();
+		}
+		void push_resume_batch(std::span<const coroutine_handle<>> hndls) override {
+			batches.push_back(hndls.size());
+			for (auto hndl : hndls)
+				hndl.resume();
+		}
+	};
 } // namespace
 
 TEST(ASYNCPP, SingleConsumerEvent) {
@@ -72,3 +88,21 @@ TEST(ASYNCPP, SingleConsumerEventInitiallySet) {
 	single_consumer_event evt(true);
 	ASSERT_TRUE(evt.is_set());
 }
+
+TEST(ASYNCPP, MultiConsumerEventBatchResume) {
+	multi_consumer_event evt;
+	batch_dispatcher disp;
+	constexpr size_t count = 150;
+	size_t resumed = 0;
+	for (size_t i = 0; i < count; i++) {
+		launch([](size_t& resumed, multi_consumer_event& evt, dispatcher& disp) -> task<void> {
+			co_await evt.wait(&disp);
+			resumed++;
+		}(resumed, evt, disp));
+	}
+	ASSERT_EQ(resumed, 0);
+	evt.set();
+	ASSERT_EQ(resumed, count);
+	// All waiters share a dispatcher, so they are handed over in as few batches as possible
+	ASSERT_EQ(disp.batches, (std::vector<size_t>{64, 64, 22}));
+}
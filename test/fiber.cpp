@@ -1,10 +1,13 @@
 #include <asyncpp/defer.h>
 #include <asyncpp/fiber.h>
 #include <asyncpp/launch.h>
+#include <asyncpp/sync_wait.h>
 #include <asyncpp/task.h>
 #include <asyncpp/timer.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 using namespace asyncpp::detail;
 using namespace asyncpp;
 
@@ -309,3 +312,69 @@ TEST(ASYNCPP, FiberExceptionHandling) {
 	ASSERT_TRUE(did_throw);
 	handle.destroy();
 }
+
+#ifndef _WIN32
+TEST(ASYNCPP, FiberStackPool) {
+	fiber_stack_pool::trim();
+	stack_context a{};
+	ASSERT_TRUE(fiber_allocate_stack(a, 200 * 1024));
+	ASSERT_EQ(a.stack_size, 256 * 1024);
+	const auto base = a.mmap_base;
+	static_cast<std::byte*>(a.stack)[-1] = std::byte{42};
+	ASSERT_TRUE(fiber_deallocate_stack(a));
+
+	// A stack of the same size class gets reused
+	stack_context b{};
+	ASSERT_TRUE(fiber_allocate_stack(b, 256 * 1024));
+	ASSERT_EQ(b.mmap_base, base);
+	static_cast<std::byte*>(b.stack)[-1] = std::byte{1};
+	stack_context c{};
+	ASSERT_TRUE(fiber_allocate_stack(c, 16 * 1024));
+	ASSERT_NE(c.mmap_base, base);
+	ASSERT_TRUE(fiber_deallocate_stack(b));
+	ASSERT_TRUE(fiber_deallocate_stack(c));
+
+	// Stacks cached by other threads end up in the global pool once they exit
+	fiber_stack_pool::trim();
+	void* thread_base = nullptr;
+	std::thread([&thread_base]() {
+		auto handle = make_fiber_handle(256 * 1024, [&thread_base]() {
+			thread_base = asyncpp::detail::g_current_fiber->fiber_stack.mmap_base;
+		});
+		handle.resume();
+		handle.destroy();
+	}).join();
+	ASSERT_TRUE(fiber_allocate_stack(a, 256 * 1024));
+	ASSERT_EQ(a.mmap_base, thread_base);
+	ASSERT_TRUE(fiber_deallocate_stack(a));
+	fiber_stack_pool::trim();
+}
+#endif
+
+#ifndef _WIN32
+TEST(ASYNCPP, FiberStackHighWater) {
+	constexpr size_t stack_size = 8 * 1024 * 1024;
+	// Leave a deeply used stack in the pool, its pages must not count towards the next fiber
+	{
+		fiber<void> deep{[]() {
+							 volatile char buffer[2 * 1024 * 1024];
+							 for (size_t i = 0; i < sizeof(buffer); i += 1024)
+								 buffer[i] = 1;
+						 },
+						 stack_size};
+		as_promise(deep.await()).get();
+		ASSERT_GE(deep.stack_high_water_mark(), 2 * 1024 * 1024);
+	}
+	fiber<void> fib{[]() {
+						volatile char buffer[128 * 1024];
+						for (size_t i = 0; i < sizeof(buffer); i += 1024)
+							buffer[i] = 1;
+					},
+					stack_size};
+	// Nothing but the initial frame is touched before the fiber runs
+	ASSERT_LT(fib.stack_high_water_mark(), 64 * 1024);
+	as_promise(fib.await()).get();
+	ASSERT_GE(fib.stack_high_water_mark(), 128 * 1024);
+	ASSERT_LT(fib.stack_high_water_mark(), 1024 * 1024);
+}
+#endif
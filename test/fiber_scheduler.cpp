@@ -0,0 +1,61 @@
+#include <asyncpp/fiber_scheduler.h>
+#include <asyncpp/mutex.h>
+#include <asyncpp/thread_pool.h>
+#include <asyncpp/timer.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, FiberSchedulerSpawn) {
+	thread_pool pool{2};
+	fiber_scheduler sched{pool};
+	auto res = sched.spawn([]() {
+		fiber_scheduler::yield();
+		return 42;
+	});
+	ASSERT_EQ(res.get(), 42);
+
+	auto failed = sched.spawn([]() { throw std::runtime_error("failed"); });
+	ASSERT_THROW(failed.get(), std::runtime_error);
+	ASSERT_THROW(fiber_scheduler::yield(), std::logic_error);
+}
+
+TEST(ASYNCPP, FiberSchedulerMutex) {
+	thread_pool pool{4};
+	fiber_scheduler sched{pool, 64 * 1024};
+	asyncpp::mutex mtx;
+	size_t counter = 0;
+	std::vector<promise<void>> fibers;
+	for (int i = 0; i < 50; i++) {
+		fibers.push_back(sched.spawn([&]() {
+			for (int j = 0; j < 100; j++) {
+				fib_await mtx.lock();
+				counter++;
+				// Yield while holding the lock, so other fibers have to block on it
+				if (j % 10 == 0) fiber_scheduler::yield();
+				mtx.unlock();
+			}
+		}));
+	}
+	for (auto& e : fibers)
+		e.get();
+	ASSERT_EQ(counter, 5000);
+}
+
+TEST(ASYNCPP, FiberSchedulerTimer) {
+	thread_pool pool{2};
+	timer tmr;
+	fiber_scheduler sched{pool};
+	auto res = sched.spawn([&tmr]() {
+		const auto start = std::chrono::steady_clock::now();
+		fib_await tmr.wait(std::chrono::milliseconds(10));
+		// The timer thread resumes the fiber, it has to continue on the pool
+		return dispatcher::current() == &tmr ? std::chrono::nanoseconds{0}
+											 : std::chrono::steady_clock::now() - start;
+	});
+	ASSERT_GE(res.get(), std::chrono::milliseconds(10));
+}
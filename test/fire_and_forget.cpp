@@ -1,6 +1,8 @@
 #include <asyncpp/fire_and_forget.h>
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+
 using namespace asyncpp;
 
 TEST(ASYNCPP, FireAndForget) {
@@ -24,3 +26,47 @@ TEST(ASYNCPP, FireAndForget) {
 	}(executed);
 	ASSERT_FALSE(executed);
 }
+
+namespace {
+	int g_handled = 0;
+	void count_exception() { g_handled++; }
+} // namespace
+
+TEST(ASYNCPP, FireAndForgetStaticPolicy) {
+	using dynamic_promise = eager_fire_and_forget_task<>::promise_type;
+	using static_promise = eager_fire_and_forget_task<default_allocator_type, exception_policy_ignore>::promise_type;
+	static_assert(sizeof(static_promise) < sizeof(dynamic_promise));
+
+	bool executed = false;
+	[](bool& executed) -> eager_fire_and_forget_task<default_allocator_type, exception_policy_ignore> {
+		executed = true;
+		throw std::runtime_error("ignored");
+		co_return;
+	}(executed);
+	ASSERT_TRUE(executed);
+
+	g_handled = 0;
+	auto task = []() -> fire_and_forget_task<default_allocator_type, exception_policy_handler<&count_exception>> {
+		throw std::runtime_error("handled");
+		co_return;
+	}();
+	ASSERT_EQ(g_handled, 0);
+	task.start();
+	ASSERT_EQ(g_handled, 1);
+}
+
+TEST(ASYNCPP, DetachedTask) {
+	bool executed = false;
+	[](bool& executed) -> detached_task<> {
+		executed = true;
+		co_return;
+	}(executed);
+	ASSERT_TRUE(executed);
+
+	g_handled = 0;
+	[]() -> detached_task<default_allocator_type, exception_policy_handler<&count_exception>> {
+		throw std::runtime_error("handled");
+		co_return;
+	}();
+	ASSERT_EQ(g_handled, 1);
+}
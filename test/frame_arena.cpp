@@ -0,0 +1,56 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/frame_arena.h>
+#include <asyncpp/launch.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+using namespace asyncpp;
+
+static_assert(ArenaBoundAllocator<frame_arena_allocator>);
+static_assert(!ArenaBoundAllocator<std::allocator<std::byte>>);
+
+TEST(ASYNCPP, FrameArena) {
+	frame_arena arena;
+	auto ptr = arena.allocate(100);
+	auto ptr2 = arena.allocate(1);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % __STDCPP_DEFAULT_NEW_ALIGNMENT__, 0);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) % __STDCPP_DEFAULT_NEW_ALIGNMENT__, 0);
+	ASSERT_GE(static_cast<std::byte*>(ptr2) - static_cast<std::byte*>(ptr), 100);
+	// Freeing from another thread is fine
+	std::thread([&]() { frame_arena::deallocate(ptr); }).join();
+	frame_arena::deallocate(ptr2);
+	// The chunk is empty again and gets reused from the start
+	auto ptr3 = arena.allocate(100);
+	ASSERT_EQ(ptr, ptr3);
+	// Too large for a regular chunk
+	auto large = arena.allocate(frame_arena::chunk_size * 2);
+	frame_arena::deallocate(large);
+	// Frames can outlive the arena
+	{
+		frame_arena temp;
+		ptr = temp.allocate(64);
+	}
+	frame_arena::deallocate(ptr);
+	frame_arena::deallocate(ptr3);
+}
+
+TEST(ASYNCPP, FrameArenaTask) {
+	thread_pool pool{2};
+	frame_arena arena;
+	auto inner = [](int val, frame_arena&) -> task<int, frame_arena_allocator> { co_return val; };
+	auto outer = [](thread_pool& pool, auto& inner, frame_arena& arena) -> task<int, frame_arena_allocator> {
+		int res = 0;
+		for (int i = 0; i < 100; i++) {
+			res += co_await inner(i, arena);
+		}
+		// The frame is destroyed on a worker thread
+		co_await defer{pool};
+		co_return res;
+	};
+	ASSERT_EQ(as_promise(outer(pool, inner, arena)).get(), 4950);
+}
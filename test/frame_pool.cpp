@@ -0,0 +1,65 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/frame_pool.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, FramePoolAllocator) {
+	frame_pool_allocator alloc;
+	// Freed blocks are reused for requests of the same size class
+	auto ptr = alloc.allocate(100);
+	alloc.deallocate(ptr, 100);
+	auto ptr2 = alloc.allocate(128);
+	ASSERT_EQ(ptr, ptr2);
+	auto ptr3 = alloc.allocate(100);
+	ASSERT_NE(ptr2, ptr3);
+	alloc.deallocate(ptr2, 128);
+	alloc.deallocate(ptr3, 100);
+	// Requests above the largest size class are not pooled
+	auto large = alloc.allocate(frame_pool_allocator::max_block_size + 1);
+	alloc.deallocate(large, frame_pool_allocator::max_block_size + 1);
+	frame_pool_allocator::flush_thread_cache();
+}
+
+TEST(ASYNCPP, FramePoolAllocatorCrossThread) {
+	constexpr size_t num_blocks = 200;
+	frame_pool_allocator alloc;
+	std::vector<std::byte*> blocks;
+	for (size_t i = 0; i < num_blocks; i++)
+		blocks.push_back(alloc.allocate(256));
+	frame_pool_allocator::flush_thread_cache();
+	// Blocks freed by another thread end up in the global pool once it caches too many or exits
+	std::thread([&]() {
+		for (auto e : blocks)
+			alloc.deallocate(e, 256);
+	}).join();
+	std::vector<std::byte*> reused;
+	for (size_t i = 0; i < num_blocks; i++) {
+		reused.push_back(alloc.allocate(256));
+		ASSERT_NE(std::find(blocks.begin(), blocks.end(), reused.back()), blocks.end());
+	}
+	for (auto e : reused)
+		alloc.deallocate(e, 256);
+}
+
+TEST(ASYNCPP, FramePoolAllocatorTask) {
+	thread_pool pool{2};
+	auto sum = [](thread_pool& pool, int depth) -> task<int, frame_pool_allocator> {
+		auto inner = [](int val) -> task<int, frame_pool_allocator> { co_return val; };
+		int res = 0;
+		for (int i = 0; i < depth; i++) {
+			// Resume on a worker, so frames get destroyed on a different thread than they were created
+			co_await defer{pool};
+			res += co_await inner(i);
+		}
+		co_return res;
+	};
+	ASSERT_EQ(as_promise(sum(pool, 100)).get(), 4950);
+}
@@ -0,0 +1,82 @@
+#include <asyncpp/event.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/launch.h>
+#include <asyncpp/task.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace asyncpp;
+
+#if ASYNCPP_TRACK_FRAMES
+namespace {
+	std::uint_least32_t g_wait_line = 0;
+
+	task<int> tracked_inner(single_consumer_event& evt) {
+		g_wait_line = std::source_location::current().line() + 1;
+		co_await evt;
+		co_return 42;
+	}
+
+	task<int> tracked_outer(single_consumer_event& evt) { co_return co_await tracked_inner(evt); }
+} // namespace
+
+TEST(ASYNCPP, FrameRegistry) {
+	const auto baseline = frame_registry::size();
+	single_consumer_event evt;
+	int result = 0;
+	launch([](single_consumer_event& evt, int& result) -> task<> {
+		result = co_await tracked_outer(evt);
+	}(evt, result));
+
+	// launch_task -> launched task -> tracked_outer -> tracked_inner
+	ASSERT_EQ(frame_registry::size(), baseline + 4);
+	auto frames = frame_registry::snapshot();
+	auto inner = std::find_if(frames.begin(), frames.end(), [](const frame_snapshot& frame) {
+		return frame.line == g_wait_line && frame.file != nullptr;
+	});
+	ASSERT_NE(inner, frames.end());
+	ASSERT_STREQ(inner->kind, "task");
+	ASSERT_NE(inner->size, 0);
+	// Follow the continuations up to the launch_task
+	size_t depth = 0;
+	for (auto frame = inner; frame != frames.end(); depth++) {
+		if (frame->continuation == nullptr) {
+			ASSERT_STREQ(frame->kind, "launch_task");
+			break;
+		}
+		frame = std::find_if(frames.begin(), frames.end(),
+							 [&](const frame_snapshot& other) { return other.address == frame->continuation; });
+	}
+	ASSERT_EQ(depth, 3);
+
+	std::stringstream ss;
+	frame_registry::dump(ss);
+	const auto str = ss.str();
+	ASSERT_NE(str.find("Suspension points:"), std::string::npos);
+	ASSERT_NE(str.find("#0 task"), std::string::npos);
+	ASSERT_NE(str.find("#3 launch_task"), std::string::npos);
+
+	evt.set();
+	ASSERT_EQ(result, 42);
+	ASSERT_EQ(frame_registry::size(), baseline);
+}
+
+TEST(ASYNCPP, FrameRegistryFireAndForget) {
+	const auto baseline = frame_registry::size();
+	single_consumer_event evt;
+	[](single_consumer_event& evt) -> eager_fire_and_forget_task<> { co_await evt; }(evt);
+	auto frames = frame_registry::snapshot();
+	ASSERT_TRUE(std::any_of(frames.begin(), frames.end(), [](const frame_snapshot& frame) {
+		return std::string_view{frame.kind} == "eager_fire_and_forget_task";
+	}));
+	evt.set();
+	ASSERT_EQ(frame_registry::size(), baseline);
+}
+#else
+TEST(ASYNCPP, FrameRegistryCompiledOut) {
+	// Without ASYNCPP_TRACK_FRAMES the promises carry no tracking state
+	static_assert(sizeof(detail::launch_task<>::promise_type) == 1);
+}
+#endif
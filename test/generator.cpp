@@ -2,6 +2,11 @@
 #include <asyncpp/generator.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <numeric>
+#include <span>
+#include <vector>
+
 using namespace asyncpp;
 
 namespace {
@@ -29,3 +34,40 @@ TEST(ASYNCPP, GeneratorAllocator) {
 	ASSERT_NE(0, alloc.released_sum);
 	ASSERT_NE(0, alloc.released_count);
 }
+
+TEST(ASYNCPP, GeneratorChunked) {
+	auto gen = []() -> generator<int> {
+		std::vector<int> buffer;
+		for (int base = 0; base < 100; base += 10) {
+			buffer.clear();
+			for (int i = 0; i < 10; i++)
+				buffer.push_back(base + i);
+			co_yield std::span<int>{buffer};
+			// Empty chunks are skipped and single values can be mixed in
+			co_yield std::span<int>{};
+		}
+		co_yield 100;
+	}();
+	std::vector<int> values;
+	for (auto e : gen)
+		values.push_back(e);
+	ASSERT_EQ(values.size(), 101);
+	for (int i = 0; i <= 100; i++)
+		ASSERT_EQ(values[i], i);
+
+	size_t chunks = 0;
+	int sum = 0;
+	auto gen2 = []() -> generator<int> {
+		std::array<int, 4> buffer{1, 2, 3, 4};
+		co_yield std::span<int>{buffer};
+		co_yield std::span<int>{buffer};
+	}();
+	for (auto it = gen2.begin(); it != gen2.end(); it.next_chunk()) {
+		auto chunk = it.chunk();
+		ASSERT_EQ(chunk.size(), 4);
+		sum += std::accumulate(chunk.begin(), chunk.end(), 0);
+		chunks++;
+	}
+	ASSERT_EQ(chunks, 2);
+	ASSERT_EQ(sum, 20);
+}
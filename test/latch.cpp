@@ -0,0 +1,33 @@
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/latch.h>
+#include <gtest/gtest.h>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, Latch) {
+	latch l{3};
+	bool done = false;
+	[](latch& l, bool& done) -> eager_fire_and_forget_task<> {
+		co_await l.wait();
+		done = true;
+	}(l, done);
+	ASSERT_FALSE(l.is_ready());
+	l.decrement();
+	ASSERT_FALSE(l.is_ready());
+	ASSERT_FALSE(done);
+	// Reaching zero needs to set the event, regardless of the amount the last decrement took
+	l.decrement(2);
+	ASSERT_TRUE(l.is_ready());
+	ASSERT_TRUE(done);
+}
+
+TEST(ASYNCPP, LatchZero) {
+	latch l{0};
+	ASSERT_TRUE(l.is_ready());
+	bool done = false;
+	[](latch& l, bool& done) -> eager_fire_and_forget_task<> {
+		co_await l.wait();
+		done = true;
+	}(l, done);
+	ASSERT_TRUE(done);
+}
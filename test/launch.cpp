@@ -92,3 +92,52 @@ TEST(ASYNCPP, AsyncLaunchScopeInvoke) {
 
 	ASSERT_TRUE(did_destroy);
 }
+
+TEST(ASYNCPP, AsyncLaunchScopeArena) {
+	struct test_dispatcher {
+		std::vector<std::function<void()>> waiting;
+		void push(std::function<void()> fn) { waiting.emplace_back(std::move(fn)); }
+		bool invoke_all() {
+			auto w = std::move(waiting);
+			for (auto& e : w)
+				e();
+			return !w.empty();
+		}
+	};
+	test_dispatcher d{};
+	int done = 0;
+	bool join_did_return = false;
+	async_launch_scope scope{async_launch_scope::use_arena};
+
+	// Run a couple of rounds, so the arena gets reused after every join
+	for (int round = 0; round < 3; round++) {
+		join_did_return = false;
+		for (int i = 0; i < 50; i++) {
+			scope.launch([](test_dispatcher& d, int& done) -> task<void> {
+				co_await defer{d};
+				done++;
+			}(d, done));
+		}
+		scope.invoke(
+			[](test_dispatcher& d, int& done) -> task<void> {
+				co_await defer{d};
+				done++;
+			},
+			d, done);
+		scope.invoke_tuple(
+			[](test_dispatcher& d, int& done) -> task<void> {
+				co_await defer{d};
+				done++;
+			},
+			std::tuple<test_dispatcher&, int&>{d, done});
+		launch([](async_launch_scope& scope, bool& join_did_return) -> task<void> {
+			co_await scope.join();
+			join_did_return = true;
+		}(scope, join_did_return));
+		ASSERT_EQ(scope.inflight_coroutines(), 52);
+		ASSERT_TRUE(d.invoke_all());
+		ASSERT_TRUE(join_did_return);
+		ASSERT_TRUE(scope.all_done());
+	}
+	ASSERT_EQ(done, 156);
+}
@@ -0,0 +1,214 @@
+#include <asyncpp/channel.h>
+#include <asyncpp/event.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/metrics.h>
+#include <asyncpp/mutex.h>
+#include <asyncpp/thread_pool.h>
+#include <asyncpp/timer.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <sstream>
+#include <thread>
+
+using namespace asyncpp;
+
+namespace {
+	struct dummy_dispatcher final : dispatcher {
+		void push(std::function<void()> cbfn) override { cbfn(); }
+	};
+} // namespace
+
+TEST(ASYNCPP, MetricsSlot) {
+	static_assert(alignof(detail::metrics_slot) == 64);
+	detail::metrics_slot slot;
+	slot.count_push(3);
+	slot.count_steal();
+	slot.count_callback(std::chrono::nanoseconds{100});
+	slot.count_callback(std::chrono::nanoseconds{300});
+	slot.count_idle(std::chrono::nanoseconds{50});
+
+	dispatcher_metrics res{};
+	slot.collect(res);
+	slot.collect(res);
+	ASSERT_EQ(res.pushed, 6);
+	ASSERT_EQ(res.executed, 4);
+	ASSERT_EQ(res.stolen, 2);
+	ASSERT_EQ(res.busy_time, std::chrono::nanoseconds{800});
+	ASSERT_EQ(res.idle_time, std::chrono::nanoseconds{100});
+	ASSERT_EQ(res.max_callback_time, std::chrono::nanoseconds{300});
+	ASSERT_EQ(res.average_callback_time(), std::chrono::nanoseconds{200});
+	ASSERT_DOUBLE_EQ(res.steal_rate(), 0.5);
+}
+
+TEST(ASYNCPP, ContentionCounters) {
+	detail::contention_counters counters;
+	counters.count_wait();
+	counters.count_wait();
+	counters.count_parked(std::chrono::nanoseconds{100});
+	counters.count_waiters(3);
+	counters.count_waiters(1);
+
+	auto res = counters.collect();
+	ASSERT_EQ(res.waits, 2);
+	ASSERT_EQ(res.suspensions, 1);
+	ASSERT_EQ(res.parked_time, std::chrono::nanoseconds{100});
+	ASSERT_EQ(res.max_parked_time, std::chrono::nanoseconds{100});
+	ASSERT_EQ(res.max_waiters, 3);
+	ASSERT_DOUBLE_EQ(res.suspend_rate(), 0.5);
+	ASSERT_EQ(res.average_parked_time(), std::chrono::nanoseconds{100});
+
+	detail::park_timer timer;
+	timer.start();
+	timer.cancel();
+	timer.finish(counters);
+	ASSERT_EQ(counters.collect().suspensions, 1);
+	timer.start();
+	timer.finish(counters);
+	ASSERT_EQ(counters.collect().suspensions, 2);
+}
+
+TEST(ASYNCPP, ChromeTraceRecorder) {
+	dummy_dispatcher disp;
+	chrome_trace_recorder recorder;
+	recorder.on_event(disp, dispatch_event::push, 0);
+	std::thread{[&]() {
+		recorder.on_event(disp, dispatch_event::start, 1);
+		recorder.on_event(disp, dispatch_event::steal, 1);
+		recorder.on_event(disp, dispatch_event::end, 1);
+	}}.join();
+	// Another recorder in between must not mix up the buffers of this thread
+	chrome_trace_recorder other;
+	other.on_event(disp, dispatch_event::push, 0);
+	recorder.on_event(disp, dispatch_event::push, 0);
+	ASSERT_EQ(recorder.size(), 5);
+	ASSERT_EQ(other.size(), 1);
+
+	std::stringstream ss;
+	recorder.write(ss);
+	const auto json = ss.str();
+	ASSERT_EQ(json.rfind(R"({"displayTimeUnit":"ns","traceEvents":[)", 0), 0);
+	ASSERT_EQ(json.substr(json.size() - 2), "]}");
+	ASSERT_NE(json.find(R"("tid":1,"name":"thread_name")"), std::string::npos);
+	ASSERT_NE(json.find(R"("tid":2,"name":"thread_name")"), std::string::npos);
+	ASSERT_EQ(json.find(R"("tid":3)"), std::string::npos);
+	ASSERT_NE(json.find(R"("ph":"B")"), std::string::npos);
+	ASSERT_NE(json.find(R"("ph":"E")"), std::string::npos);
+	ASSERT_NE(json.find(R"("name":"steal","s":"t")"), std::string::npos);
+	ASSERT_NE(json.find(R"("worker":1})"), std::string::npos);
+
+	recorder.clear();
+	ASSERT_EQ(recorder.size(), 0);
+}
+
+#if ASYNCPP_ENABLE_METRICS
+TEST(ASYNCPP, ThreadPoolMetrics) {
+	chrome_trace_recorder recorder;
+	thread_pool pool(2);
+	pool.observer(&recorder);
+	constexpr size_t count = 100;
+	std::atomic<size_t> done{0};
+	std::promise<void> finished;
+	for (size_t i = 0; i < count; i++) {
+		pool.push([&]() {
+			if (done.fetch_add(1) + 1 == count) finished.set_value();
+		});
+	}
+	ASSERT_EQ(finished.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	// The end event of the last callback is reported after it returned
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (pool.metrics().executed != count && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::yield();
+	auto res = pool.metrics();
+	ASSERT_EQ(res.workers, 2);
+	ASSERT_EQ(res.pushed, count);
+	ASSERT_EQ(res.executed, count);
+	ASSERT_LE(res.stolen, count);
+	ASSERT_EQ(res.queue_depth, 0);
+	ASSERT_GE(recorder.size(), count * 3);
+	pool.observer(nullptr);
+
+	// Counters of removed workers are kept
+	pool.resize(1);
+	ASSERT_EQ(pool.metrics().executed, count);
+}
+
+TEST(ASYNCPP, TimerMetrics) {
+	chrome_trace_recorder recorder;
+	timer tmr;
+	tmr.observer(&recorder);
+	std::promise<void> finished;
+	tmr.push([&]() { finished.set_value(); });
+	ASSERT_EQ(finished.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (tmr.metrics().executed != 1 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::yield();
+	auto res = tmr.metrics();
+	ASSERT_EQ(res.workers, 1);
+	ASSERT_EQ(res.pushed, 1);
+	ASSERT_EQ(res.executed, 1);
+	ASSERT_EQ(recorder.size(), 3);
+}
+
+TEST(ASYNCPP, MutexContentionMetrics) {
+	mutex mtx;
+	size_t locked = 0;
+	auto locker = [](mutex& mtx, size_t& locked) -> eager_fire_and_forget_task<> {
+		co_await mtx.lock();
+		locked++;
+	};
+	locker(mtx, locked);
+	locker(mtx, locked);
+	locker(mtx, locked);
+	ASSERT_EQ(locked, 1);
+	mtx.unlock();
+	mtx.unlock();
+	mtx.unlock();
+	ASSERT_EQ(locked, 3);
+	auto res = mtx.metrics();
+	ASSERT_EQ(res.waits, 3);
+	ASSERT_EQ(res.suspensions, 2);
+	ASSERT_EQ(res.max_waiters, 2);
+	ASSERT_LE(res.max_parked_time, res.parked_time);
+}
+
+TEST(ASYNCPP, EventContentionMetrics) {
+	multi_consumer_event evt;
+	auto waiter = [](multi_consumer_event& evt) -> eager_fire_and_forget_task<> { co_await evt.wait(); };
+	waiter(evt);
+	waiter(evt);
+	evt.set();
+	waiter(evt);
+	auto res = evt.metrics();
+	ASSERT_EQ(res.waits, 3);
+	ASSERT_EQ(res.suspensions, 2);
+	ASSERT_EQ(res.max_waiters, 2);
+
+	single_consumer_auto_reset_event auto_evt;
+	[](single_consumer_auto_reset_event& evt) -> eager_fire_and_forget_task<> { co_await evt.wait(); }(auto_evt);
+	auto_evt.set();
+	ASSERT_EQ(auto_evt.metrics().suspensions, 1);
+}
+
+TEST(ASYNCPP, ChannelContentionMetrics) {
+	channel<int> chan;
+	auto reader = [](channel<int>& chan) -> eager_fire_and_forget_task<> { co_await chan.read().resume_on(nullptr); };
+	reader(chan);
+	reader(chan);
+	ASSERT_TRUE(chan.try_write(1));
+	ASSERT_TRUE(chan.try_write(2));
+	ASSERT_FALSE(chan.try_write(3));
+	auto res = chan.read_metrics();
+	ASSERT_EQ(res.waits, 2);
+	ASSERT_EQ(res.suspensions, 2);
+	ASSERT_EQ(res.max_waiters, 2);
+	ASSERT_EQ(chan.write_metrics().waits, 0);
+}
+#else
+TEST(ASYNCPP, MetricsCompiledOut) {
+	// Without ASYNCPP_ENABLE_METRICS the hooks add no state to the dispatchers
+	static_assert(sizeof(dummy_dispatcher) == sizeof(void*));
+}
+#endif
@@ -1,10 +1,34 @@
+#include <asyncpp/defer.h>
 #include <asyncpp/fire_and_forget.h>
 #include <asyncpp/mutex.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
 #include <gtest/gtest.h>
 
+#include <deque>
+#include <vector>
+
 using asyncpp::eager_fire_and_forget_task;
 using asyncpp::mutex;
 using asyncpp::mutex_lock;
+using asyncpp::mutex_options;
+
+namespace {
+	struct queue_dispatcher : asyncpp::dispatcher {
+		std::deque<std::function<void()>> queue;
+		void push(std::function<void()> fn) override { queue.push_back(std::move(fn)); }
+		void run() {
+			auto old = current(this);
+			while (!queue.empty()) {
+				auto fn = std::move(queue.front());
+				queue.pop_front();
+				fn();
+			}
+			current(old);
+		}
+	};
+} // namespace
 
 TEST(ASYNCPP, Mutex) {
 	mutex mtx;
@@ -80,3 +104,52 @@ TEST(ASYNCPP, MutexLock) {
 	}
 	ASSERT_FALSE(mtx.is_locked());
 }
+
+TEST(ASYNCPP, MutexDispatchWaiters) {
+	mutex mtx{mutex_options{.dispatch_waiters = true}};
+	queue_dispatcher dsp;
+	bool done = false;
+	ASSERT_TRUE(mtx.try_lock());
+	dsp.push([&]() {
+		[](mutex& mtx, bool& done) -> eager_fire_and_forget_task<> {
+			co_await mtx.lock();
+			done = true;
+			mtx.unlock();
+		}(mtx, done);
+	});
+	dsp.run();
+	ASSERT_FALSE(done);
+	// The waiter owns the lock after unlock, but only runs once the dispatcher does
+	mtx.unlock();
+	ASSERT_FALSE(done);
+	ASSERT_TRUE(mtx.is_locked());
+	ASSERT_EQ(dsp.queue.size(), 1);
+	dsp.run();
+	ASSERT_TRUE(done);
+	ASSERT_FALSE(mtx.is_locked());
+}
+
+TEST(ASYNCPP, MutexAdaptive) {
+	constexpr size_t num_tasks = 16;
+	constexpr size_t num_iterations = 1000;
+	asyncpp::thread_pool pool{4};
+	mutex mtx{mutex_options::adaptive()};
+	size_t counter = 0;
+	std::vector<asyncpp::task<>> tasks;
+	for (size_t i = 0; i < num_tasks; i++) {
+		tasks.push_back([](asyncpp::thread_pool& pool, mutex& mtx, size_t& counter) -> asyncpp::task<> {
+			co_await asyncpp::defer{pool};
+			for (size_t n = 0; n < num_iterations; n++) {
+				auto lck = co_await mtx.lock_scoped();
+				counter++;
+			}
+		}(pool, mtx, counter));
+	}
+	std::vector<std::future<void>> results;
+	for (auto& e : tasks)
+		results.push_back(as_promise(std::move(e)));
+	for (auto& e : results)
+		e.get();
+	ASSERT_EQ(counter, num_tasks * num_iterations);
+	ASSERT_FALSE(mtx.is_locked());
+}
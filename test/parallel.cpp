@@ -0,0 +1,74 @@
+#include <asyncpp/parallel.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, ParallelFor) {
+	thread_pool pool{4};
+	std::vector<std::atomic<int>> hits(10000);
+	std::mutex mtx;
+	std::set<std::thread::id> threads;
+	as_promise([](thread_pool& pool, std::vector<std::atomic<int>>& hits, std::mutex& mtx,
+				  std::set<std::thread::id>& threads) -> task<> {
+		co_await parallel_for(pool, size_t{0}, hits.size(), [&](size_t i) {
+			hits[i]++;
+			if (i % 100 == 0) {
+				std::unique_lock lck{mtx};
+				threads.insert(std::this_thread::get_id());
+			}
+		});
+		// Empty ranges complete without suspending
+		co_await parallel_for(pool, 5, 5, [](int) { std::terminate(); });
+	}(pool, hits, mtx, threads))
+		.get();
+	for (auto& e : hits)
+		ASSERT_EQ(e, 1);
+	ASSERT_FALSE(threads.contains(std::this_thread::get_id()));
+}
+
+TEST(ASYNCPP, ParallelForException) {
+	thread_pool pool{2};
+	auto res = as_promise([](thread_pool& pool) -> task<> {
+		co_await parallel_for(pool, 0, 1000, [](int i) {
+			if (i == 500) throw std::runtime_error("failed");
+		});
+	}(pool));
+	ASSERT_THROW(res.get(), std::runtime_error);
+}
+
+TEST(ASYNCPP, ParallelTransformReduce) {
+	thread_pool pool{4};
+	std::vector<int> input(100000);
+	std::iota(input.begin(), input.end(), 0);
+	std::vector<long> output(input.size());
+	auto [end, sum, squares] = as_promise([](thread_pool& pool, std::vector<int>& input,
+											 std::vector<long>& output) -> task<std::tuple<bool, long, long>> {
+								   auto end = co_await parallel_transform(pool, input.begin(), input.end(),
+																		  output.begin(),
+																		  [](int v) { return long{v} * 2; }, 64);
+								   auto sum = co_await parallel_reduce(pool, output.begin(), output.end(), 0L);
+								   auto squares = co_await parallel_transform_reduce(
+									   pool, input.begin(), input.end(), 0L, std::plus<>{},
+									   [](int v) { return long{v} * v; });
+								   co_return std::tuple{end == output.end(), sum, squares};
+							   }(pool, input, output))
+							   .get();
+	ASSERT_TRUE(end);
+	for (size_t i = 0; i < input.size(); i++)
+		ASSERT_EQ(output[i], input[i] * 2L);
+	ASSERT_EQ(sum, 99999L * 100000L);
+	long expected = 0;
+	for (long v : input)
+		expected += v * v;
+	ASSERT_EQ(squares, expected);
+}
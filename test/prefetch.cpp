@@ -0,0 +1,90 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/prefetch.h>
+#include <asyncpp/scope_guard.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+namespace {
+	async_generator<int> counting_generator(int max, std::atomic<int>& produced, std::thread::id& thread,
+											std::atomic<bool>& destroyed) {
+		scope_guard guard{[&destroyed]() noexcept { destroyed = true; }};
+		thread = std::this_thread::get_id();
+		// A negative max never stops
+		for (int i = 0; max < 0 || i < max; i++) {
+			produced++;
+			co_yield i;
+		}
+		throw std::runtime_error("source failed");
+	}
+
+	bool wait_for(auto&& pred) {
+		auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!pred()) {
+			if (std::chrono::steady_clock::now() > end) return false;
+			std::this_thread::yield();
+		}
+		return true;
+	}
+} // namespace
+
+TEST(ASYNCPP, Prefetch) {
+	constexpr int capacity = 3;
+	thread_pool pool{1};
+	thread_pool consumer_pool{1};
+	std::atomic<int> produced{0};
+	std::atomic<bool> destroyed{false};
+	std::thread::id producer_thread{};
+	std::vector<int> values;
+	bool ran_ahead = true;
+	bool failed = false;
+	as_promise([](thread_pool& pool, thread_pool& consumer_pool, std::atomic<int>& produced,
+				  std::thread::id& producer_thread, std::atomic<bool>& destroyed, std::vector<int>& values,
+				  bool& ran_ahead, bool& failed) -> task<> {
+		// Waiting for the producer inside the consumer would block it if the consumer was resumed by it
+		co_await defer{consumer_pool};
+		auto gen = prefetch(counting_generator(10, produced, producer_thread, destroyed), &pool, capacity);
+		try {
+			for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+				// The producer fills the buffer and the value currently waiting to be written
+				auto expected = std::min<int>(10, static_cast<int>(values.size()) + capacity + 2);
+				if (!wait_for([&]() { return produced >= expected; })) ran_ahead = false;
+				values.push_back(*it);
+			}
+		} catch (const std::runtime_error&) { failed = true; }
+	}(pool, consumer_pool, produced, producer_thread, destroyed, values, ran_ahead, failed))
+		.get();
+	ASSERT_EQ(values, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+	ASSERT_TRUE(ran_ahead);
+	ASSERT_TRUE(failed);
+	ASSERT_NE(producer_thread, std::this_thread::get_id());
+	ASSERT_TRUE(wait_for([&]() { return destroyed.load(); }));
+}
+
+TEST(ASYNCPP, PrefetchDestroyEarly) {
+	thread_pool pool{1};
+	std::atomic<int> produced{0};
+	std::atomic<bool> destroyed{false};
+	std::thread::id producer_thread{};
+	int sum = 0;
+	as_promise([](thread_pool& pool, std::atomic<int>& produced, std::thread::id& producer_thread,
+				  std::atomic<bool>& destroyed, int& sum) -> task<> {
+		auto gen = prefetch(counting_generator(-1, produced, producer_thread, destroyed), &pool, 2);
+		auto it = co_await gen.begin();
+		sum += *it;
+		co_await ++it;
+		sum += *it;
+	}(pool, produced, producer_thread, destroyed, sum))
+		.get();
+	ASSERT_EQ(sum, 1);
+	ASSERT_TRUE(wait_for([&]() { return destroyed.load(); }));
+}
@@ -1,14 +1,32 @@
 #include "debug_allocator.h"
 #include <asyncpp/promise.h>
 #include <asyncpp/sync_wait.h>
+#include <atomic>
 #include <chrono>
 #include <exception>
 #include <gtest/gtest.h>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 using namespace asyncpp;
 
+namespace {
+	// Coroutine starting right away, which is only ever destroyed by its owner
+	struct manual_coroutine {
+		struct promise_type {
+			manual_coroutine get_return_object() noexcept {
+				return {coroutine_handle<promise_type>::from_promise(*this)};
+			}
+			suspend_never initial_suspend() noexcept { return {}; }
+			suspend_always final_suspend() noexcept { return {}; }
+			void return_void() noexcept {}
+			void unhandled_exception() noexcept { std::terminate(); }
+		};
+		coroutine_handle<promise_type> handle;
+	};
+} // namespace
+
 TEST(ASYNCPP, PromiseMakeFulfilled) {
 	auto p = promise<int>::make_fulfilled(42);
 	ASSERT_FALSE(p.is_pending());
@@ -426,3 +444,62 @@ TEST(ASYNCPP, PromiseRejectClearsFulfillCallbacks) {
 	p.reject<std::runtime_error>("");
 	ASSERT_EQ(count.use_count(), 1);
 }
+
+TEST(ASYNCPP, PromiseContinuationOrder) {
+	promise<int> p;
+	std::vector<int> order;
+	p.on_settle([&order]() { order.push_back(1); });
+	p.then([&order](const int&) { order.push_back(2); }, {});
+	auto awaited = as_promise(p);
+	p.on_settle([&order]() { order.push_back(3); });
+	p.fulfill(42);
+	ASSERT_EQ(order, (std::vector<int>{1, 2, 3}));
+	ASSERT_EQ(awaited.get(), 42);
+}
+
+TEST(ASYNCPP, PromiseConcurrentSettle) {
+	for (int i = 0; i < 100; i++) {
+		promise<int> p;
+		std::atomic<int> called{0};
+		std::atomic<int> settled{0};
+		bool waiter_fulfilled = false;
+		std::thread waiter{[&]() {
+			try {
+				waiter_fulfilled = p.get() == 1;
+			} catch (int) {}
+		}};
+		std::thread fulfiller{[&]() { settled += p.try_fulfill(1) ? 1 : 0; }};
+		std::thread rejecter{[&]() { settled += p.try_reject(std::make_exception_ptr(2)) ? 1 : 0; }};
+		for (int j = 0; j < 10; j++)
+			p.on_settle([&called]() { called++; });
+		fulfiller.join();
+		rejecter.join();
+		waiter.join();
+		ASSERT_EQ(settled.load(), 1);
+		ASSERT_EQ(called.load(), 10);
+		ASSERT_EQ(waiter_fulfilled, p.is_fulfilled());
+	}
+}
+
+TEST(ASYNCPP, PromiseAwaiterDestroyedLastRef) {
+	// The suspended awaiter holds the only reference to the state, so destroying it destroys the state
+	auto coro = [](promise<int> p) -> manual_coroutine { co_await std::move(p); }(promise<int>{});
+	ASSERT_FALSE(coro.handle.done());
+	coro.handle.destroy();
+}
+
+TEST(ASYNCPP, PromiseAwaiterDestroyed) {
+	promise<int> p;
+	bool resumed = false;
+	auto coro = [](promise<int> p, bool& resumed) -> manual_coroutine {
+		co_await p;
+		resumed = true;
+	}(p, resumed);
+	coro.handle.destroy();
+	// The continuation of the destroyed awaiter is gone, the others still run
+	int value = 0;
+	p.then([&value](const int& v) { value = v; }, {});
+	p.fulfill(42);
+	ASSERT_FALSE(resumed);
+	ASSERT_EQ(value, 42);
+}
@@ -32,3 +32,59 @@ TEST(ASYNCPP, PtrTagEnum) {
 	ASSERT_EQ(untagged, &t);
 	ASSERT_EQ(id, tag::test1);
 }
+
+namespace {
+	struct alignas(8) node {
+		node* next{};
+	};
+} // namespace
+
+TEST(ASYNCPP, AtomicTaggedPtr) {
+	static_assert(atomic_tagged_ptr<node>::is_always_lock_free);
+	node a, b;
+	atomic_tagged_ptr<node, tag> ptr{&a, tag::test1};
+	auto val = ptr.load();
+	ASSERT_EQ(val.ptr(), &a);
+	ASSERT_EQ(val.tag(), tag::test1);
+	ASSERT_EQ(val.generation(), 0);
+
+	ASSERT_TRUE(ptr.compare_exchange_strong(val, &b, tag::test0));
+	val = ptr.load();
+	ASSERT_EQ(val.ptr(), &b);
+	ASSERT_EQ(val.tag(), tag::test0);
+	ASSERT_EQ(val.generation(), 1);
+
+	auto old = ptr.exchange(nullptr);
+	ASSERT_EQ(old, val);
+	ASSERT_EQ(ptr.load().ptr(), nullptr);
+	ASSERT_EQ(ptr.load().generation(), 2);
+}
+
+TEST(ASYNCPP, AtomicTaggedPtrABA) {
+	node a, b;
+	atomic_tagged_ptr<node> ptr{&a};
+	auto stale = ptr.load();
+	// Change the pointer and change it back, a plain pointer CAS would succeed now
+	ptr.store(&b);
+	ptr.store(&a);
+	ASSERT_EQ(ptr.load().ptr(), stale.ptr());
+	ASSERT_NE(ptr.load(), stale);
+	ASSERT_FALSE(ptr.compare_exchange_strong(stale, &b));
+	ASSERT_EQ(stale, ptr.load());
+	ASSERT_TRUE(ptr.compare_exchange_strong(stale, &b));
+	ASSERT_EQ(ptr.load().ptr(), &b);
+}
+
+TEST(ASYNCPP, AtomicTaggedPtrGenerationWrap) {
+	using value_type = atomic_tagged_ptr<node>::value_type;
+	static_assert(value_type::pointer_bits + value_type::generation_bits == 64);
+	if constexpr (value_type::generation_bits <= 16) {
+		node a;
+		atomic_tagged_ptr<node> ptr{&a};
+		auto stale = ptr.load();
+		// The documented limit: after exactly 2^generation_bits modifications the stale value matches again
+		for (size_t i = 0; i < (size_t{1} << value_type::generation_bits); i++)
+			ptr.store(&a);
+		ASSERT_EQ(ptr.load(), stale);
+	}
+}
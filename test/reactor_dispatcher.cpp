@@ -0,0 +1,101 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/promise.h>
+#include <asyncpp/reactor_dispatcher.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <gtest/gtest.h>
+
+#ifdef ASYNCPP_HAS_REACTOR
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace asyncpp;
+
+namespace {
+	struct reactor_fixture {
+		reactor_dispatcher reactor;
+		std::thread thread{[this]() { reactor.run(); }};
+
+		~reactor_fixture() {
+			reactor.stop();
+			thread.join();
+		}
+	};
+} // namespace
+
+TEST(ASYNCPP, ReactorDispatcherStopBeforeRun) {
+	// A stop() that arrives before the thread entered run() must not get lost
+	for (int i = 0; i < 100; i++) {
+		reactor_fixture fixture;
+	}
+}
+
+TEST(ASYNCPP, ReactorDispatcher) {
+	reactor_fixture fixture;
+	std::array<int, 2> fds{};
+	ASSERT_EQ(pipe(fds.data()), 0);
+	auto res = as_promise([](reactor_dispatcher& reactor, std::array<int, 2> fds) -> task<std::string> {
+				   co_await defer{reactor};
+				   co_await reactor.wait_writable(fds[1]);
+				   if (::write(fds[1], "hello", 5) != 5) co_return "write failed";
+				   co_await reactor.wait_readable(fds[0]);
+				   std::array<char, 16> buffer{};
+				   auto size = ::read(fds[0], buffer.data(), buffer.size());
+				   if (size != 5) co_return "read failed";
+				   co_return std::string(buffer.data(), size);
+			   }(fixture.reactor, fds))
+				   .get();
+	ASSERT_EQ(res, "hello");
+
+	// Data written by another thread wakes the loop blocked in the poll
+	auto reader = as_promise([](reactor_dispatcher& reactor, int fd) -> task<std::string> {
+		co_await defer{reactor};
+		co_await reactor.wait_readable(fd);
+		std::array<char, 16> buffer{};
+		auto size = ::read(fd, buffer.data(), buffer.size());
+		co_return std::string(buffer.data(), std::max<ssize_t>(0, size));
+	}(fixture.reactor, fds[0]));
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(::write(fds[1], "world", 5), 5);
+	ASSERT_EQ(reader.get(), "world");
+	close(fds[0]);
+	close(fds[1]);
+}
+
+TEST(ASYNCPP, ReactorDispatcherTimer) {
+	reactor_fixture fixture;
+	auto res = as_promise([](reactor_dispatcher& reactor) -> task<bool> {
+				   co_await defer{reactor};
+				   const auto start = std::chrono::steady_clock::now();
+				   if (!co_await reactor.wait(std::chrono::milliseconds(10))) co_return false;
+				   co_return std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10);
+			   }(fixture.reactor))
+				   .get();
+	ASSERT_TRUE(res);
+
+	// Scheduled from another thread, ordered by their deadline
+	std::atomic<int> order{0};
+	std::atomic<int> first{0};
+	std::atomic<int> second{0};
+	promise<void> done;
+	fixture.reactor.schedule([&](bool ok) { second = ok ? ++order : -1; }, std::chrono::milliseconds(10));
+	fixture.reactor.schedule([&](bool ok) { first = ok ? ++order : -1; }, std::chrono::milliseconds(2));
+	fixture.reactor.schedule([&](bool) { done.fulfill(); }, std::chrono::milliseconds(20));
+	done.get();
+	ASSERT_EQ(first, 1);
+	ASSERT_EQ(second, 2);
+
+	// Cancelling resumes the wait right away with false
+	stop_source source;
+	auto cancelled = as_promise([](reactor_dispatcher& reactor, stop_token token) -> task<bool> {
+		co_await defer{reactor};
+		co_return co_await reactor.wait(std::chrono::hours(1), std::move(token));
+	}(fixture.reactor, source.get_token()));
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	source.request_stop();
+	ASSERT_FALSE(cancelled.get());
+}
+#endif
@@ -1,6 +1,10 @@
 #include <asyncpp/ref.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 using namespace asyncpp;
 
 namespace {
@@ -9,6 +13,12 @@ namespace {
 		~test() noexcept { did_destroy = true; }
 		using intrusive_refcount::use_count;
 	};
+	static std::atomic<int> biased_destroyed;
+	struct biased_test : intrusive_refcount<biased_test, biased_refcount> {
+		~biased_test() noexcept { biased_destroyed++; }
+		using intrusive_refcount::use_count;
+	};
+	struct derived_test : test {};
 } // namespace
 
 TEST(ASYNCPP, RefCounted) {
@@ -90,3 +100,58 @@ TEST(ASYNCPP, AtomicRefCounted) {
 	delete ptr;
 	ASSERT_TRUE(did_destroy);
 }
+
+TEST(ASYNCPP, BiasedRefCounted) {
+	biased_destroyed = 0;
+	{
+		// Only the owner thread, the object is released once the biased count drops to zero
+		ref hdl{new biased_test()};
+		ASSERT_EQ(hdl->use_count(), 1);
+		auto hdl2 = hdl;
+		ASSERT_EQ(hdl->use_count(), 2);
+		hdl2.reset();
+		ASSERT_EQ(hdl->use_count(), 1);
+	}
+	ASSERT_EQ(biased_destroyed, 1);
+
+	// Other threads take and drop references while the owner still holds one
+	ref hdl{new biased_test()};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([copy = hdl]() {
+			for (int i = 0; i < 1000; i++) {
+				auto tmp = copy;
+				static_cast<void>(tmp);
+			}
+		});
+	}
+	for (auto& e : threads)
+		e.join();
+	ASSERT_EQ(hdl->use_count(), 1);
+	ASSERT_EQ(biased_destroyed, 1);
+
+	// The owner drops its last reference first, the last foreign one releases the object
+	std::atomic<bool> owner_done{false};
+	std::thread other{[copy = hdl, &owner_done]() mutable {
+		while (!owner_done)
+			std::this_thread::yield();
+		ASSERT_EQ(biased_destroyed, 1);
+		copy.reset();
+	}};
+	hdl.reset();
+	owner_done = true;
+	other.join();
+	ASSERT_EQ(biased_destroyed, 2);
+}
+
+TEST(ASYNCPP, RefConvertingMove) {
+	did_destroy = false;
+	ref<derived_test> derived{new derived_test()};
+	auto ptr = derived.get();
+	ref<test> base{std::move(derived)};
+	ASSERT_FALSE(derived);
+	ASSERT_EQ(base.get(), ptr);
+	ASSERT_EQ(base->use_count(), 1);
+	base.reset();
+	ASSERT_TRUE(did_destroy);
+}
@@ -0,0 +1,77 @@
+#include <asyncpp/channel.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/select.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, SelectReady) {
+	channel<int> a;
+	channel<std::string> b{1};
+	ASSERT_TRUE(b.try_write("hello"));
+	std::optional<std::variant<std::optional<int>, std::optional<std::string>>> res;
+	[](auto& a, auto& b, auto& res) -> eager_fire_and_forget_task<> { res = co_await select(a.read(), b.read()); }(
+		a, b, res);
+	ASSERT_TRUE(res.has_value());
+	ASSERT_EQ(res->index(), 1);
+	ASSERT_EQ(std::get<1>(*res), "hello");
+}
+
+TEST(ASYNCPP, SelectWait) {
+	static channel<int> a;
+	static channel<int> b;
+	static std::optional<std::variant<std::optional<int>, std::optional<int>>> res;
+	[]() -> eager_fire_and_forget_task<> { res = co_await select(a.read(), b.read()); }();
+	ASSERT_FALSE(res.has_value());
+	ASSERT_TRUE(b.try_write(42));
+	ASSERT_TRUE(res.has_value());
+	ASSERT_EQ(res->index(), 1);
+	ASSERT_EQ(std::get<1>(*res), 42);
+	// The branch on a got cancelled, so there is no reader left
+	ASSERT_FALSE(a.try_write(1));
+}
+
+TEST(ASYNCPP, SelectWrite) {
+	static channel<int> a;
+	static channel<int> b;
+	static std::optional<std::variant<bool, std::optional<int>>> res;
+	[]() -> eager_fire_and_forget_task<> { res = co_await select(a.write(1), b.read()); }();
+	ASSERT_FALSE(res.has_value());
+	ASSERT_EQ(a.try_read(), 1);
+	ASSERT_TRUE(res.has_value());
+	ASSERT_EQ(res->index(), 0);
+	ASSERT_TRUE(std::get<0>(*res));
+	ASSERT_FALSE(b.try_write(2));
+}
+
+TEST(ASYNCPP, SelectClose) {
+	static channel<int> a;
+	static channel<int> b;
+	static std::optional<std::variant<std::optional<int>, std::optional<int>>> res;
+	[]() -> eager_fire_and_forget_task<> { res = co_await select(a.read(), b.read()); }();
+	a.close();
+	ASSERT_TRUE(res.has_value());
+	ASSERT_EQ(res->index(), 0);
+	ASSERT_FALSE(std::get<0>(*res).has_value());
+	ASSERT_FALSE(b.try_write(2));
+}
+
+TEST(ASYNCPP, SelectBetweenSelects) {
+	// A select writing and a select reading the same channel need to be able to complete each other
+	static channel<int> a;
+	static channel<int> b;
+	static channel<int> c;
+	static std::optional<std::variant<bool, std::optional<int>>> write_res;
+	static std::optional<std::variant<std::optional<int>, std::optional<int>>> read_res;
+	[]() -> eager_fire_and_forget_task<> { write_res = co_await select(a.write(5), b.read()); }();
+	[]() -> eager_fire_and_forget_task<> { read_res = co_await select(c.read(), a.read()); }();
+	ASSERT_TRUE(write_res.has_value());
+	ASSERT_TRUE(read_res.has_value());
+	ASSERT_EQ(write_res->index(), 0);
+	ASSERT_EQ(read_res->index(), 1);
+	ASSERT_EQ(std::get<1>(*read_res), 5);
+	ASSERT_FALSE(b.try_write(1));
+	ASSERT_FALSE(c.try_write(1));
+}
@@ -0,0 +1,77 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/semaphore.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, Semaphore) {
+	async_semaphore sem{2};
+	ASSERT_EQ(sem.available(), 2);
+	ASSERT_TRUE(sem.try_acquire());
+	ASSERT_FALSE(sem.try_acquire(2));
+	ASSERT_TRUE(sem.try_acquire());
+	ASSERT_FALSE(sem.try_acquire());
+	sem.release(2);
+	ASSERT_EQ(sem.available(), 2);
+
+	int done = 0;
+	auto acquire = [](async_semaphore& sem, size_t count, int& done) -> eager_fire_and_forget_task<> {
+		co_await sem.acquire(count, nullptr);
+		done++;
+	};
+	// Enough permits, no suspension
+	acquire(sem, 2, done);
+	ASSERT_EQ(done, 1);
+	ASSERT_EQ(sem.available(), 0);
+	// Waiters are resumed in order, a large one blocks those behind it
+	acquire(sem, 3, done);
+	acquire(sem, 1, done);
+	ASSERT_EQ(done, 1);
+	ASSERT_FALSE(sem.try_acquire());
+	sem.release(2);
+	ASSERT_EQ(done, 1);
+	sem.release(1);
+	ASSERT_EQ(done, 2);
+	sem.release(2);
+	ASSERT_EQ(done, 3);
+	// The remaining permit went back into the counter
+	ASSERT_EQ(sem.available(), 1);
+	ASSERT_TRUE(sem.try_acquire());
+}
+
+TEST(ASYNCPP, SemaphoreConcurrent) {
+	constexpr size_t num_tasks = 32;
+	constexpr size_t num_iterations = 200;
+	constexpr int max_concurrency = 3;
+	thread_pool pool{4};
+	async_semaphore sem{max_concurrency};
+	std::atomic<int> active{0};
+	std::atomic<bool> violated{false};
+	std::vector<std::future<void>> results;
+	for (size_t i = 0; i < num_tasks; i++) {
+		results.push_back(as_promise([](thread_pool& pool, async_semaphore& sem, std::atomic<int>& active,
+										std::atomic<bool>& violated, size_t count) -> task<> {
+			co_await defer{pool};
+			for (size_t n = 0; n < num_iterations; n++) {
+				co_await sem.acquire(count);
+				if (active.fetch_add(static_cast<int>(count)) + static_cast<int>(count) > max_concurrency)
+					violated = true;
+				if (n % 4 == 0) co_await defer{pool};
+				active.fetch_sub(static_cast<int>(count));
+				sem.release(count);
+			}
+		}(pool, sem, active, violated, i % 3 + 1)));
+	}
+	for (auto& e : results)
+		e.get();
+	ASSERT_FALSE(violated);
+	ASSERT_EQ(sem.available(), max_concurrency);
+}
@@ -0,0 +1,116 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/shared_mutex.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, SharedMutex) {
+	async_shared_mutex mtx;
+	ASSERT_FALSE(mtx.is_locked());
+
+	// Multiple readers, but no writer
+	ASSERT_TRUE(mtx.try_lock_shared());
+	ASSERT_TRUE(mtx.try_lock_shared());
+	ASSERT_TRUE(mtx.is_locked());
+	ASSERT_FALSE(mtx.try_lock());
+	mtx.unlock_shared();
+	mtx.unlock_shared();
+	ASSERT_FALSE(mtx.is_locked());
+
+	// A single writer excludes readers
+	ASSERT_TRUE(mtx.try_lock());
+	ASSERT_FALSE(mtx.try_lock());
+	ASSERT_FALSE(mtx.try_lock_shared());
+	mtx.unlock();
+	ASSERT_FALSE(mtx.is_locked());
+}
+
+TEST(ASYNCPP, SharedMutexHandOver) {
+	async_shared_mutex mtx;
+	int readers = 0;
+	bool writer = false;
+	auto read = [](async_shared_mutex& mtx, int& readers) -> eager_fire_and_forget_task<> {
+		co_await mtx.lock_shared();
+		readers++;
+	};
+	auto write = [](async_shared_mutex& mtx, bool& writer) -> eager_fire_and_forget_task<> {
+		co_await mtx.lock();
+		writer = true;
+	};
+
+	// Readers get in right away while only readers hold the mutex
+	read(mtx, readers);
+	ASSERT_EQ(readers, 1);
+	// A writer has to wait for the reader and blocks new readers
+	write(mtx, writer);
+	ASSERT_FALSE(writer);
+	read(mtx, readers);
+	read(mtx, readers);
+	ASSERT_EQ(readers, 1);
+	ASSERT_FALSE(mtx.try_lock_shared());
+	// Once the reader leaves the writer gets the mutex
+	mtx.unlock_shared();
+	ASSERT_TRUE(writer);
+	ASSERT_EQ(readers, 1);
+	// Releasing the writer lets both queued readers in at once
+	mtx.unlock();
+	ASSERT_EQ(readers, 3);
+	ASSERT_TRUE(mtx.is_locked());
+	ASSERT_FALSE(mtx.try_lock());
+	// The mutex went back to being uncontended, so new readers get in as well
+	ASSERT_TRUE(mtx.try_lock_shared());
+	mtx.unlock_shared();
+	mtx.unlock_shared();
+	mtx.unlock_shared();
+	ASSERT_FALSE(mtx.is_locked());
+}
+
+TEST(ASYNCPP, SharedMutexConcurrent) {
+	constexpr size_t num_tasks = 16;
+	constexpr size_t num_iterations = 500;
+	thread_pool pool{4};
+	async_shared_mutex mtx;
+	std::atomic<int> active_readers{0};
+	std::atomic<int> active_writers{0};
+	std::atomic<bool> violated{false};
+	size_t value = 0;
+	std::vector<std::future<void>> results;
+	for (size_t i = 0; i < num_tasks; i++) {
+		results.push_back(as_promise([](thread_pool& pool, async_shared_mutex& mtx, std::atomic<int>& readers,
+										std::atomic<int>& writers, std::atomic<bool>& violated, size_t& value,
+										bool is_writer) -> task<> {
+			co_await defer{pool};
+			for (size_t n = 0; n < num_iterations; n++) {
+				if (is_writer) {
+					co_await mtx.lock();
+					if (writers.fetch_add(1) != 0 || readers.load() != 0) violated = true;
+					value++;
+					// Suspend while holding the lock every now and then, so others have to queue up
+					if (n % 8 == 0) co_await defer{pool};
+					writers.fetch_sub(1);
+					mtx.unlock();
+				} else {
+					co_await mtx.lock_shared();
+					readers.fetch_add(1);
+					if (writers.load() != 0) violated = true;
+					if (n % 8 == 0) co_await defer{pool};
+					readers.fetch_sub(1);
+					mtx.unlock_shared();
+				}
+			}
+		}(pool, mtx, active_readers, active_writers, violated, value, i % 4 == 0)));
+	}
+	for (auto& e : results)
+		e.get();
+	ASSERT_FALSE(violated);
+	ASSERT_EQ(value, (num_tasks / 4) * num_iterations);
+	ASSERT_FALSE(mtx.is_locked());
+}
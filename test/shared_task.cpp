@@ -0,0 +1,78 @@
+#include <asyncpp/event.h>
+#include <asyncpp/launch.h>
+#include <asyncpp/shared_task.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, SharedTask) {
+	int runs = 0;
+	single_consumer_event evt;
+	auto shared = [](int& runs, single_consumer_event& evt) -> shared_task<std::string> {
+		runs++;
+		co_await evt;
+		co_return "result";
+	}(runs, evt);
+	ASSERT_EQ(runs, 0);
+	ASSERT_FALSE(shared.is_ready());
+
+	std::vector<std::string> results;
+	for (int i = 0; i < 3; i++) {
+		launch([](shared_task<std::string> tsk, std::vector<std::string>& results) -> task<void> {
+			results.push_back(co_await tsk);
+		}(shared, results));
+	}
+	ASSERT_EQ(runs, 1);
+	ASSERT_TRUE(results.empty());
+	evt.set();
+	ASSERT_EQ(results, std::vector<std::string>(3, "result"));
+	ASSERT_TRUE(shared.is_ready());
+
+	// Finished tasks do not suspend
+	auto res = as_promise([](shared_task<std::string> tsk) -> task<std::string> { co_return co_await tsk; }(shared));
+	ASSERT_EQ(res.get(), "result");
+	ASSERT_EQ(runs, 1);
+}
+
+TEST(ASYNCPP, SharedTaskException) {
+	auto shared = []() -> shared_task<> {
+		throw std::runtime_error("failed");
+		co_return;
+	}();
+	for (int i = 0; i < 2; i++) {
+		auto res = as_promise([](shared_task<> tsk) -> task<> { co_await tsk; }(shared));
+		ASSERT_THROW(res.get(), std::runtime_error);
+	}
+}
+
+TEST(ASYNCPP, SharedTaskThreads) {
+	constexpr size_t num_threads = 8;
+	std::atomic<int> runs{0};
+	multi_consumer_event evt;
+	auto shared = [](std::atomic<int>& runs, multi_consumer_event& evt) -> shared_task<int> {
+		runs++;
+		co_await evt;
+		co_return 42;
+	}(runs, evt);
+	std::atomic<int> sum{0};
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < num_threads; i++) {
+		threads.emplace_back([&]() {
+			launch([](shared_task<int> tsk, std::atomic<int>& sum) -> task<void> {
+				sum += co_await tsk;
+			}(shared, sum));
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	evt.set();
+	ASSERT_EQ(runs, 1);
+	ASSERT_EQ(sum, 42 * num_threads);
+}
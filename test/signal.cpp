@@ -1,6 +1,10 @@
 #include <asyncpp/signal.h>
 #include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
 #include <thread>
+#include <vector>
 
 TEST(ASYNCPP, Signal) {
 	int param = 0;
@@ -179,3 +183,217 @@ TEST(ASYNCPP, SignalExplicitThreading) {
 	asyncpp::signal_mt<void()> sigmt;
 	asyncpp::signal_st<void()> sigst;
 }
+
+TEST(ASYNCPP, SignalRcu) {
+	std::vector<int> calls;
+	asyncpp::signal_rcu<void(int)> sig;
+	ASSERT_TRUE(sig.empty());
+	ASSERT_EQ(sig(1), 0);
+	auto con = sig += [&](int val) { calls.push_back(val); };
+	auto con2 = sig.prepend([&](int val) { calls.push_back(-val); });
+	ASSERT_EQ(sig.size(), 2);
+	ASSERT_TRUE(sig.owns_handle(con));
+	ASSERT_EQ(sig(42), 2);
+	ASSERT_EQ(calls, (std::vector<int>{-42, 42}));
+	sig.remove(con2);
+	ASSERT_FALSE(sig.owns_handle(con2));
+	// More emissions than the reference counter inside the snapshot pointer can hold
+	calls.clear();
+	for (int i = 0; i < 100000; i++)
+		sig(i);
+	ASSERT_EQ(calls.size(), 100000);
+	calls = {-42, 42};
+	ASSERT_EQ(sig(41), 1);
+	con.disconnect();
+	ASSERT_EQ(sig(40), 0);
+	ASSERT_TRUE(sig.empty());
+	ASSERT_EQ(calls, (std::vector<int>{-42, 42, 41}));
+}
+
+TEST(ASYNCPP, SignalRcuModifyDuringEmit) {
+	asyncpp::signal_rcu<void(int)> sig;
+	int calls = 0;
+	asyncpp::signal_handle self;
+	asyncpp::signal_handle other;
+	self = sig += [&](int val) {
+		calls++;
+		// Removing ourself and the next slot is visible to the running emission, adding a new one is not
+		sig.remove(self);
+		other.disconnect();
+		sig += [&](int) { calls += 100; };
+		if (val == 42) sig(41);
+	};
+	other = sig += [&](int) { calls += 10; };
+	ASSERT_EQ(sig(42), 1);
+	ASSERT_EQ(calls, 101);
+	ASSERT_EQ(sig(40), 1);
+	ASSERT_EQ(calls, 201);
+}
+
+TEST(ASYNCPP, SignalRcuConcurrent) {
+	asyncpp::signal_rcu<void(int)> sig;
+	std::atomic<size_t> sum{0};
+	auto con = sig += [&](int val) { sum += val; };
+	std::atomic<bool> stop{false};
+	std::vector<std::thread> emitters;
+	for (int i = 0; i < 4; i++) {
+		emitters.emplace_back([&]() {
+			while (!stop)
+				sig(1);
+		});
+	}
+	for (int i = 0; i < 1000; i++) {
+		auto hdl = sig += [](int) {};
+		sig.remove(hdl);
+	}
+	stop = true;
+	for (auto& e : emitters)
+		e.join();
+	ASSERT_TRUE(sig.owns_handle(con));
+	ASSERT_EQ(sig.size(), 1);
+	const auto before = sum.load();
+	ASSERT_EQ(sig(1), 1);
+	ASSERT_EQ(sum.load(), before + 1);
+}
+
+TEST(ASYNCPP, SignalManagerRcu) {
+	asyncpp::signal_manager<int, void(int), asyncpp::signal_traits_rcu> mgr;
+	int param = 0;
+	auto hdl = mgr.append(10, [&param](int x) { param = x; });
+	ASSERT_TRUE(mgr.owns_handle(10, hdl));
+	ASSERT_EQ(mgr(10, 42), 1);
+	ASSERT_EQ(param, 42);
+	mgr.remove(10, hdl);
+	ASSERT_EQ(mgr(10, 43), 0);
+	ASSERT_EQ(param, 42);
+}
+
+TEST(ASYNCPP, SignalFlat) {
+	std::vector<int> calls;
+	asyncpp::signal_flat<void(int)> sig;
+	ASSERT_TRUE(sig.empty());
+	ASSERT_EQ(sig(1), 0);
+	auto con = sig += [&](int val) { calls.push_back(val); };
+	// Too large to be stored inline
+	std::array<int, 32> large{};
+	large[0] = 1000;
+	auto con2 = sig += [&calls, large](int val) { calls.push_back(val + large[0]); };
+	ASSERT_EQ(sig.size(), 2);
+	ASSERT_TRUE(sig.owns_handle(con));
+	ASSERT_TRUE(sig.owns_handle(con2));
+	ASSERT_NE(con, con2);
+	ASSERT_EQ(sig(42), 2);
+	ASSERT_EQ(calls, (std::vector<int>{42, 1042}));
+	ASSERT_TRUE(sig.remove(con));
+	ASSERT_FALSE(sig.remove(con));
+	ASSERT_FALSE(sig.owns_handle(con));
+	ASSERT_FALSE(con.valid());
+	// The free entry is reused, but the old handle stays invalid
+	auto con3 = sig += [&](int val) { calls.push_back(-val); };
+	ASSERT_FALSE(sig.owns_handle(con));
+	ASSERT_NE(con, con3);
+	calls.clear();
+	ASSERT_EQ(sig(1), 2);
+	ASSERT_EQ(calls, (std::vector<int>{-1, 1001}));
+	con2.disconnect();
+	con3.disconnect();
+	ASSERT_TRUE(sig.empty());
+	ASSERT_EQ(sig(1), 0);
+
+	// More slots than fit into a single block
+	int sum = 0;
+	std::vector<asyncpp::signal_handle> handles;
+	for (int i = 0; i < 200; i++)
+		handles.push_back(sig += [&sum, i](int) { sum += i; });
+	ASSERT_EQ(sig(0), 200);
+	ASSERT_EQ(sum, 199 * 100);
+	auto moved = std::move(sig);
+	ASSERT_TRUE(moved.owns_handle(handles[150]));
+	handles[150].disconnect();
+	ASSERT_EQ(moved(0), 199);
+	// Destroying the signal disconnects all remaining handles
+	{ auto temp = std::move(moved); }
+	ASSERT_FALSE(handles[0].valid());
+}
+
+TEST(ASYNCPP, SignalFlatModifyDuringEmit) {
+	asyncpp::signal_flat<void(int)> sig;
+	int calls = 0;
+	asyncpp::signal_handle self;
+	asyncpp::signal_handle other;
+	self = sig += [&](int val) {
+		calls++;
+		// Removing ourself and the next slot is visible to the running emission, adding a new one is not
+		sig.remove(self);
+		other.disconnect();
+		sig += [&](int) { calls += 100; };
+		if (val == 42) sig(41);
+	};
+	other = sig += [&](int) { calls += 10; };
+	ASSERT_EQ(sig(42), 1);
+	ASSERT_EQ(calls, 101);
+	ASSERT_EQ(sig.size(), 1);
+	ASSERT_EQ(sig(40), 1);
+	ASSERT_EQ(calls, 201);
+}
+
+TEST(ASYNCPP, SignalManagerFlat) {
+	asyncpp::signal_manager<int, void(int), asyncpp::signal_traits_flat> mgr;
+	int param = 0;
+	auto hdl = mgr.append(10, [&param](int x) { param = x; });
+	ASSERT_TRUE(mgr.owns_handle(10, hdl));
+	ASSERT_FALSE(mgr.owns_handle(11, hdl));
+	ASSERT_EQ(mgr(10, 42), 1);
+	ASSERT_EQ(param, 42);
+	mgr.remove(10, hdl);
+	ASSERT_EQ(mgr(10, 43), 0);
+	ASSERT_EQ(param, 42);
+}
+
+TEST(ASYNCPP, SignalManagerConcurrent) {
+	asyncpp::signal_manager<int, void(int), asyncpp::signal_traits_rcu, asyncpp::signal_map_concurrent> mgr;
+	std::atomic<size_t> sum{0};
+	auto hdl = mgr.append(0, [&](int val) { sum += val; });
+	std::atomic<bool> stop{false};
+	std::thread emitter([&]() {
+		while (!stop)
+			mgr(0, 1);
+	});
+	// Adding events grows the table while the emitter keeps looking up event 0
+	for (int i = 1; i < 1000; i++)
+		mgr.append(i, [&sum, i](int) { sum += i; });
+	stop = true;
+	emitter.join();
+	ASSERT_TRUE(mgr.owns_handle(0, hdl));
+	ASSERT_FALSE(mgr.owns_handle(1, hdl));
+	const auto before = sum.load();
+	ASSERT_EQ(mgr(999, 0), 1);
+	ASSERT_EQ(sum.load(), before + 999);
+	ASSERT_EQ(mgr(1000, 0), 0);
+	ASSERT_TRUE(mgr.remove(0, hdl));
+	ASSERT_EQ(mgr(0, 1), 0);
+	ASSERT_EQ(mgr.shrink_to_fit(), 0);
+}
+
+namespace {
+	enum class dense_event { first, second, third };
+} // namespace
+template<>
+inline constexpr size_t asyncpp::signal_event_count<dense_event> = 3;
+
+TEST(ASYNCPP, SignalManagerDense) {
+	static_assert(asyncpp::detail::dense_signal_event<dense_event>);
+	asyncpp::signal_manager<dense_event, void(int)> mgr;
+	int param = 0;
+	auto hdl = mgr.append(dense_event::third, [&param](int x) { param = x; });
+	ASSERT_TRUE(mgr.owns_handle(dense_event::third, hdl));
+	ASSERT_FALSE(mgr.owns_handle(dense_event::first, hdl));
+	ASSERT_EQ(mgr(dense_event::second, 41), 0);
+	ASSERT_EQ(mgr(dense_event::third, 42), 1);
+	ASSERT_EQ(param, 42);
+	ASSERT_EQ(mgr(static_cast<dense_event>(3), 43), 0);
+	ASSERT_THROW(mgr.append(static_cast<dense_event>(3), [](int) {}), std::out_of_range);
+	ASSERT_TRUE(mgr.remove(dense_event::third, hdl));
+	ASSERT_EQ(mgr(dense_event::third, 43), 0);
+	ASSERT_EQ(param, 42);
+}
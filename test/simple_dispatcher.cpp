@@ -0,0 +1,74 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/simple_dispatcher.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, SimpleDispatcherFastPath) {
+	simple_dispatcher disp{simple_dispatcher_mode::inline_fast_path};
+	std::vector<int> order;
+	disp.push([&]() {
+		// Pushed from the dispatcher thread, so they go to the local ring buffer. It has to grow a couple of times.
+		for (int i = 0; i < 100; i++)
+			disp.push([&order, i]() { order.push_back(i); });
+		disp.push([&]() { disp.stop(); });
+	});
+	disp.run();
+	ASSERT_EQ(order.size(), 100);
+	for (int i = 0; i < 100; i++)
+		ASSERT_EQ(order[i], i);
+}
+
+TEST(ASYNCPP, SimpleDispatcherFastPathCrossThread) {
+	constexpr size_t threads = 4;
+	constexpr size_t count = 1000;
+	simple_dispatcher disp{simple_dispatcher_mode::inline_fast_path};
+	std::thread loop{[&]() { disp.run(); }};
+	// Only touched by the dispatcher thread
+	size_t executed = 0;
+	std::vector<size_t> last(threads, 0);
+	bool in_order = true;
+	std::vector<std::thread> pushers;
+	for (size_t t = 0; t < threads; t++) {
+		pushers.emplace_back([&, t]() {
+			for (size_t i = 1; i <= count; i++) {
+				disp.push([&, t, i]() {
+					in_order = in_order && last[t] + 1 == i;
+					last[t] = i;
+					if (++executed == threads * count) disp.stop();
+				});
+				// Give the loop a chance to fall asleep every now and then
+				if (i % 100 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		});
+	}
+	for (auto& e : pushers)
+		e.join();
+	loop.join();
+	ASSERT_EQ(executed, threads * count);
+	ASSERT_TRUE(in_order);
+}
+
+TEST(ASYNCPP, SimpleDispatcherFastPathCoroutine) {
+	simple_dispatcher disp{simple_dispatcher_mode::inline_fast_path};
+	std::thread loop{[&]() { disp.run(); }};
+	auto res = as_promise([](simple_dispatcher& disp) -> task<int> {
+				   int sum = 0;
+				   for (int i = 0; i < 10; i++) {
+					   // The first defer comes from outside, the others are pushed by the dispatcher thread itself
+					   co_await defer{disp};
+					   sum += i;
+				   }
+				   co_return sum;
+			   }(disp))
+				   .get();
+	ASSERT_EQ(res, 45);
+	disp.stop();
+	loop.join();
+}
@@ -3,3 +3,5 @@
 #endif
 #include <asyncpp/dispatcher.h>
 #include <asyncpp/fiber.h>
+#include <asyncpp/frame_pool.h>
+#include <asyncpp/trampoline.h>
@@ -0,0 +1,84 @@
+// Always tests the polyfill, this file is built as a separate executable with ASYNCPP_FORCE_CUSTOM_STOP_TOKEN=1
+// so it never shares a translation unit or binary with code using the stl version.
+#include <asyncpp/stop_token.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, StopTokenCustom) {
+	stop_source source;
+	auto token = source.get_token();
+	ASSERT_TRUE(token.stop_possible());
+	ASSERT_FALSE(token.stop_requested());
+
+	int called = 0;
+	{
+		// Removed before the stop request
+		stop_callback cb{token, [&]() noexcept { called += 100; }};
+	}
+	// More callbacks than inline slots, so a chunk gets appended
+	std::vector<std::unique_ptr<stop_callback<std::function<void()>>>> callbacks;
+	for (int i = 0; i < 20; i++)
+		callbacks.push_back(std::make_unique<stop_callback<std::function<void()>>>(token, [&]() { called++; }));
+	// Free some slots and reuse them
+	callbacks.erase(callbacks.begin(), callbacks.begin() + 5);
+	for (int i = 0; i < 5; i++)
+		callbacks.push_back(std::make_unique<stop_callback<std::function<void()>>>(token, [&]() { called++; }));
+	ASSERT_EQ(called, 0);
+	ASSERT_TRUE(source.request_stop());
+	ASSERT_FALSE(source.request_stop());
+	ASSERT_EQ(called, 20);
+	ASSERT_TRUE(token.stop_requested());
+	// Registering after the stop request runs the callback right away
+	stop_callback late{token, [&]() noexcept { called++; }};
+	ASSERT_EQ(called, 21);
+	callbacks.clear();
+}
+
+TEST(ASYNCPP, StopTokenCustomDestroyInCallback) {
+	stop_source source;
+	std::optional<stop_callback<std::function<void()>>> cb;
+	cb.emplace(source.get_token(), [&]() { cb.reset(); });
+	source.request_stop();
+	ASSERT_FALSE(cb.has_value());
+}
+
+TEST(ASYNCPP, StopTokenCustomConcurrent) {
+	constexpr int threads = 4;
+	constexpr int iterations = 2000;
+	for (int round = 0; round < 10; round++) {
+		stop_source source;
+		std::atomic<int> registered{0};
+		std::atomic<int> invoked{0};
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([&]() {
+				// Keep going until the stop request was seen, so registrations race with it
+				for (int i = 0; i < iterations || !source.stop_requested(); i++) {
+					bool ran = false;
+					{
+						stop_callback cb{source.get_token(), [&]() noexcept { ran = true; }};
+						registered++;
+					}
+					// Once the callback is destroyed it must either have run completely or never run
+					if (ran) invoked++;
+				}
+			});
+		}
+		while (registered < threads * iterations / 2)
+			std::this_thread::yield();
+		source.request_stop();
+		for (auto& e : workers)
+			e.join();
+		ASSERT_GE(registered, threads * iterations);
+		// Every callback registered after the request ran inline
+		ASSERT_GT(invoked, 0);
+	}
+}
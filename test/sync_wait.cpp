@@ -0,0 +1,81 @@
+#include <asyncpp/defer.h>
+#include <asyncpp/simple_dispatcher.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, SyncWait) {
+	ASSERT_EQ(sync_wait([]() -> task<int> { co_return 42; }()), 42);
+	ASSERT_THROW(sync_wait([]() -> task<> {
+					 throw std::runtime_error("error");
+					 co_return;
+				 }()),
+				 std::runtime_error);
+}
+
+TEST(ASYNCPP, SyncWaitOtherThread) {
+	thread_pool pool{1};
+	for (int i = 0; i < 100; i++) {
+		auto res = sync_wait([](thread_pool& pool, int i) -> task<int> {
+			co_await defer{pool};
+			co_return i;
+		}(pool, i));
+		ASSERT_EQ(res, i);
+	}
+}
+
+TEST(ASYNCPP, SyncWaitOtherThreadReturnsEarly) {
+	thread_pool pool{4};
+	// The state lives on the waiting stack and gets reused right away, the resuming thread must be done with it
+	for (int i = 0; i < 10000; i++) {
+		auto res = sync_wait([](thread_pool& pool, int i) -> task<int> {
+			co_await defer{pool};
+			co_return i;
+		}(pool, i));
+		ASSERT_EQ(res, i);
+	}
+}
+
+TEST(ASYNCPP, SyncWaitLoop) {
+	simple_dispatcher loop;
+	thread_pool pool{1};
+	// The loop is reused for every call and not stopped in between
+	for (int i = 0; i < 10; i++) {
+		auto id = sync_wait(
+			[](thread_pool& pool) -> task<std::thread::id> {
+				auto caller = dispatcher::current();
+				co_await defer{pool};
+				// Without a loop this would deadlock, the calling thread is blocked
+				co_await defer{caller};
+				co_return std::this_thread::get_id();
+			}(pool),
+			loop);
+		ASSERT_EQ(id, std::this_thread::get_id());
+	}
+	ASSERT_EQ(dispatcher::current(), nullptr);
+}
+
+TEST(ASYNCPP, SyncWaitLoopStopped) {
+	thread_pool pool{1};
+	for (auto mode : {simple_dispatcher_mode::locked, simple_dispatcher_mode::inline_fast_path}) {
+		simple_dispatcher loop{mode};
+		// Stopping the loop while waiting must not end the wait before the awaitable finished
+		auto res = sync_wait(
+			[](simple_dispatcher& loop, thread_pool& pool) -> task<int> {
+				loop.stop();
+				co_await defer{pool};
+				co_await defer{loop};
+				co_return 42;
+			}(loop, pool),
+			loop);
+		ASSERT_EQ(res, 42);
+		// The stop still applies to run()
+		loop.run();
+	}
+}
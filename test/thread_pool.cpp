@@ -1,9 +1,15 @@
 #include <asyncpp/defer.h>
+#include <asyncpp/detail/work_stealing_deque.h>
+#include <asyncpp/event.h>
 #include <asyncpp/sync_wait.h>
 #include <asyncpp/task.h>
 #include <asyncpp/thread_pool.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <future>
+#include <vector>
+
 using namespace asyncpp;
 
 TEST(ASYNCPP, ThreadPoolResize) {
@@ -28,3 +34,262 @@ TEST(ASYNCPP, ThreadPool) {
 	ASSERT_EQ(status, std::future_status::ready);
 	ASSERT_NE(f.get(), std::this_thread::get_id());
 }
+
+TEST(ASYNCPP, WorkStealingDeque) {
+	detail::work_stealing_deque<size_t> deque{2};
+	ASSERT_TRUE(deque.empty());
+	ASSERT_FALSE(deque.pop().has_value());
+	ASSERT_FALSE(deque.steal().has_value());
+	for (size_t i = 0; i < 10; i++)
+		deque.push(i);
+	ASSERT_EQ(deque.size(), 10);
+	// Owner takes the newest, thieves take the oldest
+	ASSERT_EQ(deque.pop(), 9);
+	ASSERT_EQ(deque.steal(), 0);
+	ASSERT_EQ(deque.pop(), 8);
+	ASSERT_EQ(deque.steal(), 1);
+	ASSERT_EQ(deque.size(), 6);
+}
+
+TEST(ASYNCPP, WorkStealingDequeConcurrent) {
+	constexpr size_t count = 100000;
+	detail::work_stealing_deque<size_t> deque;
+	std::vector<std::atomic<size_t>> seen(count);
+	std::atomic<bool> done{false};
+	std::vector<std::thread> thieves;
+	for (int i = 0; i < 3; i++) {
+		thieves.emplace_back([&]() {
+			while (!done || !deque.empty()) {
+				if (auto res = deque.steal(); res) seen[*res]++;
+			}
+		});
+	}
+	for (size_t i = 0; i < count; i++) {
+		deque.push(i);
+		if (i % 3 == 0) {
+			if (auto res = deque.pop(); res) seen[*res]++;
+		}
+	}
+	while (auto res = deque.pop())
+		seen[*res]++;
+	done = true;
+	for (auto& e : thieves)
+		e.join();
+	for (auto& e : seen)
+		ASSERT_EQ(e.load(), 1);
+}
+
+TEST(ASYNCPP, ThreadPoolNestedPush) {
+	constexpr size_t count = 10000;
+	std::atomic<size_t> executed{0};
+	std::promise<void> done;
+	thread_pool pool(4);
+	pool.push([&]() {
+		// Pushed from within the pool, so they end up in the local deque and get stolen by the other workers
+		for (size_t i = 0; i < count; i++) {
+			pool.push([&]() {
+				if (executed.fetch_add(1) + 1 == count) done.set_value();
+			});
+		}
+	});
+	ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(executed.load(), count);
+}
+
+TEST(ASYNCPP, ThreadPoolIdleWakeup) {
+	thread_pool pool(2);
+	// Give both workers time to park
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	std::promise<std::chrono::steady_clock::duration> stolen;
+	pool.push([&]() {
+		auto start = std::chrono::steady_clock::now();
+		// This ends up in our local deque, so the parked worker has to be woken to steal it while we block
+		std::promise<void> done;
+		pool.push([&]() { done.set_value(); });
+		done.get_future().wait();
+		stolen.set_value(std::chrono::steady_clock::now() - start);
+	});
+	auto f = stolen.get_future();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	// The old implementation polled every 100ms
+	ASSERT_LT(f.get(), std::chrono::milliseconds(50));
+}
+
+TEST(ASYNCPP, ThreadPoolPushResumeBatch) {
+	constexpr size_t count = 1000;
+	thread_pool pool(4);
+	multi_consumer_event evt;
+	std::atomic<size_t> resumed{0};
+	std::vector<std::future<void>> results;
+	for (size_t i = 0; i < count; i++) {
+		results.push_back(as_promise([](multi_consumer_event& evt, thread_pool& pool,
+										std::atomic<size_t>& resumed) -> task<> {
+			co_await evt.wait(&pool);
+			resumed++;
+		}(evt, pool, resumed)));
+	}
+	// Set from outside the pool, so the batches get split across the workers
+	evt.set();
+	for (auto& e : results)
+		e.get();
+	ASSERT_EQ(resumed.load(), count);
+
+	// And from within the pool, which pushes to the local deque and wakes idle workers to steal
+	multi_consumer_event evt2;
+	resumed = 0;
+	results.clear();
+	for (size_t i = 0; i < count; i++) {
+		results.push_back(as_promise([](multi_consumer_event& evt, thread_pool& pool,
+										std::atomic<size_t>& resumed) -> task<> {
+			co_await evt.wait(&pool);
+			resumed++;
+		}(evt2, pool, resumed)));
+	}
+	pool.push([&evt2]() { evt2.set(); });
+	for (auto& e : results)
+		e.get();
+	ASSERT_EQ(resumed.load(), count);
+}
+
+TEST(ASYNCPP, CpuTopology) {
+	ASSERT_EQ(detail::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+	ASSERT_EQ(detail::parse_cpu_list("5"), (std::vector<int>{5}));
+	ASSERT_TRUE(detail::parse_cpu_list("").empty());
+#ifdef __linux__
+	auto cpus = detail::get_cpu_topology();
+	ASSERT_FALSE(cpus.empty());
+	ASSERT_TRUE(std::is_sorted(cpus.begin(), cpus.end(), [](auto& lhs, auto& rhs) { return lhs.node < rhs.node; }));
+#endif
+}
+
+TEST(ASYNCPP, ThreadPoolSharded) {
+	constexpr size_t count = 1000;
+	std::atomic<size_t> executed{0};
+	std::atomic<size_t> unpinned{0};
+	std::promise<void> done;
+	thread_pool pool(thread_pool_options{.size = 3, .sharded = true});
+	ASSERT_EQ(pool.size(), 3);
+	pool.push([&]() {
+		for (size_t i = 0; i < count; i++) {
+			pool.push([&]() {
+#ifdef __linux__
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0 || CPU_COUNT(&set) != 1)
+					unpinned++;
+#endif
+				if (executed.fetch_add(1) + 1 == count) done.set_value();
+			});
+		}
+	});
+	ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(unpinned.load(), 0);
+	pool.resize(1);
+	pool.resize(4);
+	ASSERT_EQ(pool.size(), 4);
+}
+
+TEST(ASYNCPP, ThreadPoolPriority) {
+	thread_pool pool(1);
+	std::vector<int> order;
+	std::promise<void> done;
+	pool.push([&]() {
+		// All of them are queued while we block the only worker
+		pool.push_prioritized([&]() { order.push_back(2); }, task_priority::low);
+		pool.push([&]() { order.push_back(1); });
+		pool.push_prioritized([&]() { order.push_back(0); }, task_priority::high);
+		pool.push_prioritized([&]() { done.set_value(); }, task_priority::low);
+	});
+	done.get_future().get();
+	ASSERT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(ASYNCPP, ThreadPoolPriorityStarvation) {
+	thread_pool pool(1);
+	std::atomic<bool> stop{false};
+	std::atomic<size_t> high_runs{0};
+	std::promise<size_t> low_ran;
+	std::function<void()> high = [&]() {
+		high_runs++;
+		// Keeps the high lane busy until the low priority task got its turn
+		if (!stop) pool.push_prioritized(high, task_priority::high);
+	};
+	pool.push([&]() {
+		pool.push_prioritized(high, task_priority::high);
+		pool.push_prioritized(
+			[&]() {
+				stop = true;
+				low_ran.set_value(high_runs.load());
+			},
+			task_priority::low);
+	});
+	auto f = low_ran.get_future();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_GT(f.get(), 0);
+}
+
+TEST(ASYNCPP, ThreadPoolExternalStarvation) {
+	thread_pool pool(1);
+	std::atomic<bool> flag{false};
+	std::promise<void> started;
+	auto spin = [](thread_pool& pool, std::atomic<bool>& flag, std::promise<void>& started) -> task<> {
+		co_await defer{pool};
+		started.set_value();
+		// Keeps the local queue of the only worker busy until the external push ran
+		while (!flag)
+			co_await defer{pool};
+	};
+	auto res = as_promise(spin(pool, flag, started));
+	started.get_future().get();
+	pool.push([&]() { flag = true; });
+	ASSERT_EQ(res.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	res.get();
+}
+
+TEST(ASYNCPP, ThreadPoolDeferPriority) {
+	thread_pool pool(1);
+	std::vector<int> order;
+	std::promise<void> done;
+	auto resume_with = [](thread_pool& pool, task_priority prio, std::vector<int>& order, int value) -> task<> {
+		co_await defer{pool, prio};
+		order.push_back(value);
+	};
+	std::vector<std::future<void>> results;
+	pool.push([&]() {
+		results.push_back(as_promise(resume_with(pool, task_priority::normal, order, 1)));
+		results.push_back(as_promise(resume_with(pool, task_priority::high, order, 0)));
+		done.set_value();
+	});
+	done.get_future().get();
+	for (auto& e : results)
+		e.get();
+	ASSERT_EQ(order, (std::vector<int>{0, 1}));
+}
+
+TEST(ASYNCPP, ThreadPoolAutoScale) {
+	thread_pool pool(thread_pool_options{.size = 1,
+										 .min_size = 1,
+										 .max_size = 3,
+										 .scale_interval = std::chrono::milliseconds(1),
+										 .stall_threshold = std::chrono::milliseconds(5),
+										 .idle_timeout = std::chrono::milliseconds(20)});
+	ASSERT_EQ(pool.size(), 1);
+	// The only worker blocks, so the pool has to grow to run the second callback
+	std::promise<void> release;
+	std::promise<void> second;
+	pool.push([&]() { release.get_future().wait(); });
+	pool.push([&]() { second.set_value(); });
+	auto f = second.get_future();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_GT(pool.size(), 1);
+	release.set_value();
+	// Once idle it shrinks back to the minimum
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (pool.size() != 1 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(pool.size(), 1);
+	// Still works after shrinking
+	std::promise<void> done;
+	pool.push([&]() { done.set_value(); });
+	ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
@@ -0,0 +1,124 @@
+#include <asyncpp/threadsafe_queue.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+namespace {
+	// Push count values from every producer and pop them from as many consumers, checking that every value
+	// arrives exactly once and values from the same producer stay in order.
+	template<typename Queue, typename PushFn>
+	void run_mpmc(Queue& queue, PushFn push_fn) {
+		constexpr size_t threads = 4;
+		constexpr size_t count = 5000;
+		std::atomic<size_t> popped{0};
+		std::vector<std::atomic<size_t>> seen(threads * count);
+		std::atomic<bool> in_order{true};
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < threads; t++) {
+			workers.emplace_back([&, t]() {
+				for (size_t i = 0; i < count; i++)
+					push_fn(t * count + i);
+			});
+			workers.emplace_back([&]() {
+				std::vector<size_t> last(threads, 0);
+				while (popped.load() != threads * count) {
+					auto val = queue.pop();
+					if (!val) {
+						std::this_thread::yield();
+						continue;
+					}
+					seen[*val].fetch_add(1);
+					const auto producer = *val / count;
+					if (*val % count + 1 < last[producer]) in_order = false;
+					last[producer] = *val % count + 1;
+					popped.fetch_add(1);
+				}
+			});
+		}
+		for (auto& e : workers)
+			e.join();
+		ASSERT_TRUE(in_order);
+		for (auto& e : seen)
+			ASSERT_EQ(e.load(), 1);
+		ASSERT_FALSE(queue.pop());
+	}
+} // namespace
+
+TEST(ASYNCPP, ThreadsafeQueue) {
+	threadsafe_queue<int> queue;
+	ASSERT_FALSE(queue.pop());
+	queue.push(1);
+	queue.emplace(2);
+	ASSERT_EQ(queue.pop(), 1);
+	ASSERT_EQ(queue.pop(), 2);
+	ASSERT_FALSE(queue.pop());
+}
+
+TEST(ASYNCPP, BoundedMpmcQueue) {
+	bounded_mpmc_queue<std::unique_ptr<int>> queue{3};
+	ASSERT_EQ(queue.capacity(), 4);
+	ASSERT_FALSE(queue.pop());
+	for (int i = 0; i < 4; i++)
+		ASSERT_TRUE(queue.emplace(std::make_unique<int>(i)));
+	ASSERT_FALSE(queue.push(std::make_unique<int>(4)));
+	// Wrap around a couple of times
+	for (int i = 4; i < 20; i++) {
+		auto val = queue.pop();
+		ASSERT_TRUE(val);
+		ASSERT_EQ(**val, i - 4);
+		ASSERT_TRUE(queue.push(std::make_unique<int>(i)));
+	}
+	// The remaining elements are destroyed with the queue
+}
+
+TEST(ASYNCPP, BoundedMpmcQueueThreaded) {
+	bounded_mpmc_queue<size_t> queue{64};
+	run_mpmc(queue, [&](size_t val) {
+		while (!queue.push(val))
+			std::this_thread::yield();
+	});
+}
+
+TEST(ASYNCPP, SegmentedMpmcQueue) {
+	segmented_mpmc_queue<std::unique_ptr<int>, 4> queue;
+	ASSERT_FALSE(queue.pop());
+	// Span a couple of segments
+	for (int i = 0; i < 10; i++)
+		queue.emplace(std::make_unique<int>(i));
+	for (int i = 0; i < 7; i++) {
+		auto val = queue.pop();
+		ASSERT_TRUE(val);
+		ASSERT_EQ(**val, i);
+	}
+	queue.push(std::make_unique<int>(10));
+	for (int i = 7; i < 11; i++) {
+		auto val = queue.pop();
+		ASSERT_TRUE(val);
+		ASSERT_EQ(**val, i);
+	}
+	ASSERT_FALSE(queue.pop());
+	queue.push(std::make_unique<int>(11));
+	// The remaining element is destroyed with the queue
+}
+
+TEST(ASYNCPP, SegmentedMpmcQueuePolling) {
+	segmented_mpmc_queue<size_t, 4> queue;
+	// Polling an empty queue enters the same segment over and over, which must not overflow its entry count
+	for (size_t i = 0; i < 200000; i++)
+		ASSERT_FALSE(queue.pop());
+	for (size_t i = 0; i < 10; i++)
+		queue.push(i);
+	for (size_t i = 0; i < 10; i++)
+		ASSERT_EQ(queue.pop(), i);
+	ASSERT_FALSE(queue.pop());
+}
+
+TEST(ASYNCPP, SegmentedMpmcQueueThreaded) {
+	segmented_mpmc_queue<size_t, 8> queue;
+	run_mpmc(queue, [&](size_t val) { queue.push(val); });
+}
@@ -1,10 +1,13 @@
 #include <asyncpp/defer.h>
+#include <asyncpp/detail/timing_wheel.h>
 #include <asyncpp/sync_wait.h>
 #include <asyncpp/task.h>
 #include <asyncpp/timer.h>
 #include <chrono>
 #include <exception>
 #include <gtest/gtest.h>
+#include <random>
+#include <vector>
 
 using namespace asyncpp;
 
@@ -70,3 +73,155 @@ TEST(ASYNCPP, TimerCancelDestroy) {
 	ASSERT_EQ(f.get(), false);
 	ASSERT_GE(std::chrono::milliseconds{50}, (std::chrono::steady_clock::now() - start));
 }
+
+TEST(ASYNCPP, TimerWaitCancel) {
+	timer t;
+	asyncpp::stop_source source;
+	auto start = std::chrono::steady_clock::now();
+	auto f = as_promise(
+		[](timer& p, asyncpp::stop_token st) -> task<bool> { co_return co_await p.wait(std::chrono::seconds(1), st); }(
+			t, source.get_token()));
+	ASSERT_EQ(f.wait_for(std::chrono::milliseconds(5)), std::future_status::timeout);
+	source.request_stop();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(f.get(), false);
+	ASSERT_GE(std::chrono::milliseconds{50}, (std::chrono::steady_clock::now() - start));
+}
+
+TEST(ASYNCPP, TimingWheel) {
+	detail::timing_wheel<size_t> wheel{};
+	std::minstd_rand rng{42};
+	std::vector<detail::timing_wheel<size_t>::node*> nodes;
+	std::vector<std::uint64_t> expiries;
+	for (size_t i = 0; i < 2000; i++) {
+		// Mix of short, medium and very long timeouts to cover all levels
+		std::uint64_t expiry = rng() % (i % 3 == 0 ? 100 : (i % 3 == 1 ? 10000 : 1000000));
+		expiries.push_back(expiry);
+		nodes.push_back(wheel.emplace(expiry, i));
+	}
+	// Cancel every 5th node
+	std::vector<bool> seen(nodes.size(), false);
+	for (size_t i = 0; i < nodes.size(); i += 5) {
+		wheel.unlink(nodes[i]);
+		wheel.release(nodes[i]);
+		seen[i] = true;
+	}
+	std::uint64_t tick = 0;
+	while (!wheel.empty()) {
+		tick += rng() % 50;
+		for (auto node = wheel.advance(tick); node != nullptr;) {
+			auto idx = node->value();
+			ASSERT_FALSE(seen[idx]);
+			ASSERT_LE(expiries[idx], tick);
+			// Nodes expire on the first advance that reaches their tick
+			ASSERT_GT(expiries[idx] + 50, tick);
+			seen[idx] = true;
+			wheel.release(std::exchange(node, node->next));
+		}
+		ASSERT_LE(tick, 1000100);
+	}
+	for (auto e : seen)
+		ASSERT_TRUE(e);
+}
+
+TEST(ASYNCPP, TimerWheelWait) {
+	timer t{timer_backend::timing_wheel};
+	auto start = std::chrono::steady_clock::now();
+	auto f = as_promise([](timer& p) -> task<bool> { co_return co_await p.wait(std::chrono::milliseconds(50)); }(t));
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+	ASSERT_TRUE(f.get());
+	ASSERT_LE(std::chrono::milliseconds{50}, (std::chrono::steady_clock::now() - start));
+}
+
+TEST(ASYNCPP, TimerWheelCancel) {
+	timer t{timer_backend::timing_wheel};
+	asyncpp::stop_source source;
+	std::promise<bool> res;
+	auto f = res.get_future();
+	t.schedule([&res](bool ok) mutable { res.set_value(ok); }, std::chrono::seconds(1), source.get_token());
+	ASSERT_EQ(f.wait_for(std::chrono::milliseconds(5)), std::future_status::timeout);
+	source.request_stop();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(f.get(), false);
+	// Already cancelled on schedule
+	std::promise<bool> res2;
+	t.schedule([&res2](bool ok) mutable { res2.set_value(ok); }, std::chrono::seconds(1), source.get_token());
+	ASSERT_EQ(res2.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+TEST(ASYNCPP, TimerWheelDestroyCancel) {
+	auto t = std::make_unique<timer>(timer_backend::timing_wheel);
+	auto f = as_promise([](timer& p) -> task<bool> { co_return co_await p.wait(std::chrono::seconds(1)); }(*t));
+	ASSERT_EQ(f.wait_for(std::chrono::milliseconds(5)), std::future_status::timeout);
+	t.reset();
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(f.get(), false);
+}
+
+TEST(ASYNCPP, TimerBatched) {
+	for (auto backend : {timer_backend::ordered_set, timer_backend::timing_wheel}) {
+		constexpr size_t count = 1000;
+		timer t{timer_options{.backend = backend, .batched = true}};
+		std::atomic<size_t> fired{0};
+		std::promise<void> done;
+		std::vector<std::thread> producers;
+		for (int i = 0; i < 4; i++) {
+			producers.emplace_back([&]() {
+				for (size_t n = 0; n < count / 4; n++) {
+					t.schedule(
+						[&](bool ok) {
+							ASSERT_TRUE(ok);
+							if (fired.fetch_add(1) + 1 == count) done.set_value();
+						},
+						std::chrono::milliseconds(n % 20));
+				}
+			});
+		}
+		for (auto& e : producers)
+			e.join();
+		ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+		auto start = std::chrono::steady_clock::now();
+		auto f = as_promise(
+			[](timer& p) -> task<bool> { co_return co_await p.wait(std::chrono::milliseconds(50)); }(t));
+		ASSERT_EQ(f.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+		ASSERT_TRUE(f.get());
+		ASSERT_LE(std::chrono::milliseconds{50}, (std::chrono::steady_clock::now() - start));
+	}
+}
+
+TEST(ASYNCPP, TimerBatchedOrder) {
+	std::vector<int> order;
+	std::vector<int> cancelled;
+	{
+		timer t{timer_options{.backend = timer_backend::ordered_set, .batched = true}};
+		std::promise<void> done;
+		const auto time = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+		// Entries with equal timepoints fire in the order they were scheduled
+		for (int i = 0; i < 100; i++) {
+			t.schedule(
+				[&order, &done, i](bool ok) {
+					ASSERT_TRUE(ok);
+					order.push_back(i);
+					if (i == 49) done.set_value();
+				},
+				time + std::chrono::milliseconds(i < 50 ? 1 : 0));
+		}
+		ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+		// Pending entries get invoked with false on destruction
+		for (int i = 0; i < 10; i++) {
+			t.schedule(
+				[&cancelled, i](bool ok) {
+					ASSERT_FALSE(ok);
+					cancelled.push_back(i);
+				},
+				std::chrono::seconds(10 - i));
+		}
+	}
+	ASSERT_EQ(order.size(), 100);
+	for (int i = 0; i < 50; i++) {
+		ASSERT_EQ(order[i], i + 50);
+		ASSERT_EQ(order[i + 50], i);
+	}
+	ASSERT_EQ(cancelled, (std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0}));
+}
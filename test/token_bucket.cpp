@@ -0,0 +1,53 @@
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/timer.h>
+#include <asyncpp/token_bucket.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace asyncpp;
+
+TEST(ASYNCPP, TokenBucket) {
+	timer tmr;
+	token_bucket bucket{tmr, 2, std::chrono::hours{1}};
+	ASSERT_EQ(bucket.available(), 2);
+	ASSERT_TRUE(bucket.try_acquire());
+	ASSERT_FALSE(bucket.try_acquire(2));
+	ASSERT_TRUE(bucket.try_acquire());
+	ASSERT_FALSE(bucket.try_acquire());
+	ASSERT_EQ(bucket.available(), 0);
+}
+
+TEST(ASYNCPP, TokenBucketWaiters) {
+	constexpr int num_waiters = 20;
+	timer tmr;
+	token_bucket bucket{tmr, 4, std::chrono::milliseconds{50}, 4};
+	std::mutex mtx;
+	std::vector<int> order;
+	std::atomic<int> done{0};
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_waiters; i++) {
+		[](token_bucket& bucket, int i, std::mutex& mtx, std::vector<int>& order,
+		   std::atomic<int>& done) -> eager_fire_and_forget_task<> {
+			if (!co_await bucket.acquire(1, nullptr)) co_return;
+			{
+				std::unique_lock lck{mtx};
+				order.push_back(i);
+			}
+			done++;
+		}(bucket, i, mtx, order, done);
+	}
+	// The bucket started full, the others wait for refills
+	ASSERT_EQ(done, 4);
+	while (done != num_waiters)
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	// Four refills were needed for the remaining 16 waiters
+	ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{200});
+	std::unique_lock lck{mtx};
+	for (int i = 0; i < num_waiters; i++)
+		ASSERT_EQ(order[i], i);
+}
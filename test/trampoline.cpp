@@ -0,0 +1,81 @@
+#include <asyncpp/event.h>
+#include <asyncpp/fire_and_forget.h>
+#include <asyncpp/mutex.h>
+#include <asyncpp/trampoline.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace asyncpp;
+
+namespace {
+	[[gnu::noinline]] std::uintptr_t stack_position() {
+		return reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0));
+	}
+
+	std::uintptr_t unlock_chain_depth() {
+		constexpr size_t num_waiters = 200;
+		mutex mtx;
+		std::vector<std::uintptr_t> positions;
+		EXPECT_TRUE(mtx.try_lock());
+		for (size_t i = 0; i < num_waiters; i++) {
+			[](mutex& mtx, std::vector<std::uintptr_t>& positions) -> eager_fire_and_forget_task<> {
+				co_await mtx.lock();
+				positions.push_back(stack_position());
+				// Hand the mutex to the next waiter right away
+				mtx.unlock();
+			}(mtx, positions);
+		}
+		mtx.unlock();
+		EXPECT_EQ(positions.size(), num_waiters);
+		EXPECT_FALSE(mtx.is_locked());
+		const auto [min, max] = std::minmax_element(positions.begin(), positions.end());
+		return *max - *min;
+	}
+} // namespace
+
+TEST(ASYNCPP, ResumeTrampoline) {
+	ASSERT_FALSE(resume_trampoline::enabled());
+	// Without the trampoline every hand over nests deeper into the stack
+	const auto nested = unlock_chain_depth();
+	{
+		resume_trampoline trampoline;
+		ASSERT_TRUE(resume_trampoline::enabled());
+		{
+			resume_trampoline disabled{false};
+			ASSERT_FALSE(resume_trampoline::enabled());
+		}
+		ASSERT_TRUE(resume_trampoline::enabled());
+		const auto flat = unlock_chain_depth();
+		ASSERT_LT(flat * 10, nested);
+	}
+	ASSERT_FALSE(resume_trampoline::enabled());
+}
+
+TEST(ASYNCPP, ResumeTrampolineOrder) {
+	resume_trampoline trampoline;
+	single_consumer_event first;
+	single_consumer_event second;
+	single_consumer_event third;
+	std::vector<int> order;
+	[](single_consumer_event& evt, single_consumer_event& second, single_consumer_event& third,
+	   std::vector<int>& order) -> eager_fire_and_forget_task<> {
+		co_await evt;
+		second.set();
+		third.set();
+		// Both were only queued, so they run once we suspend or finish
+		order.push_back(1);
+	}(first, second, third, order);
+	[](single_consumer_event& evt, std::vector<int>& order) -> eager_fire_and_forget_task<> {
+		co_await evt;
+		order.push_back(2);
+	}(second, order);
+	[](single_consumer_event& evt, std::vector<int>& order) -> eager_fire_and_forget_task<> {
+		co_await evt;
+		order.push_back(3);
+	}(third, order);
+	first.set();
+	ASSERT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
@@ -0,0 +1,174 @@
+#include <asyncpp/channel.h>
+#include <asyncpp/defer.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/task.h>
+#include <asyncpp/uring_dispatcher.h>
+#include <gtest/gtest.h>
+
+#ifdef ASYNCPP_HAS_URING
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+using namespace asyncpp;
+
+namespace {
+	struct uring_fixture {
+		std::optional<uring_dispatcher> uring;
+		std::thread thread;
+
+		uring_fixture() {
+			try {
+				uring.emplace();
+			} catch (const std::system_error&) { return; }
+			thread = std::thread{[this]() { uring->run(); }};
+		}
+		~uring_fixture() {
+			if (!uring) return;
+			uring->stop();
+			thread.join();
+		}
+	};
+
+	std::span<const std::byte> as_bytes(std::string_view str) { return std::as_bytes(std::span{str}); }
+} // namespace
+
+TEST(ASYNCPP, UringDispatcherStopBeforeRun) {
+	// A stop() that arrives before the thread entered run() must not get lost
+	for (int i = 0; i < 100; i++) {
+		uring_fixture fixture;
+		if (!fixture.uring) GTEST_SKIP() << "io_uring not available";
+	}
+}
+
+TEST(ASYNCPP, UringDispatcher) {
+	uring_fixture fixture;
+	if (!fixture.uring) GTEST_SKIP() << "io_uring not available";
+	std::array<int, 2> fds{};
+	ASSERT_EQ(pipe(fds.data()), 0);
+	auto res = as_promise([](uring_dispatcher& uring, std::array<int, 2> fds) -> task<std::string> {
+				   co_await defer{uring};
+				   auto written = co_await uring.write(fds[1], as_bytes("hello"));
+				   if (written != 5) co_return "write failed";
+				   std::array<std::byte, 16> buffer{};
+				   auto read = co_await uring.read(fds[0], buffer);
+				   if (read != 5) co_return "read failed";
+				   // Nothing left in the pipe, so the read gets cancelled by its timeout
+				   auto timed_out = co_await uring.read(fds[0], buffer).timeout(std::chrono::milliseconds(5));
+				   if (timed_out != -ECANCELED) co_return "timeout failed";
+				   if (co_await uring.sleep(std::chrono::milliseconds(1)) != -ETIME) co_return "sleep failed";
+				   co_return std::string(reinterpret_cast<const char*>(buffer.data()), read);
+			   }(*fixture.uring, fds))
+				   .get();
+	ASSERT_EQ(res, "hello");
+	close(fds[0]);
+	close(fds[1]);
+}
+
+TEST(ASYNCPP, UringDispatcherSocket) {
+	uring_fixture fixture;
+	if (!fixture.uring) GTEST_SKIP() << "io_uring not available";
+	int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT_GE(listener, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrlen = sizeof(addr);
+	ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+	ASSERT_EQ(listen(listener, 1), 0);
+	ASSERT_EQ(getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrlen), 0);
+
+	auto server = as_promise([](uring_dispatcher& uring, int listener) -> task<std::string> {
+		co_await defer{uring};
+		auto fd = co_await uring.accept(listener);
+		if (fd < 0) co_return "accept failed";
+		std::array<std::byte, 16> buffer{};
+		auto size = co_await uring.recv(fd, buffer);
+		if (size > 0) co_await uring.send(fd, std::span{buffer}.first(size));
+		close(fd);
+		co_return std::string(reinterpret_cast<const char*>(buffer.data()), std::max(0, size));
+	}(*fixture.uring, listener));
+	auto client = as_promise([](uring_dispatcher& uring, sockaddr_in addr) -> task<std::string> {
+		co_await defer{uring};
+		int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (co_await uring.connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+			close(fd);
+			co_return "connect failed";
+		}
+		co_await uring.send(fd, as_bytes("ping"));
+		std::array<std::byte, 16> buffer{};
+		auto size = co_await uring.recv(fd, buffer);
+		close(fd);
+		co_return std::string(reinterpret_cast<const char*>(buffer.data()), std::max(0, size));
+	}(*fixture.uring, addr));
+	ASSERT_EQ(client.get(), "ping");
+	ASSERT_EQ(server.get(), "ping");
+	close(listener);
+}
+TEST(ASYNCPP, UringBufferPool) {
+	uring_fixture fixture;
+	if (!fixture.uring) GTEST_SKIP() << "io_uring not available";
+	std::optional<uring_buffer_pool> pool;
+	try {
+		pool.emplace(*fixture.uring, 4, 64);
+	} catch (const std::system_error&) { GTEST_SKIP() << "buffer registration not supported"; }
+	int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT_GE(listener, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrlen = sizeof(addr);
+	ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+	ASSERT_EQ(listen(listener, 1), 0);
+	ASSERT_EQ(getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrlen), 0);
+	int client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+	int server = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+	ASSERT_GE(server, 0);
+	ASSERT_EQ(send(client, "ping", 4, 0), 4);
+
+	// Receive into the pool and hand the lease to a second coroutine, which echoes it without copying
+	channel<uring_buffer> leases{1};
+	auto receiver = as_promise([](uring_buffer_pool& pool, int fd, channel<uring_buffer>& out) -> task<int> {
+		co_await defer{pool.parent()};
+		auto [res, buffer] = co_await pool.recv(fd);
+		if (buffer) co_await out.write(std::move(buffer));
+		out.close();
+		co_return res;
+	}(*pool, server, leases));
+	auto forwarder = as_promise([](uring_dispatcher& uring, int fd, channel<uring_buffer>& in) -> task<int> {
+		co_await defer{uring};
+		auto buffer = co_await in.read();
+		if (!buffer) co_return -1;
+		co_return co_await uring.send_zc(fd, *buffer);
+	}(*fixture.uring, server, leases));
+	ASSERT_EQ(receiver.get(), 4);
+	auto sent = forwarder.get();
+	if (sent == -EINVAL || sent == -EOPNOTSUPP) GTEST_SKIP() << "zero copy send not supported";
+	ASSERT_EQ(sent, 4);
+	ASSERT_EQ(pool->leased(), 0);
+
+	auto sent_span = as_promise([](uring_dispatcher& uring, int fd) -> task<int> {
+		co_await defer{uring};
+		co_return co_await uring.send_zc(fd, as_bytes("pong"));
+	}(*fixture.uring, server));
+	ASSERT_EQ(sent_span.get(), 4);
+	std::array<char, 8> buffer{};
+	size_t received = 0;
+	while (received < buffer.size()) {
+		auto size = ::recv(client, buffer.data() + received, buffer.size() - received, 0);
+		ASSERT_GT(size, 0);
+		received += size;
+	}
+	ASSERT_EQ(std::string_view(buffer.data(), buffer.size()), "pingpong");
+	close(server);
+	close(client);
+	close(listener);
+}
+#endif
@@ -0,0 +1,110 @@
+#include <asyncpp/event.h>
+#include <asyncpp/sync_wait.h>
+#include <asyncpp/thread_pool.h>
+#include <asyncpp/when_all.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <list>
+#include <stdexcept>
+#include <string>
+
+using namespace asyncpp;
+
+namespace {
+	task<int> value_task(int val) { co_return val; }
+	task<std::string> string_task(std::string val) { co_return val; }
+	task<void> void_task(int& counter) {
+		counter++;
+		co_return;
+	}
+	task<int> throwing_task() {
+		throw std::runtime_error("failed");
+		co_return 0;
+	}
+	task<int> event_task(single_consumer_event& evt, int val) {
+		co_await evt;
+		co_return val;
+	}
+} // namespace
+
+TEST(ASYNCPP, WhenAllTuple) {
+	int counter = 0;
+	auto res = as_promise(when_all(value_task(1), string_task("hello"), void_task(counter))).get();
+	ASSERT_EQ(std::get<0>(res), 1);
+	ASSERT_EQ(std::get<1>(res), "hello");
+	ASSERT_EQ(counter, 1);
+	static_assert(std::is_same_v<decltype(res), std::tuple<int, std::string, std::monostate>>);
+}
+
+TEST(ASYNCPP, WhenAllRange) {
+	std::vector<task<int>> tasks;
+	for (int i = 0; i < 10; i++)
+		tasks.push_back(value_task(i));
+	auto res = as_promise(when_all(std::move(tasks))).get();
+	ASSERT_EQ(res.size(), 10);
+	for (int i = 0; i < 10; i++)
+		ASSERT_EQ(res[i], i);
+
+	int counter = 0;
+	std::list<task<void>> void_tasks;
+	void_tasks.push_back(void_task(counter));
+	void_tasks.push_back(void_task(counter));
+	as_promise(when_all(void_tasks)).get();
+	ASSERT_EQ(counter, 2);
+
+	auto empty = as_promise(when_all(std::vector<task<int>>{})).get();
+	ASSERT_TRUE(empty.empty());
+}
+
+TEST(ASYNCPP, WhenAllException) {
+	auto res = as_promise(when_all(value_task(1), throwing_task()));
+	ASSERT_THROW(res.get(), std::runtime_error);
+}
+
+TEST(ASYNCPP, WhenAllSuspended) {
+	single_consumer_event a;
+	single_consumer_event b;
+	auto res = as_promise(when_all(event_task(a, 1), event_task(b, 2)));
+	ASSERT_EQ(res.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+	b.set();
+	ASSERT_EQ(res.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+	a.set();
+	ASSERT_EQ(res.get(), std::make_tuple(1, 2));
+}
+
+TEST(ASYNCPP, WhenAllThreadPool) {
+	thread_pool pool{4};
+	std::atomic<int> sum{0};
+	auto child = [](std::atomic<int>& sum, int val) -> task<void> {
+		sum.fetch_add(val);
+		co_return;
+	};
+	std::vector<task<void>> tasks;
+	for (int i = 1; i <= 100; i++)
+		tasks.push_back(child(sum, i));
+	as_promise(when_all(std::move(tasks)).start_on(&pool)).get();
+	ASSERT_EQ(sum.load(), 5050);
+}
+
+TEST(ASYNCPP, WhenAny) {
+	single_consumer_event a;
+	single_consumer_event b;
+	auto res = as_promise(when_any(event_task(a, 1), event_task(b, 2)));
+	ASSERT_EQ(res.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+	b.set();
+	auto val = res.get();
+	ASSERT_EQ(val.index(), 1);
+	ASSERT_EQ(std::get<1>(val), 2);
+	// The other task keeps running and cleans up once it finished
+	a.set();
+
+	single_consumer_event c;
+	std::vector<task<int>> tasks;
+	tasks.push_back(event_task(c, 1));
+	tasks.push_back(value_task(2));
+	auto [idx, v] = as_promise(when_any(std::move(tasks))).get();
+	ASSERT_EQ(idx, 1);
+	ASSERT_EQ(v, 2);
+	c.set();
+}